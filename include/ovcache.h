@@ -0,0 +1,167 @@
+#pragma once
+
+#include <ovhashmap.h>
+
+/**
+ * @brief Eviction policy of ov_cache
+ */
+enum ov_cache_policy {
+  /** Evict the least recently used entry. A hit moves the entry to the front of the list. */
+  ov_cache_policy_lru = 0,
+  /**
+   * SIEVE, a CLOCK variant: entries are kept in insertion order and a hit only sets a visited bit.
+   * A hand sweeps from the oldest entry, clearing visited bits, and evicts the first unvisited entry.
+   * Hits never reorder the list, so it holds up better than LRU against scans.
+   */
+  ov_cache_policy_sieve = 1,
+};
+
+/**
+ * @brief Callback invoked for each entry evicted to make room
+ *
+ * Called while the shard lock is held, so it must not call back into the same cache.
+ *
+ * @param item Evicted item, valid only during the call
+ * @param userdata ov_cache_options.userdata
+ */
+typedef void (*ov_cache_evict_func)(void const *const item, void *const userdata);
+
+struct ov_cache_options {
+  /** Size of each item. Must be greater than 0. */
+  size_t item_size;
+  /** Number of bytes at the beginning of each item to use as key. Ignored if get_key is set. */
+  size_t key_bytes;
+  /** Function to extract key from item, or NULL to use key_bytes. */
+  ov_hashmap_get_key_func get_key;
+  /** Maximum number of entries, or 0 for no entry limit. */
+  size_t max_entries;
+  /** Maximum total cost passed to OV_CACHE_PUT, or 0 for no cost limit. */
+  size_t max_bytes;
+  enum ov_cache_policy policy;
+  /** If true, the cache may be used from multiple threads. */
+  bool thread_safe;
+  /**
+   * Number of independently locked shards when thread_safe, rounded up to a power of two (max 256).
+   * 0 selects the default. Limits are split across shards so that the shares add up to max_entries and
+   * max_bytes, and fewer shards are used when a limit is smaller than the shard count.
+   */
+  size_t shards;
+  /** Called for each evicted entry. Can be NULL. */
+  ov_cache_evict_func on_evict;
+  void *userdata;
+};
+
+struct ov_cache_stats {
+  size_t count;
+  size_t bytes;
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;
+};
+
+/**
+ * @brief Create a bounded cache
+ *
+ * Get, put and evict are O(1). At least one of max_entries and max_bytes must be set.
+ * Automatically includes debug information for memory tracking.
+ *
+ * @param options_ptr Pointer to struct ov_cache_options. Must not be NULL.
+ * @return Pointer to created cache, or NULL on failure
+ *
+ * @example
+ *   struct ov_cache *c = OV_CACHE_CREATE(&((struct ov_cache_options){
+ *       .item_size = sizeof(struct record),
+ *       .key_bytes = sizeof(int),
+ *       .max_entries = 10000,
+ *       .policy = ov_cache_policy_sieve,
+ *       .thread_safe = true,
+ *   }));
+ */
+#define OV_CACHE_CREATE(options_ptr) ov_cache_create((options_ptr)MEM_FILEPOS_VALUES)
+
+/**
+ * @brief Destroy cache and free all memory
+ *
+ * The eviction callback is not called for the remaining entries.
+ *
+ * @param cp Pointer to cache pointer (will be set to NULL). Must not be NULL.
+ */
+#define OV_CACHE_DESTROY(cp) ov_cache_destroy((cp)MEM_FILEPOS_VALUES)
+
+/**
+ * @brief Remove all entries
+ *
+ * The eviction callback is not called. Counters are kept.
+ *
+ * @param cp Pointer to cache. Must not be NULL.
+ */
+#define OV_CACHE_CLEAR(cp) ov_cache_clear(cp)
+
+/**
+ * @brief Get current number of entries
+ *
+ * @param cp Pointer to cache. Can be NULL.
+ * @return Number of entries, or 0 if cp is NULL
+ */
+#define OV_CACHE_COUNT(cp) ov_cache_count(cp)
+
+/**
+ * @brief Look up an entry and mark it as used
+ *
+ * @param cp Pointer to cache. Must not be NULL.
+ * @param key_item_ptr Pointer to key or item containing key. Must not be NULL.
+ * @param dest_ptr Pointer receiving a copy of the item. Can be NULL.
+ * @return true on hit, false on miss
+ */
+#define OV_CACHE_GET(cp, key_item_ptr, dest_ptr) ov_cache_get((cp), (key_item_ptr), (dest_ptr))
+
+/**
+ * @brief Insert or replace an entry, evicting others as needed
+ *
+ * Automatically includes debug information for memory tracking.
+ *
+ * @param cp Pointer to cache. Must not be NULL.
+ * @param item_ptr Pointer to item. Must not be NULL.
+ * @param cost Size charged against max_bytes. Ignored if max_bytes is 0.
+ * @return true on success, false on memory allocation failure or if cost exceeds the limit of a shard
+ */
+#define OV_CACHE_PUT(cp, item_ptr, cost) ov_cache_put((cp), (item_ptr), (cost)MEM_FILEPOS_VALUES)
+
+/**
+ * @brief Remove an entry
+ *
+ * The eviction callback is not called.
+ *
+ * @param cp Pointer to cache. Must not be NULL.
+ * @param key_item_ptr Pointer to key or item containing key. Must not be NULL.
+ * @param dest_ptr Pointer receiving a copy of the removed item. Can be NULL.
+ * @return true if the entry was present
+ */
+#define OV_CACHE_DELETE(cp, key_item_ptr, dest_ptr) ov_cache_delete((cp), (key_item_ptr), (dest_ptr))
+
+/**
+ * @brief Get entry counts and hit/miss/eviction counters
+ *
+ * @param cp Pointer to cache. Must not be NULL.
+ * @param stats_ptr Pointer to struct ov_cache_stats receiving the result. Must not be NULL.
+ */
+#define OV_CACHE_GET_STATS(cp, stats_ptr) ov_cache_get_stats((cp), (stats_ptr))
+
+/**
+ * @brief Reset hit/miss/eviction counters to 0
+ *
+ * @param cp Pointer to cache. Must not be NULL.
+ */
+#define OV_CACHE_RESET_STATS(cp) ov_cache_reset_stats(cp)
+
+struct ov_cache;
+
+NODISCARD struct ov_cache *ov_cache_create(struct ov_cache_options const *const options MEM_FILEPOS_PARAMS);
+void ov_cache_destroy(struct ov_cache **const cp MEM_FILEPOS_PARAMS);
+void ov_cache_clear(struct ov_cache *const c);
+NODISCARD size_t ov_cache_count(struct ov_cache *const c);
+NODISCARD bool ov_cache_get(struct ov_cache *const c, void const *const key_item, void *const dest);
+NODISCARD bool ov_cache_put(struct ov_cache *const c, void const *const item, size_t const cost MEM_FILEPOS_PARAMS);
+bool ov_cache_delete(struct ov_cache *const c, void const *const key_item, void *const dest);
+void ov_cache_get_stats(struct ov_cache *const c, struct ov_cache_stats *const stats);
+void ov_cache_reset_stats(struct ov_cache *const c);
@@ -164,6 +164,300 @@
  */
 #define OV_HASHMAP_ITER(hmp, size_t_ptr, item_ptr_ptr) ov_hashmap_iter((hmp), (size_t_ptr), (void **)(item_ptr_ptr))
 
+/**
+ * @brief Reserve room for at least n items
+ *
+ * Grows the hashmap once so that n items can be stored without further rehashing.
+ * The reserved size also becomes the minimum size, so deleting items will not shrink below it.
+ * Automatically includes debug information for memory tracking.
+ *
+ * @param hmp Pointer to hashmap. Must not be NULL.
+ * @param n Number of items to make room for
+ * @return true on success, false on memory allocation failure
+ *
+ * @example
+ *   if (!OV_HASHMAP_RESERVE(hm, 1000000)) {
+ *     // Handle memory allocation failure
+ *   }
+ */
+#define OV_HASHMAP_RESERVE(hmp, n) ov_hashmap_reserve((hmp), (n)MEM_FILEPOS_VALUES)
+
+/**
+ * @brief Release unused capacity
+ *
+ * Shrinks the hashmap to the smallest size that holds the current items
+ * and lowers the minimum size set by creation or OV_HASHMAP_RESERVE.
+ * Automatically includes debug information for memory tracking.
+ *
+ * @param hmp Pointer to hashmap. Must not be NULL.
+ * @return true on success, false on memory allocation failure
+ *
+ * @example
+ *   // after deleting most items
+ *   if (!OV_HASHMAP_SHRINK_TO_FIT(hm)) {
+ *     // Handle memory allocation failure, hm is still valid
+ *   }
+ */
+#define OV_HASHMAP_SHRINK_TO_FIT(hmp) ov_hashmap_shrink_to_fit((hmp)MEM_FILEPOS_VALUES)
+
+/**
+ * @brief Set the load factor at which the hashmap grows
+ *
+ * Higher values use less memory at the cost of longer probe sequences.
+ * The value is clamped to the range supported by the hashmap (0.50 to 0.95).
+ *
+ * @param hmp Pointer to hashmap. Must not be NULL.
+ * @param load_factor Ratio of items to buckets that triggers growth, between 0 and 1
+ *
+ * @example
+ *   OV_HASHMAP_SET_LOAD_FACTOR(hm, 0.85);
+ */
+#define OV_HASHMAP_SET_LOAD_FACTOR(hmp, load_factor) ov_hashmap_set_load_factor((hmp), (load_factor))
+
+/**
+ * @brief Insert many items with a single sizing step
+ *
+ * Reserves room for all items up front, then inserts them in order.
+ * Later items overwrite earlier ones with the same key.
+ * Automatically includes debug information for memory tracking.
+ *
+ * @param hmp Pointer to hashmap. Must not be NULL.
+ * @param items Pointer to contiguous array of items. Can be NULL only if n is 0.
+ * @param n Number of items
+ * @return true on success, false on memory allocation failure (some items may have been inserted)
+ *
+ * @example
+ *   struct record records[1000];
+ *   if (!OV_HASHMAP_SET_BULK(hm, records, 1000)) {
+ *     // Handle memory allocation failure
+ *   }
+ */
+#define OV_HASHMAP_SET_BULK(hmp, items, n) ov_hashmap_set_bulk((hmp), (items), (n)MEM_FILEPOS_VALUES)
+
+/**
+ * @brief Freeze a static key hashmap into an immutable perfect hash image
+ *
+ * Builds a minimal perfect hash over the current keys and writes it, together with copies of all
+ * items, into a single flat buffer. The buffer contains no pointers, so it can be written to a file
+ * and later memory-mapped or loaded at any address and queried in place with OV_HASHMAP_FROZEN_GET.
+ * Every lookup touches exactly one item slot.
+ * Items must not contain pointers if the image is meant to outlive the process.
+ * The image is allocated with OV_REALLOC and must be freed with OV_FREE.
+ *
+ * @param hmp Pointer to static key hashmap. Must not be NULL. Dynamic key hashmaps are not supported.
+ * @param image_ptr Pointer to void pointer receiving the image. *image_ptr must be NULL.
+ * @param size_t_ptr Pointer to size_t receiving the image size in bytes. Must not be NULL.
+ * @return true on success, false on failure
+ *
+ * @example
+ *   void *image = NULL;
+ *   size_t image_bytes = 0;
+ *   if (OV_HASHMAP_FREEZE(hm, &image, &image_bytes)) {
+ *     struct record const *r = (struct record const *)OV_HASHMAP_FROZEN_GET(image, &(int){123});
+ *     OV_FREE(&image);
+ *   }
+ */
+#define OV_HASHMAP_FREEZE(hmp, image_ptr, size_t_ptr)                                                                  \
+  ov_hashmap_freeze((hmp), (image_ptr), (size_t_ptr)MEM_FILEPOS_VALUES)
+
+/**
+ * @brief Check that a buffer holds a well-formed frozen hashmap image
+ *
+ * Must be called before querying an image that was read or mapped from outside the process.
+ * The image must be 8-byte aligned.
+ *
+ * @param image Pointer to image. Can be NULL.
+ * @param image_bytes Size of the buffer in bytes
+ * @return true if the image can be queried safely, false otherwise
+ */
+#define OV_HASHMAP_FROZEN_VALIDATE(image, image_bytes) ov_hashmap_frozen_validate((image), (image_bytes))
+
+/**
+ * @brief Get the number of items in a frozen hashmap image
+ *
+ * @param image Pointer to image. Can be NULL.
+ * @return Number of items, or 0 if image is NULL
+ */
+#define OV_HASHMAP_FROZEN_COUNT(image) ov_hashmap_frozen_count(image)
+
+/**
+ * @brief Get item from a frozen hashmap image by key
+ *
+ * @param image Pointer to image. Must not be NULL.
+ * @param key_item_ptr Pointer to key or item containing key. Must not be NULL.
+ * @return Pointer to the item inside the image, or NULL if not found
+ */
+#define OV_HASHMAP_FROZEN_GET(image, key_item_ptr) ov_hashmap_frozen_get((image), (key_item_ptr))
+
+/**
+ * @brief Iterate over all items in a frozen hashmap image
+ *
+ * Items are stored densely, so iteration cost depends only on the number of items.
+ *
+ * @param image Pointer to image. Must not be NULL.
+ * @param size_t_ptr Pointer to iterator variable (size_t), initialized to 0. Must not be NULL.
+ * @param item_ptr_ptr Pointer to const item pointer (will receive current item). Must not be NULL.
+ * @return true if item retrieved, false when iteration complete
+ */
+#define OV_HASHMAP_FROZEN_ITER(image, size_t_ptr, item_ptr_ptr)                                                        \
+  ov_hashmap_frozen_iter((image), (size_t_ptr), (void const **)(item_ptr_ptr))
+
+/**
+ * @brief Write a static key hashmap to a flat snapshot image
+ *
+ * Unlike OV_HASHMAP_FREEZE, this does no extra work: the bucket array is written out as it is,
+ * together with the hash seeds, so it is as fast as a memcpy of the table. The image contains no
+ * pointers and can be written to a file, then queried in place with OV_HASHMAP_SNAPSHOT_GET or
+ * turned back into a mutable hashmap with OV_HASHMAP_LOAD.
+ * Values are stored in native byte order and the bucket layout depends on the pointer size, so
+ * images are only portable between builds of the same architecture; validation rejects others.
+ * Items must not contain pointers if the image is meant to outlive the process.
+ * The image is allocated with OV_REALLOC and must be freed with OV_FREE.
+ *
+ * @param hmp Pointer to static key hashmap. Must not be NULL. Dynamic key hashmaps are not supported.
+ * @param image_ptr Pointer to void pointer receiving the image. *image_ptr must be NULL.
+ * @param size_t_ptr Pointer to size_t receiving the image size in bytes. Must not be NULL.
+ * @return true on success, false on failure
+ *
+ * @example
+ *   void *image = NULL;
+ *   size_t image_bytes = 0;
+ *   if (OV_HASHMAP_SNAPSHOT(hm, &image, &image_bytes)) {
+ *     fwrite(image, 1, image_bytes, fp);
+ *     OV_FREE(&image);
+ *   }
+ */
+#define OV_HASHMAP_SNAPSHOT(hmp, image_ptr, size_t_ptr)                                                                \
+  ov_hashmap_snapshot((hmp), (image_ptr), (size_t_ptr)MEM_FILEPOS_VALUES)
+
+/**
+ * @brief Check that a buffer holds a well-formed snapshot image
+ *
+ * Must be called before querying an image that was read from outside the process.
+ * OV_HASHMAP_LOAD and OV_HASHMAP_SNAPSHOT_MAP validate on their own.
+ * The image must be 8-byte aligned.
+ *
+ * @param image Pointer to image. Can be NULL.
+ * @param image_bytes Size of the buffer in bytes
+ * @return true if the image can be queried safely, false otherwise
+ */
+#define OV_HASHMAP_SNAPSHOT_VALIDATE(image, image_bytes) ov_hashmap_snapshot_validate((image), (image_bytes))
+
+/**
+ * @brief Get the number of items in a snapshot image
+ *
+ * @param image Pointer to image. Can be NULL.
+ * @return Number of items, or 0 if image is NULL
+ */
+#define OV_HASHMAP_SNAPSHOT_COUNT(image) ov_hashmap_snapshot_count(image)
+
+/**
+ * @brief Get item from a snapshot image by key without loading it
+ *
+ * Probes the stored bucket array exactly like OV_HASHMAP_GET does on a live hashmap.
+ *
+ * @param image Pointer to validated image. Must not be NULL.
+ * @param key_item_ptr Pointer to key or item containing key. Must not be NULL.
+ * @return Pointer to the item inside the image, or NULL if not found
+ */
+#define OV_HASHMAP_SNAPSHOT_GET(image, key_item_ptr) ov_hashmap_snapshot_get((image), (key_item_ptr))
+
+/**
+ * @brief Create a hashmap from a snapshot image
+ *
+ * The bucket array is copied back as it is, with the original seeds, so nothing is rehashed.
+ * The image is validated first and is not referenced after the call.
+ * Automatically includes debug information for memory tracking.
+ *
+ * @param image Pointer to image. Must not be NULL.
+ * @param image_bytes Size of the buffer in bytes
+ * @return Pointer to a new static key hashmap, or NULL if the image is invalid or on memory allocation failure
+ */
+#define OV_HASHMAP_LOAD(image, image_bytes) ov_hashmap_load((image), (image_bytes)MEM_FILEPOS_VALUES)
+
+/**
+ * @brief Read-only mapping of a snapshot file
+ */
+struct ov_hashmap_snapshot_mapping {
+  void const *image;
+  size_t image_bytes;
+};
+
+/**
+ * @brief Map a snapshot file into memory read-only
+ *
+ * Pages are loaded on demand by the OS, so opening a large snapshot is cheap and lookups with
+ * OV_HASHMAP_SNAPSHOT_GET touch only the pages they probe. The file must not be modified while
+ * it is mapped. Not supported on WASI.
+ *
+ * @param path Path to the snapshot file. Must not be NULL.
+ * @param mapping_ptr Pointer to struct ov_hashmap_snapshot_mapping receiving the mapping. Must not be NULL.
+ * @return true on success, false if the file cannot be mapped or does not hold a valid image
+ *
+ * @example
+ *   struct ov_hashmap_snapshot_mapping m;
+ *   if (OV_HASHMAP_SNAPSHOT_MAP(NSTR("table.bin"), &m)) {
+ *     struct record const *r = (struct record const *)OV_HASHMAP_SNAPSHOT_GET(m.image, &(int){123});
+ *     OV_HASHMAP_SNAPSHOT_UNMAP(&m);
+ *   }
+ */
+#define OV_HASHMAP_SNAPSHOT_MAP(path, mapping_ptr) ov_hashmap_snapshot_map((path), (mapping_ptr))
+
+/**
+ * @brief Unmap a snapshot file mapped with OV_HASHMAP_SNAPSHOT_MAP
+ *
+ * @param mapping_ptr Pointer to mapping (will be zeroed). Must not be NULL.
+ */
+#define OV_HASHMAP_SNAPSHOT_UNMAP(mapping_ptr) ov_hashmap_snapshot_unmap(mapping_ptr)
+
+/**
+ * @brief Collect statistics about a hashmap
+ *
+ * Count, capacity, load factor and probe distances are always available and are computed by
+ * scanning the table, so this costs O(capacity). Probe distance is the number of buckets an item
+ * sits past its home bucket.
+ * Resize and get hit/miss counters are only collected when the library is built with
+ * HASHMAP_STATS enabled; otherwise they are always 0 and the hot paths carry no extra work.
+ *
+ * @param hmp Pointer to hashmap. Must not be NULL.
+ * @param stats_ptr Pointer to struct ov_hashmap_stats receiving the result. Must not be NULL.
+ *
+ * @example
+ *   struct ov_hashmap_stats st;
+ *   OV_HASHMAP_GET_STATS(hm, &st);
+ *   printf("load %.2f, avg probe %.2f, max probe %zu\n", st.load_factor, st.avg_probe, st.max_probe);
+ */
+#define OV_HASHMAP_GET_STATS(hmp, stats_ptr) ov_hashmap_get_stats((hmp), (stats_ptr))
+
+/**
+ * @brief Reset resize and get hit/miss counters to 0
+ *
+ * Does nothing unless the library is built with HASHMAP_STATS enabled.
+ *
+ * @param hmp Pointer to hashmap. Must not be NULL.
+ */
+#define OV_HASHMAP_RESET_STATS(hmp) ov_hashmap_reset_stats(hmp)
+
+/**
+ * Number of bins in ov_hashmap_stats.probe_histogram.
+ * The last bin also counts every item with a longer probe distance.
+ */
+#define OV_HASHMAP_STATS_HISTOGRAM_SIZE 16
+
+struct ov_hashmap_stats {
+  size_t count;
+  size_t capacity;
+  double load_factor;
+  double avg_probe;
+  size_t max_probe;
+  size_t probe_histogram[OV_HASHMAP_STATS_HISTOGRAM_SIZE];
+  // The following are 0 unless built with HASHMAP_STATS.
+  uint64_t resizes;
+  uint64_t resize_ns;
+  uint64_t get_hits;
+  uint64_t get_misses;
+};
+
 struct ov_hashmap;
 
 typedef void (*ov_hashmap_get_key_func)(void const *const item, void const **const key, size_t *const key_bytes);
@@ -180,3 +474,27 @@ NODISCARD void const *ov_hashmap_get(struct ov_hashmap const *const hm, void con
 NODISCARD bool ov_hashmap_set(struct ov_hashmap *const hm, void const *const item MEM_FILEPOS_PARAMS);
 void const *ov_hashmap_delete(struct ov_hashmap *const hm, void const *const key_item);
 NODISCARD bool ov_hashmap_iter(struct ov_hashmap *const hm, size_t *const i, void **const item);
+NODISCARD bool ov_hashmap_reserve(struct ov_hashmap *const hm, size_t const n MEM_FILEPOS_PARAMS);
+NODISCARD bool ov_hashmap_shrink_to_fit(struct ov_hashmap *const hm MEM_FILEPOS_PARAMS);
+void ov_hashmap_set_load_factor(struct ov_hashmap *const hm, double const load_factor);
+NODISCARD bool ov_hashmap_set_bulk(struct ov_hashmap *const hm,
+                                   void const *const items,
+                                   size_t const n MEM_FILEPOS_PARAMS);
+NODISCARD bool ov_hashmap_freeze(struct ov_hashmap const *const hm,
+                                 void **const image,
+                                 size_t *const image_bytes MEM_FILEPOS_PARAMS);
+NODISCARD bool ov_hashmap_frozen_validate(void const *const image, size_t const image_bytes);
+NODISCARD size_t ov_hashmap_frozen_count(void const *const image);
+NODISCARD void const *ov_hashmap_frozen_get(void const *const image, void const *const key_item);
+NODISCARD bool ov_hashmap_frozen_iter(void const *const image, size_t *const i, void const **const item);
+NODISCARD bool ov_hashmap_snapshot(struct ov_hashmap const *const hm,
+                                   void **const image,
+                                   size_t *const image_bytes MEM_FILEPOS_PARAMS);
+NODISCARD bool ov_hashmap_snapshot_validate(void const *const image, size_t const image_bytes);
+NODISCARD size_t ov_hashmap_snapshot_count(void const *const image);
+NODISCARD void const *ov_hashmap_snapshot_get(void const *const image, void const *const key_item);
+NODISCARD struct ov_hashmap *ov_hashmap_load(void const *const image, size_t const image_bytes MEM_FILEPOS_PARAMS);
+NODISCARD bool ov_hashmap_snapshot_map(NATIVE_CHAR const *const path, struct ov_hashmap_snapshot_mapping *const m);
+void ov_hashmap_snapshot_unmap(struct ov_hashmap_snapshot_mapping *const m);
+void ov_hashmap_get_stats(struct ov_hashmap const *const hm, struct ov_hashmap_stats *const stats);
+void ov_hashmap_reset_stats(struct ov_hashmap *const hm);
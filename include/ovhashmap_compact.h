@@ -0,0 +1,130 @@
+#pragma once
+
+#include <ovhashmap.h>
+
+/**
+ * @brief Create an insertion-ordered compact hashmap with custom key extraction
+ *
+ * Items are kept in a dense array in insertion order, and a separate open-addressing index
+ * maps hashes to positions in that array. Index slots are 8, 16 or 32 bits wide depending on
+ * the number of entries, so small maps stay small and iteration only walks stored items.
+ * Updating an existing key keeps its position; deleted items leave a hole that is reclaimed
+ * when the map grows.
+ * Automatically includes debug information for memory tracking.
+ *
+ * @param item_size Size of each item to store. Must be greater than 0.
+ * @param cap Initial capacity (will grow as needed). Can be 0 for default capacity.
+ * @param get_key_fn Function to extract key from item. Must not be NULL.
+ * @return Pointer to created hashmap, or NULL on failure
+ *
+ * @example
+ *   struct ov_hashmap_compact *hm = OV_HASHMAP_COMPACT_CREATE_DYNAMIC(sizeof(struct record), 0, get_key);
+ */
+#define OV_HASHMAP_COMPACT_CREATE_DYNAMIC(item_size, cap, get_key_fn)                                                  \
+  ov_hashmap_compact_create_dynamic((item_size), (cap), (get_key_fn)MEM_FILEPOS_VALUES)
+
+/**
+ * @brief Create an insertion-ordered compact hashmap with static keys
+ *
+ * Keys are the first N bytes of each item. See OV_HASHMAP_COMPACT_CREATE_DYNAMIC.
+ * Automatically includes debug information for memory tracking.
+ *
+ * @param item_size Size of each item to store. Must be greater than 0.
+ * @param cap Initial capacity (will grow as needed). Can be 0 for default capacity.
+ * @param key_size Number of bytes at the beginning of each item to use as key. Must be greater than 0.
+ * @return Pointer to created hashmap, or NULL on failure
+ *
+ * @example
+ *   struct ov_hashmap_compact *hm = OV_HASHMAP_COMPACT_CREATE_STATIC(sizeof(struct record), 0, sizeof(int));
+ */
+#define OV_HASHMAP_COMPACT_CREATE_STATIC(item_size, cap, key_size)                                                     \
+  ov_hashmap_compact_create_static((item_size), (cap), (key_size)MEM_FILEPOS_VALUES)
+
+/**
+ * @brief Destroy hashmap and free all memory
+ *
+ * @param hmp Pointer to hashmap pointer (will be set to NULL). Must not be NULL.
+ */
+#define OV_HASHMAP_COMPACT_DESTROY(hmp) ov_hashmap_compact_destroy((hmp)MEM_FILEPOS_VALUES)
+
+/**
+ * @brief Clear all items from hashmap
+ *
+ * @param hmp Pointer to hashmap. Must not be NULL.
+ */
+#define OV_HASHMAP_COMPACT_CLEAR(hmp) ov_hashmap_compact_clear(hmp)
+
+/**
+ * @brief Get current number of items in hashmap
+ *
+ * @param hmp Pointer to hashmap. Can be NULL.
+ * @return Number of items currently stored, or 0 if hmp is NULL
+ */
+#define OV_HASHMAP_COMPACT_COUNT(hmp) ov_hashmap_compact_count(hmp)
+
+/**
+ * @brief Get item from hashmap by key
+ *
+ * @param hmp Pointer to hashmap. Must not be NULL.
+ * @param key_item_ptr Pointer to key or item containing key. Must not be NULL.
+ * @return Pointer to found item, or NULL if not found. Valid until the next set or delete.
+ */
+#define OV_HASHMAP_COMPACT_GET(hmp, key_item_ptr) ov_hashmap_compact_get((hmp), (key_item_ptr))
+
+/**
+ * @brief Set/insert item into hashmap
+ *
+ * New keys are appended after all existing items. Existing keys are updated in place
+ * and keep their position in iteration order.
+ * Automatically includes debug information for memory tracking.
+ *
+ * @param hmp Pointer to hashmap. Must not be NULL.
+ * @param item_ptr Pointer to item to insert/update. Must not be NULL.
+ * @return true on success, false on memory allocation failure
+ */
+#define OV_HASHMAP_COMPACT_SET(hmp, item_ptr) ov_hashmap_compact_set((hmp), (item_ptr)MEM_FILEPOS_VALUES)
+
+/**
+ * @brief Delete item from hashmap
+ *
+ * @param hmp Pointer to hashmap. Must not be NULL.
+ * @param key_item_ptr Pointer to key or item containing key. Must not be NULL.
+ * @return Pointer to deleted item, or NULL if not found. Valid until the next set or clear.
+ */
+#define OV_HASHMAP_COMPACT_DELETE(hmp, key_item_ptr) ov_hashmap_compact_delete((hmp), (key_item_ptr))
+
+/**
+ * @brief Iterate over all items in insertion order
+ *
+ * Initialize iterator to 0. Deleting the current item during iteration is allowed.
+ *
+ * @param hmp Pointer to hashmap. Must not be NULL.
+ * @param size_t_ptr Pointer to iterator variable (size_t). Must not be NULL.
+ * @param item_ptr_ptr Pointer to item pointer (will receive current item). Must not be NULL.
+ * @return true if item retrieved, false when iteration complete
+ *
+ * @example
+ *   size_t iter = 0;
+ *   struct record *item;
+ *   while (OV_HASHMAP_COMPACT_ITER(hm, &iter, &item)) {
+ *     printf("Item: %d %s\n", item->id, item->name);
+ *   }
+ */
+#define OV_HASHMAP_COMPACT_ITER(hmp, size_t_ptr, item_ptr_ptr)                                                         \
+  ov_hashmap_compact_iter((hmp), (size_t_ptr), (void **)(item_ptr_ptr))
+
+struct ov_hashmap_compact;
+
+NODISCARD struct ov_hashmap_compact *ov_hashmap_compact_create_dynamic(size_t const item_size,
+                                                                       size_t const cap,
+                                                                       ov_hashmap_get_key_func const get_key
+                                                                           MEM_FILEPOS_PARAMS);
+NODISCARD struct ov_hashmap_compact *
+ov_hashmap_compact_create_static(size_t const item_size, size_t const cap, size_t const key_bytes MEM_FILEPOS_PARAMS);
+void ov_hashmap_compact_destroy(struct ov_hashmap_compact **const hmp MEM_FILEPOS_PARAMS);
+void ov_hashmap_compact_clear(struct ov_hashmap_compact *const hm);
+NODISCARD size_t ov_hashmap_compact_count(struct ov_hashmap_compact const *const hm);
+NODISCARD void const *ov_hashmap_compact_get(struct ov_hashmap_compact const *const hm, void const *const key_item);
+NODISCARD bool ov_hashmap_compact_set(struct ov_hashmap_compact *const hm, void const *const item MEM_FILEPOS_PARAMS);
+void const *ov_hashmap_compact_delete(struct ov_hashmap_compact *const hm, void const *const key_item);
+NODISCARD bool ov_hashmap_compact_iter(struct ov_hashmap_compact *const hm, size_t *const i, void **const item);
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <ovhashmap.h>
+
+/**
+ * @brief Create a thread-safe dynamic hashmap with custom key extraction
+ *
+ * The table is split into independently locked shards so that threads touching different
+ * shards never contend. Reads take a shared lock on a single shard, writes take an exclusive
+ * lock on a single shard, and a resize only ever rehashes the shard being written to.
+ *
+ * @param item_size Size of each item to store. Must be greater than 0.
+ * @param cap Initial total capacity (split across shards). Can be 0 for default capacity.
+ * @param get_key_fn Function to extract key from item. Must not be NULL.
+ * @param shards Number of shards, rounded up to a power of two (max 256). 0 selects the default.
+ * @return Pointer to created hashmap, or NULL on failure
+ *
+ * @example
+ *   struct ov_hashmap_concurrent *hm =
+ *       OV_HASHMAP_CONCURRENT_CREATE_DYNAMIC(sizeof(struct record), 1024, get_key, 0);
+ */
+#define OV_HASHMAP_CONCURRENT_CREATE_DYNAMIC(item_size, cap, get_key_fn, shards)                                       \
+  ov_hashmap_concurrent_create_dynamic((item_size), (cap), (get_key_fn), (shards)MEM_FILEPOS_VALUES)
+
+/**
+ * @brief Create a thread-safe static key hashmap
+ *
+ * Keys are the first N bytes of each item. See OV_HASHMAP_CONCURRENT_CREATE_DYNAMIC for sharding.
+ *
+ * @param item_size Size of each item to store. Must be greater than 0.
+ * @param cap Initial total capacity (split across shards). Can be 0 for default capacity.
+ * @param key_size Number of bytes at the beginning of each item to use as key. Must be greater than 0.
+ * @param shards Number of shards, rounded up to a power of two (max 256). 0 selects the default.
+ * @return Pointer to created hashmap, or NULL on failure
+ *
+ * @example
+ *   struct record { int id; char name[32]; };
+ *   struct ov_hashmap_concurrent *hm =
+ *       OV_HASHMAP_CONCURRENT_CREATE_STATIC(sizeof(struct record), 1024, sizeof(int), 0);
+ */
+#define OV_HASHMAP_CONCURRENT_CREATE_STATIC(item_size, cap, key_size, shards)                                          \
+  ov_hashmap_concurrent_create_static((item_size), (cap), (key_size), (shards)MEM_FILEPOS_VALUES)
+
+/**
+ * @brief Destroy hashmap and free all memory
+ *
+ * Must not be called while other threads are still using the hashmap.
+ *
+ * @param hmp Pointer to hashmap pointer (will be set to NULL). Must not be NULL.
+ */
+#define OV_HASHMAP_CONCURRENT_DESTROY(hmp) ov_hashmap_concurrent_destroy((hmp)MEM_FILEPOS_VALUES)
+
+/**
+ * @brief Clear all items from hashmap
+ *
+ * Shards are cleared one at a time, so concurrent writers may leave items behind.
+ *
+ * @param hmp Pointer to hashmap. Must not be NULL.
+ */
+#define OV_HASHMAP_CONCURRENT_CLEAR(hmp) ov_hashmap_concurrent_clear(hmp)
+
+/**
+ * @brief Get current number of items in hashmap
+ *
+ * Lock-free. The result is a snapshot and may be stale while writers are active.
+ *
+ * @param hmp Pointer to hashmap. Can be NULL.
+ * @return Number of items currently stored, or 0 if hmp is NULL
+ */
+#define OV_HASHMAP_CONCURRENT_COUNT(hmp) ov_hashmap_concurrent_count(hmp)
+
+/**
+ * @brief Get item from hashmap by key
+ *
+ * Unlike OV_HASHMAP_GET, the item is copied out while the shard is locked,
+ * because a pointer into the table could be invalidated by another thread at any time.
+ *
+ * @param hmp Pointer to hashmap. Must not be NULL.
+ * @param key_item_ptr Pointer to key or item containing key. Must not be NULL.
+ * @param dest_ptr Receives a copy of the found item. Can be NULL to only test for existence.
+ * @return true if found, false otherwise
+ *
+ * @example
+ *   struct record r;
+ *   if (OV_HASHMAP_CONCURRENT_GET(hm, &(int){123}, &r)) { // found
+ *   }
+ */
+#define OV_HASHMAP_CONCURRENT_GET(hmp, key_item_ptr, dest_ptr)                                                         \
+  ov_hashmap_concurrent_get((hmp), (key_item_ptr), (dest_ptr))
+
+/**
+ * @brief Set/insert item into hashmap
+ *
+ * @param hmp Pointer to hashmap. Must not be NULL.
+ * @param item_ptr Pointer to item to insert/update. Must not be NULL.
+ * @return true on success, false on memory allocation failure
+ */
+#define OV_HASHMAP_CONCURRENT_SET(hmp, item_ptr) ov_hashmap_concurrent_set((hmp), (item_ptr)MEM_FILEPOS_VALUES)
+
+/**
+ * @brief Delete item from hashmap
+ *
+ * @param hmp Pointer to hashmap. Must not be NULL.
+ * @param key_item_ptr Pointer to key or item containing key. Must not be NULL.
+ * @param dest_ptr Receives a copy of the deleted item. Can be NULL.
+ * @return true if an item was deleted, false if not found
+ */
+#define OV_HASHMAP_CONCURRENT_DELETE(hmp, key_item_ptr, dest_ptr)                                                      \
+  ov_hashmap_concurrent_delete((hmp), (key_item_ptr), (dest_ptr))
+
+/**
+ * @brief Iterate over all items in hashmap
+ *
+ * Initialize iterator to 0. Each step copies one item out under a shared shard lock.
+ * Iteration is weakly consistent: items inserted or deleted concurrently may or may not be seen,
+ * and a shard resized by another thread in the middle of iteration may yield items twice or skip them.
+ *
+ * @param hmp Pointer to hashmap. Must not be NULL.
+ * @param size_t_ptr Pointer to iterator variable (size_t). Must not be NULL.
+ * @param dest_ptr Receives a copy of the current item. Must not be NULL.
+ * @return true if item retrieved, false when iteration complete
+ *
+ * @example
+ *   size_t iter = 0;
+ *   struct record r;
+ *   while (OV_HASHMAP_CONCURRENT_ITER(hm, &iter, &r)) {
+ *     printf("Item: %d %s\n", r.id, r.name);
+ *   }
+ */
+#define OV_HASHMAP_CONCURRENT_ITER(hmp, size_t_ptr, dest_ptr)                                                          \
+  ov_hashmap_concurrent_iter((hmp), (size_t_ptr), (dest_ptr))
+
+struct ov_hashmap_concurrent;
+
+NODISCARD struct ov_hashmap_concurrent *
+ov_hashmap_concurrent_create_dynamic(size_t const item_size,
+                                     size_t const cap,
+                                     ov_hashmap_get_key_func const get_key,
+                                     size_t const shards MEM_FILEPOS_PARAMS);
+NODISCARD struct ov_hashmap_concurrent *ov_hashmap_concurrent_create_static(size_t const item_size,
+                                                                            size_t const cap,
+                                                                            size_t const key_bytes,
+                                                                            size_t const shards MEM_FILEPOS_PARAMS);
+void ov_hashmap_concurrent_destroy(struct ov_hashmap_concurrent **const hmp MEM_FILEPOS_PARAMS);
+void ov_hashmap_concurrent_clear(struct ov_hashmap_concurrent *const hm);
+NODISCARD size_t ov_hashmap_concurrent_count(struct ov_hashmap_concurrent const *const hm);
+bool ov_hashmap_concurrent_get(struct ov_hashmap_concurrent *const hm,
+                               void const *const key_item,
+                               void *const dest);
+NODISCARD bool ov_hashmap_concurrent_set(struct ov_hashmap_concurrent *const hm,
+                                         void const *const item MEM_FILEPOS_PARAMS);
+bool ov_hashmap_concurrent_delete(struct ov_hashmap_concurrent *const hm,
+                                  void const *const key_item,
+                                  void *const dest);
+NODISCARD bool ov_hashmap_concurrent_iter(struct ov_hashmap_concurrent *const hm, size_t *const i, void *const dest);
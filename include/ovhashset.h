@@ -0,0 +1,154 @@
+#pragma once
+
+#include <ovhashmap.h>
+
+/**
+ * @brief Create a hash set of fixed-size keys
+ *
+ * Only the key bytes are stored, so a set of uint64_t ids uses no more memory per entry than
+ * the key itself plus the bucket header. Hashing and probing are the same as ov_hashmap.
+ * Automatically includes debug information for memory tracking.
+ *
+ * @param key_size Size of each key in bytes. Must be greater than 0.
+ * @param cap Initial capacity (will grow as needed). Can be 0 for default capacity.
+ * @return Pointer to created set, or NULL on failure
+ *
+ * @example
+ *   struct ov_hashset *seen = OV_HASHSET_CREATE_STATIC(sizeof(uint64_t), 0);
+ *   if (!OV_HASHSET_CONTAINS(seen, &id, sizeof(id))) {
+ *     OV_HASHSET_INSERT(seen, &id, sizeof(id));
+ *   }
+ */
+#define OV_HASHSET_CREATE_STATIC(key_size, cap) ov_hashset_create_static((key_size), (cap)MEM_FILEPOS_VALUES)
+
+/**
+ * @brief Create a hash set of variable-size keys
+ *
+ * Each entry stores a pointer to the key bytes and their length, not a copy of the bytes.
+ * The memory the keys point to must stay valid while they are in the set; interned strings
+ * from ov_intern are a natural fit.
+ * Automatically includes debug information for memory tracking.
+ *
+ * @param cap Initial capacity (will grow as needed). Can be 0 for default capacity.
+ * @return Pointer to created set, or NULL on failure
+ */
+#define OV_HASHSET_CREATE_DYNAMIC(cap) ov_hashset_create_dynamic((cap)MEM_FILEPOS_VALUES)
+
+/**
+ * @brief Destroy set and free all memory
+ *
+ * @param hsp Pointer to set pointer (will be set to NULL). Must not be NULL.
+ */
+#define OV_HASHSET_DESTROY(hsp) ov_hashset_destroy((hsp)MEM_FILEPOS_VALUES)
+
+/**
+ * @brief Remove all keys from set
+ *
+ * @param hsp Pointer to set. Must not be NULL.
+ */
+#define OV_HASHSET_CLEAR(hsp) ov_hashset_clear(hsp)
+
+/**
+ * @brief Get current number of keys in set
+ *
+ * @param hsp Pointer to set. Can be NULL.
+ * @return Number of keys currently stored, or 0 if hsp is NULL
+ */
+#define OV_HASHSET_COUNT(hsp) ov_hashset_count(hsp)
+
+/**
+ * @brief Insert a key into set
+ *
+ * Inserting a key that is already present leaves the set unchanged.
+ * Automatically includes debug information for memory tracking.
+ *
+ * @param hsp Pointer to set. Must not be NULL.
+ * @param key_ptr Pointer to key bytes. Can be NULL only if key_bytes is 0.
+ * @param key_bytes Length of the key. For fixed-size sets it must equal the key size.
+ * @return true on success, false on memory allocation failure
+ */
+#define OV_HASHSET_INSERT(hsp, key_ptr, key_bytes) ov_hashset_insert((hsp), (key_ptr), (key_bytes)MEM_FILEPOS_VALUES)
+
+/**
+ * @brief Check whether a key is in set
+ *
+ * @param hsp Pointer to set. Must not be NULL.
+ * @param key_ptr Pointer to key bytes. Can be NULL only if key_bytes is 0.
+ * @param key_bytes Length of the key. For fixed-size sets it must equal the key size.
+ * @return true if the key is present
+ */
+#define OV_HASHSET_CONTAINS(hsp, key_ptr, key_bytes) ov_hashset_contains((hsp), (key_ptr), (key_bytes))
+
+/**
+ * @brief Remove a key from set
+ *
+ * @param hsp Pointer to set. Must not be NULL.
+ * @param key_ptr Pointer to key bytes. Can be NULL only if key_bytes is 0.
+ * @param key_bytes Length of the key. For fixed-size sets it must equal the key size.
+ * @return true if the key was present and has been removed
+ */
+#define OV_HASHSET_REMOVE(hsp, key_ptr, key_bytes) ov_hashset_remove((hsp), (key_ptr), (key_bytes))
+
+/**
+ * @brief Iterate over all keys in set
+ *
+ * Initialize iterator to 0. The order is unspecified.
+ *
+ * @param hsp Pointer to set. Must not be NULL.
+ * @param size_t_ptr Pointer to iterator variable (size_t). Must not be NULL.
+ * @param key_ptr_ptr Pointer to const void pointer receiving the key. Must not be NULL.
+ * @param key_bytes_ptr Pointer to size_t receiving the key length. Can be NULL.
+ * @return true if key retrieved, false when iteration complete
+ *
+ * @example
+ *   size_t iter = 0;
+ *   uint64_t const *id;
+ *   while (OV_HASHSET_ITER(seen, &iter, &id, NULL)) {
+ *     printf("%llu\n", (unsigned long long)*id);
+ *   }
+ */
+#define OV_HASHSET_ITER(hsp, size_t_ptr, key_ptr_ptr, key_bytes_ptr)                                                   \
+  ov_hashset_iter((hsp), (size_t_ptr), (void const **)(key_ptr_ptr), (key_bytes_ptr))
+
+/**
+ * @brief Add every key of src to dest
+ *
+ * Both sets must be of the same kind and, for fixed-size sets, the same key size.
+ * dest is sized once for the combined count before inserting.
+ * Automatically includes debug information for memory tracking.
+ *
+ * @param dest_hsp Pointer to set receiving the union. Must not be NULL.
+ * @param src_hsp Pointer to set to merge in. Must not be NULL.
+ * @return true on success, false on memory allocation failure (some keys may have been inserted)
+ */
+#define OV_HASHSET_UNION(dest_hsp, src_hsp) ov_hashset_union((dest_hsp), (src_hsp)MEM_FILEPOS_VALUES)
+
+/**
+ * @brief Remove every key of dest that is not in src
+ *
+ * Both sets must be of the same kind and, for fixed-size sets, the same key size.
+ * Runs in place in a single pass over dest without allocating.
+ *
+ * @param dest_hsp Pointer to set receiving the intersection. Must not be NULL.
+ * @param src_hsp Pointer to set to intersect with. Must not be NULL.
+ * @return Number of keys removed from dest
+ */
+#define OV_HASHSET_INTERSECT(dest_hsp, src_hsp) ov_hashset_intersect((dest_hsp), (src_hsp))
+
+struct ov_hashset;
+
+NODISCARD struct ov_hashset *ov_hashset_create_static(size_t const key_size, size_t const cap MEM_FILEPOS_PARAMS);
+NODISCARD struct ov_hashset *ov_hashset_create_dynamic(size_t const cap MEM_FILEPOS_PARAMS);
+void ov_hashset_destroy(struct ov_hashset **const hsp MEM_FILEPOS_PARAMS);
+void ov_hashset_clear(struct ov_hashset *const hs);
+NODISCARD size_t ov_hashset_count(struct ov_hashset const *const hs);
+NODISCARD bool
+ov_hashset_insert(struct ov_hashset *const hs, void const *const key, size_t const key_bytes MEM_FILEPOS_PARAMS);
+NODISCARD bool ov_hashset_contains(struct ov_hashset const *const hs, void const *const key, size_t const key_bytes);
+bool ov_hashset_remove(struct ov_hashset *const hs, void const *const key, size_t const key_bytes);
+NODISCARD bool ov_hashset_iter(struct ov_hashset const *const hs,
+                               size_t *const i,
+                               void const **const key,
+                               size_t *const key_bytes);
+NODISCARD bool ov_hashset_union(struct ov_hashset *const dest, struct ov_hashset const *const src MEM_FILEPOS_PARAMS);
+size_t ov_hashset_intersect(struct ov_hashset *const dest, struct ov_hashset const *const src);
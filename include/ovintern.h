@@ -0,0 +1,100 @@
+#pragma once
+
+#include <ovbase.h>
+
+/**
+ * @brief Create a string interning table
+ *
+ * Each distinct string is stored once, NUL-terminated, in large arena blocks, and is identified
+ * by a stable pointer and a dense 32-bit id assigned in insertion order starting at 0.
+ * Interned strings are never moved or freed until the table is destroyed, so two interned
+ * strings are equal exactly when their pointers (or ids) are equal, and the id can be used
+ * directly as a hash or as a static hashmap key.
+ * Automatically includes debug information for memory tracking.
+ *
+ * @param thread_safe If true, OV_INTERN and OV_INTERN_FIND may be called from multiple threads.
+ *                    OV_INTERN_STR and OV_INTERN_LEN never take a lock.
+ * @return Pointer to created table, or NULL on failure
+ *
+ * @example
+ *   struct ov_intern *in = OV_INTERN_CREATE(false);
+ *   uint32_t id;
+ *   char const *a = OV_INTERN(in, "hello", 5, &id);
+ *   char const *b = OV_INTERN(in, "hello", 5, NULL);
+ *   // a == b, OV_INTERN_STR(in, id) == a
+ *   OV_INTERN_DESTROY(&in);
+ */
+#define OV_INTERN_CREATE(thread_safe) ov_intern_create((thread_safe)MEM_FILEPOS_VALUES)
+
+/**
+ * @brief Destroy an interning table and free all strings
+ *
+ * @param inp Pointer to table pointer (will be set to NULL). Must not be NULL.
+ */
+#define OV_INTERN_DESTROY(inp) ov_intern_destroy((inp)MEM_FILEPOS_VALUES)
+
+/**
+ * @brief Intern a string
+ *
+ * Returns the existing copy if the string was interned before, otherwise copies it into the arena.
+ * The string may contain NUL bytes; the stored copy is always followed by an extra NUL.
+ * Automatically includes debug information for memory tracking.
+ *
+ * @param inp Pointer to table. Must not be NULL.
+ * @param str Pointer to string bytes. Can be NULL only if len is 0.
+ * @param len Length of string in bytes
+ * @param id_ptr Pointer to uint32_t receiving the id. Can be NULL.
+ * @return Stable pointer to the interned string, or NULL on failure
+ */
+#define OV_INTERN(inp, str, len, id_ptr) ov_intern((inp), (str), (len), (id_ptr)MEM_FILEPOS_VALUES)
+
+/**
+ * @brief Look up a string without interning it
+ *
+ * @param inp Pointer to table. Must not be NULL.
+ * @param str Pointer to string bytes. Can be NULL only if len is 0.
+ * @param len Length of string in bytes
+ * @param id_ptr Pointer to uint32_t receiving the id. Can be NULL.
+ * @return Stable pointer to the interned string, or NULL if it has not been interned
+ */
+#define OV_INTERN_FIND(inp, str, len, id_ptr) ov_intern_find((inp), (str), (len), (id_ptr))
+
+/**
+ * @brief Get the interned string for an id
+ *
+ * @param inp Pointer to table. Must not be NULL.
+ * @param id Id returned by OV_INTERN
+ * @return Stable pointer to the interned string, or NULL if id is out of range
+ */
+#define OV_INTERN_STR(inp, id) ov_intern_str((inp), (id))
+
+/**
+ * @brief Get the length in bytes of the interned string for an id
+ *
+ * @param inp Pointer to table. Must not be NULL.
+ * @param id Id returned by OV_INTERN
+ * @return Length of the string, or 0 if id is out of range
+ */
+#define OV_INTERN_LEN(inp, id) ov_intern_len((inp), (id))
+
+/**
+ * @brief Get number of interned strings
+ *
+ * Ids in the range [0, count) are valid.
+ *
+ * @param inp Pointer to table. Can be NULL.
+ * @return Number of interned strings, or 0 if inp is NULL
+ */
+#define OV_INTERN_COUNT(inp) ov_intern_count(inp)
+
+struct ov_intern;
+
+NODISCARD struct ov_intern *ov_intern_create(bool const thread_safe MEM_FILEPOS_PARAMS);
+void ov_intern_destroy(struct ov_intern **const inp MEM_FILEPOS_PARAMS);
+NODISCARD char const *
+ov_intern(struct ov_intern *const in, char const *const str, size_t const len, uint32_t *const id MEM_FILEPOS_PARAMS);
+NODISCARD char const *
+ov_intern_find(struct ov_intern *const in, char const *const str, size_t const len, uint32_t *const id);
+NODISCARD char const *ov_intern_str(struct ov_intern const *const in, uint32_t const id);
+NODISCARD size_t ov_intern_len(struct ov_intern const *const in, uint32_t const id);
+NODISCARD size_t ov_intern_count(struct ov_intern const *const in);
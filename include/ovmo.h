@@ -8,6 +8,7 @@
 #define pgettext_noop(ctxt, id) (id)
 
 struct mo;
+struct ov_intern;
 
 /**
  * @brief Parse .mo file from memory buffer
@@ -45,6 +46,18 @@ char const *mo_gettext(struct mo const *const mp, char const *const id);
  */
 char const *mo_pgettext(struct mo const *const mp, char const *const ctxt, char const *const id);
 
+/**
+ * @brief Get translated string for an interned message ID
+ *
+ * Uses the length stored with the interned string, so no strlen or strcmp over the id is needed.
+ *
+ * @param mp Pointer to mo structure. Can be NULL.
+ * @param in Interning table that owns id (must not be NULL)
+ * @param id Id returned by OV_INTERN
+ * @return Translated string, the interned id string if not found, or "" if id is not valid
+ */
+char const *mo_gettext_intern(struct mo const *const mp, struct ov_intern const *const in, uint32_t const id);
+
 /**
  * @brief Get translated plural string
  *
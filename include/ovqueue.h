@@ -0,0 +1,145 @@
+#pragma once
+
+#include <ovbase.h>
+
+/**
+ * @brief Create a bounded single-producer single-consumer queue
+ *
+ * A lock-free ring of fixed-size items. The producer and consumer indices live on separate
+ * cache lines, and each side keeps a cached copy of the other side's index, so an
+ * uncontended push or pop touches no shared cache line except the slot itself.
+ * At most one thread may push and at most one thread may pop at any time.
+ * Automatically includes debug information for memory tracking.
+ *
+ * @param item_size Size of each item in bytes. Must be greater than 0.
+ * @param capacity Number of slots, rounded up to a power of two (at least 2)
+ * @param err Pointer to struct ov_error for error information. Can be NULL.
+ * @return Pointer to created queue, or NULL on failure
+ *
+ * @example
+ *   struct ov_spsc_queue *q = OV_SPSC_QUEUE_CREATE(sizeof(struct message), 1024, &err);
+ *   // producer
+ *   if (!ov_spsc_queue_push(q, &msg)) {
+ *     // the queue was closed
+ *   }
+ *   // consumer
+ *   while (ov_spsc_queue_pop(q, &msg)) {
+ *     handle(&msg);
+ *   }
+ */
+#define OV_SPSC_QUEUE_CREATE(item_size, capacity, err)                                                                 \
+  ov_spsc_queue_create((item_size), (capacity), (err)MEM_FILEPOS_VALUES)
+
+/**
+ * @brief Destroy a queue. No thread may be using it.
+ *
+ * @param qp Pointer to queue pointer (will be set to NULL). Must not be NULL.
+ */
+#define OV_SPSC_QUEUE_DESTROY(qp) ov_spsc_queue_destroy((qp)MEM_FILEPOS_VALUES)
+
+NODISCARD struct ov_spsc_queue *
+ov_spsc_queue_create(size_t const item_size, size_t const capacity, struct ov_error *const err MEM_FILEPOS_PARAMS);
+void ov_spsc_queue_destroy(struct ov_spsc_queue **const qp MEM_FILEPOS_PARAMS);
+
+/**
+ * @brief Push an item without blocking
+ *
+ * @param q Pointer to queue. Must not be NULL.
+ * @param item Pointer to the item to copy in. Must not be NULL.
+ * @return true on success, false if the queue is full or closed
+ */
+NODISCARD bool ov_spsc_queue_try_push(struct ov_spsc_queue *const q, void const *const item);
+
+/**
+ * @brief Pop an item without blocking
+ *
+ * @param q Pointer to queue. Must not be NULL.
+ * @param item Receives a copy of the item. Must not be NULL.
+ * @return true on success, false if the queue is empty
+ */
+NODISCARD bool ov_spsc_queue_try_pop(struct ov_spsc_queue *const q, void *const item);
+
+/**
+ * @brief Push an item, waiting while the queue is full
+ *
+ * Spins briefly before sleeping, and only sleeps while the queue is actually full.
+ *
+ * @param q Pointer to queue. Must not be NULL.
+ * @param item Pointer to the item to copy in. Must not be NULL.
+ * @return true on success, false if the queue is closed
+ */
+NODISCARD bool ov_spsc_queue_push(struct ov_spsc_queue *const q, void const *const item);
+
+/**
+ * @brief Pop an item, waiting while the queue is empty
+ *
+ * Items pushed before the queue was closed are still returned.
+ *
+ * @param q Pointer to queue. Must not be NULL.
+ * @param item Receives a copy of the item. Must not be NULL.
+ * @return true on success, false once the queue is closed and empty
+ */
+NODISCARD bool ov_spsc_queue_pop(struct ov_spsc_queue *const q, void *const item);
+
+/**
+ * @brief Close the queue and wake every blocked caller
+ *
+ * Pushes fail from now on; pops drain the remaining items and then fail.
+ *
+ * @param q Pointer to queue. Must not be NULL.
+ */
+void ov_spsc_queue_close(struct ov_spsc_queue *const q);
+
+/**
+ * @brief Create a bounded multi-producer multi-consumer queue
+ *
+ * Dmitry Vyukov's bounded MPMC queue: every slot carries a sequence number that tells
+ * producers and consumers whether it is free or filled for their turn, so each operation
+ * is a single compare-and-swap on the enqueue or dequeue index (each on its own cache line)
+ * plus a copy. Any number of threads may push and pop concurrently.
+ * Items are delivered in FIFO order with respect to the successful claims of the index.
+ * Automatically includes debug information for memory tracking.
+ *
+ * @param item_size Size of each item in bytes. Must be greater than 0.
+ * @param capacity Number of slots, rounded up to a power of two (at least 2)
+ * @param err Pointer to struct ov_error for error information. Can be NULL.
+ * @return Pointer to created queue, or NULL on failure
+ */
+#define OV_MPMC_QUEUE_CREATE(item_size, capacity, err)                                                                 \
+  ov_mpmc_queue_create((item_size), (capacity), (err)MEM_FILEPOS_VALUES)
+
+/**
+ * @brief Destroy a queue. No thread may be using it.
+ *
+ * @param qp Pointer to queue pointer (will be set to NULL). Must not be NULL.
+ */
+#define OV_MPMC_QUEUE_DESTROY(qp) ov_mpmc_queue_destroy((qp)MEM_FILEPOS_VALUES)
+
+NODISCARD struct ov_mpmc_queue *
+ov_mpmc_queue_create(size_t const item_size, size_t const capacity, struct ov_error *const err MEM_FILEPOS_PARAMS);
+void ov_mpmc_queue_destroy(struct ov_mpmc_queue **const qp MEM_FILEPOS_PARAMS);
+
+/**
+ * @brief Push an item without blocking. See ov_spsc_queue_try_push.
+ */
+NODISCARD bool ov_mpmc_queue_try_push(struct ov_mpmc_queue *const q, void const *const item);
+
+/**
+ * @brief Pop an item without blocking. See ov_spsc_queue_try_pop.
+ */
+NODISCARD bool ov_mpmc_queue_try_pop(struct ov_mpmc_queue *const q, void *const item);
+
+/**
+ * @brief Push an item, waiting while the queue is full. See ov_spsc_queue_push.
+ */
+NODISCARD bool ov_mpmc_queue_push(struct ov_mpmc_queue *const q, void const *const item);
+
+/**
+ * @brief Pop an item, waiting while the queue is empty. See ov_spsc_queue_pop.
+ */
+NODISCARD bool ov_mpmc_queue_pop(struct ov_mpmc_queue *const q, void *const item);
+
+/**
+ * @brief Close the queue and wake every blocked caller. See ov_spsc_queue_close.
+ */
+void ov_mpmc_queue_close(struct ov_mpmc_queue *const q);
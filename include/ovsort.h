@@ -1,6 +1,10 @@
 #pragma once
 
+#include <ovbase.h>
+
 #include <stddef.h>
+#include <stdint.h>
+#include <string.h>
 
 /**
  * Sort elements using callback
@@ -9,6 +13,8 @@
  * delegating comparison and swap operations to the provided callbacks. The
  * sort is not stable. The caller can carry arbitrary state through
  * `userdata` to operate on custom containers or multiple arrays.
+ * Ranges that partition badly are finished with heapsort, so even crafted
+ * inputs take O(n log n) comparisons.
  *
  * @param n Number of elements to sort
  * @param compare Comparison callback that returns negative/zero/positive
@@ -42,3 +48,555 @@ void ov_qsort(void *const base,
               size_t const item_size,
               int (*const compare)(void const *const a, void const *const b, void *const userdata),
               void *const userdata);
+
+/**
+ * Sort elements using callback, keeping the order of equal elements
+ *
+ * Adaptive merge sort in the style of TimSort: existing ascending and strictly
+ * descending runs are used as they are, so already or nearly sorted input takes
+ * close to linear time. Merges are done in place through the swap callback, which
+ * costs O(n log^2 n) swaps in the worst case but needs no extra memory.
+ *
+ * @param n Number of elements to sort
+ * @param compare Comparison callback that returns negative/zero/positive
+ *                integer for less/equal/greater
+ * @param swap Swap callback that exchanges elements at the specified indices
+ * @param userdata Opaque pointer forwarded to callbacks for shared context
+ */
+void ov_stable_sort(size_t const n,
+                    int (*const compare)(size_t const idx0, size_t const idx1, void *const userdata),
+                    void (*const swap)(size_t const idx0, size_t const idx1, void *const userdata),
+                    void *const userdata);
+
+/**
+ * Sort array elements with a stable adaptive merge sort
+ *
+ * Same algorithm as ov_stable_sort, for arrays. Merges whose shorter run fits in
+ * the scratch buffer copy that run out and merge back with O(n) moves; the rest
+ * are done in place. A buffer of (n / 2) * item_size bytes is enough for every
+ * merge to use it. No memory is allocated.
+ *
+ * @param base Pointer to the array to be sorted
+ * @param n Number of elements in the array
+ * @param item_size Size in bytes of each element
+ * @param compare Comparison callback that returns negative/zero/positive
+ *                integer for less/equal/greater
+ * @param userdata Opaque pointer forwarded to the comparison callback
+ * @param scratch Scratch buffer, or NULL to merge in place only
+ * @param scratch_bytes Size of the scratch buffer in bytes
+ */
+void ov_stable_qsort(void *const base,
+                     size_t const n,
+                     size_t const item_size,
+                     int (*const compare)(void const *const a, void const *const b, void *const userdata),
+                     void *const userdata,
+                     void *const scratch,
+                     size_t const scratch_bytes);
+
+/**
+ * Partially sort elements so that the element at nth is the one a full sort would put there
+ *
+ * Elements before nth compare less than or equal to it and elements after it compare
+ * greater than or equal, in no particular order. Uses quickselect with median-of-three
+ * pivots; a range that runs out of the 2*log2(n) depth budget is finished with a heap
+ * select, so the expected cost is O(n) and the worst case O(n log n).
+ *
+ * @param n Number of elements
+ * @param nth Index of the element to place, must be less than n
+ * @param compare Comparison callback that returns negative/zero/positive
+ *                integer for less/equal/greater
+ * @param swap Swap callback that exchanges elements at the specified indices
+ * @param userdata Opaque pointer forwarded to callbacks for shared context
+ */
+void ov_nth_element(size_t const n,
+                    size_t const nth,
+                    int (*const compare)(size_t const idx0, size_t const idx1, void *const userdata),
+                    void (*const swap)(size_t const idx0, size_t const idx1, void *const userdata),
+                    void *const userdata);
+
+/**
+ * Sort the k smallest elements into [0, k)
+ *
+ * The remaining elements are left in [k, n) in no particular order. Keeps a max-heap
+ * of the k best elements seen so far while scanning the rest, which takes O(n log k)
+ * comparisons, and then sorts the heap. The sort is not stable.
+ *
+ * @param n Number of elements
+ * @param k Number of elements to select; values above n sort everything
+ * @param compare Comparison callback that returns negative/zero/positive
+ *                integer for less/equal/greater
+ * @param swap Swap callback that exchanges elements at the specified indices
+ * @param userdata Opaque pointer forwarded to callbacks for shared context
+ */
+void ov_partial_sort(size_t const n,
+                     size_t const k,
+                     int (*const compare)(size_t const idx0, size_t const idx1, void *const userdata),
+                     void (*const swap)(size_t const idx0, size_t const idx1, void *const userdata),
+                     void *const userdata);
+
+/**
+ * Streaming top-k accumulator
+ *
+ * Keeps the k items that sort first under compare out of every item pushed, in a
+ * caller-provided buffer of k items. To keep the largest scores, compare in
+ * descending order. Treat the fields as read-only.
+ */
+struct ov_topk {
+  void *items;
+  size_t capacity;
+  size_t count;
+  size_t item_size;
+  int (*compare)(void const *const a, void const *const b, void *const userdata);
+  void *userdata;
+};
+
+/**
+ * Initialize a top-k accumulator
+ *
+ * @param tk Accumulator to initialize
+ * @param buffer Buffer of capacity * item_size bytes that receives the kept items
+ * @param capacity Number of items to keep
+ * @param item_size Size in bytes of each item
+ * @param compare Comparison callback that returns negative/zero/positive
+ *                integer for less/equal/greater
+ * @param userdata Opaque pointer forwarded to the comparison callback
+ *
+ * @example
+ *   struct ov_topk tk;
+ *   ov_topk_init(&tk, best, 100, sizeof(struct scored), compare_score_desc, NULL);
+ *   for (size_t i = 0; i < n; ++i) {
+ *     ov_topk_push(&tk, &items[i]);
+ *   }
+ *   size_t const found = ov_topk_finish(&tk); // best[0..found) sorted by score
+ */
+void ov_topk_init(struct ov_topk *const tk,
+                  void *const buffer,
+                  size_t const capacity,
+                  size_t const item_size,
+                  int (*const compare)(void const *const a, void const *const b, void *const userdata),
+                  void *const userdata);
+
+/**
+ * Offer an item to a top-k accumulator
+ *
+ * O(log k) when the item is kept, a single comparison when it is not.
+ *
+ * @param tk Accumulator
+ * @param item Item to copy into the buffer if it is among the best k so far
+ * @return true if the item was kept
+ */
+bool ov_topk_push(struct ov_topk *const tk, void const *const item);
+
+/**
+ * Get the kept item that sorts last
+ *
+ * Once the accumulator is full, items that do not sort before this one are rejected,
+ * so callers can skip building them.
+ *
+ * @param tk Accumulator
+ * @return Pointer to the item in the buffer, or NULL while fewer than k items are kept
+ */
+void const *ov_topk_threshold(struct ov_topk const *const tk);
+
+/**
+ * Sort the kept items in the buffer and empty the accumulator
+ *
+ * @param tk Accumulator
+ * @return Number of items sorted at the start of the buffer
+ */
+size_t ov_topk_finish(struct ov_topk *const tk);
+
+/**
+ * Compute the permutation that sorts an array, without moving its elements
+ *
+ * Fills perm so that base[perm[0]], base[perm[1]], ... is in sorted order. Only the
+ * index array is moved while sorting, which saves most of the memory traffic when
+ * items are much larger than an index. Items are compared in random order though, so
+ * for records of a few cache lines or less, sorting them directly with ov_qsort is
+ * usually faster. Equal items keep their original order.
+ * Use ov_apply_permutation to rearrange the array, and any parallel arrays, afterwards.
+ *
+ * @param perm Array of n indices receiving the permutation
+ * @param n Number of elements in the array
+ * @param base Pointer to the array to be sorted
+ * @param item_size Size in bytes of each element
+ * @param compare Comparison callback that returns negative/zero/positive
+ *                integer for less/equal/greater
+ * @param userdata Opaque pointer forwarded to the comparison callback
+ */
+void ov_argsort(size_t *const perm,
+                size_t const n,
+                void const *const base,
+                size_t const item_size,
+                int (*const compare)(void const *const a, void const *const b, void *const userdata),
+                void *const userdata);
+
+/**
+ * Same as ov_argsort with 32-bit indices, which halves the size of the index array
+ *
+ * n must not exceed UINT32_MAX.
+ */
+void ov_argsort_u32(uint32_t *const perm,
+                    size_t const n,
+                    void const *const base,
+                    size_t const item_size,
+                    int (*const compare)(void const *const a, void const *const b, void *const userdata),
+                    void *const userdata);
+
+struct ov_permute_array {
+  void *base;
+  size_t item_size;
+};
+
+/**
+ * Rearrange arrays in place so that element i becomes the former element perm[i]
+ *
+ * All arrays are rearranged in a single pass that follows each cycle of the
+ * permutation once, copying each item once. If one item of every array together
+ * exceeds 4096 bytes, items are swapped along the cycle instead. No memory is
+ * allocated. perm is used to mark visited positions and is the identity permutation
+ * on return.
+ *
+ * @param perm Permutation of [0, n), for example from ov_argsort
+ * @param n Number of elements in each array
+ * @param arrays Arrays to rearrange
+ * @param narrays Number of arrays
+ *
+ * @example
+ *   ov_argsort(perm, n, records, sizeof(*records), compare_records, NULL);
+ *   ov_apply_permutation(perm, n, (struct ov_permute_array[]){
+ *       {records, sizeof(*records)},
+ *       {ids, sizeof(*ids)},
+ *   }, 2);
+ */
+void ov_apply_permutation(size_t *const perm,
+                          size_t const n,
+                          struct ov_permute_array const *const arrays,
+                          size_t const narrays);
+
+/**
+ * Same as ov_apply_permutation with 32-bit indices
+ */
+void ov_apply_permutation_u32(uint32_t *const perm,
+                              size_t const n,
+                              struct ov_permute_array const *const arrays,
+                              size_t const narrays);
+
+/**
+ * Run tasks [0, ntasks) and return when all of them have completed
+ *
+ * Lets ov_parallel_qsort run on a caller-provided worker pool. Tasks are independent
+ * and may run in any order on any thread, including the calling one.
+ *
+ * @param ntasks Number of tasks
+ * @param task Function to call once for each task index
+ * @param userdata Opaque pointer to pass to task
+ * @param executor ov_parallel_qsort_options.executor
+ */
+typedef void (*ov_parallel_run_func)(size_t const ntasks,
+                                     void (*const task)(size_t const index, void *const userdata),
+                                     void *const userdata,
+                                     void *const executor);
+
+struct ov_parallel_qsort_options {
+  /** Number of threads to use, or 0 for the number of online processors. Capped at 256. */
+  size_t threads;
+  /** Arrays shorter than this are sorted with ov_qsort on the calling thread, 0 selects the default (65536). */
+  size_t serial_threshold;
+  /** Function that runs tasks on a worker pool, or NULL to start threads for each phase. */
+  ov_parallel_run_func run;
+  /** Opaque pointer passed to run. */
+  void *executor;
+};
+
+/**
+ * Sort array elements on multiple threads
+ *
+ * Splits the array into one part per thread, sorts the parts concurrently with
+ * ov_qsort and merges the sorted runs pairwise. Each merge is split across all
+ * threads by binary searching the split points of both runs, so the merge rounds
+ * scale as well as the first phase. Needs n * item_size bytes of scratch memory;
+ * if that cannot be allocated the array is sorted on the calling thread instead.
+ * The sort is not stable, and compare is called from several threads at once.
+ * Automatically includes debug information for memory tracking.
+ *
+ * @param base Pointer to the array to be sorted
+ * @param n Number of elements in the array
+ * @param item_size Size in bytes of each element
+ * @param compare Comparison callback that returns negative/zero/positive
+ *                integer for less/equal/greater
+ * @param userdata Opaque pointer forwarded to the comparison callback
+ * @param options Pointer to struct ov_parallel_qsort_options, or NULL for defaults
+ *
+ * @example
+ *   OV_PARALLEL_QSORT(records, n, sizeof(struct record), compare_records, NULL, NULL);
+ */
+#define OV_PARALLEL_QSORT(base, n, item_size, compare, userdata, options)                                              \
+  ov_parallel_qsort((base), (n), (item_size), (compare), (userdata), (options)MEM_FILEPOS_VALUES)
+
+void ov_parallel_qsort(void *const base,
+                       size_t const n,
+                       size_t const item_size,
+                       int (*const compare)(void const *const a, void const *const b, void *const userdata),
+                       void *const userdata,
+                       struct ov_parallel_qsort_options const *const options MEM_FILEPOS_PARAMS);
+
+/**
+ * Sort unsigned, signed or IEEE floating point keys with a radix sort
+ *
+ * With a scratch buffer of n elements the sort is LSD and stable: a single read pass
+ * builds the histograms of every 8-bit digit, then each digit costs one scatter pass
+ * unless it has the same value in all keys, in which case the pass is skipped.
+ * Without a scratch buffer the sort is MSD in place (American flag sort), which needs
+ * no extra memory but is not stable. No memory is allocated in either case.
+ *
+ * Floats are ordered by their bit patterns: -0.0 sorts before +0.0, and NaNs sort
+ * after +infinity or before -infinity depending on their sign bit.
+ *
+ * @param data Pointer to the array to be sorted
+ * @param n Number of elements in the array
+ * @param scratch Scratch buffer of n elements, or NULL to sort in place
+ */
+void ov_radix_sort_u32(uint32_t *const data, size_t const n, uint32_t *const scratch);
+void ov_radix_sort_u64(uint64_t *const data, size_t const n, uint64_t *const scratch);
+void ov_radix_sort_i32(int32_t *const data, size_t const n, int32_t *const scratch);
+void ov_radix_sort_i64(int64_t *const data, size_t const n, int64_t *const scratch);
+void ov_radix_sort_f32(float *const data, size_t const n, float *const scratch);
+void ov_radix_sort_f64(double *const data, size_t const n, double *const scratch);
+
+/**
+ * Sort records by an unsigned 64-bit key with a radix sort
+ *
+ * Same algorithm as ov_radix_sort_u64. The key callback is called once per record for
+ * the histograms and again for each pass that is not skipped, so it should be cheap;
+ * keys that only use the low bits skip the passes of the high digits.
+ * Use ov_radix_key_i64 and ov_radix_key_f64 to turn signed or floating point fields
+ * into keys with the same order.
+ *
+ * @param base Pointer to the array to be sorted
+ * @param n Number of elements in the array
+ * @param item_size Size in bytes of each element
+ * @param key Callback that returns the key of an element
+ * @param userdata Opaque pointer forwarded to the key callback
+ * @param scratch Scratch buffer of n * item_size bytes, or NULL to sort in place
+ *
+ * @example
+ *   static uint64_t record_key(void const *const item, void *const userdata) {
+ *     (void)userdata;
+ *     return ov_radix_key_f64(((struct record const *)item)->score);
+ *   }
+ *   ov_radix_sort_records(records, n, sizeof(struct record), record_key, NULL, scratch);
+ */
+void ov_radix_sort_records(void *const base,
+                           size_t const n,
+                           size_t const item_size,
+                           uint64_t (*const key)(void const *const item, void *const userdata),
+                           void *const userdata,
+                           void *const scratch);
+
+/**
+ * Map a signed integer to an unsigned key with the same order
+ */
+static inline uint64_t ov_radix_key_i64(int64_t const v) { return (uint64_t)v ^ UINT64_C(0x8000000000000000); }
+
+/**
+ * Map a double to an unsigned key with the same order as ov_radix_sort_f64
+ */
+static inline uint64_t ov_radix_key_f64(double const v) {
+  uint64_t u;
+  memcpy(&u, &v, sizeof(u));
+  return (u & UINT64_C(0x8000000000000000)) ? ~u : u | UINT64_C(0x8000000000000000);
+}
+
+/**
+ * Sort up to 32 scalar keys with a sorting network
+ *
+ * Runs a fixed bitonic network whose compare-exchanges are branchless, so the running
+ * time does not depend on the data and nothing is mispredicted. The stages run in explicit
+ * SSE2 or NEON min/max kernels where the target has them, and in a scalar loop otherwise;
+ * both give the same result. Faster than insertion sort from a handful of unsorted
+ * elements on, which matters when sorting many tiny groups. Floats compare with `<`,
+ * except that NaNs sort after every number.
+ *
+ * @param data Pointer to the array to be sorted
+ * @param n Number of elements, at most 32
+ */
+void ov_sort_network_i32(int32_t *const data, size_t const n);
+void ov_sort_network_u32(uint32_t *const data, size_t const n);
+void ov_sort_network_i64(int64_t *const data, size_t const n);
+void ov_sort_network_u64(uint64_t *const data, size_t const n);
+void ov_sort_network_f32(float *const data, size_t const n);
+void ov_sort_network_f64(double *const data, size_t const n);
+
+/**
+ * Sort scalar keys
+ *
+ * The introsort of OV_SORT_DEFINE with the matching ov_sort_network_* as the base case
+ * for ranges of up to 32 elements. Floats are ordered as in ov_sort_network_f32.
+ * The sort is not stable.
+ *
+ * @param data Pointer to the array to be sorted
+ * @param n Number of elements in the array
+ */
+void ov_sort_i32(int32_t *const data, size_t const n);
+void ov_sort_u32(uint32_t *const data, size_t const n);
+void ov_sort_i64(int64_t *const data, size_t const n);
+void ov_sort_u64(uint64_t *const data, size_t const n);
+void ov_sort_f32(float *const data, size_t const n);
+void ov_sort_f64(double *const data, size_t const n);
+
+/**
+ * Define a sort function specialized for one element type
+ *
+ * Expands to `static inline void name(T *const base, size_t const n)`, an introsort like
+ * ov_sort: median-of-three quicksort, insertion sort for short ranges and heapsort for
+ * ranges that exceed the 2*log2(n) depth budget, so the worst case is O(n log n).
+ * Unlike ov_qsort, the comparison is expanded inline and elements are moved as T, so there
+ * are no calls through function pointers and no byte-wise swaps. The sort is not stable.
+ * Partitioning puts the median of three in front and behind the range as sentinels, so the
+ * inner scans need no bounds checks. The larger part is deferred while the smaller one is
+ * sorted first, which keeps the explicit stack below log2(n) entries.
+ *
+ * @param name Name of the function to define
+ * @param T Element type
+ * @param less Function or function-like macro taking two `T const *` and returning
+ *             nonzero if the first element must come before the second
+ *
+ * @example
+ *   #define record_less(a, b) ((a)->key < (b)->key)
+ *   OV_SORT_DEFINE(sort_records, struct record, record_less)
+ *
+ *   sort_records(records, n);
+ */
+#define OV_SORT_DEFINE(name, T, less)                                                                                  \
+  static inline void name##_insertion(T *const base, size_t const n) {                                                 \
+    for (size_t i = 1; i < n; ++i) {                                                                                   \
+      T const v = base[i];                                                                                             \
+      size_t j = i;                                                                                                    \
+      while (j > 0 && less(&v, &base[j - 1])) {                                                                        \
+        base[j] = base[j - 1];                                                                                         \
+        --j;                                                                                                           \
+      }                                                                                                                \
+      base[j] = v;                                                                                                     \
+    }                                                                                                                  \
+  }                                                                                                                    \
+  OV_SORT_DEFINE_BASE(name, T, less, name##_insertion, 16)
+
+/**
+ * Define a sort function specialized for one element type with a custom base case
+ *
+ * Same as OV_SORT_DEFINE, but ranges of at most threshold elements are finished by
+ * base_sort instead of insertion sort. Use it to plug in a sorting network such as
+ * ov_sort_network_i32 for scalar keys.
+ *
+ * @param name Name of the function to define
+ * @param T Element type
+ * @param less Function or function-like macro taking two `T const *` and returning
+ *             nonzero if the first element must come before the second
+ * @param base_sort Function taking `T *const base, size_t const n` that sorts up to
+ *                  threshold elements in the same order as less
+ * @param threshold Largest range passed to base_sort, at least 3
+ */
+#define OV_SORT_DEFINE_BASE(name, T, less, base_sort, threshold)                                                       \
+  static inline void name##_swap(T *const a, T *const b) {                                                             \
+    T const tmp = *a;                                                                                                  \
+    *a = *b;                                                                                                           \
+    *b = tmp;                                                                                                          \
+  }                                                                                                                    \
+  static inline void name##_sift_down(T *const base, size_t root, size_t const n) {                                    \
+    for (;;) {                                                                                                         \
+      size_t child = root * 2 + 1;                                                                                     \
+      if (child >= n) {                                                                                                \
+        return;                                                                                                        \
+      }                                                                                                                \
+      if (child + 1 < n && less(&base[child], &base[child + 1])) {                                                     \
+        ++child;                                                                                                       \
+      }                                                                                                                \
+      if (!less(&base[root], &base[child])) {                                                                          \
+        return;                                                                                                        \
+      }                                                                                                                \
+      name##_swap(&base[root], &base[child]);                                                                          \
+      root = child;                                                                                                    \
+    }                                                                                                                  \
+  }                                                                                                                    \
+  static inline void name##_heapsort(T *const base, size_t const n) {                                                  \
+    for (size_t i = n / 2; i-- > 0;) {                                                                                 \
+      name##_sift_down(base, i, n);                                                                                    \
+    }                                                                                                                  \
+    for (size_t i = n - 1; i > 0; --i) {                                                                               \
+      name##_swap(&base[0], &base[i]);                                                                                 \
+      name##_sift_down(base, 0, i);                                                                                    \
+    }                                                                                                                  \
+  }                                                                                                                    \
+  static inline size_t name##_partition(T *const base, size_t const n) {                                               \
+    size_t const mid = n / 2;                                                                                          \
+    if (less(&base[mid], &base[0])) {                                                                                  \
+      name##_swap(&base[mid], &base[0]);                                                                               \
+    }                                                                                                                  \
+    if (less(&base[n - 1], &base[mid])) {                                                                              \
+      name##_swap(&base[n - 1], &base[mid]);                                                                           \
+      if (less(&base[mid], &base[0])) {                                                                                \
+        name##_swap(&base[mid], &base[0]);                                                                             \
+      }                                                                                                                \
+    }                                                                                                                  \
+    T const pivot = base[mid];                                                                                         \
+    size_t i = 0;                                                                                                      \
+    size_t j = n - 1;                                                                                                  \
+    for (;;) {                                                                                                         \
+      do {                                                                                                             \
+        ++i;                                                                                                           \
+      } while (less(&base[i], &pivot));                                                                                \
+      do {                                                                                                             \
+        --j;                                                                                                           \
+      } while (less(&pivot, &base[j]));                                                                                \
+      if (i >= j) {                                                                                                    \
+        return j + 1;                                                                                                  \
+      }                                                                                                                \
+      name##_swap(&base[i], &base[j]);                                                                                 \
+    }                                                                                                                  \
+  }                                                                                                                    \
+  static inline void name(T *const base, size_t const n) {                                                             \
+    enum { name##_base_threshold = (threshold) };                                                                      \
+    size_t stack_begin[sizeof(size_t) * 8];                                                                            \
+    size_t stack_end[sizeof(size_t) * 8];                                                                              \
+    size_t stack_budget[sizeof(size_t) * 8];                                                                           \
+    size_t depth = 0;                                                                                                  \
+    size_t begin = 0;                                                                                                  \
+    size_t end = n;                                                                                                    \
+    size_t budget = 0;                                                                                                 \
+    if (!base || n < 2) {                                                                                              \
+      return;                                                                                                          \
+    }                                                                                                                  \
+    for (size_t m = n; m >>= 1;) {                                                                                     \
+      budget += 2;                                                                                                     \
+    }                                                                                                                  \
+    for (;;) {                                                                                                         \
+      while (end - begin > name##_base_threshold) {                                                                    \
+        if (budget == 0) {                                                                                             \
+          name##_heapsort(base + begin, end - begin);                                                                  \
+          begin = end;                                                                                                 \
+          break;                                                                                                       \
+        }                                                                                                              \
+        --budget;                                                                                                      \
+        size_t const mid = begin + name##_partition(base + begin, end - begin);                                        \
+        stack_budget[depth] = budget;                                                                                  \
+        if (mid - begin < end - mid) {                                                                                 \
+          stack_begin[depth] = mid;                                                                                    \
+          stack_end[depth++] = end;                                                                                    \
+          end = mid;                                                                                                   \
+        } else {                                                                                                       \
+          stack_begin[depth] = begin;                                                                                  \
+          stack_end[depth++] = mid;                                                                                    \
+          begin = mid;                                                                                                 \
+        }                                                                                                              \
+      }                                                                                                                \
+      base_sort(base + begin, end - begin);                                                                            \
+      if (depth == 0) {                                                                                                \
+        return;                                                                                                        \
+      }                                                                                                                \
+      --depth;                                                                                                         \
+      begin = stack_begin[depth];                                                                                      \
+      end = stack_end[depth];                                                                                          \
+      budget = stack_budget[depth];                                                                                    \
+    }                                                                                                                  \
+  }
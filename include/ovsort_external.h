@@ -0,0 +1,132 @@
+#pragma once
+
+#include <ovbase.h>
+
+/**
+ * @brief Callback receiving the merged output of ov_external_sort_finish, one item at a time
+ *
+ * @param item Next item in sorted order, valid only during the call
+ * @param userdata Opaque pointer passed to OV_EXTERNAL_SORT_FINISH
+ * @return true to continue, false to stop the merge
+ */
+typedef bool (*ov_external_sort_output_func)(void const *const item, void *const userdata);
+
+struct ov_external_sort_options {
+  /** Size of each item. Must be greater than 0. */
+  size_t item_size;
+  /** Comparison callback that returns negative/zero/positive integer for less/equal/greater. */
+  int (*compare)(void const *const a, void const *const b, void *const userdata);
+  /** Opaque pointer forwarded to compare. */
+  void *userdata;
+  /**
+   * Memory used for sorting runs and for the merge buffers, in bytes. 0 selects the default (64 MiB, 4 MiB on WASI).
+   * The budget is raised to hold at least 16 items.
+   */
+  size_t memory_budget;
+  /**
+   * Directory for temporary files, or NULL for TMPDIR (GetTempPathW on Windows) or /tmp.
+   * The string is not copied and must outlive the sorter.
+   */
+  NATIVE_CHAR const *temp_dir;
+};
+
+struct ov_external_sort_stats {
+  /** Items added since the last finish. */
+  uint64_t items;
+  /** Sorted runs written to temporary files. */
+  size_t runs;
+  /** Merge passes that wrote intermediate runs back to disk during the last finish. */
+  size_t intermediate_passes;
+  /** Bytes written to temporary files. */
+  uint64_t bytes_written;
+};
+
+/**
+ * @brief Create an external sorter for data sets larger than memory
+ *
+ * Items are collected in a buffer of the memory budget. Each time it fills up it is
+ * sorted with ov_qsort and written to a temporary file as a sorted run. Finishing
+ * merges all runs with a loser tree, reading each run through its own block of the
+ * buffer, and streams the result to a callback. When there are more runs than blocks
+ * that fit in the budget, groups of runs are first merged into longer runs on disk.
+ * Temporary files are deleted as soon as they are created, so nothing is left behind
+ * if the process dies. On WASI only inputs that fit in the budget can be sorted.
+ * Automatically includes debug information for memory tracking.
+ *
+ * @param options_ptr Pointer to struct ov_external_sort_options. Must not be NULL.
+ * @param err Pointer to struct ov_error for error information. Can be NULL.
+ * @return Pointer to created sorter, or NULL on failure
+ *
+ * @example
+ *   struct ov_external_sort *es = OV_EXTERNAL_SORT_CREATE(&((struct ov_external_sort_options){
+ *       .item_size = sizeof(struct log_record),
+ *       .compare = compare_records,
+ *       .memory_budget = 256 * 1024 * 1024,
+ *   }), &err);
+ *   while (read_records(buf, &n)) {
+ *     if (!OV_EXTERNAL_SORT_ADD(es, buf, n, &err)) {
+ *       goto cleanup;
+ *     }
+ *   }
+ *   if (!OV_EXTERNAL_SORT_FINISH(es, write_record, out, &err)) {
+ *     goto cleanup;
+ *   }
+ *   OV_EXTERNAL_SORT_DESTROY(&es);
+ */
+#define OV_EXTERNAL_SORT_CREATE(options_ptr, err) ov_external_sort_create((options_ptr), (err)MEM_FILEPOS_VALUES)
+
+/**
+ * @brief Destroy an external sorter and delete its temporary files
+ *
+ * @param esp Pointer to sorter pointer (will be set to NULL). Must not be NULL.
+ */
+#define OV_EXTERNAL_SORT_DESTROY(esp) ov_external_sort_destroy((esp)MEM_FILEPOS_VALUES)
+
+/**
+ * @brief Add items, writing a sorted run to disk whenever the buffer fills up
+ *
+ * Automatically includes debug information for memory tracking.
+ *
+ * @param es Pointer to sorter. Must not be NULL.
+ * @param items Pointer to n items. Can be NULL if n is 0.
+ * @param n Number of items
+ * @param err Pointer to struct ov_error for error information. Can be NULL.
+ * @return true on success, false on I/O or memory error
+ */
+#define OV_EXTERNAL_SORT_ADD(es, items, n, err) ov_external_sort_add((es), (items), (n), (err)MEM_FILEPOS_VALUES)
+
+/**
+ * @brief Merge everything added so far and stream it in sorted order
+ *
+ * The sorter is empty afterwards and can be reused, also when the merge failed or
+ * was stopped by the callback. The sort is not stable.
+ * Automatically includes debug information for memory tracking.
+ *
+ * @param es Pointer to sorter. Must not be NULL.
+ * @param output Callback receiving each item. Must not be NULL.
+ * @param userdata Opaque pointer forwarded to output
+ * @param err Pointer to struct ov_error for error information. Can be NULL.
+ * @return true on success, false on I/O or memory error, or with ov_error_generic_abort if output returned false
+ */
+#define OV_EXTERNAL_SORT_FINISH(es, output, userdata, err)                                                             \
+  ov_external_sort_finish((es), (output), (userdata), (err)MEM_FILEPOS_VALUES)
+
+NODISCARD struct ov_external_sort *ov_external_sort_create(struct ov_external_sort_options const *const options,
+                                                           struct ov_error *const err MEM_FILEPOS_PARAMS);
+void ov_external_sort_destroy(struct ov_external_sort **const esp MEM_FILEPOS_PARAMS);
+NODISCARD bool ov_external_sort_add(struct ov_external_sort *const es,
+                                    void const *const items,
+                                    size_t const n,
+                                    struct ov_error *const err MEM_FILEPOS_PARAMS);
+NODISCARD bool ov_external_sort_finish(struct ov_external_sort *const es,
+                                       ov_external_sort_output_func const output,
+                                       void *const userdata,
+                                       struct ov_error *const err MEM_FILEPOS_PARAMS);
+
+/**
+ * @brief Get counters of the current or last sort
+ *
+ * @param es Pointer to sorter. Must not be NULL.
+ * @param stats Pointer receiving the counters. Must not be NULL.
+ */
+void ov_external_sort_get_stats(struct ov_external_sort const *const es, struct ov_external_sort_stats *const stats);
@@ -0,0 +1,295 @@
+#pragma once
+
+#include <ovbase.h>
+#include <ovthreads.h>
+
+#include <stdatomic.h>
+
+// Waiters park on a futex on Linux. Elsewhere every primitive carries a mutex and a condition
+// variable that emulate it; waking through either only happens when a waiter has actually parked.
+#if defined(__linux__) && !defined(__EMSCRIPTEN__)
+#  define OV_SYNC_FUTEX 1
+#endif
+
+struct ov_sync_fallback {
+  mtx_t mtx;
+  cnd_t cnd;
+};
+
+/**
+ * @brief Contention counters of a lock
+ *
+ * Only the slow path updates the counters, so an uncontended acquisition costs nothing extra.
+ * The values are sampled with relaxed loads and are meant for profiling, not for synchronization.
+ */
+struct ov_lock_stats {
+  /** Acquisitions that could not take the lock on the first attempt. */
+  uint64_t contended;
+  /** Backoff rounds spent waiting by those acquisitions. */
+  uint64_t spins;
+  /** Number of times a waiter went to sleep. Always 0 for ov_spinlock. */
+  uint64_t parks;
+};
+
+struct ov_lock_counters {
+  atomic_uint_least64_t contended;
+  atomic_uint_least64_t spins;
+  atomic_uint_least64_t parks;
+};
+
+/**
+ * @brief Test-and-test-and-set spinlock with exponential backoff
+ *
+ * Waiters spin on a plain load, which stays in their own cache, and only attempt the atomic
+ * exchange once the lock looks free. Each failed attempt doubles the number of pause
+ * instructions before the next look, up to a limit after which the waiter yields its time slice.
+ * Suitable for critical sections of a few dozen instructions; anything that can block
+ * belongs under ov_adaptive_mutex instead.
+ *
+ * @example
+ *   struct ov_spinlock lock;
+ *   ov_spinlock_init(&lock);
+ *   ov_spinlock_lock(&lock);
+ *   ++shared_counter;
+ *   ov_spinlock_unlock(&lock);
+ */
+struct ov_spinlock {
+  atomic_bool locked;
+  struct ov_lock_counters counters;
+};
+
+void ov_spinlock_init(struct ov_spinlock *const sl);
+void ov_spinlock_lock(struct ov_spinlock *const sl);
+NODISCARD bool ov_spinlock_try_lock(struct ov_spinlock *const sl);
+void ov_spinlock_unlock(struct ov_spinlock *const sl);
+void ov_spinlock_get_stats(struct ov_spinlock *const sl, struct ov_lock_stats *const stats);
+
+/**
+ * @brief Mutex that spins briefly before parking
+ *
+ * Lock state is a single atomic word, so an uncontended lock and unlock are one atomic
+ * operation each and never touch the kernel. A contended lock first spins; the spin budget
+ * adapts to how long recent acquisitions actually had to wait, and is 0 on single-processor
+ * machines where spinning only delays the owner. After that the waiter parks, and unlock
+ * only wakes someone when a waiter is known to be parked.
+ */
+struct ov_adaptive_mutex {
+  atomic_uint state;
+  atomic_uint spin_budget;
+  unsigned int max_spins;
+#ifndef OV_SYNC_FUTEX
+  struct ov_sync_fallback fallback;
+#endif
+  struct ov_lock_counters counters;
+};
+
+/**
+ * @brief Initialize an adaptive mutex
+ *
+ * @param m Pointer to mutex. Must not be NULL.
+ * @param err Pointer to struct ov_error for error information. Can be NULL.
+ * @return true on success, false if the parking primitives could not be created
+ */
+NODISCARD bool ov_adaptive_mutex_init(struct ov_adaptive_mutex *const m, struct ov_error *const err);
+void ov_adaptive_mutex_exit(struct ov_adaptive_mutex *const m);
+void ov_adaptive_mutex_lock(struct ov_adaptive_mutex *const m);
+NODISCARD bool ov_adaptive_mutex_try_lock(struct ov_adaptive_mutex *const m);
+void ov_adaptive_mutex_unlock(struct ov_adaptive_mutex *const m);
+void ov_adaptive_mutex_get_stats(struct ov_adaptive_mutex *const m, struct ov_lock_stats *const stats);
+
+/**
+ * @brief Writer-preferring reader-writer lock
+ *
+ * Any number of readers can hold the lock together; an uncontended read lock or unlock is a
+ * single atomic operation on a shared word. As soon as a writer is waiting, new readers
+ * queue up behind it, so a steady stream of readers cannot starve writers. Waiters spin
+ * briefly and then park. Neither side is recursive, and a read lock cannot be upgraded.
+ *
+ * @example
+ *   ov_rwlock_read_lock(&cfg_lock);
+ *   value = lookup(cfg, key);
+ *   ov_rwlock_read_unlock(&cfg_lock);
+ *
+ *   ov_rwlock_write_lock(&cfg_lock);
+ *   reload(cfg);
+ *   ov_rwlock_write_unlock(&cfg_lock);
+ */
+struct ov_rwlock {
+  atomic_uint state;
+  size_t writers_waiting;
+  mtx_t mtx;
+  cnd_t readers;
+  cnd_t writers;
+  struct ov_lock_counters read_counters;
+  struct ov_lock_counters write_counters;
+};
+
+/**
+ * @brief Initialize a reader-writer lock
+ *
+ * @param rw Pointer to lock. Must not be NULL.
+ * @param err Pointer to struct ov_error for error information. Can be NULL.
+ * @return true on success, false if the parking primitives could not be created
+ */
+NODISCARD bool ov_rwlock_init(struct ov_rwlock *const rw, struct ov_error *const err);
+void ov_rwlock_exit(struct ov_rwlock *const rw);
+void ov_rwlock_read_lock(struct ov_rwlock *const rw);
+NODISCARD bool ov_rwlock_try_read_lock(struct ov_rwlock *const rw);
+void ov_rwlock_read_unlock(struct ov_rwlock *const rw);
+void ov_rwlock_write_lock(struct ov_rwlock *const rw);
+NODISCARD bool ov_rwlock_try_write_lock(struct ov_rwlock *const rw);
+void ov_rwlock_write_unlock(struct ov_rwlock *const rw);
+
+/**
+ * @brief Get the contention counters of a reader-writer lock
+ *
+ * @param rw Pointer to lock. Must not be NULL.
+ * @param read_stats Receives the counters of the read side. Can be NULL.
+ * @param write_stats Receives the counters of the write side. Can be NULL.
+ */
+void ov_rwlock_get_stats(struct ov_rwlock *const rw,
+                         struct ov_lock_stats *const read_stats,
+                         struct ov_lock_stats *const write_stats);
+
+/**
+ * @brief Manual-reset event
+ *
+ * Lighter than a cndvar for one-shot signals such as "initialization finished" or "stop":
+ * the state is one atomic word, waiters spin briefly before parking, and ov_event_set only
+ * makes a syscall when a waiter has actually gone to sleep.
+ *
+ * @example
+ *   // worker
+ *   ov_event_wait(&ready);
+ *   // main thread
+ *   ov_event_set(&ready);
+ */
+struct ov_event {
+  atomic_uint state;
+#ifndef OV_SYNC_FUTEX
+  struct ov_sync_fallback fallback;
+#endif
+};
+
+/**
+ * @brief Initialize an event
+ *
+ * @param ev Pointer to event. Must not be NULL.
+ * @param set Initial state
+ * @param err Pointer to struct ov_error for error information. Can be NULL.
+ * @return true on success, false if the parking primitives could not be created
+ */
+NODISCARD bool ov_event_init(struct ov_event *const ev, bool const set, struct ov_error *const err);
+void ov_event_exit(struct ov_event *const ev);
+
+/**
+ * @brief Set the event and release every waiter. Setting a set event has no effect.
+ */
+void ov_event_set(struct ov_event *const ev);
+
+/**
+ * @brief Clear the event so that following waits block again
+ */
+void ov_event_reset(struct ov_event *const ev);
+
+/**
+ * @brief Check whether the event is set without blocking
+ */
+NODISCARD bool ov_event_is_set(struct ov_event *const ev);
+
+/**
+ * @brief Block until the event is set
+ */
+void ov_event_wait(struct ov_event *const ev);
+
+/**
+ * @brief Counting semaphore
+ *
+ * ov_semaphore_wait takes one unit, spinning briefly and then parking while the count is 0.
+ * ov_semaphore_post only makes a syscall when a waiter has gone to sleep.
+ */
+struct ov_semaphore {
+  atomic_uint count;
+  atomic_uint waiters;
+#ifndef OV_SYNC_FUTEX
+  struct ov_sync_fallback fallback;
+#endif
+};
+
+/**
+ * @brief Initialize a semaphore
+ *
+ * @param sem Pointer to semaphore. Must not be NULL.
+ * @param count Initial count
+ * @param err Pointer to struct ov_error for error information. Can be NULL.
+ * @return true on success, false if the parking primitives could not be created
+ */
+NODISCARD bool ov_semaphore_init(struct ov_semaphore *const sem, unsigned int const count, struct ov_error *const err);
+void ov_semaphore_exit(struct ov_semaphore *const sem);
+
+/**
+ * @brief Add n units and wake up to n waiters
+ */
+void ov_semaphore_post(struct ov_semaphore *const sem, unsigned int const n);
+
+/**
+ * @brief Take one unit if available
+ *
+ * @return true if a unit was taken, false if the count was 0
+ */
+NODISCARD bool ov_semaphore_try_wait(struct ov_semaphore *const sem);
+
+/**
+ * @brief Take one unit, blocking while the count is 0
+ */
+void ov_semaphore_wait(struct ov_semaphore *const sem);
+
+/**
+ * @brief Wait group for a dynamic set of jobs
+ *
+ * ov_waitgroup_add registers jobs, each job calls ov_waitgroup_done when it finishes, and
+ * ov_waitgroup_wait blocks until the count drops to 0. Only the ov_waitgroup_done that brings
+ * the count to 0 with a sleeping waiter makes a syscall. A group can be reused once wait has
+ * returned, but jobs must not be added while another thread is still waiting for 0.
+ * The last ov_waitgroup_done may still be returning when ov_waitgroup_wait returns, so only
+ * call ov_waitgroup_exit once the jobs themselves are gone, for example after joining their threads.
+ *
+ * @example
+ *   ov_waitgroup_add(&wg, njobs);
+ *   for (size_t i = 0; i < njobs; ++i) {
+ *     start_job(jobs + i, &wg); // calls ov_waitgroup_done(&wg) when finished
+ *   }
+ *   ov_waitgroup_wait(&wg);
+ */
+struct ov_waitgroup {
+  atomic_uint count;
+  atomic_uint waiters;
+#ifndef OV_SYNC_FUTEX
+  struct ov_sync_fallback fallback;
+#endif
+};
+
+/**
+ * @brief Initialize a wait group with a count of 0
+ *
+ * @param wg Pointer to wait group. Must not be NULL.
+ * @param err Pointer to struct ov_error for error information. Can be NULL.
+ * @return true on success, false if the parking primitives could not be created
+ */
+NODISCARD bool ov_waitgroup_init(struct ov_waitgroup *const wg, struct ov_error *const err);
+void ov_waitgroup_exit(struct ov_waitgroup *const wg);
+
+/**
+ * @brief Register n more jobs
+ */
+void ov_waitgroup_add(struct ov_waitgroup *const wg, unsigned int const n);
+
+/**
+ * @brief Mark one job as finished
+ */
+void ov_waitgroup_done(struct ov_waitgroup *const wg);
+
+/**
+ * @brief Block until every registered job has finished
+ */
+void ov_waitgroup_wait(struct ov_waitgroup *const wg);
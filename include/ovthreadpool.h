@@ -0,0 +1,189 @@
+#pragma once
+
+#include <ovbase.h>
+
+/**
+ * @brief Task executed by a thread pool worker
+ *
+ * @param userdata Opaque pointer passed to ov_threadpool_submit
+ */
+typedef void (*ov_threadpool_task_func)(void *const userdata);
+
+struct ov_threadpool_options {
+  /** Number of worker threads, or 0 for the number of online processors. */
+  size_t threads;
+};
+
+/**
+ * @brief Create a work-stealing thread pool
+ *
+ * Every worker owns a Chase-Lev deque. Tasks submitted from a worker (usually from inside
+ * another task) go to the bottom of that worker's deque and are run last-in first-out,
+ * which keeps recursive work cache-friendly; idle workers steal the oldest task from the top
+ * of other deques. Tasks submitted from any other thread go through a shared FIFO queue.
+ * Workers with nothing to do park on a condition variable.
+ * Automatically includes debug information for memory tracking.
+ *
+ * @param options_ptr Pointer to struct ov_threadpool_options, or NULL for defaults
+ * @param err Pointer to struct ov_error for error information. Can be NULL.
+ * @return Pointer to created pool, or NULL on failure
+ *
+ * @example
+ *   struct ov_threadpool *tp = OV_THREADPOOL_CREATE(NULL, &err);
+ *   for (size_t i = 0; i < nfiles; ++i) {
+ *     if (!ov_threadpool_submit(tp, compress_file, files + i, &err)) {
+ *       goto cleanup;
+ *     }
+ *   }
+ *   ov_threadpool_wait(tp);
+ *   OV_THREADPOOL_DESTROY(&tp);
+ */
+#define OV_THREADPOOL_CREATE(options_ptr, err) ov_threadpool_create((options_ptr), (err)MEM_FILEPOS_VALUES)
+
+/**
+ * @brief Wait for all submitted tasks, stop the workers and free the pool
+ *
+ * Tasks that are still queued are run before the workers exit.
+ * Must not be called from a task of the same pool.
+ *
+ * @param tpp Pointer to pool pointer (will be set to NULL). Must not be NULL.
+ */
+#define OV_THREADPOOL_DESTROY(tpp) ov_threadpool_destroy((tpp)MEM_FILEPOS_VALUES)
+
+NODISCARD struct ov_threadpool *ov_threadpool_create(struct ov_threadpool_options const *const options,
+                                                     struct ov_error *const err MEM_FILEPOS_PARAMS);
+void ov_threadpool_destroy(struct ov_threadpool **const tpp MEM_FILEPOS_PARAMS);
+
+/**
+ * @brief Queue a task
+ *
+ * Can be called from any thread, including from inside a task.
+ *
+ * @param tp Pointer to pool. Must not be NULL.
+ * @param func Task function. Must not be NULL.
+ * @param userdata Opaque pointer forwarded to func
+ * @param err Pointer to struct ov_error for error information. Can be NULL.
+ * @return true on success, false if the queue could not grow
+ */
+NODISCARD bool ov_threadpool_submit(struct ov_threadpool *const tp,
+                                    ov_threadpool_task_func const func,
+                                    void *const userdata,
+                                    struct ov_error *const err);
+
+/**
+ * @brief Block until every submitted task, including tasks submitted by tasks, has finished
+ *
+ * Must not be called from a task of the same pool, as that task would wait for itself.
+ *
+ * @param tp Pointer to pool. Must not be NULL.
+ */
+void ov_threadpool_wait(struct ov_threadpool *const tp);
+
+/**
+ * @brief Get the number of worker threads
+ *
+ * @param tp Pointer to pool. Must not be NULL.
+ * @return Number of workers
+ */
+size_t ov_threadpool_get_threads(struct ov_threadpool const *const tp);
+
+/**
+ * @brief Run ntasks tasks on a pool and return when all of them have finished
+ *
+ * Matches ov_parallel_run_func, so a pool can drive ov_parallel_qsort through
+ * ov_parallel_qsort_options.run with the pool as executor. The calling thread runs tasks
+ * too while it waits, which also makes it safe to call from inside a task of the same pool.
+ * If tasks cannot be queued they run on the calling thread.
+ *
+ * @param ntasks Number of tasks
+ * @param task Task function, called once with each index in [0, ntasks)
+ * @param userdata Opaque pointer forwarded to task
+ * @param executor Pointer to struct ov_threadpool. Must not be NULL.
+ */
+void ov_threadpool_parallel_run(size_t const ntasks,
+                                void (*const task)(size_t const index, void *const userdata),
+                                void *const userdata,
+                                void *const executor);
+
+/**
+ * @brief Loop body for ov_parallel_for, called with a chunk [begin, end) of the range
+ *
+ * @param begin First index of the chunk
+ * @param end One past the last index of the chunk
+ * @param userdata Opaque pointer passed to ov_parallel_for
+ */
+typedef void (*ov_parallel_for_func)(size_t const begin, size_t const end, void *const userdata);
+
+/**
+ * @brief Accumulates a chunk [begin, end) into partial, a per-thread result of result_size bytes
+ */
+typedef void (*ov_parallel_map_func)(size_t const begin, size_t const end, void *const partial, void *const userdata);
+
+/**
+ * @brief Merges the partial result src into dest
+ */
+typedef void (*ov_parallel_combine_func)(void *const dest, void const *const src, void *const userdata);
+
+/**
+ * @brief Run fn over [begin, end) in chunks spread across a pool
+ *
+ * Chunks are claimed from a shared cursor: each claim takes half of the remaining range
+ * divided by the number of threads, but never less than grain, so early chunks are large
+ * and the tail is split finely for load balance. The calling thread takes part and the call
+ * returns once the whole range is done. Chunk sizes are multiples of grain, so when grain
+ * items of output fill whole cache lines no two threads ever write to the same line.
+ *
+ * @param tp Pointer to pool, or NULL to call fn once on the calling thread
+ * @param begin First index
+ * @param end One past the last index
+ * @param grain Minimum chunk size, 0 is treated as 1
+ * @param fn Loop body. Must not be NULL.
+ * @param userdata Opaque pointer forwarded to fn
+ *
+ * @example
+ *   static void to_upper(size_t const begin, size_t const end, void *const userdata) {
+ *     char *const s = userdata;
+ *     for (size_t i = begin; i < end; ++i) {
+ *       s[i] = (char)toupper((unsigned char)s[i]);
+ *     }
+ *   }
+ *   ov_parallel_for(tp, 0, len, 65536, to_upper, buf);
+ */
+void ov_parallel_for(struct ov_threadpool *const tp,
+                     size_t const begin,
+                     size_t const end,
+                     size_t const grain,
+                     ov_parallel_for_func const fn,
+                     void *const userdata);
+
+/**
+ * @brief Reduce [begin, end) in parallel into a value of result_size bytes
+ *
+ * On entry result holds the identity value (0 for a sum, for example). Every thread gets its
+ * own copy of it on a separate cache line, folds the chunks it claims into that copy with map,
+ * and the copies are merged into result with combine on the calling thread. Chunks are
+ * scheduled as in ov_parallel_for, so which chunks end up in which partial varies between
+ * runs: combine must be associative and commutative.
+ *
+ * @param tp Pointer to pool, or NULL to call map once on the calling thread with result
+ * @param begin First index
+ * @param end One past the last index
+ * @param grain Minimum chunk size, 0 is treated as 1
+ * @param result Identity value on entry, reduced value on return. Must not be NULL.
+ * @param result_size Size of the value. Must be greater than 0.
+ * @param map Folds a chunk into a partial result. Must not be NULL.
+ * @param combine Merges two partial results. Must not be NULL.
+ * @param userdata Opaque pointer forwarded to map and combine
+ * @param err Pointer to struct ov_error for error information. Can be NULL.
+ * @return true on success, false if the partial results could not be allocated
+ */
+NODISCARD bool ov_parallel_reduce(struct ov_threadpool *const tp,
+                                  size_t const begin,
+                                  size_t const end,
+                                  size_t const grain,
+                                  void *const result,
+                                  size_t const result_size,
+                                  ov_parallel_map_func const map,
+                                  ov_parallel_combine_func const combine,
+                                  void *const userdata,
+                                  struct ov_error *const err);
@@ -2,6 +2,7 @@
 
 #include <assert.h>
 #include <ovbase_config.h>
+#include <stddef.h>
 
 #if __STDC_VERSION__ < 201112L || !defined(__STDC_NO_THREADS) || __STDC_NO_THREADS__
 #  ifdef __GNUC__
@@ -25,16 +26,12 @@
 #    define TIME_UTC (1)
 int timespec_get(struct timespec *ts, int base);
 #  endif
-#  define DISABLE_TLS
-#  define DISABLE_CALL_ONCE
 #  ifdef OVBASE_DISABLE_PTHREAD_EXIT
 #    define pthread_exit(x)                                                                                            \
       (void)(x);                                                                                                       \
       __builtin_trap()
 #  endif
 #  include <ovbase_3rd/tinycthread.h>
-#  undef DISABLE_TLS
-#  undef DISABLE_CALL_ONCE
 #  ifdef __GNUC__
 #    pragma GCC diagnostic pop
 #  endif // __GNUC__
@@ -42,6 +39,33 @@ int timespec_get(struct timespec *ts, int base);
 #  include <threads.h>
 #endif // __STDC_VERSION__ < 201112L || !defined(__STDC_NO_THREADS) || __STDC_NO_THREADS__
 
+// tss_create / tss_get / tss_set / tss_delete and call_once are available on every platform.
+// tss destructors run when a thread exits; on Windows that covers threads started with
+// thrd_create, and other threads only where the toolchain runs TLS callbacks.
+
+/**
+ * @brief Storage-class specifier for per-thread variables
+ *
+ * A plain thread-local variable: reading it is a single memory access, without the call
+ * and key lookup of tss_get. It has no destructor, so anything that has to be released
+ * at thread exit still needs a tss key; a common pattern is to cache the pointer stored
+ * in the key in an OV_THREAD_LOCAL variable.
+ * OV_HAS_THREAD_LOCAL is defined when the compiler supports it.
+ *
+ * @example
+ *   static OV_THREAD_LOCAL uint64_t rng_state;
+ */
+#if defined(_MSC_VER) && !defined(__clang__)
+#  define OV_THREAD_LOCAL __declspec(thread)
+#  define OV_HAS_THREAD_LOCAL 1
+#elif __STDC_VERSION__ >= 201112L
+#  define OV_THREAD_LOCAL _Thread_local
+#  define OV_HAS_THREAD_LOCAL 1
+#elif defined(__GNUC__)
+#  define OV_THREAD_LOCAL __thread
+#  define OV_HAS_THREAD_LOCAL 1
+#endif
+
 struct cndvar {
   cnd_t cnd;
   mtx_t mtx;
@@ -116,3 +140,10 @@ static inline int cndvar_timedwait_while(struct cndvar *cv, int var, const struc
   }
   return thrd_success;
 }
+
+/**
+ * @brief Get the number of processors available to the process
+ *
+ * @return Number of online processors, at least 1
+ */
+size_t ov_thread_hardware_concurrency(void);
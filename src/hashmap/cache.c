@@ -0,0 +1,554 @@
+#include "common.h"
+
+#include <ovcache.h>
+#include <ovthreads.h>
+
+#include <assert.h>
+#include <string.h>
+
+enum {
+  cache_line_size = 64,
+  default_shards = 16,
+  max_shard_bits = 8,
+  min_index_size = 16,
+};
+
+// Every live node stores the low 31 bits of its hash with this bit set, so a zero tag marks a free slot.
+static uint32_t const live_bit = 0x80000000u;
+static uint32_t const none = UINT32_MAX;
+static size_t const max_slots = (size_t)1 << 31;
+
+struct node {
+  uint32_t prev; // towards the newest entry
+  uint32_t next; // towards the oldest entry, or the next free slot
+  uint32_t tag;
+  bool visited;
+  size_t cost;
+};
+
+struct shard {
+  _Alignas(cache_line_size) mtx_t mtx;
+  char *items;
+  struct node *nodes;
+  uint32_t *index; // open addressing table of slot + 1, 0 marks an empty position
+  size_t index_mask;
+  size_t slots; // allocated slots
+  size_t used;  // slots handed out at least once
+  uint32_t free_head;
+  uint32_t head;
+  uint32_t tail;
+  uint32_t hand;
+  size_t count;
+  size_t bytes;
+  size_t max_entries;
+  size_t max_bytes;
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;
+};
+
+struct ov_cache {
+  struct ov_hashmap key; // key description and filepos only, map is not used
+  struct shard *shards;
+  size_t shard_mask;
+  size_t item_size;
+  uint64_t seed0;
+  uint64_t seed1;
+  enum ov_cache_policy policy;
+  bool thread_safe;
+  ov_cache_evict_func on_evict;
+  void *userdata;
+};
+
+static inline void shard_lock(struct ov_cache *const c, struct shard *const s) {
+  if (c->thread_safe) {
+    mtx_lock(&s->mtx);
+  }
+}
+
+static inline void shard_unlock(struct ov_cache *const c, struct shard *const s) {
+  if (c->thread_safe) {
+    mtx_unlock(&s->mtx);
+  }
+}
+
+static inline char *item_at(struct ov_cache const *const c, struct shard const *const s, uint32_t const slot) {
+  return s->items + (size_t)slot * c->item_size;
+}
+
+// The index position comes from the low bits, so the shard is taken from the top bits to keep them independent.
+static inline struct shard *select_shard(struct ov_cache *const c, uint64_t const hash) {
+  return c->shards + ((size_t)(hash >> 56) & c->shard_mask);
+}
+
+// Returns the index position that refers to the item with the given key, or SIZE_MAX if not found.
+static size_t
+find(struct ov_cache const *const c, struct shard const *const s, void const *const key_item, uint32_t const tag) {
+  for (size_t i = tag & s->index_mask;; i = (i + 1) & s->index_mask) {
+    uint32_t const v = s->index[i];
+    if (!v) {
+      return SIZE_MAX;
+    }
+    if (s->nodes[v - 1].tag == tag && ov_hm_compare(item_at(c, s, v - 1), key_item, &c->key) == 0) {
+      return i;
+    }
+  }
+}
+
+static size_t find_slot(struct shard const *const s, uint32_t const slot) {
+  size_t i = s->nodes[slot].tag & s->index_mask;
+  while (s->index[i] != slot + 1) {
+    i = (i + 1) & s->index_mask;
+  }
+  return i;
+}
+
+static void index_insert(struct shard *const s, uint32_t const slot) {
+  size_t i = s->nodes[slot].tag & s->index_mask;
+  while (s->index[i]) {
+    i = (i + 1) & s->index_mask;
+  }
+  s->index[i] = slot + 1;
+}
+
+// Backward shift deletion keeps probe sequences intact without tombstones.
+static void index_remove(struct shard *const s, size_t i) {
+  for (size_t j = (i + 1) & s->index_mask;; j = (j + 1) & s->index_mask) {
+    uint32_t const v = s->index[j];
+    if (!v) {
+      break;
+    }
+    size_t const home = s->nodes[v - 1].tag & s->index_mask;
+    if (((j - home) & s->index_mask) >= ((j - i) & s->index_mask)) {
+      s->index[i] = v;
+      i = j;
+    }
+  }
+  s->index[i] = 0;
+}
+
+static bool index_rebuild(struct shard *const s, size_t const size MEM_FILEPOS_PARAMS) {
+  uint32_t *index = NULL;
+  if (!ov_mem_realloc(&index, size, sizeof(uint32_t) MEM_FILEPOS_VALUES_PASSTHRU)) {
+    return false;
+  }
+  memset(index, 0, size * sizeof(uint32_t));
+  if (s->index) {
+    ov_mem_free(&s->index MEM_FILEPOS_VALUES_PASSTHRU);
+  }
+  s->index = index;
+  s->index_mask = size - 1;
+  for (uint32_t slot = s->head; slot != none; slot = s->nodes[slot].next) {
+    index_insert(s, slot);
+  }
+  return true;
+}
+
+static void list_unlink(struct shard *const s, uint32_t const slot) {
+  struct node *const n = s->nodes + slot;
+  if (s->hand == slot) {
+    s->hand = n->prev;
+  }
+  if (n->prev != none) {
+    s->nodes[n->prev].next = n->next;
+  } else {
+    s->head = n->next;
+  }
+  if (n->next != none) {
+    s->nodes[n->next].prev = n->prev;
+  } else {
+    s->tail = n->prev;
+  }
+}
+
+static void list_push_head(struct shard *const s, uint32_t const slot) {
+  struct node *const n = s->nodes + slot;
+  n->prev = none;
+  n->next = s->head;
+  if (s->head != none) {
+    s->nodes[s->head].prev = slot;
+  } else {
+    s->tail = slot;
+  }
+  s->head = slot;
+}
+
+static void remove_slot(struct shard *const s, uint32_t const slot, size_t const pos) {
+  list_unlink(s, slot);
+  index_remove(s, pos);
+  s->bytes -= s->nodes[slot].cost;
+  --s->count;
+  s->nodes[slot].tag = 0;
+  s->nodes[slot].next = s->free_head;
+  s->free_head = slot;
+}
+
+static void touch(struct ov_cache const *const c, struct shard *const s, uint32_t const slot) {
+  if (c->policy == ov_cache_policy_sieve) {
+    s->nodes[slot].visited = true;
+  } else if (s->head != slot) {
+    list_unlink(s, slot);
+    list_push_head(s, slot);
+  }
+}
+
+static uint32_t choose_victim(struct ov_cache const *const c, struct shard *const s, uint32_t const keep) {
+  if (c->policy != ov_cache_policy_sieve) {
+    uint32_t const victim = s->tail;
+    return victim == keep ? s->nodes[victim].prev : victim;
+  }
+  uint32_t hand = s->hand != none ? s->hand : s->tail;
+  while (s->nodes[hand].visited || hand == keep) {
+    s->nodes[hand].visited = false;
+    hand = s->nodes[hand].prev != none ? s->nodes[hand].prev : s->tail;
+  }
+  // Unlinking the victim moves the hand on to the next newer entry.
+  s->hand = hand;
+  return hand;
+}
+
+static void evict_one(struct ov_cache *const c, struct shard *const s, uint32_t const keep) {
+  uint32_t const victim = choose_victim(c, s, keep);
+  if (c->on_evict) {
+    c->on_evict(item_at(c, s, victim), c->userdata);
+  }
+  remove_slot(s, victim, find_slot(s, victim));
+  ++s->evictions;
+}
+
+static uint32_t alloc_slot(struct ov_cache const *const c, struct shard *const s MEM_FILEPOS_PARAMS) {
+  if (s->free_head != none) {
+    uint32_t const slot = s->free_head;
+    s->free_head = s->nodes[slot].next;
+    return slot;
+  }
+  if (s->used == s->slots) {
+    size_t n = s->slots ? s->slots * 2 : 16;
+    if (s->max_entries && n > s->max_entries) {
+      n = s->max_entries;
+    }
+    if (n > max_slots || n <= s->slots) {
+      return none;
+    }
+    if (!ov_mem_realloc(&s->items, n, c->item_size MEM_FILEPOS_VALUES_PASSTHRU) ||
+        !ov_mem_realloc(&s->nodes, n, sizeof(struct node) MEM_FILEPOS_VALUES_PASSTHRU)) {
+      return none;
+    }
+    s->slots = n;
+  }
+  return (uint32_t)s->used++;
+}
+
+static void shard_free(struct shard *const s MEM_FILEPOS_PARAMS) {
+  if (s->index) {
+    ov_mem_free(&s->index MEM_FILEPOS_VALUES_PASSTHRU);
+  }
+  if (s->nodes) {
+    ov_mem_free(&s->nodes MEM_FILEPOS_VALUES_PASSTHRU);
+  }
+  if (s->items) {
+    ov_mem_free(&s->items MEM_FILEPOS_VALUES_PASSTHRU);
+  }
+}
+
+struct ov_cache *ov_cache_create(struct ov_cache_options const *const options MEM_FILEPOS_PARAMS) {
+  assert(options != NULL && "options must not be NULL");
+  assert((!options || options->item_size > 0) && "item_size must be greater than 0");
+  assert((!options || options->get_key || options->key_bytes > 0) && "get_key or key_bytes must be set");
+  assert((!options || options->max_entries || options->max_bytes) && "max_entries or max_bytes must be set");
+#ifdef ALLOCATE_LOGGER
+  assert(filepos != NULL && "filepos must not be NULL");
+#endif
+  if (!options || options->item_size == 0 || (!options->get_key && options->key_bytes == 0) ||
+      (!options->max_entries && !options->max_bytes)) {
+    return NULL;
+  }
+
+  struct ov_cache *result = NULL;
+  struct ov_cache *c = NULL;
+  size_t initialized = 0;
+
+  if (!ov_mem_realloc(&c, 1, sizeof(*c) MEM_FILEPOS_VALUES_PASSTHRU)) {
+    goto cleanup;
+  }
+  *c = (struct ov_cache){
+      .key =
+          {
+              .get_key = options->get_key,
+              .key_bytes = options->get_key ? 0 : options->key_bytes,
+#ifdef ALLOCATE_LOGGER
+              .filepos = *filepos,
+#endif
+          },
+      .item_size = options->item_size,
+      .policy = options->policy,
+      .thread_safe = options->thread_safe,
+      .on_evict = options->on_evict,
+      .userdata = options->userdata,
+  };
+  ov_hm_generate_seeds(&c->seed0, &c->seed1);
+
+  size_t n = 1;
+  if (options->thread_safe) {
+    size_t const want = options->shards ? options->shards : default_shards;
+    while (n < want && n < ((size_t)1 << max_shard_bits)) {
+      n *= 2;
+    }
+    // every shard needs a share of at least 1, since 0 would mean no limit
+    while (n > 1 && ((options->max_entries && n > options->max_entries) ||
+                     (options->max_bytes && n > options->max_bytes))) {
+      n /= 2;
+    }
+  }
+  c->shard_mask = n - 1;
+
+  if (!ov_mem_aligned_alloc(&c->shards, n, sizeof(struct shard), cache_line_size MEM_FILEPOS_VALUES_PASSTHRU)) {
+    goto cleanup;
+  }
+  for (; initialized < n; ++initialized) {
+    struct shard *const s = c->shards + initialized;
+    // the shares add up to exactly the requested limits
+    *s = (struct shard){
+        .free_head = none,
+        .head = none,
+        .tail = none,
+        .hand = none,
+        .max_entries = options->max_entries / n + (initialized < options->max_entries % n ? 1u : 0u),
+        .max_bytes = options->max_bytes / n + (initialized < options->max_bytes % n ? 1u : 0u),
+    };
+    if (c->thread_safe && mtx_init(&s->mtx, mtx_plain) != thrd_success) {
+      goto cleanup;
+    }
+    if (!index_rebuild(s, min_index_size MEM_FILEPOS_VALUES_PASSTHRU)) {
+      if (c->thread_safe) {
+        mtx_destroy(&s->mtx);
+      }
+      goto cleanup;
+    }
+  }
+
+  result = c;
+  c = NULL;
+
+cleanup:
+  if (c) {
+    if (c->shards) {
+      for (size_t i = 0; i < initialized; ++i) {
+        shard_free(c->shards + i MEM_FILEPOS_VALUES_PASSTHRU);
+        if (c->thread_safe) {
+          mtx_destroy(&c->shards[i].mtx);
+        }
+      }
+      ov_mem_aligned_free(&c->shards MEM_FILEPOS_VALUES_PASSTHRU);
+    }
+    ov_mem_free(&c MEM_FILEPOS_VALUES_PASSTHRU);
+  }
+  return result;
+}
+
+void ov_cache_destroy(struct ov_cache **const cp MEM_FILEPOS_PARAMS) {
+  assert(cp != NULL && "cp must not be NULL");
+  assert(*cp != NULL && "cache is already destroyed or not initialized");
+#ifdef ALLOCATE_LOGGER
+  assert(filepos != NULL && "filepos must not be NULL");
+#endif
+  if (!cp || !*cp) {
+    return;
+  }
+
+  struct ov_cache *const c = *cp;
+  for (size_t i = 0; i <= c->shard_mask; ++i) {
+    shard_free(c->shards + i MEM_FILEPOS_VALUES_PASSTHRU);
+    if (c->thread_safe) {
+      mtx_destroy(&c->shards[i].mtx);
+    }
+  }
+  ov_mem_aligned_free(&c->shards MEM_FILEPOS_VALUES_PASSTHRU);
+  ov_mem_free((void **)cp MEM_FILEPOS_VALUES_PASSTHRU);
+}
+
+void ov_cache_clear(struct ov_cache *const c) {
+  assert(c != NULL && "c must not be NULL");
+  if (!c) {
+    return;
+  }
+
+  for (size_t i = 0; i <= c->shard_mask; ++i) {
+    struct shard *const s = c->shards + i;
+    shard_lock(c, s);
+    memset(s->index, 0, (s->index_mask + 1) * sizeof(uint32_t));
+    s->used = 0;
+    s->free_head = none;
+    s->head = none;
+    s->tail = none;
+    s->hand = none;
+    s->count = 0;
+    s->bytes = 0;
+    shard_unlock(c, s);
+  }
+}
+
+size_t ov_cache_count(struct ov_cache *const c) {
+  if (!c) {
+    return 0;
+  }
+
+  size_t r = 0;
+  for (size_t i = 0; i <= c->shard_mask; ++i) {
+    struct shard *const s = c->shards + i;
+    shard_lock(c, s);
+    r += s->count;
+    shard_unlock(c, s);
+  }
+  return r;
+}
+
+bool ov_cache_get(struct ov_cache *const c, void const *const key_item, void *const dest) {
+  assert(c != NULL && "c must not be NULL");
+  assert(key_item != NULL && "key_item must not be NULL");
+  if (!c || !key_item) {
+    return false;
+  }
+
+  uint64_t const hash = ov_hm_hash(&c->key, key_item, c->seed0, c->seed1);
+  uint32_t const tag = (uint32_t)hash | live_bit;
+  struct shard *const s = select_shard(c, hash);
+  shard_lock(c, s);
+  size_t const pos = find(c, s, key_item, tag);
+  if (pos != SIZE_MAX) {
+    uint32_t const slot = s->index[pos] - 1;
+    if (dest) {
+      memcpy(dest, item_at(c, s, slot), c->item_size);
+    }
+    touch(c, s, slot);
+    ++s->hits;
+  } else {
+    ++s->misses;
+  }
+  shard_unlock(c, s);
+  return pos != SIZE_MAX;
+}
+
+bool ov_cache_put(struct ov_cache *const c, void const *const item, size_t const cost MEM_FILEPOS_PARAMS) {
+  assert(c != NULL && "c must not be NULL");
+  assert(item != NULL && "item must not be NULL");
+#ifdef ALLOCATE_LOGGER
+  assert(filepos != NULL && "filepos must not be NULL");
+#endif
+  if (!c || !item) {
+    return false;
+  }
+
+  uint64_t const hash = ov_hm_hash(&c->key, item, c->seed0, c->seed1);
+  uint32_t const tag = (uint32_t)hash | live_bit;
+  struct shard *const s = select_shard(c, hash);
+  size_t const charged = s->max_bytes ? cost : 0;
+  if (s->max_bytes && charged > s->max_bytes) {
+    return false;
+  }
+  bool result = false;
+  shard_lock(c, s);
+
+  size_t const pos = find(c, s, item, tag);
+  if (pos != SIZE_MAX) {
+    uint32_t const slot = s->index[pos] - 1;
+    memcpy(item_at(c, s, slot), item, c->item_size);
+    s->bytes = s->bytes - s->nodes[slot].cost + charged;
+    s->nodes[slot].cost = charged;
+    touch(c, s, slot);
+    while (s->max_bytes && s->bytes > s->max_bytes) {
+      evict_one(c, s, slot);
+    }
+    result = true;
+    goto cleanup;
+  }
+
+  while (s->count && ((s->max_entries && s->count >= s->max_entries) ||
+                      (s->max_bytes && s->bytes + charged > s->max_bytes))) {
+    evict_one(c, s, none);
+  }
+  // keep the index at most half full
+  if ((s->count + 1) * 2 > s->index_mask + 1 &&
+      !index_rebuild(s, (s->index_mask + 1) * 2 MEM_FILEPOS_VALUES_PASSTHRU)) {
+    goto cleanup;
+  }
+  {
+    uint32_t const slot = alloc_slot(c, s MEM_FILEPOS_VALUES_PASSTHRU);
+    if (slot == none) {
+      goto cleanup;
+    }
+    memcpy(item_at(c, s, slot), item, c->item_size);
+    s->nodes[slot] = (struct node){
+        .tag = tag,
+        .cost = charged,
+    };
+    list_push_head(s, slot);
+    index_insert(s, slot);
+    ++s->count;
+    s->bytes += charged;
+  }
+  result = true;
+
+cleanup:
+  shard_unlock(c, s);
+  return result;
+}
+
+bool ov_cache_delete(struct ov_cache *const c, void const *const key_item, void *const dest) {
+  assert(c != NULL && "c must not be NULL");
+  assert(key_item != NULL && "key_item must not be NULL");
+  if (!c || !key_item) {
+    return false;
+  }
+
+  uint64_t const hash = ov_hm_hash(&c->key, key_item, c->seed0, c->seed1);
+  uint32_t const tag = (uint32_t)hash | live_bit;
+  struct shard *const s = select_shard(c, hash);
+  shard_lock(c, s);
+  size_t const pos = find(c, s, key_item, tag);
+  if (pos != SIZE_MAX) {
+    uint32_t const slot = s->index[pos] - 1;
+    if (dest) {
+      memcpy(dest, item_at(c, s, slot), c->item_size);
+    }
+    remove_slot(s, slot, pos);
+  }
+  shard_unlock(c, s);
+  return pos != SIZE_MAX;
+}
+
+void ov_cache_get_stats(struct ov_cache *const c, struct ov_cache_stats *const stats) {
+  assert(c != NULL && "c must not be NULL");
+  assert(stats != NULL && "stats must not be NULL");
+  if (!c || !stats) {
+    return;
+  }
+
+  *stats = (struct ov_cache_stats){0};
+  for (size_t i = 0; i <= c->shard_mask; ++i) {
+    struct shard *const s = c->shards + i;
+    shard_lock(c, s);
+    stats->count += s->count;
+    stats->bytes += s->bytes;
+    stats->hits += s->hits;
+    stats->misses += s->misses;
+    stats->evictions += s->evictions;
+    shard_unlock(c, s);
+  }
+}
+
+void ov_cache_reset_stats(struct ov_cache *const c) {
+  assert(c != NULL && "c must not be NULL");
+  if (!c) {
+    return;
+  }
+
+  for (size_t i = 0; i <= c->shard_mask; ++i) {
+    struct shard *const s = c->shards + i;
+    shard_lock(c, s);
+    s->hits = 0;
+    s->misses = 0;
+    s->evictions = 0;
+    shard_unlock(c, s);
+  }
+}
@@ -0,0 +1,363 @@
+#include <ovtest.h>
+
+#include <ovcache.h>
+#include <ovthreads.h>
+
+#include <stdatomic.h>
+
+struct test_item {
+  uint32_t key;
+  uint32_t v;
+};
+
+struct test_evicted {
+  uint32_t keys[64];
+  size_t n;
+};
+
+static void test_on_evict(void const *const item, void *const userdata) {
+  struct test_evicted *const ev = (struct test_evicted *)userdata;
+  if (ev->n < sizeof(ev->keys) / sizeof(ev->keys[0])) {
+    ev->keys[ev->n] = ((struct test_item const *)item)->key;
+  }
+  ++ev->n;
+}
+
+static bool put(struct ov_cache *const c, uint32_t const key, size_t const cost) {
+  return OV_CACHE_PUT(c, &((struct test_item){.key = key, .v = key * 10}), cost);
+}
+
+static bool has(struct ov_cache *const c, uint32_t const key) {
+  struct test_item got = {0};
+  return OV_CACHE_GET(c, &key, &got) && got.key == key && got.v == key * 10;
+}
+
+static void test_lru(void) {
+  struct test_evicted ev = {0};
+  struct ov_cache *c = OV_CACHE_CREATE(&((struct ov_cache_options){
+      .item_size = sizeof(struct test_item),
+      .key_bytes = sizeof(uint32_t),
+      .max_entries = 3,
+      .policy = ov_cache_policy_lru,
+      .on_evict = test_on_evict,
+      .userdata = &ev,
+  }));
+  if (!TEST_CHECK(c != NULL)) {
+    return;
+  }
+
+  TEST_CHECK(put(c, 1, 0) && put(c, 2, 0) && put(c, 3, 0));
+  TEST_CHECK(OV_CACHE_COUNT(c) == 3);
+  // 1 becomes the most recently used, so 2 is evicted next
+  TEST_CHECK(has(c, 1));
+  TEST_CHECK(put(c, 4, 0));
+  TEST_CHECK(ev.n == 1 && ev.keys[0] == 2);
+  TEST_CHECK(!has(c, 2));
+  TEST_CHECK(has(c, 1) && has(c, 3) && has(c, 4));
+  // replacing an entry does not evict
+  TEST_CHECK(put(c, 3, 0));
+  TEST_CHECK(ev.n == 1);
+  TEST_CHECK(OV_CACHE_COUNT(c) == 3);
+
+  {
+    struct test_item got = {0};
+    TEST_CHECK(OV_CACHE_DELETE(c, &(uint32_t){4}, &got) && got.key == 4);
+    TEST_CHECK(!OV_CACHE_DELETE(c, &(uint32_t){4}, NULL));
+    TEST_CHECK(ev.n == 1);
+  }
+
+  {
+    struct ov_cache_stats st;
+    OV_CACHE_GET_STATS(c, &st);
+    TEST_CHECK(st.count == 2);
+    TEST_CHECK(st.hits == 4);
+    TEST_CHECK(st.misses == 1);
+    TEST_CHECK(st.evictions == 1);
+    OV_CACHE_RESET_STATS(c);
+    OV_CACHE_GET_STATS(c, &st);
+    TEST_CHECK(st.count == 2 && st.hits == 0 && st.misses == 0 && st.evictions == 0);
+  }
+
+  OV_CACHE_CLEAR(c);
+  TEST_CHECK(OV_CACHE_COUNT(c) == 0);
+  TEST_CHECK(!has(c, 1));
+  TEST_CHECK(put(c, 5, 0) && has(c, 5));
+
+  OV_CACHE_DESTROY(&c);
+  TEST_CHECK(c == NULL);
+}
+
+static void test_sieve(void) {
+  struct test_evicted ev = {0};
+  struct ov_cache *c = OV_CACHE_CREATE(&((struct ov_cache_options){
+      .item_size = sizeof(struct test_item),
+      .key_bytes = sizeof(uint32_t),
+      .max_entries = 4,
+      .policy = ov_cache_policy_sieve,
+      .on_evict = test_on_evict,
+      .userdata = &ev,
+  }));
+  if (!TEST_CHECK(c != NULL)) {
+    return;
+  }
+
+  TEST_CHECK(put(c, 1, 0) && put(c, 2, 0) && put(c, 3, 0) && put(c, 4, 0));
+  // visited entries survive the sweep, the oldest unvisited one goes
+  TEST_CHECK(has(c, 1) && has(c, 3));
+  TEST_CHECK(put(c, 5, 0));
+  TEST_CHECK(ev.n == 1 && ev.keys[0] == 2);
+  // the hand continues from where it stopped: 3 was visited, so 4 goes next
+  TEST_CHECK(put(c, 6, 0));
+  TEST_CHECK(ev.n == 2 && ev.keys[1] == 4);
+  // the hand now points at 5, which was never hit
+  TEST_CHECK(put(c, 7, 0));
+  TEST_CHECK(ev.n == 3 && ev.keys[2] == 5);
+  TEST_CHECK(OV_CACHE_COUNT(c) == 4);
+  TEST_CHECK(has(c, 1) && has(c, 3) && has(c, 6) && has(c, 7));
+
+  // a scan of one-hit items only churns through unvisited entries
+  for (uint32_t k = 100; k < 200; ++k) {
+    TEST_CHECK(has(c, 7));
+    TEST_CHECK(put(c, k, 0));
+  }
+  TEST_CHECK(has(c, 7));
+  TEST_CHECK(OV_CACHE_COUNT(c) == 4);
+
+  OV_CACHE_DESTROY(&c);
+}
+
+static void test_bytes(void) {
+  struct ov_cache *c = OV_CACHE_CREATE(&((struct ov_cache_options){
+      .item_size = sizeof(struct test_item),
+      .key_bytes = sizeof(uint32_t),
+      .max_bytes = 100,
+  }));
+  if (!TEST_CHECK(c != NULL)) {
+    return;
+  }
+
+  TEST_CHECK(put(c, 1, 40) && put(c, 2, 40));
+  TEST_CHECK(put(c, 3, 40));
+  TEST_CHECK(!has(c, 1) && has(c, 2) && has(c, 3));
+  TEST_CHECK(!put(c, 4, 101));
+  // growing an entry evicts others but never itself
+  TEST_CHECK(put(c, 3, 90));
+  TEST_CHECK(!has(c, 2) && has(c, 3));
+  {
+    struct ov_cache_stats st;
+    OV_CACHE_GET_STATS(c, &st);
+    TEST_CHECK(st.count == 1 && st.bytes == 90);
+  }
+  for (uint32_t k = 10; k < 1000; ++k) {
+    if (!TEST_CHECK(put(c, k, k % 7))) {
+      break;
+    }
+    struct ov_cache_stats st;
+    OV_CACHE_GET_STATS(c, &st);
+    if (!TEST_CHECK(st.bytes <= 100)) {
+      break;
+    }
+  }
+
+  OV_CACHE_DESTROY(&c);
+}
+
+struct test_item_dynamic {
+  char const *key;
+  size_t v;
+};
+
+static void test_get_key_dynamic(void const *const item, void const **const key, size_t *const key_bytes) {
+  struct test_item_dynamic const *const it = (struct test_item_dynamic const *)item;
+  *key = it->key;
+  *key_bytes = strlen(it->key);
+}
+
+static void test_dynamic(void) {
+  struct ov_cache *c = OV_CACHE_CREATE(&((struct ov_cache_options){
+      .item_size = sizeof(struct test_item_dynamic),
+      .get_key = test_get_key_dynamic,
+      .max_entries = 100,
+  }));
+  if (!TEST_CHECK(c != NULL)) {
+    return;
+  }
+
+  struct test_item_dynamic got = {0};
+  TEST_CHECK(OV_CACHE_PUT(c, &((struct test_item_dynamic){.key = "hello", .v = 1}), 0));
+  TEST_CHECK(OV_CACHE_PUT(c, &((struct test_item_dynamic){.key = "world", .v = 2}), 0));
+  TEST_CHECK(OV_CACHE_GET(c, &(struct test_item_dynamic){.key = "world"}, &got) && got.v == 2);
+  TEST_CHECK(!OV_CACHE_GET(c, &(struct test_item_dynamic){.key = "worl"}, &got));
+  TEST_CHECK(OV_CACHE_COUNT(c) == 2);
+
+  OV_CACHE_DESTROY(&c);
+}
+
+static void test_churn(void) {
+  enum { n = 50000, cap = 1000 };
+  struct ov_cache *c = OV_CACHE_CREATE(&((struct ov_cache_options){
+      .item_size = sizeof(struct test_item),
+      .key_bytes = sizeof(uint32_t),
+      .max_entries = cap,
+      .policy = ov_cache_policy_sieve,
+  }));
+  if (!TEST_CHECK(c != NULL)) {
+    return;
+  }
+
+  uint64_t state = 1;
+  for (size_t i = 0; i < n; ++i) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    uint32_t const key = (uint32_t)(state >> 33) % (cap * 4);
+    if (!has(c, key)) {
+      if (!TEST_CHECK(put(c, key, 0))) {
+        break;
+      }
+    }
+    if ((state >> 20) % 10 == 0) {
+      (void)OV_CACHE_DELETE(c, &key, NULL);
+    }
+  }
+  TEST_CHECK(OV_CACHE_COUNT(c) <= cap);
+  {
+    struct ov_cache_stats st;
+    OV_CACHE_GET_STATS(c, &st);
+    TEST_CHECK(st.hits + st.misses == n);
+    TEST_MSG("hits=%llu misses=%llu", (unsigned long long)st.hits, (unsigned long long)st.misses);
+  }
+
+  OV_CACHE_DESTROY(&c);
+}
+
+static void test_shard_limits(void) {
+  // The shares of the shards add up to the limits, even when a limit is smaller than the shard count.
+  static size_t const limits[] = {100, 3, 1};
+  for (size_t i = 0; i < sizeof(limits) / sizeof(limits[0]); ++i) {
+    TEST_CASE_("max_entries=%zu", limits[i]);
+    struct ov_cache *c = OV_CACHE_CREATE(&((struct ov_cache_options){
+        .item_size = sizeof(struct test_item),
+        .key_bytes = sizeof(uint32_t),
+        .max_entries = limits[i],
+        .thread_safe = true,
+        .shards = 16,
+    }));
+    if (!TEST_CHECK(c != NULL)) {
+      return;
+    }
+    for (uint32_t k = 0; k < 2000; ++k) {
+      if (!TEST_CHECK(put(c, k, 0))) {
+        break;
+      }
+    }
+    // 2000 keys fill every shard
+    TEST_CHECK(OV_CACHE_COUNT(c) == limits[i]);
+    TEST_MSG("count=%zu", OV_CACHE_COUNT(c));
+    OV_CACHE_DESTROY(&c);
+  }
+
+  TEST_CASE("max_bytes=100");
+  struct ov_cache *c = OV_CACHE_CREATE(&((struct ov_cache_options){
+      .item_size = sizeof(struct test_item),
+      .key_bytes = sizeof(uint32_t),
+      .max_bytes = 100,
+      .thread_safe = true,
+      .shards = 16,
+  }));
+  if (!TEST_CHECK(c != NULL)) {
+    return;
+  }
+  for (uint32_t k = 0; k < 2000; ++k) {
+    if (!TEST_CHECK(put(c, k, 1))) {
+      break;
+    }
+  }
+  {
+    struct ov_cache_stats st;
+    OV_CACHE_GET_STATS(c, &st);
+    TEST_CHECK(st.bytes == 100);
+    TEST_MSG("bytes=%zu", st.bytes);
+  }
+  OV_CACHE_DESTROY(&c);
+}
+
+enum {
+  test_threads = 8,
+  test_ops_per_thread = 20000,
+  test_thread_cap = 512,
+};
+
+struct test_thread_context {
+  struct ov_cache *c;
+  uint32_t seed;
+  atomic_int *failures;
+};
+
+static int test_cache_thread(void *userdata) {
+  struct test_thread_context *const ctx = (struct test_thread_context *)userdata;
+  uint32_t state = ctx->seed * 2654435761u + 1;
+  for (uint32_t i = 0; i < test_ops_per_thread; ++i) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    uint32_t const key = state % (test_thread_cap * 2);
+    struct test_item got = {0};
+    if (OV_CACHE_GET(ctx->c, &key, &got)) {
+      if (got.key != key || got.v != key * 10) {
+        atomic_fetch_add(ctx->failures, 1);
+      }
+    } else if (!put(ctx->c, key, 0)) {
+      atomic_fetch_add(ctx->failures, 1);
+    }
+  }
+  return 0;
+}
+
+static void test_threads_mixed(void) {
+  struct ov_cache *c = OV_CACHE_CREATE(&((struct ov_cache_options){
+      .item_size = sizeof(struct test_item),
+      .key_bytes = sizeof(uint32_t),
+      .max_entries = test_thread_cap,
+      .policy = ov_cache_policy_lru,
+      .thread_safe = true,
+      .shards = 8,
+  }));
+  if (!TEST_CHECK(c != NULL)) {
+    return;
+  }
+
+  atomic_int failures = 0;
+  thrd_t threads[test_threads];
+  struct test_thread_context ctx[test_threads];
+  size_t started = 0;
+  for (size_t i = 0; i < test_threads; ++i) {
+    ctx[i] = (struct test_thread_context){.c = c, .seed = (uint32_t)i, .failures = &failures};
+    if (!TEST_CHECK(thrd_create(threads + i, test_cache_thread, ctx + i) == thrd_success)) {
+      break;
+    }
+    ++started;
+  }
+  for (size_t i = 0; i < started; ++i) {
+    thrd_join(threads[i], NULL);
+  }
+  TEST_CHECK(atomic_load(&failures) == 0);
+  TEST_CHECK(OV_CACHE_COUNT(c) <= test_thread_cap);
+  {
+    struct ov_cache_stats st;
+    OV_CACHE_GET_STATS(c, &st);
+    TEST_CHECK(st.hits + st.misses == (uint64_t)started * test_ops_per_thread);
+    TEST_CHECK(st.evictions > 0);
+  }
+
+  OV_CACHE_DESTROY(&c);
+}
+
+TEST_LIST = {
+    {"test_lru", test_lru},
+    {"test_sieve", test_sieve},
+    {"test_bytes", test_bytes},
+    {"test_dynamic", test_dynamic},
+    {"test_churn", test_churn},
+    {"test_shard_limits", test_shard_limits},
+    {"test_threads_mixed", test_threads_mixed},
+    {NULL, NULL},
+};
@@ -3,6 +3,12 @@
 #include "../mem.h"
 
 #include <assert.h>
+#include <ovrand.h>
+#include <string.h>
+
+#ifdef HASHMAP_STATS
+#  include <ovthreads.h> // struct timespec, timespec_get, TIME_UTC
+#endif
 
 #ifdef __GNUC__
 #  pragma GCC diagnostic push
@@ -150,8 +156,7 @@ void *ov_hm_realloc(void *p, size_t const s, void *const udata) {
 #ifdef ALLOCATE_LOGGER
   assert(udata != NULL && "udata must not be NULL");
   struct ov_hashmap const *const hm = (struct ov_hashmap const *)udata;
-  assert(hm->filepos != NULL && "hm->filepos must not be NULL");
-  struct ov_filepos const *const filepos = hm->filepos;
+  struct ov_filepos const *const filepos = &hm->filepos;
 #else
   (void)udata;
 #endif
@@ -166,10 +171,322 @@ void ov_hm_free(void *p, void *const udata) {
 #ifdef ALLOCATE_LOGGER
   assert(udata != NULL && "udata must not be NULL");
   struct ov_hashmap const *const hm = (struct ov_hashmap const *)udata;
-  assert(hm->filepos != NULL && "hm->filepos must not be NULL");
-  struct ov_filepos const *const filepos = hm->filepos;
+  struct ov_filepos const *const filepos = &hm->filepos;
 #else
   (void)udata;
 #endif
   mem_core_(&p, 0 MEM_FILEPOS_VALUES_PASSTHRU);
 }
+
+void ov_hm_generate_seeds(uint64_t *const seed0, uint64_t *const seed1) {
+  assert(seed0 != NULL && "seed0 must not be NULL");
+  assert(seed1 != NULL && "seed1 must not be NULL");
+  uint64_t hash = ov_rand_splitmix64_next(ov_rand_get_global_hint());
+  *seed0 = ov_rand_splitmix64(hash);
+  hash = ov_rand_splitmix64_next(hash);
+  *seed1 = ov_rand_splitmix64(hash);
+}
+
+static inline void get_key(struct ov_hashmap const *const hm, void const *const item, void const **key, size_t *len) {
+  if (hm->get_key) {
+    hm->get_key(item, key, len);
+    return;
+  }
+  *key = item;
+  *len = hm->key_bytes;
+}
+
+uint64_t ov_hm_hash(struct ov_hashmap const *const hm,
+                    void const *const item,
+                    uint64_t const seed0,
+                    uint64_t const seed1) {
+  if (!item || !hm) {
+    return 0;
+  }
+  void const *p = NULL;
+  size_t len = 0;
+  get_key(hm, item, &p, &len);
+  return sip_hash_1_3(p, len, seed0, seed1);
+}
+
+static uint64_t calc_hash(void const *const item, uint64_t const seed0, uint64_t const seed1, void const *const udata) {
+  return ov_hm_hash((struct ov_hashmap const *)udata, item, seed0, seed1);
+}
+
+int ov_hm_compare(void const *const a, void const *const b, void const *const udata) {
+  struct ov_hashmap const *const hm = (struct ov_hashmap const *)udata;
+  if (!hm) {
+    return 0;
+  }
+  if (!a && !b) {
+    return 0;
+  }
+  if (!a) {
+    return -1;
+  }
+  if (!b) {
+    return 1;
+  }
+  if (!hm->get_key) {
+    return memcmp(a, b, hm->key_bytes);
+  }
+  void const *p0 = NULL, *p1 = NULL;
+  size_t len0 = 0, len1 = 0;
+  hm->get_key(a, &p0, &len0);
+  hm->get_key(b, &p1, &len1);
+  int r = memcmp(p0, p1, len0 < len1 ? len0 : len1);
+  if (len0 == len1 || r != 0) {
+    return r;
+  }
+  return len0 < len1 ? -1 : 1;
+}
+
+bool ov_hm_init(struct ov_hashmap *const hm,
+                size_t const item_size,
+                size_t const cap,
+                uint64_t const seed0,
+                uint64_t const seed1) {
+  assert(hm != NULL && "hm must not be NULL");
+  assert(item_size > 0 && "item_size must be greater than 0");
+  if (!hm || item_size == 0) {
+    return false;
+  }
+  hm->map = hashmap_new_with_allocator(
+      ov_hm_realloc, ov_hm_free, item_size, cap, seed0, seed1, calc_hash, ov_hm_compare, NULL, hm);
+#ifdef HASHMAP_STATS
+  ov_hm_stats_init(hm);
+#endif
+  return hm->map != NULL;
+}
+
+// Smallest bucket count that holds n items without crossing the grow threshold.
+static size_t buckets_for(struct hashmap const *const map, size_t const n) {
+  double const lf = map->loadfactor / 100.0;
+  size_t nb = 16;
+  while ((size_t)((double)nb * lf) < n) {
+    if (nb > SIZE_MAX / 2) {
+      return 0;
+    }
+    nb *= 2;
+  }
+  return nb;
+}
+
+bool ov_hm_grow(struct hashmap *const map, size_t const n) {
+  assert(map != NULL && "map must not be NULL");
+  size_t const nb = buckets_for(map, n);
+  if (!nb) {
+    return false;
+  }
+  if (nb > map->nbuckets && !resize(map, nb)) {
+    return false;
+  }
+  return true;
+}
+
+bool ov_hm_reserve(struct hashmap *const map, size_t const n) {
+  assert(map != NULL && "map must not be NULL");
+  if (!ov_hm_grow(map, n)) {
+    return false;
+  }
+  size_t const nb = buckets_for(map, n);
+  if (nb > map->cap) {
+    map->cap = nb;
+  }
+  return true;
+}
+
+bool ov_hm_shrink_to_fit(struct hashmap *const map) {
+  assert(map != NULL && "map must not be NULL");
+  size_t const nb = buckets_for(map, map->count);
+  if (!nb) {
+    return false;
+  }
+  map->cap = nb;
+  if (nb < map->nbuckets && !resize(map, nb)) {
+    return false;
+  }
+  return true;
+}
+
+size_t ov_hm_item_size(struct hashmap const *const map) {
+  assert(map != NULL && "map must not be NULL");
+  return map->elsize;
+}
+
+size_t ov_hm_retain(struct hashmap *const map, bool (*const keep)(void const *item, void *udata), void *const udata) {
+  assert(map != NULL && "map must not be NULL");
+  assert(keep != NULL && "keep must not be NULL");
+  size_t removed = 0;
+  size_t i = 0;
+  while (i < map->nbuckets) {
+    struct bucket *prev = bucket_at(map, i);
+    if (!prev->dib || keep(bucket_item(prev), udata)) {
+      ++i;
+      continue;
+    }
+    // Same backward shift as hashmap_delete_with_hash, but without shrinking so bucket positions stay valid.
+    // i is not advanced because the next item of the cluster may have been shifted into it.
+    prev->dib = 0;
+    for (size_t j = (i + 1) & map->mask;; j = (j + 1) & map->mask) {
+      struct bucket *const b = bucket_at(map, j);
+      if (b->dib <= 1) {
+        prev->dib = 0;
+        break;
+      }
+      memcpy(prev, b, map->bucketsz);
+      prev->dib--;
+      prev = b;
+    }
+    --map->count;
+    ++removed;
+  }
+  while (map->nbuckets > map->cap && map->count <= map->shrinkat) {
+    if (!resize(map, map->nbuckets / 2)) {
+      break;
+    }
+  }
+  return removed;
+}
+
+size_t ov_hm_bucket_size(size_t const item_size) {
+  size_t bucketsz = sizeof(struct bucket) + item_size;
+  while (bucketsz & (sizeof(uintptr_t) - 1)) {
+    ++bucketsz;
+  }
+  return bucketsz;
+}
+
+void ov_hm_snapshot_describe(struct hashmap const *const map, struct ov_hm_snapshot_header *const h) {
+  assert(map != NULL && "map must not be NULL");
+  assert(h != NULL && "h must not be NULL");
+  h->seed0 = map->seed0;
+  h->seed1 = map->seed1;
+  h->count = map->count;
+  h->nbuckets = map->nbuckets;
+  h->item_size = map->elsize;
+  h->bucket_size = map->bucketsz;
+  h->load_factor = map->loadfactor;
+}
+
+void ov_hm_snapshot_write(struct hashmap *const map, void *const dest) {
+  assert(map != NULL && "map must not be NULL");
+  assert(dest != NULL && "dest must not be NULL");
+  char *d = (char *)dest;
+  for (size_t i = 0; i < map->nbuckets; ++i, d += map->bucketsz) {
+    struct bucket const *const b = bucket_at(map, i);
+    if (b->dib) {
+      memcpy(d, b, map->bucketsz);
+    } else {
+      // Deleted items leave stale bytes behind; keep them out of the image.
+      memset(d, 0, map->bucketsz);
+    }
+  }
+}
+
+bool ov_hm_snapshot_restore(struct hashmap *const map,
+                            struct ov_hm_snapshot_header const *const h,
+                            void const *const buckets) {
+  assert(map != NULL && "map must not be NULL");
+  assert(h != NULL && "h must not be NULL");
+  assert(buckets != NULL && "buckets must not be NULL");
+  assert(map->count == 0 && "map must be empty");
+  assert(map->bucketsz == h->bucket_size && "map must have the bucket size of the snapshot");
+  size_t const nbuckets = (size_t)h->nbuckets;
+  if (nbuckets != map->nbuckets && !resize(map, nbuckets)) {
+    return false;
+  }
+  if (map->nbuckets != nbuckets) {
+    return false;
+  }
+  hashmap_set_load_factor(map, (double)h->load_factor / 100.0);
+  memcpy(map->buckets, buckets, nbuckets * map->bucketsz);
+  map->count = (size_t)h->count;
+  return true;
+}
+
+void const *ov_hm_snapshot_find(struct ov_hm_snapshot_header const *const h,
+                                void const *const buckets,
+                                void const *const key_item) {
+  assert(h != NULL && "h must not be NULL");
+  assert(buckets != NULL && "buckets must not be NULL");
+  assert(key_item != NULL && "key_item must not be NULL");
+  size_t const key_bytes = (size_t)h->key_bytes;
+  size_t const bucketsz = (size_t)h->bucket_size;
+  size_t const mask = (size_t)h->nbuckets - 1;
+  uint64_t const hash = clip_hash(sip_hash_1_3(key_item, key_bytes, h->seed0, h->seed1));
+  size_t i = (size_t)hash & mask;
+  // Robin hood order: once a bucket sits closer to its home than we are to ours, the key is absent.
+  // The distance bound also keeps a corrupt but validated image from looping forever.
+  for (uint64_t dib = 1; dib <= h->nbuckets; ++dib, i = (i + 1) & mask) {
+    char const *const p = (char const *)buckets + i * bucketsz;
+    struct bucket const *const b = (struct bucket const *)(void const *)p;
+    if (b->dib < dib) {
+      return NULL;
+    }
+    if (b->hash == hash && memcmp(p + sizeof(struct bucket), key_item, key_bytes) == 0) {
+      return p + sizeof(struct bucket);
+    }
+  }
+  return NULL;
+}
+
+void ov_hm_scan_stats(struct hashmap *const map, struct ov_hashmap_stats *const stats) {
+  assert(map != NULL && "map must not be NULL");
+  assert(stats != NULL && "stats must not be NULL");
+  stats->count = map->count;
+  stats->capacity = map->nbuckets;
+  stats->load_factor = map->nbuckets ? (double)map->count / (double)map->nbuckets : 0;
+  stats->max_probe = 0;
+  memset(stats->probe_histogram, 0, sizeof(stats->probe_histogram));
+  uint64_t total = 0;
+  for (size_t i = 0; i < map->nbuckets; ++i) {
+    struct bucket const *const b = bucket_at(map, i);
+    if (!b->dib) {
+      continue;
+    }
+    size_t const dist = (size_t)b->dib - 1;
+    total += dist;
+    if (dist > stats->max_probe) {
+      stats->max_probe = dist;
+    }
+    size_t const slot = dist < OV_HASHMAP_STATS_HISTOGRAM_SIZE ? dist : OV_HASHMAP_STATS_HISTOGRAM_SIZE - 1;
+    ++stats->probe_histogram[slot];
+  }
+  stats->avg_probe = map->count ? (double)total / (double)map->count : 0;
+}
+
+#ifdef HASHMAP_STATS
+void ov_hm_stats_init(struct ov_hashmap *const hm) {
+  assert(hm != NULL && "hm must not be NULL");
+  hm->stats = &hm->stats_storage;
+  hm->stats->resizes = 0;
+  hm->stats->resize_ns = 0;
+  atomic_init(&hm->stats->get_hits, 0);
+  atomic_init(&hm->stats->get_misses, 0);
+}
+
+uint64_t ov_hm_stats_now(void) {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+size_t ov_hm_stats_nbuckets(struct hashmap const *const map) { return map->nbuckets; }
+
+bool ov_hm_stats_resize_pending(struct hashmap const *const map, bool const grow) {
+  if (grow) {
+    return map->count >= map->growat;
+  }
+  return map->nbuckets > map->cap && map->count <= map->shrinkat + 1;
+}
+
+void ov_hm_stats_record_resize(struct ov_hashmap const *const hm, size_t const nbuckets_before, uint64_t const start) {
+  if (hm->map->nbuckets == nbuckets_before) {
+    return;
+  }
+  uint64_t const now = ov_hm_stats_now();
+  ++hm->stats->resizes;
+  hm->stats->resize_ns += now > start ? now - start : 0;
+}
+#endif
@@ -5,17 +5,278 @@
 
 #include "../../3rd/hashmap.c/hashmap.h"
 
+#include <ovrand.h>
+
+#ifdef HASHMAP_STATS
+#  include <stdatomic.h>
+
+struct ov_hm_stats {
+  uint64_t resizes;
+  uint64_t resize_ns;
+  atomic_uint_least64_t get_hits;
+  atomic_uint_least64_t get_misses;
+};
+#endif
+
 struct ov_hashmap {
   struct hashmap *map;
-  union {
-    ov_hashmap_get_key_func get_key;
-    size_t key_bytes;
-  };
+  ov_hashmap_get_key_func get_key; // NULL for static key hashmaps
+  size_t key_bytes;                // used only when get_key is NULL
 #ifdef ALLOCATE_LOGGER
-  struct ov_filepos const *filepos;
+  // Copied rather than referenced: the table may reallocate on clear or delete,
+  // long after the filepos passed to set has gone out of scope.
+  struct ov_filepos filepos;
+#endif
+#ifdef HASHMAP_STATS
+  // Points at stats_storage, so counters can be updated from functions taking a const hashmap.
+  struct ov_hm_stats *stats;
+  struct ov_hm_stats stats_storage;
 #endif
 };
 
 uint64_t sip_hash_1_3(const void *data, size_t len, uint64_t seed0, uint64_t seed1);
 void *ov_hm_realloc(void *const p, size_t const s, void *const udata);
 void ov_hm_free(void *const p, void *const udata);
+
+/**
+ * @brief Generate a fresh pair of hash seeds
+ *
+ * @param seed0 Receives the first seed. Must not be NULL.
+ * @param seed1 Receives the second seed. Must not be NULL.
+ */
+void ov_hm_generate_seeds(uint64_t *const seed0, uint64_t *const seed1);
+
+/**
+ * @brief Hash the key of an item the same way the underlying table does
+ *
+ * @param hm Hashmap describing how to extract the key. Must not be NULL.
+ * @param item Item or key item to hash. Must not be NULL.
+ * @param seed0 First hash seed
+ * @param seed1 Second hash seed
+ * @return Hash value
+ */
+NODISCARD uint64_t ov_hm_hash(struct ov_hashmap const *const hm,
+                              void const *const item,
+                              uint64_t const seed0,
+                              uint64_t const seed1);
+
+/**
+ * @brief Compare the keys of two items the same way the underlying table does
+ *
+ * @param a First item
+ * @param b Second item
+ * @param udata struct ov_hashmap describing how to extract the key
+ * @return 0 if the keys are equal, otherwise a value that orders the keys
+ */
+NODISCARD int ov_hm_compare(void const *const a, void const *const b, void const *const udata);
+
+/**
+ * @brief Create the underlying table for an ov_hashmap
+ *
+ * hm->get_key or hm->key_bytes must be set before calling this function.
+ * hm itself is used as udata for the table, so it must not move while the table is alive.
+ *
+ * @param hm Hashmap to initialize. Must not be NULL.
+ * @param item_size Size of each item
+ * @param cap Initial capacity
+ * @param seed0 First hash seed
+ * @param seed1 Second hash seed
+ * @return true on success, false on memory allocation failure
+ */
+NODISCARD bool ov_hm_init(struct ov_hashmap *const hm,
+                          size_t const item_size,
+                          size_t const cap,
+                          uint64_t const seed0,
+                          uint64_t const seed1);
+
+/**
+ * @brief Grow the table so that n items fit without further rehashing
+ *
+ * Unlike ov_hm_reserve, the minimum size is left alone, so deletes can shrink the table again.
+ *
+ * @param map Table to grow. Must not be NULL.
+ * @param n Number of items to make room for
+ * @return true on success, false on memory allocation failure
+ */
+NODISCARD bool ov_hm_grow(struct hashmap *const map, size_t const n);
+
+/**
+ * @brief Grow the table so that n items fit without further rehashing
+ *
+ * The new size also becomes the floor the table will not shrink below.
+ *
+ * @param map Table to grow. Must not be NULL.
+ * @param n Number of items to make room for
+ * @return true on success, false on memory allocation failure
+ */
+NODISCARD bool ov_hm_reserve(struct hashmap *const map, size_t const n);
+
+/**
+ * @brief Shrink the table to the smallest size that holds the current items
+ *
+ * @param map Table to shrink. Must not be NULL.
+ * @return true on success, false on memory allocation failure
+ */
+NODISCARD bool ov_hm_shrink_to_fit(struct hashmap *const map);
+
+/**
+ * @brief Get the item size of the table
+ *
+ * @param map Table. Must not be NULL.
+ * @return Size of each item in bytes
+ */
+NODISCARD size_t ov_hm_item_size(struct hashmap const *const map);
+
+/**
+ * @brief Remove every item for which keep returns false
+ *
+ * Walks the buckets once and removes items in place with the same backward shift as a delete,
+ * so no rehashing happens while scanning. The table is shrunk afterwards if it became sparse.
+ *
+ * @param map Table. Must not be NULL.
+ * @param keep Predicate called once per item (possibly again for an item that was shifted). Must not be NULL.
+ * @param udata Passed to keep.
+ * @return Number of removed items
+ */
+size_t ov_hm_retain(struct hashmap *const map, bool (*const keep)(void const *item, void *udata), void *const udata);
+
+// Frozen image layout. Every offset is relative to the start of the image, so the image can be
+// copied or mapped anywhere. Values are stored in native byte order; the magic doubles as a
+// byte order check.
+//
+//   struct ov_hm_frozen_header
+//   uint32_t displacements[nbuckets]
+//   item items[count] (at items_offset, 8-byte aligned)
+//
+// Keys are assigned to buckets, and each bucket gets a displacement that sends all of its keys
+// to distinct slots of the item array (hash and displace). Buckets holding a single key store the
+// slot directly with ov_hm_frozen_direct set instead.
+struct ov_hm_frozen_header {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t seed0;
+  uint64_t seed1;
+  uint64_t count;
+  uint64_t nbuckets;
+  uint64_t item_size;
+  uint64_t key_bytes;
+  uint64_t buckets_offset;
+  uint64_t items_offset;
+  uint64_t total_bytes;
+};
+
+static uint32_t const ov_hm_frozen_magic = 0x48504f46; // "FOPH"
+static uint32_t const ov_hm_frozen_version = 1;
+static uint32_t const ov_hm_frozen_direct = 0x80000000;
+static uint64_t const ov_hm_frozen_max_count = 0x7fffffff;
+
+static inline uint32_t ov_hm_frozen_range(uint32_t const x, uint64_t const n) {
+  return (uint32_t)(((uint64_t)x * n) >> 32);
+}
+
+static inline uint32_t ov_hm_frozen_bucket(uint64_t const hash, uint64_t const nbuckets) {
+  return ov_hm_frozen_range((uint32_t)hash, nbuckets);
+}
+
+static inline uint32_t ov_hm_frozen_slot(uint64_t const hash, uint32_t const displacement, uint64_t const count) {
+  if (displacement & ov_hm_frozen_direct) {
+    return displacement & ~ov_hm_frozen_direct;
+  }
+  return ov_hm_frozen_range((uint32_t)((hash >> 32) ^ ov_rand_splitmix64(displacement)), count);
+}
+
+// Snapshot image layout. Like the frozen image, every offset is relative to the start of the image
+// and values are stored in native byte order.
+//
+//   struct ov_hm_snapshot_header
+//   bucket buckets[nbuckets] (at buckets_offset, 8-byte aligned)
+//
+// The bucket array is the robin hood table exactly as ov_hashmap keeps it in memory, so an image
+// can be queried in place or copied back into a live hashmap without rehashing. Empty buckets are
+// zeroed. bucket_size depends on the pointer size of the writer, which validation checks.
+struct ov_hm_snapshot_header {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t seed0;
+  uint64_t seed1;
+  uint64_t count;
+  uint64_t nbuckets;
+  uint64_t item_size;
+  uint64_t key_bytes;
+  uint64_t bucket_size;
+  uint64_t load_factor; // percent
+  uint64_t buckets_offset;
+  uint64_t total_bytes;
+};
+
+static uint32_t const ov_hm_snapshot_magic = 0x5348564f; // "OVHS"
+static uint32_t const ov_hm_snapshot_version = 1;
+
+/**
+ * @brief Get the size of a bucket holding items of the given size
+ *
+ * @param item_size Size of each item
+ * @return Size of each bucket in bytes
+ */
+NODISCARD size_t ov_hm_bucket_size(size_t const item_size);
+
+/**
+ * @brief Fill the table-dependent fields of a snapshot header
+ *
+ * Sets seeds, count, nbuckets, item_size, bucket_size and load_factor.
+ *
+ * @param map Table. Must not be NULL.
+ * @param h Header to fill. Must not be NULL.
+ */
+void ov_hm_snapshot_describe(struct hashmap const *const map, struct ov_hm_snapshot_header *const h);
+
+/**
+ * @brief Copy the bucket array of the table, zeroing empty buckets
+ *
+ * @param map Table. Must not be NULL.
+ * @param dest Receives nbuckets * bucket_size bytes. Must not be NULL.
+ */
+void ov_hm_snapshot_write(struct hashmap *const map, void *const dest);
+
+/**
+ * @brief Replace the contents of an empty table with the buckets of a snapshot
+ *
+ * The table must have been created with the seeds and item size recorded in the header.
+ *
+ * @param map Empty table. Must not be NULL.
+ * @param h Validated snapshot header. Must not be NULL.
+ * @param buckets Bucket array of the snapshot. Must not be NULL.
+ * @return true on success, false on memory allocation failure
+ */
+NODISCARD bool ov_hm_snapshot_restore(struct hashmap *const map,
+                                      struct ov_hm_snapshot_header const *const h,
+                                      void const *const buckets);
+
+/**
+ * @brief Look up a key in a snapshot bucket array without copying it
+ *
+ * @param h Validated snapshot header. Must not be NULL.
+ * @param buckets Bucket array of the snapshot. Must not be NULL.
+ * @param key_item Key or item containing key. Must not be NULL.
+ * @return Pointer to the item inside the bucket array, or NULL if not found
+ */
+NODISCARD void const *ov_hm_snapshot_find(struct ov_hm_snapshot_header const *const h,
+                                          void const *const buckets,
+                                          void const *const key_item);
+
+/**
+ * @brief Fill the structural part of ov_hashmap_stats by scanning the table
+ *
+ * @param map Table to inspect. Must not be NULL.
+ * @param stats Receives count, capacity, load factor and probe distances. Must not be NULL.
+ */
+void ov_hm_scan_stats(struct hashmap *const map, struct ov_hashmap_stats *const stats);
+
+#ifdef HASHMAP_STATS
+void ov_hm_stats_init(struct ov_hashmap *const hm);
+NODISCARD uint64_t ov_hm_stats_now(void);
+NODISCARD size_t ov_hm_stats_nbuckets(struct hashmap const *const map);
+// Whether the next set (grow) or delete (shrink) of the table will resize it.
+NODISCARD bool ov_hm_stats_resize_pending(struct hashmap const *const map, bool const grow);
+void ov_hm_stats_record_resize(struct ov_hashmap const *const hm, size_t const nbuckets_before, uint64_t const start);
+#endif
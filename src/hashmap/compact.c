@@ -0,0 +1,358 @@
+#include "common.h"
+
+#include <ovarray.h>
+#include <ovhashmap_compact.h>
+
+#include <assert.h>
+#include <string.h>
+
+// Every live entry stores the low 31 bits of its hash with this bit set, so a zero tag marks a deleted entry.
+static uint32_t const live_bit = 0x80000000u;
+
+static size_t const min_index_size = 8;
+static size_t const max_index_size = (size_t)1 << 31;
+
+struct ov_hashmap_compact {
+  struct ov_hashmap key; // key description and filepos only, map is not used
+  char *items;           // ov_array of entries in insertion order, including deleted ones
+  uint32_t *tags;        // ov_array parallel to items
+  void *index;           // open addressing table of entry index + 1, 0 marks an empty slot
+  size_t index_mask;
+  size_t limit; // number of entries the index can address before it has to be rebuilt
+  size_t count;
+  size_t item_size;
+  uint64_t seed0;
+  uint64_t seed1;
+  unsigned int index_width;
+};
+
+static inline size_t index_get(struct ov_hashmap_compact const *const hm, size_t const i) {
+  switch (hm->index_width) {
+  case 1:
+    return ((uint8_t const *)hm->index)[i];
+  case 2:
+    return ((uint16_t const *)hm->index)[i];
+  default:
+    return ((uint32_t const *)hm->index)[i];
+  }
+}
+
+static inline void index_set(struct ov_hashmap_compact *const hm, size_t const i, size_t const v) {
+  switch (hm->index_width) {
+  case 1:
+    ((uint8_t *)hm->index)[i] = (uint8_t)v;
+    break;
+  case 2:
+    ((uint16_t *)hm->index)[i] = (uint16_t)v;
+    break;
+  default:
+    ((uint32_t *)hm->index)[i] = (uint32_t)v;
+    break;
+  }
+}
+
+static inline uint32_t calc_tag(struct ov_hashmap_compact const *const hm, void const *const item) {
+  return (uint32_t)ov_hm_hash(&hm->key, item, hm->seed0, hm->seed1) | live_bit;
+}
+
+static inline char *item_at(struct ov_hashmap_compact const *const hm, size_t const e) {
+  return hm->items + e * hm->item_size;
+}
+
+// Returns the index slot that refers to the item with the given key, or SIZE_MAX if not found.
+// When not found, *empty receives the slot where the key would be inserted.
+static size_t find(struct ov_hashmap_compact const *const hm,
+                   void const *const key_item,
+                   uint32_t const tag,
+                   size_t *const empty) {
+  size_t i = tag & hm->index_mask;
+  for (;;) {
+    size_t const v = index_get(hm, i);
+    if (!v) {
+      if (empty) {
+        *empty = i;
+      }
+      return SIZE_MAX;
+    }
+    if (hm->tags[v - 1] == tag && ov_hm_compare(item_at(hm, v - 1), key_item, &hm->key) == 0) {
+      return i;
+    }
+    i = (i + 1) & hm->index_mask;
+  }
+}
+
+static void index_insert(struct ov_hashmap_compact *const hm, size_t const e) {
+  size_t i = hm->tags[e] & hm->index_mask;
+  while (index_get(hm, i)) {
+    i = (i + 1) & hm->index_mask;
+  }
+  index_set(hm, i, e + 1);
+}
+
+// Drops deleted entries and rebuilds the index with the given number of slots.
+// On failure the map is left unchanged.
+static bool rebuild(struct ov_hashmap_compact *const hm, size_t const index_size MEM_FILEPOS_PARAMS) {
+  size_t const limit = index_size / 3 * 2;
+  unsigned int const width = limit < UINT8_MAX ? 1 : limit < UINT16_MAX ? 2 : 4;
+  void *index = NULL;
+  if (!ov_array_grow((void **)&hm->items, hm->item_size, limit MEM_FILEPOS_VALUES_PASSTHRU) ||
+      !ov_array_grow((void **)&hm->tags, sizeof(uint32_t), limit MEM_FILEPOS_VALUES_PASSTHRU) ||
+      !ov_mem_realloc(&index, index_size, width MEM_FILEPOS_VALUES_PASSTHRU)) {
+    return false;
+  }
+  memset(index, 0, index_size * width);
+
+  size_t const len = ov_array_length(hm->items);
+  size_t n = 0;
+  for (size_t e = 0; e < len; ++e) {
+    if (!hm->tags[e]) {
+      continue;
+    }
+    if (n != e) {
+      memcpy(item_at(hm, n), item_at(hm, e), hm->item_size);
+      hm->tags[n] = hm->tags[e];
+    }
+    ++n;
+  }
+  ov_array_set_length(hm->items, n);
+  ov_array_set_length(hm->tags, n);
+
+  if (hm->index) {
+    ov_mem_free(&hm->index MEM_FILEPOS_VALUES_PASSTHRU);
+  }
+  hm->index = index;
+  hm->index_width = width;
+  hm->index_mask = index_size - 1;
+  hm->limit = limit;
+  for (size_t e = 0; e < n; ++e) {
+    index_insert(hm, e);
+  }
+  return true;
+}
+
+static struct ov_hashmap_compact *create(size_t const item_size,
+                                         size_t const cap,
+                                         ov_hashmap_get_key_func const get_key,
+                                         size_t const key_bytes MEM_FILEPOS_PARAMS) {
+  struct ov_hashmap_compact *result = NULL;
+  struct ov_hashmap_compact *hm = NULL;
+
+  size_t index_size = min_index_size;
+  while (index_size / 3 * 2 < cap) {
+    if (index_size >= max_index_size) {
+      goto cleanup;
+    }
+    index_size *= 2;
+  }
+
+  if (!ov_mem_realloc(&hm, 1, sizeof(*hm) MEM_FILEPOS_VALUES_PASSTHRU)) {
+    goto cleanup;
+  }
+  *hm = (struct ov_hashmap_compact){
+      .key =
+          {
+              .get_key = get_key,
+              .key_bytes = key_bytes,
+#ifdef ALLOCATE_LOGGER
+              .filepos = *filepos,
+#endif
+          },
+      .item_size = item_size,
+  };
+  ov_hm_generate_seeds(&hm->seed0, &hm->seed1);
+  if (!rebuild(hm, index_size MEM_FILEPOS_VALUES_PASSTHRU)) {
+    goto cleanup;
+  }
+
+  result = hm;
+  hm = NULL;
+
+cleanup:
+  if (hm) {
+    ov_hashmap_compact_destroy(&hm MEM_FILEPOS_VALUES_PASSTHRU);
+  }
+  return result;
+}
+
+struct ov_hashmap_compact *ov_hashmap_compact_create_dynamic(size_t const item_size,
+                                                             size_t const cap,
+                                                             ov_hashmap_get_key_func const get_key MEM_FILEPOS_PARAMS) {
+  assert(item_size > 0 && "item_size must be greater than 0");
+  assert(get_key != NULL && "get_key must not be NULL");
+#ifdef ALLOCATE_LOGGER
+  assert(filepos != NULL && "filepos must not be NULL");
+#endif
+  if (!get_key || item_size == 0) {
+    return NULL;
+  }
+  return create(item_size, cap, get_key, 0 MEM_FILEPOS_VALUES_PASSTHRU);
+}
+
+struct ov_hashmap_compact *
+ov_hashmap_compact_create_static(size_t const item_size, size_t const cap, size_t const key_bytes MEM_FILEPOS_PARAMS) {
+  assert(item_size > 0 && "item_size must be greater than 0");
+  assert(key_bytes > 0 && "key_bytes must be greater than 0");
+#ifdef ALLOCATE_LOGGER
+  assert(filepos != NULL && "filepos must not be NULL");
+#endif
+  if (item_size == 0 || key_bytes == 0) {
+    return NULL;
+  }
+  return create(item_size, cap, NULL, key_bytes MEM_FILEPOS_VALUES_PASSTHRU);
+}
+
+void ov_hashmap_compact_destroy(struct ov_hashmap_compact **const hmp MEM_FILEPOS_PARAMS) {
+  assert(hmp != NULL && "hmp must not be NULL");
+  assert(*hmp != NULL && "hashmap is already destroyed or not initialized");
+#ifdef ALLOCATE_LOGGER
+  assert(filepos != NULL && "filepos must not be NULL");
+#endif
+  if (!hmp || !*hmp) {
+    return;
+  }
+
+  struct ov_hashmap_compact *hm = *hmp;
+  if (hm->index) {
+    ov_mem_free(&hm->index MEM_FILEPOS_VALUES_PASSTHRU);
+  }
+  if (hm->tags) {
+    ov_array_destroy((void **)&hm->tags MEM_FILEPOS_VALUES_PASSTHRU);
+  }
+  if (hm->items) {
+    ov_array_destroy((void **)&hm->items MEM_FILEPOS_VALUES_PASSTHRU);
+  }
+  ov_mem_free((void **)hmp MEM_FILEPOS_VALUES_PASSTHRU);
+}
+
+void ov_hashmap_compact_clear(struct ov_hashmap_compact *const hm) {
+  assert(hm != NULL && "hm must not be NULL");
+  if (!hm) {
+    return;
+  }
+
+  ov_array_set_length(hm->items, 0);
+  ov_array_set_length(hm->tags, 0);
+  memset(hm->index, 0, (hm->index_mask + 1) * hm->index_width);
+  hm->count = 0;
+}
+
+size_t ov_hashmap_compact_count(struct ov_hashmap_compact const *const hm) {
+  if (!hm) {
+    return 0;
+  }
+  return hm->count;
+}
+
+void const *ov_hashmap_compact_get(struct ov_hashmap_compact const *const hm, void const *const key_item) {
+  assert(hm != NULL && "hm must not be NULL");
+  assert(key_item != NULL && "key_item must not be NULL");
+  if (!hm || !key_item) {
+    return NULL;
+  }
+
+  size_t const slot = find(hm, key_item, calc_tag(hm, key_item), NULL);
+  if (slot == SIZE_MAX) {
+    return NULL;
+  }
+  return item_at(hm, index_get(hm, slot) - 1);
+}
+
+bool ov_hashmap_compact_set(struct ov_hashmap_compact *const hm, void const *const item MEM_FILEPOS_PARAMS) {
+  assert(hm != NULL && "hm must not be NULL");
+  assert(item != NULL && "item must not be NULL");
+#ifdef ALLOCATE_LOGGER
+  assert(filepos != NULL && "filepos must not be NULL");
+#endif
+  if (!hm || !item) {
+    return false;
+  }
+
+#ifdef ALLOCATE_LOGGER
+  hm->key.filepos = *filepos;
+#endif
+  uint32_t const tag = calc_tag(hm, item);
+  size_t empty = 0;
+  size_t const slot = find(hm, item, tag, &empty);
+  if (slot != SIZE_MAX) {
+    memcpy(item_at(hm, index_get(hm, slot) - 1), item, hm->item_size);
+    return true;
+  }
+
+  size_t len = ov_array_length(hm->items);
+  if (len >= hm->limit) {
+    // Grow only when live entries fill more than half of the entries, otherwise reclaim deleted ones.
+    size_t index_size = hm->index_mask + 1;
+    if (hm->count >= hm->limit / 2) {
+      if (index_size >= max_index_size) {
+        return false;
+      }
+      index_size *= 2;
+    }
+    if (!rebuild(hm, index_size MEM_FILEPOS_VALUES_PASSTHRU)) {
+      return false;
+    }
+    len = ov_array_length(hm->items);
+    (void)find(hm, item, tag, &empty);
+  }
+
+  memcpy(item_at(hm, len), item, hm->item_size);
+  hm->tags[len] = tag;
+  ov_array_set_length(hm->items, len + 1);
+  ov_array_set_length(hm->tags, len + 1);
+  index_set(hm, empty, len + 1);
+  ++hm->count;
+  return true;
+}
+
+void const *ov_hashmap_compact_delete(struct ov_hashmap_compact *const hm, void const *const key_item) {
+  assert(hm != NULL && "hm must not be NULL");
+  assert(key_item != NULL && "key_item must not be NULL");
+  if (!hm || !key_item) {
+    return NULL;
+  }
+
+  size_t i = find(hm, key_item, calc_tag(hm, key_item), NULL);
+  if (i == SIZE_MAX) {
+    return NULL;
+  }
+  size_t const e = index_get(hm, i) - 1;
+
+  // Backward shift deletion keeps probe sequences intact without tombstones in the index.
+  size_t j = i;
+  for (;;) {
+    j = (j + 1) & hm->index_mask;
+    size_t const v = index_get(hm, j);
+    if (!v) {
+      break;
+    }
+    size_t const home = hm->tags[v - 1] & hm->index_mask;
+    if ((j > i && (home <= i || home > j)) || (j < i && home <= i && home > j)) {
+      index_set(hm, i, v);
+      i = j;
+    }
+  }
+  index_set(hm, i, 0);
+
+  hm->tags[e] = 0;
+  --hm->count;
+  return item_at(hm, e);
+}
+
+bool ov_hashmap_compact_iter(struct ov_hashmap_compact *const hm, size_t *const i, void **const item) {
+  assert(hm != NULL && "hm must not be NULL");
+  assert(i != NULL && "i must not be NULL");
+  assert(item != NULL && "item must not be NULL");
+  if (!hm || !i || !item) {
+    return false;
+  }
+
+  size_t const len = ov_array_length(hm->items);
+  while (*i < len) {
+    size_t const e = (*i)++;
+    if (hm->tags[e]) {
+      *item = item_at(hm, e);
+      return true;
+    }
+  }
+  return false;
+}
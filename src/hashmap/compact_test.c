@@ -0,0 +1,142 @@
+#include <ovtest.h>
+
+#include <ovhashmap_compact.h>
+
+struct test_item_static {
+  uint32_t key;
+  uint32_t v;
+};
+
+struct test_item_dynamic {
+  char const *key;
+  size_t v;
+};
+
+static void test_get_key_dynamic(void const *const item, void const **const key, size_t *const key_bytes) {
+  struct test_item_dynamic const *const it = (struct test_item_dynamic const *)item;
+  *key = it->key;
+  *key_bytes = strlen(it->key);
+}
+
+static void test_insertion_order(void) {
+  struct ov_hashmap_compact *hm =
+      OV_HASHMAP_COMPACT_CREATE_DYNAMIC(sizeof(struct test_item_dynamic), 0, test_get_key_dynamic);
+  if (!TEST_CHECK(hm != NULL)) {
+    return;
+  }
+
+  static char const *const keys[] = {"delta", "alpha", "echo", "charlie", "bravo"};
+  for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); ++i) {
+    if (!TEST_CHECK(OV_HASHMAP_COMPACT_SET(hm, &((struct test_item_dynamic){.key = keys[i], .v = i})))) {
+      goto cleanup;
+    }
+  }
+  // updating keeps the position, deleting and re-adding moves to the end
+  TEST_CHECK(OV_HASHMAP_COMPACT_SET(hm, &((struct test_item_dynamic){.key = "echo", .v = 100})));
+  struct test_item_dynamic const *const deleted =
+      (struct test_item_dynamic const *)OV_HASHMAP_COMPACT_DELETE(hm, &(struct test_item_dynamic){.key = "alpha"});
+  TEST_CHECK(deleted != NULL && deleted->v == 1);
+  TEST_CHECK(OV_HASHMAP_COMPACT_DELETE(hm, &(struct test_item_dynamic){.key = "alpha"}) == NULL);
+  TEST_CHECK(OV_HASHMAP_COMPACT_SET(hm, &((struct test_item_dynamic){.key = "alpha", .v = 200})));
+  TEST_CHECK(OV_HASHMAP_COMPACT_COUNT(hm) == 5);
+
+  {
+    static char const *const want[] = {"delta", "echo", "charlie", "bravo", "alpha"};
+    size_t iter = 0, n = 0;
+    struct test_item_dynamic *item = NULL;
+    while (OV_HASHMAP_COMPACT_ITER(hm, &iter, &item)) {
+      if (!TEST_CHECK(n < 5 && strcmp(item->key, want[n]) == 0)) {
+        TEST_MSG("position %zu: got %s", n, item->key);
+      }
+      ++n;
+    }
+    TEST_CHECK(n == 5);
+  }
+
+  struct test_item_dynamic const *const got =
+      (struct test_item_dynamic const *)OV_HASHMAP_COMPACT_GET(hm, &(struct test_item_dynamic){.key = "echo"});
+  TEST_CHECK(got != NULL && got->v == 100);
+  TEST_CHECK(OV_HASHMAP_COMPACT_GET(hm, &(struct test_item_dynamic){.key = "ech"}) == NULL);
+
+  OV_HASHMAP_COMPACT_CLEAR(hm);
+  TEST_CHECK(OV_HASHMAP_COMPACT_COUNT(hm) == 0);
+  TEST_CHECK(OV_HASHMAP_COMPACT_GET(hm, &(struct test_item_dynamic){.key = "echo"}) == NULL);
+
+cleanup:
+  OV_HASHMAP_COMPACT_DESTROY(&hm);
+  TEST_CHECK(hm == NULL);
+}
+
+static void test_growth_and_churn(void) {
+  enum { n = 100000 };
+  struct ov_hashmap_compact *hm =
+      OV_HASHMAP_COMPACT_CREATE_STATIC(sizeof(struct test_item_static), 0, sizeof(uint32_t));
+  if (!TEST_CHECK(hm != NULL)) {
+    return;
+  }
+
+  // crosses the 8, 16 and 32 bit index widths
+  for (uint32_t i = 0; i < n; ++i) {
+    if (!TEST_CHECK(OV_HASHMAP_COMPACT_SET(hm, &((struct test_item_static){.key = i, .v = i})))) {
+      goto cleanup;
+    }
+  }
+  TEST_CHECK(OV_HASHMAP_COMPACT_COUNT(hm) == n);
+
+  // delete every third item, then add new keys to force compaction of deleted entries
+  for (uint32_t i = 0; i < n; i += 3) {
+    TEST_CHECK(OV_HASHMAP_COMPACT_DELETE(hm, &i) != NULL);
+  }
+  for (uint32_t i = n; i < n + n / 2; ++i) {
+    if (!TEST_CHECK(OV_HASHMAP_COMPACT_SET(hm, &((struct test_item_static){.key = i, .v = i})))) {
+      goto cleanup;
+    }
+  }
+  for (uint32_t i = 0; i < n + n / 2; ++i) {
+    struct test_item_static const *const got = (struct test_item_static const *)OV_HASHMAP_COMPACT_GET(hm, &i);
+    bool const want = i >= n || i % 3 != 0;
+    if (!TEST_CHECK((got != NULL) == want)) {
+      TEST_MSG("key %u", i);
+      goto cleanup;
+    }
+    if (got) {
+      TEST_CHECK(got->v == i);
+    }
+  }
+
+  {
+    // iteration still follows insertion order
+    size_t iter = 0, found = 0;
+    uint32_t prev = 0;
+    bool ordered = true;
+    struct test_item_static *item = NULL;
+    while (OV_HASHMAP_COMPACT_ITER(hm, &iter, &item)) {
+      if (found && item->key <= prev) {
+        ordered = false;
+      }
+      prev = item->key;
+      ++found;
+    }
+    TEST_CHECK(ordered);
+    TEST_CHECK(found == OV_HASHMAP_COMPACT_COUNT(hm));
+  }
+
+  {
+    // deleting while iterating
+    size_t iter = 0;
+    struct test_item_static *item = NULL;
+    while (OV_HASHMAP_COMPACT_ITER(hm, &iter, &item)) {
+      TEST_CHECK(OV_HASHMAP_COMPACT_DELETE(hm, &item->key) != NULL);
+    }
+    TEST_CHECK(OV_HASHMAP_COMPACT_COUNT(hm) == 0);
+  }
+
+cleanup:
+  OV_HASHMAP_COMPACT_DESTROY(&hm);
+}
+
+TEST_LIST = {
+    {"test_insertion_order", test_insertion_order},
+    {"test_growth_and_churn", test_growth_and_churn},
+    {NULL, NULL},
+};
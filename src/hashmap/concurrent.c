@@ -0,0 +1,326 @@
+#include "common.h"
+
+#include <ovhashmap_concurrent.h>
+#include <ovthreads.h>
+
+#include <assert.h>
+#include <stdatomic.h>
+#include <string.h>
+
+enum {
+  cache_line_size = 64,
+  default_shards = 16,
+  max_shard_bits = 8,
+  spin_limit = 64,
+};
+
+// Shard lock state: the top bit is set while a writer holds or waits for the shard,
+// the remaining bits count active readers.
+static unsigned int const writer_bit = 0x80000000u;
+
+struct shard {
+  _Alignas(cache_line_size) atomic_uint state;
+  atomic_size_t count;
+  mtx_t writer;
+  struct ov_hashmap hm;
+};
+
+struct ov_hashmap_concurrent {
+  struct shard *shards;
+  size_t shard_mask;
+  size_t iter_mask;
+  unsigned int shard_bits;
+  unsigned int iter_shift;
+  size_t item_size;
+  uint64_t seed0;
+  uint64_t seed1;
+};
+
+static inline void backoff(unsigned int *const spins) {
+  if (++*spins > spin_limit) {
+    thrd_yield();
+  }
+}
+
+// Readers never block each other; they only back off while a writer holds or is waiting for the shard.
+// This keeps reads to a single atomic increment and decrement on an uncontended path.
+static void shard_read_lock(struct shard *const s) {
+  unsigned int spins = 0;
+  for (;;) {
+    unsigned int st = atomic_load_explicit(&s->state, memory_order_relaxed);
+    if (!(st & writer_bit) &&
+        atomic_compare_exchange_weak_explicit(&s->state, &st, st + 1, memory_order_acquire, memory_order_relaxed)) {
+      return;
+    }
+    backoff(&spins);
+  }
+}
+
+static void shard_read_unlock(struct shard *const s) { atomic_fetch_sub_explicit(&s->state, 1, memory_order_release); }
+
+static void shard_write_lock(struct shard *const s) {
+  mtx_lock(&s->writer);
+  atomic_fetch_or_explicit(&s->state, writer_bit, memory_order_acquire);
+  unsigned int spins = 0;
+  while (atomic_load_explicit(&s->state, memory_order_acquire) & ~writer_bit) {
+    backoff(&spins);
+  }
+}
+
+static void shard_write_unlock(struct shard *const s) {
+  atomic_fetch_and_explicit(&s->state, ~writer_bit, memory_order_release);
+  mtx_unlock(&s->writer);
+}
+
+// The underlying table only uses the low 48 bits of the hash, so the shard index is taken
+// from the top bits to keep shard selection independent of the bucket position.
+static inline struct shard *select_shard(struct ov_hashmap_concurrent *const hm, uint64_t const hash) {
+  return hm->shards + ((size_t)(hash >> 56) & hm->shard_mask);
+}
+
+static struct ov_hashmap_concurrent *create(size_t const item_size,
+                                            size_t const cap,
+                                            ov_hashmap_get_key_func const get_key,
+                                            size_t const key_bytes,
+                                            size_t const shards MEM_FILEPOS_PARAMS) {
+  struct ov_hashmap_concurrent *result = NULL;
+  struct ov_hashmap_concurrent *hm = NULL;
+  size_t initialized = 0;
+
+  if (!ov_mem_realloc(&hm, 1, sizeof(*hm) MEM_FILEPOS_VALUES_PASSTHRU)) {
+    goto cleanup;
+  }
+  *hm = (struct ov_hashmap_concurrent){
+      .item_size = item_size,
+  };
+
+  {
+    size_t const want = shards ? shards : default_shards;
+    while (hm->shard_bits < max_shard_bits && ((size_t)1 << hm->shard_bits) < want) {
+      ++hm->shard_bits;
+    }
+  }
+  size_t const n = (size_t)1 << hm->shard_bits;
+  hm->shard_mask = n - 1;
+  hm->iter_shift = (unsigned int)(sizeof(size_t) * 8) - hm->shard_bits;
+  hm->iter_mask = hm->shard_bits ? ((size_t)1 << hm->iter_shift) - 1 : SIZE_MAX;
+  ov_hm_generate_seeds(&hm->seed0, &hm->seed1);
+
+  if (!ov_mem_aligned_alloc(&hm->shards, n, sizeof(struct shard), cache_line_size MEM_FILEPOS_VALUES_PASSTHRU)) {
+    goto cleanup;
+  }
+
+  {
+    size_t const shard_cap = (cap + n - 1) / n;
+    for (; initialized < n; ++initialized) {
+      struct shard *const s = hm->shards + initialized;
+      atomic_init(&s->state, 0);
+      atomic_init(&s->count, 0);
+      s->hm = (struct ov_hashmap){
+          .get_key = get_key,
+          .key_bytes = key_bytes,
+#ifdef ALLOCATE_LOGGER
+          .filepos = *filepos,
+#endif
+      };
+      if (mtx_init(&s->writer, mtx_plain) != thrd_success) {
+        goto cleanup;
+      }
+      if (!ov_hm_init(&s->hm, item_size, shard_cap, hm->seed0, hm->seed1)) {
+        mtx_destroy(&s->writer);
+        goto cleanup;
+      }
+    }
+  }
+
+  result = hm;
+  hm = NULL;
+
+cleanup:
+  if (hm) {
+    if (hm->shards) {
+      for (size_t i = 0; i < initialized; ++i) {
+        hashmap_free(hm->shards[i].hm.map);
+        mtx_destroy(&hm->shards[i].writer);
+      }
+      ov_mem_aligned_free(&hm->shards MEM_FILEPOS_VALUES_PASSTHRU);
+    }
+    ov_mem_free(&hm MEM_FILEPOS_VALUES_PASSTHRU);
+  }
+  return result;
+}
+
+struct ov_hashmap_concurrent *ov_hashmap_concurrent_create_dynamic(size_t const item_size,
+                                                                   size_t const cap,
+                                                                   ov_hashmap_get_key_func const get_key,
+                                                                   size_t const shards MEM_FILEPOS_PARAMS) {
+  assert(item_size > 0 && "item_size must be greater than 0");
+  assert(get_key != NULL && "get_key must not be NULL");
+#ifdef ALLOCATE_LOGGER
+  assert(filepos != NULL && "filepos must not be NULL");
+#endif
+  if (!get_key || item_size == 0) {
+    return NULL;
+  }
+  return create(item_size, cap, get_key, 0, shards MEM_FILEPOS_VALUES_PASSTHRU);
+}
+
+struct ov_hashmap_concurrent *ov_hashmap_concurrent_create_static(size_t const item_size,
+                                                                  size_t const cap,
+                                                                  size_t const key_bytes,
+                                                                  size_t const shards MEM_FILEPOS_PARAMS) {
+  assert(item_size > 0 && "item_size must be greater than 0");
+  assert(key_bytes > 0 && "key_bytes must be greater than 0");
+#ifdef ALLOCATE_LOGGER
+  assert(filepos != NULL && "filepos must not be NULL");
+#endif
+  if (item_size == 0 || key_bytes == 0) {
+    return NULL;
+  }
+  return create(item_size, cap, NULL, key_bytes, shards MEM_FILEPOS_VALUES_PASSTHRU);
+}
+
+void ov_hashmap_concurrent_destroy(struct ov_hashmap_concurrent **const hmp MEM_FILEPOS_PARAMS) {
+  assert(hmp != NULL && "hmp must not be NULL");
+  assert(*hmp != NULL && "hashmap is already destroyed or not initialized");
+#ifdef ALLOCATE_LOGGER
+  assert(filepos != NULL && "filepos must not be NULL");
+#endif
+  if (!hmp || !*hmp) {
+    return;
+  }
+
+  struct ov_hashmap_concurrent *hm = *hmp;
+  size_t const n = hm->shard_mask + 1;
+  for (size_t i = 0; i < n; ++i) {
+    struct shard *const s = hm->shards + i;
+#ifdef ALLOCATE_LOGGER
+    s->hm.filepos = *filepos;
+#endif
+    hashmap_free(s->hm.map);
+    s->hm.map = NULL;
+    mtx_destroy(&s->writer);
+  }
+  ov_mem_aligned_free(&hm->shards MEM_FILEPOS_VALUES_PASSTHRU);
+  ov_mem_free((void **)hmp MEM_FILEPOS_VALUES_PASSTHRU);
+}
+
+void ov_hashmap_concurrent_clear(struct ov_hashmap_concurrent *const hm) {
+  assert(hm != NULL && "hm must not be NULL");
+  if (!hm) {
+    return;
+  }
+
+  size_t const n = hm->shard_mask + 1;
+  for (size_t i = 0; i < n; ++i) {
+    struct shard *const s = hm->shards + i;
+    shard_write_lock(s);
+    hashmap_clear(s->hm.map, false);
+    atomic_store_explicit(&s->count, 0, memory_order_relaxed);
+    shard_write_unlock(s);
+  }
+}
+
+size_t ov_hashmap_concurrent_count(struct ov_hashmap_concurrent const *const hm) {
+  if (!hm) {
+    return 0;
+  }
+
+  size_t const n = hm->shard_mask + 1;
+  size_t r = 0;
+  for (size_t i = 0; i < n; ++i) {
+    r += atomic_load_explicit(&hm->shards[i].count, memory_order_relaxed);
+  }
+  return r;
+}
+
+bool ov_hashmap_concurrent_get(struct ov_hashmap_concurrent *const hm, void const *const key_item, void *const dest) {
+  assert(hm != NULL && "hm must not be NULL");
+  assert(key_item != NULL && "key_item must not be NULL");
+  if (!hm || !key_item) {
+    return false;
+  }
+
+  uint64_t const hash = ov_hm_hash(&hm->shards[0].hm, key_item, hm->seed0, hm->seed1);
+  struct shard *const s = select_shard(hm, hash);
+  shard_read_lock(s);
+  void const *const item = hashmap_get_with_hash(s->hm.map, key_item, hash);
+  if (item && dest) {
+    memcpy(dest, item, hm->item_size);
+  }
+  shard_read_unlock(s);
+  return item != NULL;
+}
+
+bool ov_hashmap_concurrent_set(struct ov_hashmap_concurrent *const hm, void const *const item MEM_FILEPOS_PARAMS) {
+  assert(hm != NULL && "hm must not be NULL");
+  assert(item != NULL && "item must not be NULL");
+#ifdef ALLOCATE_LOGGER
+  assert(filepos != NULL && "filepos must not be NULL");
+#endif
+  if (!hm || !item) {
+    return false;
+  }
+
+  uint64_t const hash = ov_hm_hash(&hm->shards[0].hm, item, hm->seed0, hm->seed1);
+  struct shard *const s = select_shard(hm, hash);
+  shard_write_lock(s);
+#ifdef ALLOCATE_LOGGER
+  s->hm.filepos = *filepos;
+#endif
+  hashmap_set_with_hash(s->hm.map, item, hash);
+  bool const ok = !hashmap_oom(s->hm.map);
+  atomic_store_explicit(&s->count, hashmap_count(s->hm.map), memory_order_relaxed);
+  shard_write_unlock(s);
+  return ok;
+}
+
+bool ov_hashmap_concurrent_delete(struct ov_hashmap_concurrent *const hm,
+                                  void const *const key_item,
+                                  void *const dest) {
+  assert(hm != NULL && "hm must not be NULL");
+  assert(key_item != NULL && "key_item must not be NULL");
+  if (!hm || !key_item) {
+    return false;
+  }
+
+  uint64_t const hash = ov_hm_hash(&hm->shards[0].hm, key_item, hm->seed0, hm->seed1);
+  struct shard *const s = select_shard(hm, hash);
+  shard_write_lock(s);
+  void const *const item = hashmap_delete_with_hash(s->hm.map, key_item, hash);
+  if (item && dest) {
+    memcpy(dest, item, hm->item_size);
+  }
+  atomic_store_explicit(&s->count, hashmap_count(s->hm.map), memory_order_relaxed);
+  shard_write_unlock(s);
+  return item != NULL;
+}
+
+bool ov_hashmap_concurrent_iter(struct ov_hashmap_concurrent *const hm, size_t *const i, void *const dest) {
+  assert(hm != NULL && "hm must not be NULL");
+  assert(i != NULL && "i must not be NULL");
+  assert(dest != NULL && "dest must not be NULL");
+  if (!hm || !i || !dest) {
+    return false;
+  }
+
+  // The iterator packs the shard index into the top bits and the bucket position into the rest.
+  size_t idx = hm->shard_bits ? *i >> hm->iter_shift : 0;
+  size_t pos = *i & hm->iter_mask;
+  for (;;) {
+    struct shard *const s = hm->shards + idx;
+    void *item = NULL;
+    shard_read_lock(s);
+    bool const found = hashmap_iter(s->hm.map, &pos, &item);
+    if (found) {
+      memcpy(dest, item, hm->item_size);
+    }
+    shard_read_unlock(s);
+    if (found || idx == hm->shard_mask) {
+      *i = hm->shard_bits ? (idx << hm->iter_shift) | pos : pos;
+      return found;
+    }
+    ++idx;
+    pos = 0;
+  }
+}
@@ -0,0 +1,194 @@
+#include <ovtest.h>
+
+#include <ovhashmap_concurrent.h>
+#include <ovthreads.h>
+
+#include <stdatomic.h>
+
+struct test_item_static {
+  uint32_t key;
+  uint32_t v;
+};
+
+struct test_item_dynamic {
+  char const *key;
+  size_t v;
+};
+
+static void test_get_key_dynamic(void const *const item, void const **const key, size_t *const key_bytes) {
+  struct test_item_dynamic const *const it = (struct test_item_dynamic const *)item;
+  *key = it->key;
+  *key_bytes = strlen(it->key);
+}
+
+static void test_static(void) {
+  struct ov_hashmap_concurrent *hm = OV_HASHMAP_CONCURRENT_CREATE_STATIC(
+      sizeof(struct test_item_static), 0, sizeof(uint32_t), 4);
+  if (!TEST_CHECK(hm != NULL)) {
+    return;
+  }
+
+  struct test_item_static got = {0};
+  TEST_CHECK(OV_HASHMAP_CONCURRENT_COUNT(hm) == 0);
+  TEST_CHECK(!OV_HASHMAP_CONCURRENT_GET(hm, &(uint32_t){1}, &got));
+
+  for (uint32_t i = 0; i < 1000; ++i) {
+    if (!TEST_CHECK(OV_HASHMAP_CONCURRENT_SET(hm, &((struct test_item_static){.key = i, .v = i * 2})))) {
+      goto cleanup;
+    }
+  }
+  TEST_CHECK(OV_HASHMAP_CONCURRENT_COUNT(hm) == 1000);
+  TEST_CHECK(OV_HASHMAP_CONCURRENT_GET(hm, &(uint32_t){500}, &got));
+  TEST_CHECK(got.key == 500 && got.v == 1000);
+  TEST_CHECK(OV_HASHMAP_CONCURRENT_GET(hm, &(uint32_t){999}, NULL));
+
+  // overwrite keeps the count
+  TEST_CHECK(OV_HASHMAP_CONCURRENT_SET(hm, &((struct test_item_static){.key = 500, .v = 1})));
+  TEST_CHECK(OV_HASHMAP_CONCURRENT_COUNT(hm) == 1000);
+  TEST_CHECK(OV_HASHMAP_CONCURRENT_GET(hm, &(uint32_t){500}, &got) && got.v == 1);
+
+  TEST_CHECK(OV_HASHMAP_CONCURRENT_DELETE(hm, &(uint32_t){500}, &got));
+  TEST_CHECK(got.key == 500);
+  TEST_CHECK(!OV_HASHMAP_CONCURRENT_DELETE(hm, &(uint32_t){500}, NULL));
+  TEST_CHECK(OV_HASHMAP_CONCURRENT_COUNT(hm) == 999);
+
+  {
+    size_t iter = 0;
+    size_t n = 0;
+    uint64_t sum = 0;
+    while (OV_HASHMAP_CONCURRENT_ITER(hm, &iter, &got)) {
+      ++n;
+      sum += got.key;
+    }
+    TEST_CHECK(n == 999);
+    TEST_CHECK(sum == (999 * 1000 / 2) - 500);
+    TEST_CHECK(!OV_HASHMAP_CONCURRENT_ITER(hm, &iter, &got));
+  }
+
+  OV_HASHMAP_CONCURRENT_CLEAR(hm);
+  TEST_CHECK(OV_HASHMAP_CONCURRENT_COUNT(hm) == 0);
+  TEST_CHECK(!OV_HASHMAP_CONCURRENT_GET(hm, &(uint32_t){1}, NULL));
+
+cleanup:
+  OV_HASHMAP_CONCURRENT_DESTROY(&hm);
+  TEST_CHECK(hm == NULL);
+}
+
+static void test_dynamic(void) {
+  struct ov_hashmap_concurrent *hm =
+      OV_HASHMAP_CONCURRENT_CREATE_DYNAMIC(sizeof(struct test_item_dynamic), 0, test_get_key_dynamic, 1);
+  if (!TEST_CHECK(hm != NULL)) {
+    return;
+  }
+
+  struct test_item_dynamic got = {0};
+  TEST_CHECK(OV_HASHMAP_CONCURRENT_SET(hm, &((struct test_item_dynamic){.key = "hello", .v = 1})));
+  TEST_CHECK(OV_HASHMAP_CONCURRENT_SET(hm, &((struct test_item_dynamic){.key = "world", .v = 2})));
+  TEST_CHECK(OV_HASHMAP_CONCURRENT_COUNT(hm) == 2);
+  TEST_CHECK(OV_HASHMAP_CONCURRENT_GET(hm, &(struct test_item_dynamic){.key = "world"}, &got) && got.v == 2);
+  TEST_CHECK(!OV_HASHMAP_CONCURRENT_GET(hm, &(struct test_item_dynamic){.key = "worl"}, &got));
+
+  size_t iter = 0;
+  size_t n = 0;
+  while (OV_HASHMAP_CONCURRENT_ITER(hm, &iter, &got)) {
+    ++n;
+  }
+  TEST_CHECK(n == 2);
+
+  OV_HASHMAP_CONCURRENT_DESTROY(&hm);
+}
+
+enum {
+  test_threads = 8,
+  test_items_per_thread = 20000,
+};
+
+struct test_thread_context {
+  struct ov_hashmap_concurrent *hm;
+  uint32_t base;
+  atomic_int *failures;
+};
+
+static int test_writer_thread(void *userdata) {
+  struct test_thread_context *const ctx = (struct test_thread_context *)userdata;
+  for (uint32_t i = 0; i < test_items_per_thread; ++i) {
+    uint32_t const key = ctx->base + i;
+    if (!OV_HASHMAP_CONCURRENT_SET(ctx->hm, &((struct test_item_static){.key = key, .v = ~key}))) {
+      atomic_fetch_add(ctx->failures, 1);
+    }
+    struct test_item_static got = {0};
+    if (!OV_HASHMAP_CONCURRENT_GET(ctx->hm, &key, &got) || got.v != ~key) {
+      atomic_fetch_add(ctx->failures, 1);
+    }
+    // delete every other item again to exercise shrinking alongside growth
+    if ((i & 1) && !OV_HASHMAP_CONCURRENT_DELETE(ctx->hm, &key, NULL)) {
+      atomic_fetch_add(ctx->failures, 1);
+    }
+  }
+  return 0;
+}
+
+static int test_reader_thread(void *userdata) {
+  struct test_thread_context *const ctx = (struct test_thread_context *)userdata;
+  // Keys from the writers' ranges may or may not be present, but any value seen must be consistent.
+  for (uint32_t round = 0; round < 4; ++round) {
+    for (uint32_t key = 0; key < test_threads * test_items_per_thread; key += 7) {
+      struct test_item_static got = {0};
+      if (OV_HASHMAP_CONCURRENT_GET(ctx->hm, &key, &got) && (got.key != key || got.v != ~key)) {
+        atomic_fetch_add(ctx->failures, 1);
+      }
+    }
+  }
+  return 0;
+}
+
+static void test_threads_mixed(void) {
+  struct ov_hashmap_concurrent *hm =
+      OV_HASHMAP_CONCURRENT_CREATE_STATIC(sizeof(struct test_item_static), 0, sizeof(uint32_t), 0);
+  if (!TEST_CHECK(hm != NULL)) {
+    return;
+  }
+
+  atomic_int failures = 0;
+  thrd_t threads[test_threads * 2];
+  struct test_thread_context ctx[test_threads * 2];
+  size_t started = 0;
+  for (size_t i = 0; i < test_threads * 2; ++i) {
+    ctx[i] = (struct test_thread_context){
+        .hm = hm,
+        .base = (uint32_t)(i % test_threads) * test_items_per_thread,
+        .failures = &failures,
+    };
+    if (!TEST_CHECK(thrd_create(threads + i, i < test_threads ? test_writer_thread : test_reader_thread, ctx + i) ==
+                    thrd_success)) {
+      break;
+    }
+    ++started;
+  }
+  for (size_t i = 0; i < started; ++i) {
+    thrd_join(threads[i], NULL);
+  }
+  TEST_CHECK(atomic_load(&failures) == 0);
+  TEST_CHECK(OV_HASHMAP_CONCURRENT_COUNT(hm) == test_threads * test_items_per_thread / 2);
+  TEST_MSG("count=%zu", OV_HASHMAP_CONCURRENT_COUNT(hm));
+
+  {
+    size_t iter = 0;
+    size_t n = 0;
+    struct test_item_static got = {0};
+    while (OV_HASHMAP_CONCURRENT_ITER(hm, &iter, &got)) {
+      TEST_CHECK_(!(got.key & 1), "key %u should have been deleted", got.key);
+      ++n;
+    }
+    TEST_CHECK(n == test_threads * test_items_per_thread / 2);
+  }
+
+  OV_HASHMAP_CONCURRENT_DESTROY(&hm);
+}
+
+TEST_LIST = {
+    {"test_static", test_static},
+    {"test_dynamic", test_dynamic},
+    {"test_threads_mixed", test_threads_mixed},
+    {NULL, NULL},
+};
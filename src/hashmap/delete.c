@@ -8,5 +8,14 @@ void const *ov_hashmap_delete(struct ov_hashmap *const hm, void const *const key
     return NULL;
   }
 
+#ifdef HASHMAP_STATS
+  if (ov_hm_stats_resize_pending(hm->map, false)) {
+    size_t const nbuckets = ov_hm_stats_nbuckets(hm->map);
+    uint64_t const start = ov_hm_stats_now();
+    void const *const item = hashmap_delete(hm->map, key_item);
+    ov_hm_stats_record_resize(hm, nbuckets, start);
+    return item;
+  }
+#endif
   return hashmap_delete(hm->map, key_item);
 }
@@ -12,6 +12,9 @@ void ov_hashmap_destroy(struct ov_hashmap **const hmp MEM_FILEPOS_PARAMS) {
   }
 
   struct ov_hashmap *hm = *hmp;
+#ifdef ALLOCATE_LOGGER
+  hm->filepos = *filepos;
+#endif
   if (hm->map) {
     hashmap_free(hm->map);
     hm->map = NULL;
@@ -0,0 +1,258 @@
+#include "common.h"
+
+#include <assert.h>
+#include <ovarray.h>
+#include <string.h>
+
+enum {
+  // Average keys per bucket. Smaller buckets make the displacement search cheap even when
+  // the item array is almost full, at the cost of 2 bytes per key for the displacement table.
+  keys_per_bucket = 2,
+  max_attempts = 16,
+  max_displacement = 1 << 20,
+};
+
+struct entry {
+  uint64_t hash;
+  void const *item;
+};
+
+struct builder {
+  struct ov_hm_frozen_header const *header;
+  uint32_t *displacements;
+  char *items;
+  struct entry *entries; // sorted by bucket
+  size_t *bucket_start;  // nbuckets + 1
+  uint32_t *order;       // buckets sorted by size, largest first
+  uint32_t *slots;       // scratch for the bucket being placed
+  ov_bitarray *taken;
+};
+
+static void sort_into_buckets(struct builder *const b, struct entry const *const src, size_t const max_size) {
+  size_t const nbuckets = (size_t)b->header->nbuckets;
+  size_t const count = (size_t)b->header->count;
+  memset(b->bucket_start, 0, sizeof(size_t) * (nbuckets + 1));
+  for (size_t i = 0; i < count; ++i) {
+    ++b->bucket_start[ov_hm_frozen_bucket(src[i].hash, nbuckets) + 1];
+  }
+  for (size_t i = 0; i < nbuckets; ++i) {
+    b->bucket_start[i + 1] += b->bucket_start[i];
+  }
+  // scatter using order[] as a temporary cursor per bucket
+  for (size_t i = 0; i < nbuckets; ++i) {
+    b->order[i] = 0;
+  }
+  for (size_t i = 0; i < count; ++i) {
+    uint32_t const bk = ov_hm_frozen_bucket(src[i].hash, nbuckets);
+    b->entries[b->bucket_start[bk] + b->order[bk]++] = src[i];
+  }
+  // counting sort of buckets by size, largest first
+  size_t pos = 0;
+  for (size_t size = max_size; size > 0; --size) {
+    for (size_t i = 0; i < nbuckets; ++i) {
+      if (b->bucket_start[i + 1] - b->bucket_start[i] == size) {
+        b->order[pos++] = (uint32_t)i;
+      }
+    }
+  }
+  for (size_t i = 0; i < nbuckets; ++i) {
+    if (b->bucket_start[i + 1] == b->bucket_start[i]) {
+      b->order[pos++] = (uint32_t)i;
+    }
+  }
+}
+
+static bool place_bucket(struct builder *const b, uint32_t const bucket) {
+  struct entry const *const e = b->entries + b->bucket_start[bucket];
+  size_t const n = b->bucket_start[bucket + 1] - b->bucket_start[bucket];
+  uint64_t const count = b->header->count;
+  for (uint32_t d = 0; d < max_displacement; ++d) {
+    size_t j = 0;
+    for (; j < n; ++j) {
+      uint32_t const slot = ov_hm_frozen_slot(e[j].hash, d, count);
+      if (OV_BITARRAY_GET(b->taken, slot)) {
+        break;
+      }
+      size_t k = 0;
+      while (k < j && b->slots[k] != slot) {
+        ++k;
+      }
+      if (k < j) {
+        break;
+      }
+      b->slots[j] = slot;
+    }
+    if (j < n) {
+      continue;
+    }
+    for (j = 0; j < n; ++j) {
+      OV_BITARRAY_SET(b->taken, b->slots[j]);
+      memcpy(b->items + b->slots[j] * b->header->item_size, e[j].item, (size_t)b->header->item_size);
+    }
+    b->displacements[bucket] = d;
+    return true;
+  }
+  return false;
+}
+
+static bool place_all(struct builder *const b) {
+  size_t const nbuckets = (size_t)b->header->nbuckets;
+  size_t const count = (size_t)b->header->count;
+  if (count) {
+    memset(b->taken, 0, OV_BITARRAY_LENGTH_TO_BYTES(count));
+  }
+  size_t i = 0;
+  for (; i < nbuckets; ++i) {
+    uint32_t const bk = b->order[i];
+    if (b->bucket_start[bk + 1] - b->bucket_start[bk] < 2) {
+      break;
+    }
+    if (!place_bucket(b, bk)) {
+      return false;
+    }
+  }
+  // Single key buckets point straight at whatever slot is still free.
+  size_t free_slot = 0;
+  for (; i < nbuckets; ++i) {
+    uint32_t const bk = b->order[i];
+    if (b->bucket_start[bk + 1] == b->bucket_start[bk]) {
+      b->displacements[bk] = 0;
+      continue;
+    }
+    while (OV_BITARRAY_GET(b->taken, free_slot)) {
+      ++free_slot;
+    }
+    OV_BITARRAY_SET(b->taken, free_slot);
+    memcpy(b->items + free_slot * b->header->item_size,
+           b->entries[b->bucket_start[bk]].item,
+           (size_t)b->header->item_size);
+    b->displacements[bk] = ov_hm_frozen_direct | (uint32_t)free_slot;
+  }
+  return true;
+}
+
+bool ov_hashmap_freeze(struct ov_hashmap const *const hm,
+                       void **const image,
+                       size_t *const image_bytes MEM_FILEPOS_PARAMS) {
+  assert(hm != NULL && "hm must not be NULL");
+  assert(hm->get_key == NULL && "only static key hashmaps can be frozen");
+  assert(image != NULL && "image must not be NULL");
+  assert(*image == NULL && "*image must be NULL");
+  assert(image_bytes != NULL && "image_bytes must not be NULL");
+#ifdef ALLOCATE_LOGGER
+  assert(filepos != NULL && "filepos must not be NULL");
+#endif
+  if (!hm || hm->get_key || !image || *image || !image_bytes) {
+    return false;
+  }
+
+  size_t const count = hashmap_count(hm->map);
+  size_t const item_size = ov_hm_item_size(hm->map);
+  if (count > ov_hm_frozen_max_count) {
+    return false;
+  }
+  size_t const nbuckets = count / keys_per_bucket + 1;
+  size_t const buckets_offset = (sizeof(struct ov_hm_frozen_header) + 7) & ~(size_t)7;
+  size_t const items_offset = (buckets_offset + nbuckets * sizeof(uint32_t) + 7) & ~(size_t)7;
+  if (item_size && count > (SIZE_MAX - items_offset) / item_size) {
+    return false;
+  }
+  size_t const total_bytes = items_offset + count * item_size;
+
+  bool result = false;
+  char *buf = NULL;
+  struct entry *hashed = NULL;
+  struct builder b = {0};
+  struct ov_hm_frozen_header header = {
+      .magic = ov_hm_frozen_magic,
+      .version = ov_hm_frozen_version,
+      .count = count,
+      .nbuckets = nbuckets,
+      .item_size = item_size,
+      .key_bytes = hm->key_bytes,
+      .buckets_offset = buckets_offset,
+      .items_offset = items_offset,
+      .total_bytes = total_bytes,
+  };
+  b.header = &header;
+
+  if (!ov_mem_realloc(&buf, total_bytes, sizeof(char) MEM_FILEPOS_VALUES_PASSTHRU)) {
+    goto cleanup;
+  }
+  memset(buf, 0, total_bytes);
+  b.displacements = (uint32_t *)(void *)(buf + buckets_offset);
+  b.items = buf + items_offset;
+  if (count) {
+    if (!ov_mem_realloc(&hashed, count, sizeof(struct entry) MEM_FILEPOS_VALUES_PASSTHRU) ||
+        !ov_mem_realloc(&b.entries, count, sizeof(struct entry) MEM_FILEPOS_VALUES_PASSTHRU) ||
+        !ov_bitarray_alloc(&b.taken, count MEM_FILEPOS_VALUES_PASSTHRU)) {
+      goto cleanup;
+    }
+  }
+  if (!ov_mem_realloc(&b.bucket_start, nbuckets + 1, sizeof(size_t) MEM_FILEPOS_VALUES_PASSTHRU) ||
+      !ov_mem_realloc(&b.order, nbuckets, sizeof(uint32_t) MEM_FILEPOS_VALUES_PASSTHRU)) {
+    goto cleanup;
+  }
+
+  for (int attempt = 0; attempt < max_attempts && !result; ++attempt) {
+    ov_hm_generate_seeds(&header.seed0, &header.seed1);
+    {
+      size_t iter = 0, n = 0;
+      void *item = NULL;
+      while (hashmap_iter(hm->map, &iter, &item)) {
+        hashed[n++] = (struct entry){
+            .hash = sip_hash_1_3(item, hm->key_bytes, header.seed0, header.seed1),
+            .item = item,
+        };
+      }
+    }
+    size_t max_size = 0;
+    {
+      // bucket_start is reused here to find the largest bucket
+      memset(b.bucket_start, 0, sizeof(size_t) * (nbuckets + 1));
+      for (size_t i = 0; i < count; ++i) {
+        size_t const sz = ++b.bucket_start[ov_hm_frozen_bucket(hashed[i].hash, nbuckets)];
+        if (sz > max_size) {
+          max_size = sz;
+        }
+      }
+    }
+    if (!ov_mem_realloc(&b.slots, max_size + 1, sizeof(uint32_t) MEM_FILEPOS_VALUES_PASSTHRU)) {
+      goto cleanup;
+    }
+    sort_into_buckets(&b, hashed, max_size);
+    result = place_all(&b);
+  }
+  if (!result) {
+    goto cleanup;
+  }
+
+  memcpy(buf, &header, sizeof(header));
+  *image = buf;
+  *image_bytes = total_bytes;
+  buf = NULL;
+
+cleanup:
+  if (b.slots) {
+    ov_mem_free(&b.slots MEM_FILEPOS_VALUES_PASSTHRU);
+  }
+  if (b.taken) {
+    ov_mem_free(&b.taken MEM_FILEPOS_VALUES_PASSTHRU);
+  }
+  if (b.order) {
+    ov_mem_free(&b.order MEM_FILEPOS_VALUES_PASSTHRU);
+  }
+  if (b.bucket_start) {
+    ov_mem_free(&b.bucket_start MEM_FILEPOS_VALUES_PASSTHRU);
+  }
+  if (b.entries) {
+    ov_mem_free(&b.entries MEM_FILEPOS_VALUES_PASSTHRU);
+  }
+  if (hashed) {
+    ov_mem_free(&hashed MEM_FILEPOS_VALUES_PASSTHRU);
+  }
+  if (buf) {
+    ov_mem_free(&buf MEM_FILEPOS_VALUES_PASSTHRU);
+  }
+  return result;
+}
@@ -0,0 +1,76 @@
+#include "common.h"
+
+#include <assert.h>
+#include <string.h>
+
+static inline struct ov_hm_frozen_header const *get_header(void const *const image) {
+  return (struct ov_hm_frozen_header const *)image;
+}
+
+bool ov_hashmap_frozen_validate(void const *const image, size_t const image_bytes) {
+  if (!image || image_bytes < sizeof(struct ov_hm_frozen_header) || ((uintptr_t)image & 7) != 0) {
+    return false;
+  }
+  struct ov_hm_frozen_header const *const h = get_header(image);
+  if (h->magic != ov_hm_frozen_magic || h->version != ov_hm_frozen_version) {
+    return false;
+  }
+  if (h->total_bytes > image_bytes || h->count > ov_hm_frozen_max_count || h->nbuckets == 0 ||
+      h->nbuckets > UINT32_MAX || h->item_size == 0 || h->key_bytes == 0 || h->key_bytes > h->item_size) {
+    return false;
+  }
+  if (h->buckets_offset < sizeof(struct ov_hm_frozen_header) || (h->buckets_offset & 7) != 0 ||
+      (h->items_offset & 7) != 0 || h->buckets_offset > h->total_bytes ||
+      h->nbuckets > (h->total_bytes - h->buckets_offset) / sizeof(uint32_t) ||
+      h->buckets_offset + h->nbuckets * sizeof(uint32_t) > h->items_offset || h->items_offset > h->total_bytes ||
+      h->count > (h->total_bytes - h->items_offset) / h->item_size) {
+    return false;
+  }
+  return true;
+}
+
+size_t ov_hashmap_frozen_count(void const *const image) {
+  if (!image) {
+    return 0;
+  }
+  return (size_t)get_header(image)->count;
+}
+
+void const *ov_hashmap_frozen_get(void const *const image, void const *const key_item) {
+  assert(image != NULL && "image must not be NULL");
+  assert(key_item != NULL && "key_item must not be NULL");
+  if (!image || !key_item) {
+    return NULL;
+  }
+
+  struct ov_hm_frozen_header const *const h = get_header(image);
+  if (!h->count) {
+    return NULL;
+  }
+  char const *const base = (char const *)image;
+  uint64_t const hash = sip_hash_1_3(key_item, (size_t)h->key_bytes, h->seed0, h->seed1);
+  uint32_t const *const displacements = (uint32_t const *)(void const *)(base + h->buckets_offset);
+  uint32_t const slot = ov_hm_frozen_slot(hash, displacements[ov_hm_frozen_bucket(hash, h->nbuckets)], h->count);
+  if (slot >= h->count) {
+    return NULL;
+  }
+  char const *const item = base + h->items_offset + slot * h->item_size;
+  return memcmp(item, key_item, (size_t)h->key_bytes) == 0 ? item : NULL;
+}
+
+bool ov_hashmap_frozen_iter(void const *const image, size_t *const i, void const **const item) {
+  assert(image != NULL && "image must not be NULL");
+  assert(i != NULL && "i must not be NULL");
+  assert(item != NULL && "item must not be NULL");
+  if (!image || !i || !item) {
+    return false;
+  }
+
+  struct ov_hm_frozen_header const *const h = get_header(image);
+  if (*i >= h->count) {
+    return false;
+  }
+  *item = (char const *)image + h->items_offset + *i * h->item_size;
+  ++*i;
+  return true;
+}
@@ -8,5 +8,9 @@ void const *ov_hashmap_get(struct ov_hashmap const *const hm, void const *const
     return NULL;
   }
 
-  return hashmap_get(hm->map, key_item);
+  void const *const item = hashmap_get(hm->map, key_item);
+#ifdef HASHMAP_STATS
+  atomic_fetch_add_explicit(item ? &hm->stats->get_hits : &hm->stats->get_misses, 1, memory_order_relaxed);
+#endif
+  return item;
 }
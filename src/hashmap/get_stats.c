@@ -0,0 +1,19 @@
+#include "common.h"
+#include <assert.h>
+
+void ov_hashmap_get_stats(struct ov_hashmap const *const hm, struct ov_hashmap_stats *const stats) {
+  assert(hm != NULL && "hm must not be NULL");
+  assert(stats != NULL && "stats must not be NULL");
+  if (!hm || !stats) {
+    return;
+  }
+
+  *stats = (struct ov_hashmap_stats){0};
+  ov_hm_scan_stats(hm->map, stats);
+#ifdef HASHMAP_STATS
+  stats->resizes = hm->stats->resizes;
+  stats->resize_ns = hm->stats->resize_ns;
+  stats->get_hits = atomic_load_explicit(&hm->stats->get_hits, memory_order_relaxed);
+  stats->get_misses = atomic_load_explicit(&hm->stats->get_misses, memory_order_relaxed);
+#endif
+}
@@ -0,0 +1,250 @@
+#include "common.h"
+
+#include <ovhashset.h>
+
+#include <assert.h>
+
+// Entry of a variable-size key set. Fixed-size sets store the key bytes directly as the item.
+struct dynamic_key {
+  void const *ptr;
+  size_t len;
+};
+
+struct ov_hashset {
+  struct ov_hashmap hm;
+};
+
+static void get_dynamic_key(void const *const item, void const **const key, size_t *const key_bytes) {
+  struct dynamic_key const *const k = (struct dynamic_key const *)item;
+  *key = k->ptr;
+  *key_bytes = k->len;
+}
+
+static inline bool is_dynamic(struct ov_hashset const *const hs) { return hs->hm.get_key != NULL; }
+
+static inline bool key_valid(struct ov_hashset const *const hs, void const *const key, size_t const key_bytes) {
+  if (is_dynamic(hs)) {
+    return key != NULL || key_bytes == 0;
+  }
+  return key != NULL && key_bytes == hs->hm.key_bytes;
+}
+
+static inline bool compatible(struct ov_hashset const *const a, struct ov_hashset const *const b) {
+  return a->hm.get_key == b->hm.get_key && a->hm.key_bytes == b->hm.key_bytes;
+}
+
+static struct ov_hashset *create(size_t const item_size,
+                                 size_t const cap,
+                                 ov_hashmap_get_key_func const get_key,
+                                 size_t const key_bytes MEM_FILEPOS_PARAMS) {
+  struct ov_hashset *result = NULL;
+  struct ov_hashset *hs = NULL;
+
+  if (!ov_mem_realloc(&hs, 1, sizeof(*hs) MEM_FILEPOS_VALUES_PASSTHRU)) {
+    goto cleanup;
+  }
+  hs->hm = (struct ov_hashmap){
+      .get_key = get_key,
+      .key_bytes = key_bytes,
+#ifdef ALLOCATE_LOGGER
+      .filepos = *filepos,
+#endif
+  };
+  {
+    uint64_t s0, s1;
+    ov_hm_generate_seeds(&s0, &s1);
+    if (!ov_hm_init(&hs->hm, item_size, cap, s0, s1)) {
+      goto cleanup;
+    }
+  }
+
+  result = hs;
+  hs = NULL;
+
+cleanup:
+  if (hs) {
+    ov_mem_free(&hs MEM_FILEPOS_VALUES_PASSTHRU);
+  }
+  return result;
+}
+
+struct ov_hashset *ov_hashset_create_static(size_t const key_size, size_t const cap MEM_FILEPOS_PARAMS) {
+  assert(key_size > 0 && "key_size must be greater than 0");
+#ifdef ALLOCATE_LOGGER
+  assert(filepos != NULL && "filepos must not be NULL");
+#endif
+  if (key_size == 0) {
+    return NULL;
+  }
+  return create(key_size, cap, NULL, key_size MEM_FILEPOS_VALUES_PASSTHRU);
+}
+
+struct ov_hashset *ov_hashset_create_dynamic(size_t const cap MEM_FILEPOS_PARAMS) {
+#ifdef ALLOCATE_LOGGER
+  assert(filepos != NULL && "filepos must not be NULL");
+#endif
+  return create(sizeof(struct dynamic_key), cap, get_dynamic_key, 0 MEM_FILEPOS_VALUES_PASSTHRU);
+}
+
+void ov_hashset_destroy(struct ov_hashset **const hsp MEM_FILEPOS_PARAMS) {
+  assert(hsp != NULL && "hsp must not be NULL");
+  assert(*hsp != NULL && "hashset is already destroyed or not initialized");
+#ifdef ALLOCATE_LOGGER
+  assert(filepos != NULL && "filepos must not be NULL");
+#endif
+  if (!hsp || !*hsp) {
+    return;
+  }
+
+  struct ov_hashset *const hs = *hsp;
+#ifdef ALLOCATE_LOGGER
+  hs->hm.filepos = *filepos;
+#endif
+  hashmap_free(hs->hm.map);
+  hs->hm.map = NULL;
+  ov_mem_free((void **)hsp MEM_FILEPOS_VALUES_PASSTHRU);
+}
+
+void ov_hashset_clear(struct ov_hashset *const hs) {
+  assert(hs != NULL && "hs must not be NULL");
+  if (!hs) {
+    return;
+  }
+  hashmap_clear(hs->hm.map, false);
+}
+
+size_t ov_hashset_count(struct ov_hashset const *const hs) {
+  if (!hs) {
+    return 0;
+  }
+  return hashmap_count(hs->hm.map);
+}
+
+bool ov_hashset_insert(struct ov_hashset *const hs,
+                       void const *const key,
+                       size_t const key_bytes MEM_FILEPOS_PARAMS) {
+  assert(hs != NULL && "hs must not be NULL");
+  assert((!hs || key_valid(hs, key, key_bytes)) && "key must not be NULL and must match the key size of the set");
+#ifdef ALLOCATE_LOGGER
+  assert(filepos != NULL && "filepos must not be NULL");
+#endif
+  if (!hs || !key_valid(hs, key, key_bytes)) {
+    return false;
+  }
+
+#ifdef ALLOCATE_LOGGER
+  hs->hm.filepos = *filepos;
+#endif
+  if (is_dynamic(hs)) {
+    hashmap_set(hs->hm.map, &(struct dynamic_key){.ptr = key ? key : "", .len = key_bytes});
+  } else {
+    hashmap_set(hs->hm.map, key);
+  }
+  return !hashmap_oom(hs->hm.map);
+}
+
+bool ov_hashset_contains(struct ov_hashset const *const hs, void const *const key, size_t const key_bytes) {
+  assert(hs != NULL && "hs must not be NULL");
+  assert((!hs || key_valid(hs, key, key_bytes)) && "key must not be NULL and must match the key size of the set");
+  if (!hs || !key_valid(hs, key, key_bytes)) {
+    return false;
+  }
+
+  if (is_dynamic(hs)) {
+    return hashmap_get(hs->hm.map, &(struct dynamic_key){.ptr = key ? key : "", .len = key_bytes}) != NULL;
+  }
+  return hashmap_get(hs->hm.map, key) != NULL;
+}
+
+bool ov_hashset_remove(struct ov_hashset *const hs, void const *const key, size_t const key_bytes) {
+  assert(hs != NULL && "hs must not be NULL");
+  assert((!hs || key_valid(hs, key, key_bytes)) && "key must not be NULL and must match the key size of the set");
+  if (!hs || !key_valid(hs, key, key_bytes)) {
+    return false;
+  }
+
+  if (is_dynamic(hs)) {
+    return hashmap_delete(hs->hm.map, &(struct dynamic_key){.ptr = key ? key : "", .len = key_bytes}) != NULL;
+  }
+  return hashmap_delete(hs->hm.map, key) != NULL;
+}
+
+bool ov_hashset_iter(struct ov_hashset const *const hs,
+                     size_t *const i,
+                     void const **const key,
+                     size_t *const key_bytes) {
+  assert(hs != NULL && "hs must not be NULL");
+  assert(i != NULL && "i must not be NULL");
+  assert(key != NULL && "key must not be NULL");
+  if (!hs || !i || !key) {
+    return false;
+  }
+
+  void *item = NULL;
+  if (!hashmap_iter(hs->hm.map, i, &item)) {
+    return false;
+  }
+  if (is_dynamic(hs)) {
+    struct dynamic_key const *const k = (struct dynamic_key const *)item;
+    *key = k->ptr;
+    if (key_bytes) {
+      *key_bytes = k->len;
+    }
+  } else {
+    *key = item;
+    if (key_bytes) {
+      *key_bytes = hs->hm.key_bytes;
+    }
+  }
+  return true;
+}
+
+bool ov_hashset_union(struct ov_hashset *const dest, struct ov_hashset const *const src MEM_FILEPOS_PARAMS) {
+  assert(dest != NULL && "dest must not be NULL");
+  assert(src != NULL && "src must not be NULL");
+  assert((!dest || !src || compatible(dest, src)) && "dest and src must have the same key layout");
+#ifdef ALLOCATE_LOGGER
+  assert(filepos != NULL && "filepos must not be NULL");
+#endif
+  if (!dest || !src || !compatible(dest, src)) {
+    return false;
+  }
+  if (dest == src) {
+    return true;
+  }
+
+#ifdef ALLOCATE_LOGGER
+  dest->hm.filepos = *filepos;
+#endif
+  size_t const dest_count = hashmap_count(dest->hm.map);
+  size_t const src_count = hashmap_count(src->hm.map);
+  // Sizing for the worst case avoids repeated rehashing while merging; overlap only leaves some slack.
+  // The minimum size stays as it was, so later removals can shrink the set again.
+  if (src_count > SIZE_MAX - dest_count || !ov_hm_grow(dest->hm.map, dest_count + src_count)) {
+    return false;
+  }
+  size_t iter = 0;
+  void *item = NULL;
+  while (hashmap_iter(src->hm.map, &iter, &item)) {
+    hashmap_set(dest->hm.map, item);
+    if (hashmap_oom(dest->hm.map)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool contained_in(void const *const item, void *const udata) {
+  struct ov_hashset const *const other = (struct ov_hashset const *)udata;
+  return hashmap_get(other->hm.map, item) != NULL;
+}
+
+size_t ov_hashset_intersect(struct ov_hashset *const dest, struct ov_hashset const *const src) {
+  assert(dest != NULL && "dest must not be NULL");
+  assert(src != NULL && "src must not be NULL");
+  assert((!dest || !src || compatible(dest, src)) && "dest and src must have the same key layout");
+  if (!dest || !src || !compatible(dest, src) || dest == src) {
+    return 0;
+  }
+  return ov_hm_retain(dest->hm.map, contained_in, (void *)(uintptr_t)src);
+}
@@ -0,0 +1,166 @@
+#include <ovtest.h>
+
+#include <ovhashset.h>
+
+static void test_static(void) {
+  struct ov_hashset *hs = OV_HASHSET_CREATE_STATIC(sizeof(uint64_t), 0);
+  if (!TEST_CHECK(hs != NULL)) {
+    return;
+  }
+
+  TEST_CHECK(OV_HASHSET_COUNT(hs) == 0);
+  TEST_CHECK(!OV_HASHSET_CONTAINS(hs, &(uint64_t){1}, sizeof(uint64_t)));
+
+  for (uint64_t i = 0; i < 10000; ++i) {
+    if (!TEST_CHECK(OV_HASHSET_INSERT(hs, &i, sizeof(i)))) {
+      goto cleanup;
+    }
+  }
+  // duplicates do not change the set
+  for (uint64_t i = 0; i < 10000; i += 2) {
+    if (!TEST_CHECK(OV_HASHSET_INSERT(hs, &i, sizeof(i)))) {
+      goto cleanup;
+    }
+  }
+  TEST_CHECK(OV_HASHSET_COUNT(hs) == 10000);
+  TEST_CHECK(OV_HASHSET_CONTAINS(hs, &(uint64_t){9999}, sizeof(uint64_t)));
+  TEST_CHECK(!OV_HASHSET_CONTAINS(hs, &(uint64_t){10000}, sizeof(uint64_t)));
+
+  TEST_CHECK(OV_HASHSET_REMOVE(hs, &(uint64_t){5000}, sizeof(uint64_t)));
+  TEST_CHECK(!OV_HASHSET_REMOVE(hs, &(uint64_t){5000}, sizeof(uint64_t)));
+  TEST_CHECK(!OV_HASHSET_CONTAINS(hs, &(uint64_t){5000}, sizeof(uint64_t)));
+  TEST_CHECK(OV_HASHSET_COUNT(hs) == 9999);
+
+  {
+    size_t iter = 0, n = 0, key_bytes = 0;
+    uint64_t const *key = NULL;
+    uint64_t sum = 0;
+    while (OV_HASHSET_ITER(hs, &iter, &key, &key_bytes)) {
+      TEST_CHECK(key_bytes == sizeof(uint64_t));
+      sum += *key;
+      ++n;
+    }
+    TEST_CHECK(n == 9999);
+    TEST_CHECK(sum == 9999 * 10000 / 2 - 5000);
+  }
+
+  OV_HASHSET_CLEAR(hs);
+  TEST_CHECK(OV_HASHSET_COUNT(hs) == 0);
+  TEST_CHECK(!OV_HASHSET_CONTAINS(hs, &(uint64_t){1}, sizeof(uint64_t)));
+
+cleanup:
+  OV_HASHSET_DESTROY(&hs);
+  TEST_CHECK(hs == NULL);
+}
+
+static void test_dynamic(void) {
+  struct ov_hashset *hs = OV_HASHSET_CREATE_DYNAMIC(0);
+  if (!TEST_CHECK(hs != NULL)) {
+    return;
+  }
+
+  static char const *const words[] = {"apple", "banana", "apple", "cherry", "", "banana"};
+  for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); ++i) {
+    if (!TEST_CHECK(OV_HASHSET_INSERT(hs, words[i], strlen(words[i])))) {
+      goto cleanup;
+    }
+  }
+  TEST_CHECK(OV_HASHSET_COUNT(hs) == 4);
+  TEST_CHECK(OV_HASHSET_CONTAINS(hs, "cherry", 6));
+  TEST_CHECK(OV_HASHSET_CONTAINS(hs, "cherry pie", 6));
+  TEST_CHECK(!OV_HASHSET_CONTAINS(hs, "cherr", 5));
+  TEST_CHECK(OV_HASHSET_CONTAINS(hs, NULL, 0));
+  TEST_CHECK(OV_HASHSET_REMOVE(hs, "", 0));
+  TEST_CHECK(!OV_HASHSET_CONTAINS(hs, "", 0));
+
+  {
+    size_t iter = 0, n = 0, key_bytes = 0;
+    char const *key = NULL;
+    while (OV_HASHSET_ITER(hs, &iter, &key, &key_bytes)) {
+      TEST_CHECK(key_bytes == strlen(key));
+      ++n;
+    }
+    TEST_CHECK(n == 3);
+  }
+
+cleanup:
+  OV_HASHSET_DESTROY(&hs);
+}
+
+static void test_union_intersect(void) {
+  enum { n = 20000 };
+  struct ov_hashset *a = OV_HASHSET_CREATE_STATIC(sizeof(uint32_t), 0);
+  struct ov_hashset *b = OV_HASHSET_CREATE_STATIC(sizeof(uint32_t), 0);
+  struct ov_hashset *c = OV_HASHSET_CREATE_STATIC(sizeof(uint32_t), 0);
+  if (!TEST_CHECK(a != NULL && b != NULL && c != NULL)) {
+    goto cleanup;
+  }
+
+  // a: multiples of 2, b: multiples of 3, c: multiples of 5
+  for (uint32_t i = 0; i < n; ++i) {
+    if ((i % 2 == 0 && !TEST_CHECK(OV_HASHSET_INSERT(a, &i, sizeof(i)))) ||
+        (i % 3 == 0 && !TEST_CHECK(OV_HASHSET_INSERT(b, &i, sizeof(i)))) ||
+        (i % 5 == 0 && !TEST_CHECK(OV_HASHSET_INSERT(c, &i, sizeof(i))))) {
+      goto cleanup;
+    }
+  }
+
+  if (!TEST_CHECK(OV_HASHSET_UNION(a, b))) {
+    goto cleanup;
+  }
+  {
+    size_t expected = 0;
+    for (uint32_t i = 0; i < n; ++i) {
+      bool const want = i % 2 == 0 || i % 3 == 0;
+      expected += want;
+      if (OV_HASHSET_CONTAINS(a, &i, sizeof(i)) != want) {
+        TEST_CHECK(false);
+        TEST_MSG("union mismatch at %u", i);
+        break;
+      }
+    }
+    TEST_CHECK(OV_HASHSET_COUNT(a) == expected);
+  }
+
+  {
+    size_t const before = OV_HASHSET_COUNT(a);
+    size_t const removed = OV_HASHSET_INTERSECT(a, c);
+    size_t expected = 0;
+    for (uint32_t i = 0; i < n; ++i) {
+      bool const want = (i % 2 == 0 || i % 3 == 0) && i % 5 == 0;
+      expected += want;
+      if (OV_HASHSET_CONTAINS(a, &i, sizeof(i)) != want) {
+        TEST_CHECK(false);
+        TEST_MSG("intersection mismatch at %u", i);
+        break;
+      }
+    }
+    TEST_CHECK(OV_HASHSET_COUNT(a) == expected);
+    TEST_CHECK(removed == before - expected);
+  }
+
+  // intersecting with an empty set removes everything, and the set stays usable afterwards
+  OV_HASHSET_CLEAR(b);
+  TEST_CHECK(OV_HASHSET_INTERSECT(c, b) == n / 5);
+  TEST_CHECK(OV_HASHSET_COUNT(c) == 0);
+  TEST_CHECK(OV_HASHSET_INSERT(c, &(uint32_t){7}, sizeof(uint32_t)));
+  TEST_CHECK(OV_HASHSET_CONTAINS(c, &(uint32_t){7}, sizeof(uint32_t)));
+
+cleanup:
+  if (c) {
+    OV_HASHSET_DESTROY(&c);
+  }
+  if (b) {
+    OV_HASHSET_DESTROY(&b);
+  }
+  if (a) {
+    OV_HASHSET_DESTROY(&a);
+  }
+}
+
+TEST_LIST = {
+    {"test_static", test_static},
+    {"test_dynamic", test_dynamic},
+    {"test_union_intersect", test_union_intersect},
+    {NULL, NULL},
+};
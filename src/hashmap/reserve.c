@@ -0,0 +1,25 @@
+#include "common.h"
+#include <assert.h>
+
+bool ov_hashmap_reserve(struct ov_hashmap *const hm, size_t const n MEM_FILEPOS_PARAMS) {
+  assert(hm != NULL && "hm must not be NULL");
+#ifdef ALLOCATE_LOGGER
+  assert(filepos != NULL && "filepos must not be NULL");
+#endif
+  if (!hm) {
+    return false;
+  }
+
+#ifdef ALLOCATE_LOGGER
+  hm->filepos = *filepos;
+#endif
+#ifdef HASHMAP_STATS
+  size_t const nbuckets = ov_hm_stats_nbuckets(hm->map);
+  uint64_t const start = ov_hm_stats_now();
+  bool const r = ov_hm_reserve(hm->map, n);
+  ov_hm_stats_record_resize(hm, nbuckets, start);
+  return r;
+#else
+  return ov_hm_reserve(hm->map, n);
+#endif
+}
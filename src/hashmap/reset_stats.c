@@ -0,0 +1,16 @@
+#include "common.h"
+#include <assert.h>
+
+void ov_hashmap_reset_stats(struct ov_hashmap *const hm) {
+  assert(hm != NULL && "hm must not be NULL");
+  if (!hm) {
+    return;
+  }
+
+#ifdef HASHMAP_STATS
+  hm->stats->resizes = 0;
+  hm->stats->resize_ns = 0;
+  atomic_store_explicit(&hm->stats->get_hits, 0, memory_order_relaxed);
+  atomic_store_explicit(&hm->stats->get_misses, 0, memory_order_relaxed);
+#endif
+}
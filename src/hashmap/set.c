@@ -12,7 +12,16 @@ bool ov_hashmap_set(struct ov_hashmap *const hm, void const *const item MEM_FILE
   }
 
 #ifdef ALLOCATE_LOGGER
-  hm->filepos = filepos;
+  hm->filepos = *filepos;
+#endif
+#ifdef HASHMAP_STATS
+  if (ov_hm_stats_resize_pending(hm->map, true)) {
+    size_t const nbuckets = ov_hm_stats_nbuckets(hm->map);
+    uint64_t const start = ov_hm_stats_now();
+    hashmap_set(hm->map, item);
+    ov_hm_stats_record_resize(hm, nbuckets, start);
+    return !hashmap_oom(hm->map);
+  }
 #endif
   hashmap_set(hm->map, item);
   return !hashmap_oom(hm->map);
@@ -0,0 +1,41 @@
+#include "common.h"
+#include <assert.h>
+
+bool ov_hashmap_set_bulk(struct ov_hashmap *const hm, void const *const items, size_t const n MEM_FILEPOS_PARAMS) {
+  assert(hm != NULL && "hm must not be NULL");
+  assert((items != NULL || n == 0) && "items must not be NULL");
+#ifdef ALLOCATE_LOGGER
+  assert(filepos != NULL && "filepos must not be NULL");
+#endif
+  if (!hm || (!items && n)) {
+    return false;
+  }
+
+#ifdef ALLOCATE_LOGGER
+  hm->filepos = *filepos;
+#endif
+  size_t const count = hashmap_count(hm->map);
+  if (n > SIZE_MAX - count) {
+    return false;
+  }
+#ifdef HASHMAP_STATS
+  size_t const nbuckets = ov_hm_stats_nbuckets(hm->map);
+  uint64_t const start = ov_hm_stats_now();
+  bool const reserved = ov_hm_grow(hm->map, count + n);
+  ov_hm_stats_record_resize(hm, nbuckets, start);
+#else
+  bool const reserved = ov_hm_grow(hm->map, count + n);
+#endif
+  if (!reserved) {
+    return false;
+  }
+  size_t const item_size = ov_hm_item_size(hm->map);
+  char const *p = (char const *)items;
+  for (size_t i = 0; i < n; ++i, p += item_size) {
+    hashmap_set(hm->map, p);
+    if (hashmap_oom(hm->map)) {
+      return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,12 @@
+#include "common.h"
+#include <assert.h>
+
+void ov_hashmap_set_load_factor(struct ov_hashmap *const hm, double const load_factor) {
+  assert(hm != NULL && "hm must not be NULL");
+  assert(load_factor > 0 && load_factor < 1 && "load_factor must be between 0 and 1");
+  if (!hm) {
+    return;
+  }
+
+  hashmap_set_load_factor(hm->map, load_factor);
+}
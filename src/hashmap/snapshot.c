@@ -0,0 +1,144 @@
+#include "common.h"
+
+#include <assert.h>
+#include <string.h>
+
+static inline struct ov_hm_snapshot_header const *get_header(void const *const image) {
+  return (struct ov_hm_snapshot_header const *)image;
+}
+
+static inline void const *get_buckets(void const *const image) {
+  return (char const *)image + get_header(image)->buckets_offset;
+}
+
+bool ov_hashmap_snapshot(struct ov_hashmap const *const hm,
+                         void **const image,
+                         size_t *const image_bytes MEM_FILEPOS_PARAMS) {
+  assert(hm != NULL && "hm must not be NULL");
+  assert(hm->get_key == NULL && "only static key hashmaps can be snapshotted");
+  assert(image != NULL && "image must not be NULL");
+  assert(*image == NULL && "*image must be NULL");
+  assert(image_bytes != NULL && "image_bytes must not be NULL");
+#ifdef ALLOCATE_LOGGER
+  assert(filepos != NULL && "filepos must not be NULL");
+#endif
+  if (!hm || hm->get_key || !image || *image || !image_bytes) {
+    return false;
+  }
+
+  struct ov_hm_snapshot_header header = {
+      .magic = ov_hm_snapshot_magic,
+      .version = ov_hm_snapshot_version,
+      .key_bytes = hm->key_bytes,
+      .buckets_offset = (sizeof(struct ov_hm_snapshot_header) + 7) & ~(uint64_t)7,
+  };
+  ov_hm_snapshot_describe(hm->map, &header);
+  size_t const buckets_offset = (size_t)header.buckets_offset;
+  size_t const nbuckets = (size_t)header.nbuckets;
+  size_t const bucket_size = (size_t)header.bucket_size;
+  if (nbuckets > (SIZE_MAX - buckets_offset) / bucket_size) {
+    return false;
+  }
+  size_t const total_bytes = buckets_offset + nbuckets * bucket_size;
+  header.total_bytes = total_bytes;
+
+  char *buf = NULL;
+  if (!ov_mem_realloc(&buf, total_bytes, sizeof(char) MEM_FILEPOS_VALUES_PASSTHRU)) {
+    return false;
+  }
+  memset(buf, 0, buckets_offset);
+  memcpy(buf, &header, sizeof(header));
+  ov_hm_snapshot_write(hm->map, buf + buckets_offset);
+  *image = buf;
+  *image_bytes = total_bytes;
+  return true;
+}
+
+bool ov_hashmap_snapshot_validate(void const *const image, size_t const image_bytes) {
+  if (!image || image_bytes < sizeof(struct ov_hm_snapshot_header) || ((uintptr_t)image & 7) != 0) {
+    return false;
+  }
+  struct ov_hm_snapshot_header const *const h = get_header(image);
+  if (h->magic != ov_hm_snapshot_magic || h->version != ov_hm_snapshot_version) {
+    return false;
+  }
+  if (h->total_bytes > image_bytes || h->item_size == 0 || h->item_size > SIZE_MAX / 2 || h->key_bytes == 0 ||
+      h->key_bytes > h->item_size || h->bucket_size != ov_hm_bucket_size((size_t)h->item_size)) {
+    return false;
+  }
+  // The table is always a power of two in size and never completely full.
+  if (h->nbuckets == 0 || (h->nbuckets & (h->nbuckets - 1)) != 0 || h->count >= h->nbuckets ||
+      h->load_factor == 0 || h->load_factor >= 100) {
+    return false;
+  }
+  if (h->buckets_offset < sizeof(struct ov_hm_snapshot_header) || (h->buckets_offset & 7) != 0 ||
+      h->buckets_offset > h->total_bytes || h->nbuckets > (h->total_bytes - h->buckets_offset) / h->bucket_size) {
+    return false;
+  }
+  return true;
+}
+
+size_t ov_hashmap_snapshot_count(void const *const image) {
+  if (!image) {
+    return 0;
+  }
+  return (size_t)get_header(image)->count;
+}
+
+void const *ov_hashmap_snapshot_get(void const *const image, void const *const key_item) {
+  assert(image != NULL && "image must not be NULL");
+  assert(key_item != NULL && "key_item must not be NULL");
+  if (!image || !key_item) {
+    return NULL;
+  }
+
+  struct ov_hm_snapshot_header const *const h = get_header(image);
+  if (!h->count) {
+    return NULL;
+  }
+  return ov_hm_snapshot_find(h, get_buckets(image), key_item);
+}
+
+struct ov_hashmap *ov_hashmap_load(void const *const image, size_t const image_bytes MEM_FILEPOS_PARAMS) {
+  assert(image != NULL && "image must not be NULL");
+#ifdef ALLOCATE_LOGGER
+  assert(filepos != NULL && "filepos must not be NULL");
+#endif
+  if (!ov_hashmap_snapshot_validate(image, image_bytes)) {
+    return NULL;
+  }
+
+  struct ov_hm_snapshot_header const *const h = get_header(image);
+  struct ov_hashmap *result = NULL;
+  struct ov_hashmap *hm = NULL;
+
+  if (!ov_mem_realloc(&hm, 1, sizeof(*hm) MEM_FILEPOS_VALUES_PASSTHRU)) {
+    goto cleanup;
+  }
+  *hm = (struct ov_hashmap){
+      .key_bytes = (size_t)h->key_bytes,
+#ifdef ALLOCATE_LOGGER
+      .filepos = *filepos,
+#endif
+  };
+  // The stored hashes are only meaningful under the seeds they were computed with.
+  if (!ov_hm_init(hm, (size_t)h->item_size, 0, h->seed0, h->seed1)) {
+    goto cleanup;
+  }
+  if (!ov_hm_snapshot_restore(hm->map, h, get_buckets(image))) {
+    goto cleanup;
+  }
+
+  result = hm;
+  hm = NULL;
+
+cleanup:
+  if (hm) {
+    if (hm->map) {
+      hashmap_free(hm->map);
+      hm->map = NULL;
+    }
+    ov_mem_free(&hm MEM_FILEPOS_VALUES_PASSTHRU);
+  }
+  return result;
+}
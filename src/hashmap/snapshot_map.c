@@ -0,0 +1,111 @@
+#include "common.h"
+
+#include <assert.h>
+
+#ifdef _WIN32
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#elif !defined(__wasi__)
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+#ifdef _WIN32
+static void *map_file(NATIVE_CHAR const *const path, size_t *const bytes) {
+  void *view = NULL;
+  HANDLE mapping = NULL;
+  HANDLE file = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    goto cleanup;
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size) || size.QuadPart < (LONGLONG)sizeof(struct ov_hm_snapshot_header) ||
+      (unsigned long long)size.QuadPart > SIZE_MAX) {
+    goto cleanup;
+  }
+  mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (!mapping) {
+    goto cleanup;
+  }
+  view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (view) {
+    *bytes = (size_t)size.QuadPart;
+  }
+
+cleanup:
+  // The view keeps the file mapped after both handles are closed.
+  if (mapping) {
+    CloseHandle(mapping);
+  }
+  if (file != INVALID_HANDLE_VALUE) {
+    CloseHandle(file);
+  }
+  return view;
+}
+
+static void unmap_file(void const *const image, size_t const bytes) {
+  (void)bytes;
+  UnmapViewOfFile(image);
+}
+#elif !defined(__wasi__)
+static void *map_file(NATIVE_CHAR const *const path, size_t *const bytes) {
+  void *view = NULL;
+  int const fd = open(path, O_RDONLY);
+  if (fd == -1) {
+    return NULL;
+  }
+  struct stat st;
+  if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(struct ov_hm_snapshot_header) &&
+      (unsigned long long)st.st_size <= SIZE_MAX) {
+    view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (view == MAP_FAILED) {
+      view = NULL;
+    } else {
+      *bytes = (size_t)st.st_size;
+    }
+  }
+  close(fd);
+  return view;
+}
+
+static void unmap_file(void const *const image, size_t const bytes) { munmap((void *)(uintptr_t)image, bytes); }
+#endif
+
+bool ov_hashmap_snapshot_map(NATIVE_CHAR const *const path, struct ov_hashmap_snapshot_mapping *const m) {
+  assert(path != NULL && "path must not be NULL");
+  assert(m != NULL && "m must not be NULL");
+  if (!path || !m) {
+    return false;
+  }
+  *m = (struct ov_hashmap_snapshot_mapping){0};
+#ifdef __wasi__
+  return false;
+#else
+  size_t bytes = 0;
+  void *const view = map_file(path, &bytes);
+  if (!view) {
+    return false;
+  }
+  // Mappings are page aligned, so only the contents can make the image unusable.
+  if (!ov_hashmap_snapshot_validate(view, bytes)) {
+    unmap_file(view, bytes);
+    return false;
+  }
+  m->image = view;
+  m->image_bytes = bytes;
+  return true;
+#endif
+}
+
+void ov_hashmap_snapshot_unmap(struct ov_hashmap_snapshot_mapping *const m) {
+  assert(m != NULL && "m must not be NULL");
+  if (!m || !m->image) {
+    return;
+  }
+#ifndef __wasi__
+  unmap_file(m->image, m->image_bytes);
+#endif
+  *m = (struct ov_hashmap_snapshot_mapping){0};
+}
@@ -162,8 +162,377 @@ cleanup:
   OV_HASHMAP_DESTROY(&hm);
 }
 
+struct test_item_u64 {
+  uint64_t key;
+  uint64_t v;
+};
+
+static void test_ov_hashmap_reserve(void) {
+  enum { n = 10000 };
+  struct ov_hashmap *hm = OV_HASHMAP_CREATE_STATIC(sizeof(struct test_item_u64), 0, sizeof(uint64_t));
+  if (!TEST_CHECK(hm != NULL)) {
+    return;
+  }
+
+  if (!TEST_CHECK(OV_HASHMAP_RESERVE(hm, n))) {
+    goto cleanup;
+  }
+  if (!TEST_CHECK(OV_HASHMAP_SET(hm, &((struct test_item_u64){.key = 0, .v = 0})))) {
+    goto cleanup;
+  }
+  {
+    // No rehash may happen within the reserved size. Items may still move (Robin Hood inserts and
+    // backward-shift deletes shuffle them), so compare the table size rather than item addresses.
+    struct ov_hashmap_stats before;
+    struct ov_hashmap_stats after;
+    OV_HASHMAP_GET_STATS(hm, &before);
+    for (uint64_t i = 1; i < n; ++i) {
+      if (!TEST_CHECK(OV_HASHMAP_SET(hm, &((struct test_item_u64){.key = i, .v = i})))) {
+        goto cleanup;
+      }
+    }
+    OV_HASHMAP_GET_STATS(hm, &after);
+    TEST_CHECK(after.capacity == before.capacity);
+    TEST_CHECK(after.resizes == before.resizes);
+    TEST_MSG("capacity %zu -> %zu", before.capacity, after.capacity);
+  }
+  TEST_CHECK(OV_HASHMAP_COUNT(hm) == n);
+
+  {
+    // Reserved size is a floor, so deleting everything then refilling must not resize either.
+    struct ov_hashmap_stats before;
+    struct ov_hashmap_stats after;
+    OV_HASHMAP_GET_STATS(hm, &before);
+    for (uint64_t i = 1; i < n; ++i) {
+      TEST_CHECK(OV_HASHMAP_DELETE(hm, &i) != NULL);
+    }
+    OV_HASHMAP_GET_STATS(hm, &after);
+    TEST_CHECK(after.capacity == before.capacity);
+    for (uint64_t i = 1; i < n; ++i) {
+      if (!TEST_CHECK(OV_HASHMAP_SET(hm, &((struct test_item_u64){.key = i, .v = i})))) {
+        goto cleanup;
+      }
+    }
+    OV_HASHMAP_GET_STATS(hm, &after);
+    TEST_CHECK(after.capacity == before.capacity);
+    TEST_CHECK(after.resizes == before.resizes);
+    TEST_MSG("capacity %zu -> %zu", before.capacity, after.capacity);
+  }
+
+  for (uint64_t i = 10; i < n; ++i) {
+    TEST_CHECK(OV_HASHMAP_DELETE(hm, &i) != NULL);
+  }
+  if (!TEST_CHECK(OV_HASHMAP_SHRINK_TO_FIT(hm))) {
+    goto cleanup;
+  }
+  TEST_CHECK(OV_HASHMAP_COUNT(hm) == 10);
+  for (uint64_t i = 0; i < 10; ++i) {
+    struct test_item_u64 const *const got = (struct test_item_u64 const *)OV_HASHMAP_GET(hm, &i);
+    TEST_CHECK(got != NULL && got->v == i);
+  }
+
+cleanup:
+  OV_HASHMAP_DESTROY(&hm);
+}
+
+static void test_ov_hashmap_set_bulk(void) {
+  enum { n = 5000 };
+  struct ov_hashmap *hm = OV_HASHMAP_CREATE_STATIC(sizeof(struct test_item_u64), 0, sizeof(uint64_t));
+  struct test_item_u64 *items = NULL;
+  if (!TEST_CHECK(hm != NULL)) {
+    goto cleanup;
+  }
+  OV_HASHMAP_SET_LOAD_FACTOR(hm, 0.9);
+  if (!TEST_CHECK(OV_REALLOC(&items, n, sizeof(*items)))) {
+    goto cleanup;
+  }
+  for (size_t i = 0; i < n; ++i) {
+    // every key appears twice, the later item must win
+    items[i] = (struct test_item_u64){.key = i / 2, .v = i};
+  }
+  TEST_CHECK(OV_HASHMAP_SET_BULK(hm, NULL, 0));
+  if (!TEST_CHECK(OV_HASHMAP_SET_BULK(hm, items, n))) {
+    goto cleanup;
+  }
+  TEST_CHECK(OV_HASHMAP_COUNT(hm) == n / 2);
+  for (uint64_t i = 0; i < n / 2; ++i) {
+    struct test_item_u64 const *const got = (struct test_item_u64 const *)OV_HASHMAP_GET(hm, &i);
+    TEST_CHECK(got != NULL && got->v == i * 2 + 1);
+  }
+
+cleanup:
+  if (items) {
+    OV_FREE(&items);
+  }
+  if (hm) {
+    OV_HASHMAP_DESTROY(&hm);
+  }
+}
+
+static void test_ov_hashmap_freeze(void) {
+  enum { n = 20000 };
+  struct ov_hashmap *hm = OV_HASHMAP_CREATE_STATIC(sizeof(struct test_item_u64), 0, sizeof(uint64_t));
+  void *image = NULL;
+  void *moved = NULL;
+  size_t image_bytes = 0;
+  if (!TEST_CHECK(hm != NULL)) {
+    goto cleanup;
+  }
+  for (uint64_t i = 0; i < n; ++i) {
+    if (!TEST_CHECK(OV_HASHMAP_SET(hm, &((struct test_item_u64){.key = i * 7919, .v = i})))) {
+      goto cleanup;
+    }
+  }
+  if (!TEST_CHECK(OV_HASHMAP_FREEZE(hm, &image, &image_bytes))) {
+    goto cleanup;
+  }
+  TEST_CHECK(OV_HASHMAP_FROZEN_VALIDATE(image, image_bytes));
+  TEST_CHECK(!OV_HASHMAP_FROZEN_VALIDATE(image, image_bytes - 1));
+  TEST_CHECK(OV_HASHMAP_FROZEN_COUNT(image) == n);
+
+  // The image must work at any address.
+  if (!TEST_CHECK(OV_REALLOC(&moved, image_bytes, 1))) {
+    goto cleanup;
+  }
+  memcpy(moved, image, image_bytes);
+  OV_FREE(&image);
+
+  for (uint64_t i = 0; i < n; ++i) {
+    struct test_item_u64 const *const got =
+        (struct test_item_u64 const *)OV_HASHMAP_FROZEN_GET(moved, &(uint64_t){i * 7919});
+    if (!TEST_CHECK(got != NULL && got->v == i)) {
+      TEST_MSG("key %" PRIu64, i * 7919);
+      goto cleanup;
+    }
+    TEST_CHECK(OV_HASHMAP_FROZEN_GET(moved, &(uint64_t){i * 7919 + 1}) == NULL);
+  }
+  {
+    size_t iter = 0, found = 0;
+    uint64_t sum = 0;
+    struct test_item_u64 const *item = NULL;
+    while (OV_HASHMAP_FROZEN_ITER(moved, &iter, &item)) {
+      sum += item->v;
+      ++found;
+    }
+    TEST_CHECK(found == n);
+    TEST_CHECK(sum == (uint64_t)n * (n - 1) / 2);
+  }
+
+  ((uint32_t *)moved)[0] ^= 1;
+  TEST_CHECK(!OV_HASHMAP_FROZEN_VALIDATE(moved, image_bytes));
+  OV_FREE(&moved);
+
+  // empty map
+  OV_HASHMAP_CLEAR(hm);
+  if (!TEST_CHECK(OV_HASHMAP_FREEZE(hm, &image, &image_bytes))) {
+    goto cleanup;
+  }
+  TEST_CHECK(OV_HASHMAP_FROZEN_VALIDATE(image, image_bytes));
+  TEST_CHECK(OV_HASHMAP_FROZEN_COUNT(image) == 0);
+  TEST_CHECK(OV_HASHMAP_FROZEN_GET(image, &(uint64_t){0}) == NULL);
+
+cleanup:
+  if (moved) {
+    OV_FREE(&moved);
+  }
+  if (image) {
+    OV_FREE(&image);
+  }
+  if (hm) {
+    OV_HASHMAP_DESTROY(&hm);
+  }
+}
+
+static void test_ov_hashmap_snapshot(void) {
+  enum { n = 20000 };
+  struct ov_hashmap *hm = OV_HASHMAP_CREATE_STATIC(sizeof(struct test_item_u64), 0, sizeof(uint64_t));
+  struct ov_hashmap *loaded = NULL;
+  void *image = NULL;
+  void *moved = NULL;
+  size_t image_bytes = 0;
+  if (!TEST_CHECK(hm != NULL)) {
+    goto cleanup;
+  }
+  for (uint64_t i = 0; i < n; ++i) {
+    if (!TEST_CHECK(OV_HASHMAP_SET(hm, &((struct test_item_u64){.key = i * 7919, .v = i})))) {
+      goto cleanup;
+    }
+  }
+  // deleted items must not come back
+  for (uint64_t i = 0; i < n; i += 10) {
+    TEST_CHECK(OV_HASHMAP_DELETE(hm, &(uint64_t){i * 7919}) != NULL);
+  }
+  if (!TEST_CHECK(OV_HASHMAP_SNAPSHOT(hm, &image, &image_bytes))) {
+    goto cleanup;
+  }
+  TEST_CHECK(OV_HASHMAP_SNAPSHOT_VALIDATE(image, image_bytes));
+  TEST_CHECK(!OV_HASHMAP_SNAPSHOT_VALIDATE(image, image_bytes - 1));
+  TEST_CHECK(!OV_HASHMAP_FROZEN_VALIDATE(image, image_bytes));
+  TEST_CHECK(OV_HASHMAP_SNAPSHOT_COUNT(image) == n - n / 10);
+
+  // The image must work at any address.
+  if (!TEST_CHECK(OV_REALLOC(&moved, image_bytes, 1))) {
+    goto cleanup;
+  }
+  memcpy(moved, image, image_bytes);
+  OV_FREE(&image);
+
+  for (uint64_t i = 0; i < n; ++i) {
+    struct test_item_u64 const *const got =
+        (struct test_item_u64 const *)OV_HASHMAP_SNAPSHOT_GET(moved, &(uint64_t){i * 7919});
+    if (!TEST_CHECK(i % 10 == 0 ? got == NULL : got != NULL && got->v == i)) {
+      TEST_MSG("key %" PRIu64, i * 7919);
+      goto cleanup;
+    }
+    TEST_CHECK(OV_HASHMAP_SNAPSHOT_GET(moved, &(uint64_t){i * 7919 + 1}) == NULL);
+  }
+
+  loaded = OV_HASHMAP_LOAD(moved, image_bytes);
+  if (!TEST_CHECK(loaded != NULL)) {
+    goto cleanup;
+  }
+  TEST_CHECK(OV_HASHMAP_COUNT(loaded) == n - n / 10);
+  for (uint64_t i = 0; i < n; ++i) {
+    struct test_item_u64 const *const got =
+        (struct test_item_u64 const *)OV_HASHMAP_GET(loaded, &(uint64_t){i * 7919});
+    if (!TEST_CHECK(i % 10 == 0 ? got == NULL : got != NULL && got->v == i)) {
+      TEST_MSG("key %" PRIu64, i * 7919);
+      goto cleanup;
+    }
+  }
+  // the loaded map is an ordinary hashmap and keeps growing
+  for (uint64_t i = n; i < n * 2; ++i) {
+    if (!TEST_CHECK(OV_HASHMAP_SET(loaded, &((struct test_item_u64){.key = i * 7919, .v = i})))) {
+      goto cleanup;
+    }
+  }
+  TEST_CHECK(OV_HASHMAP_COUNT(loaded) == n * 2 - n / 10);
+  {
+    struct test_item_u64 const *const got =
+        (struct test_item_u64 const *)OV_HASHMAP_GET(loaded, &(uint64_t){(n * 2 - 1) * 7919});
+    TEST_CHECK(got != NULL && got->v == n * 2 - 1);
+  }
+
+#ifndef __wasi__
+  // WASI has no file mappings
+  {
+    static char const path[] = "test_ov_hashmap_snapshot.bin";
+    FILE *fp = fopen(path, "wb");
+    if (!TEST_CHECK(fp != NULL)) {
+      goto cleanup;
+    }
+    TEST_CHECK(fwrite(moved, 1, image_bytes, fp) == image_bytes);
+    fclose(fp);
+    struct ov_hashmap_snapshot_mapping m;
+    if (TEST_CHECK(OV_HASHMAP_SNAPSHOT_MAP(NSTR("test_ov_hashmap_snapshot.bin"), &m))) {
+      TEST_CHECK(m.image_bytes == image_bytes);
+      TEST_CHECK(OV_HASHMAP_SNAPSHOT_COUNT(m.image) == n - n / 10);
+      struct test_item_u64 const *const got =
+          (struct test_item_u64 const *)OV_HASHMAP_SNAPSHOT_GET(m.image, &(uint64_t){7 * 7919});
+      TEST_CHECK(got != NULL && got->v == 7);
+      OV_HASHMAP_SNAPSHOT_UNMAP(&m);
+      TEST_CHECK(m.image == NULL);
+    }
+    remove(path);
+    TEST_CHECK(!OV_HASHMAP_SNAPSHOT_MAP(NSTR("test_ov_hashmap_snapshot.bin"), &m));
+  }
+#endif
+
+  ((uint32_t *)moved)[0] ^= 1;
+  TEST_CHECK(!OV_HASHMAP_SNAPSHOT_VALIDATE(moved, image_bytes));
+  TEST_CHECK(OV_HASHMAP_LOAD(moved, image_bytes) == NULL);
+  OV_FREE(&moved);
+
+  // empty map
+  OV_HASHMAP_CLEAR(hm);
+  if (!TEST_CHECK(OV_HASHMAP_SNAPSHOT(hm, &image, &image_bytes))) {
+    goto cleanup;
+  }
+  TEST_CHECK(OV_HASHMAP_SNAPSHOT_VALIDATE(image, image_bytes));
+  TEST_CHECK(OV_HASHMAP_SNAPSHOT_COUNT(image) == 0);
+  TEST_CHECK(OV_HASHMAP_SNAPSHOT_GET(image, &(uint64_t){0}) == NULL);
+
+cleanup:
+  if (moved) {
+    OV_FREE(&moved);
+  }
+  if (image) {
+    OV_FREE(&image);
+  }
+  if (loaded) {
+    OV_HASHMAP_DESTROY(&loaded);
+  }
+  if (hm) {
+    OV_HASHMAP_DESTROY(&hm);
+  }
+}
+
+static void test_ov_hashmap_stats(void) {
+  enum { n = 3000 };
+  struct ov_hashmap *hm = OV_HASHMAP_CREATE_STATIC(sizeof(struct test_item_u64), 0, sizeof(uint64_t));
+  if (!TEST_CHECK(hm != NULL)) {
+    return;
+  }
+
+  struct ov_hashmap_stats st;
+  OV_HASHMAP_GET_STATS(hm, &st);
+  TEST_CHECK(st.count == 0);
+  TEST_CHECK(st.capacity > 0);
+  TEST_CHECK(st.load_factor == 0);
+  TEST_CHECK(st.max_probe == 0);
+
+  for (uint64_t i = 0; i < n; ++i) {
+    if (!TEST_CHECK(OV_HASHMAP_SET(hm, &((struct test_item_u64){.key = i, .v = i})))) {
+      goto cleanup;
+    }
+  }
+  {
+    size_t found = 0;
+    for (uint64_t i = 0; i < n * 2; ++i) {
+      if (OV_HASHMAP_GET(hm, &i)) {
+        ++found;
+      }
+    }
+    TEST_CHECK(found == n);
+  }
+
+  OV_HASHMAP_GET_STATS(hm, &st);
+  TEST_CHECK(st.count == n);
+  TEST_CHECK(st.capacity >= n);
+  TEST_CHECK(st.load_factor > 0 && st.load_factor < 1);
+  TEST_CHECK(st.avg_probe >= 0 && st.avg_probe <= (double)st.max_probe);
+  {
+    size_t total = 0;
+    for (size_t i = 0; i < OV_HASHMAP_STATS_HISTOGRAM_SIZE; ++i) {
+      total += st.probe_histogram[i];
+    }
+    TEST_CHECK(total == n);
+  }
+#ifdef HASHMAP_STATS
+  TEST_CHECK(st.resizes > 0);
+  TEST_CHECK(st.get_hits == n);
+  TEST_CHECK(st.get_misses == n);
+#else
+  TEST_CHECK(st.resizes == 0 && st.resize_ns == 0);
+  TEST_CHECK(st.get_hits == 0 && st.get_misses == 0);
+#endif
+
+  OV_HASHMAP_RESET_STATS(hm);
+  OV_HASHMAP_GET_STATS(hm, &st);
+  TEST_CHECK(st.count == n);
+  TEST_CHECK(st.resizes == 0 && st.get_hits == 0 && st.get_misses == 0);
+
+cleanup:
+  OV_HASHMAP_DESTROY(&hm);
+}
+
 TEST_LIST = {
     {"test_ov_hashmap_dynamic", test_ov_hashmap_dynamic},
     {"test_ov_hashmap_static", test_ov_hashmap_static},
+    {"test_ov_hashmap_reserve", test_ov_hashmap_reserve},
+    {"test_ov_hashmap_set_bulk", test_ov_hashmap_set_bulk},
+    {"test_ov_hashmap_freeze", test_ov_hashmap_freeze},
+    {"test_ov_hashmap_snapshot", test_ov_hashmap_snapshot},
+    {"test_ov_hashmap_stats", test_ov_hashmap_stats},
     {NULL, NULL},
 };
@@ -0,0 +1,284 @@
+#include <ovintern.h>
+
+#include <ovhashmap.h>
+#include <ovthreads.h>
+
+#include <assert.h>
+#include <stdatomic.h>
+#include <string.h>
+
+enum {
+  block_size = 64 * 1024,
+  // Strings larger than this get a block of their own so they do not waste the tail of the current one.
+  large_string = block_size / 4,
+  // Entry segment k holds (segment_base << k) entries, so segments never move and 24 of them cover 32-bit ids.
+  segment_base_bits = 8,
+  segment_base = 1 << segment_base_bits,
+  max_segments = 24,
+};
+
+// Total capacity of all segments: segment_base * (2^max_segments - 1) == 2^32 - segment_base.
+static uint32_t const max_ids = UINT32_MAX - segment_base + 1;
+
+struct block {
+  struct block *next;
+};
+
+struct entry {
+  char const *str;
+  size_t len;
+};
+
+struct item {
+  char const *str;
+  size_t len;
+  uint32_t id;
+};
+
+struct ov_intern {
+  struct ov_hashmap *map;
+  struct block *blocks;
+  char *cur;
+  size_t remain;
+  struct entry *segments[max_segments];
+  atomic_size_t count;
+  bool thread_safe;
+  mtx_t mtx;
+};
+
+static void get_key(void const *const item, void const **const key, size_t *const key_bytes) {
+  struct item const *const it = (struct item const *)item;
+  *key = it->str;
+  *key_bytes = it->len;
+}
+
+static inline size_t segment_of(uint32_t const id, size_t *const offset) {
+  size_t const q = ((size_t)id >> segment_base_bits) + 1;
+  size_t k = 0;
+  while (q >> (k + 1)) {
+    ++k;
+  }
+  *offset = (size_t)id - (((size_t)1 << k) - 1) * segment_base;
+  return k;
+}
+
+static struct entry const *entry_at(struct ov_intern const *const in, uint32_t const id) {
+  // Acquire pairs with the release in ov_intern so the entry and its segment are visible.
+  if ((size_t)id >= atomic_load_explicit(&in->count, memory_order_acquire)) {
+    return NULL;
+  }
+  size_t offset = 0;
+  size_t const k = segment_of(id, &offset);
+  return in->segments[k] + offset;
+}
+
+static char *arena_alloc(struct ov_intern *const in, size_t const bytes MEM_FILEPOS_PARAMS) {
+  if (bytes > large_string) {
+    struct block *b = NULL;
+    if (bytes > SIZE_MAX - sizeof(struct block) ||
+        !ov_mem_realloc(&b, 1, sizeof(struct block) + bytes MEM_FILEPOS_VALUES_PASSTHRU)) {
+      return NULL;
+    }
+    b->next = in->blocks;
+    in->blocks = b;
+    return (char *)(b + 1);
+  }
+  if (bytes > in->remain) {
+    struct block *b = NULL;
+    if (!ov_mem_realloc(&b, 1, sizeof(struct block) + block_size MEM_FILEPOS_VALUES_PASSTHRU)) {
+      return NULL;
+    }
+    b->next = in->blocks;
+    in->blocks = b;
+    in->cur = (char *)(b + 1);
+    in->remain = block_size;
+  }
+  char *const p = in->cur;
+  in->cur += bytes;
+  in->remain -= bytes;
+  return p;
+}
+
+struct ov_intern *ov_intern_create(bool const thread_safe MEM_FILEPOS_PARAMS) {
+#ifdef ALLOCATE_LOGGER
+  assert(filepos != NULL && "filepos must not be NULL");
+#endif
+  struct ov_intern *result = NULL;
+  struct ov_intern *in = NULL;
+  bool mtx_initialized = false;
+
+  if (!ov_mem_realloc(&in, 1, sizeof(*in) MEM_FILEPOS_VALUES_PASSTHRU)) {
+    goto cleanup;
+  }
+  *in = (struct ov_intern){
+      .thread_safe = thread_safe,
+  };
+  atomic_init(&in->count, 0);
+  if (thread_safe) {
+    if (mtx_init(&in->mtx, mtx_plain) != thrd_success) {
+      goto cleanup;
+    }
+    mtx_initialized = true;
+  }
+  in->map = ov_hashmap_create_dynamic(sizeof(struct item), 0, get_key MEM_FILEPOS_VALUES_PASSTHRU);
+  if (!in->map) {
+    goto cleanup;
+  }
+
+  result = in;
+  in = NULL;
+
+cleanup:
+  if (in) {
+    if (mtx_initialized) {
+      mtx_destroy(&in->mtx);
+    }
+    ov_mem_free(&in MEM_FILEPOS_VALUES_PASSTHRU);
+  }
+  return result;
+}
+
+void ov_intern_destroy(struct ov_intern **const inp MEM_FILEPOS_PARAMS) {
+  assert(inp != NULL && "inp must not be NULL");
+  assert(*inp != NULL && "table is already destroyed or not initialized");
+#ifdef ALLOCATE_LOGGER
+  assert(filepos != NULL && "filepos must not be NULL");
+#endif
+  if (!inp || !*inp) {
+    return;
+  }
+
+  struct ov_intern *const in = *inp;
+  ov_hashmap_destroy(&in->map MEM_FILEPOS_VALUES_PASSTHRU);
+  for (size_t k = 0; k < max_segments && in->segments[k]; ++k) {
+    ov_mem_free(&in->segments[k] MEM_FILEPOS_VALUES_PASSTHRU);
+  }
+  while (in->blocks) {
+    struct block *b = in->blocks;
+    in->blocks = b->next;
+    ov_mem_free(&b MEM_FILEPOS_VALUES_PASSTHRU);
+  }
+  if (in->thread_safe) {
+    mtx_destroy(&in->mtx);
+  }
+  ov_mem_free((void **)inp MEM_FILEPOS_VALUES_PASSTHRU);
+}
+
+static struct item const *lookup(struct ov_intern *const in, char const *const str, size_t const len) {
+  return (struct item const *)ov_hashmap_get(in->map, &(struct item){.str = str, .len = len});
+}
+
+char const *
+ov_intern(struct ov_intern *const in, char const *const str, size_t const len, uint32_t *const id MEM_FILEPOS_PARAMS) {
+  assert(in != NULL && "in must not be NULL");
+  assert((str != NULL || len == 0) && "str must not be NULL");
+#ifdef ALLOCATE_LOGGER
+  assert(filepos != NULL && "filepos must not be NULL");
+#endif
+  if (!in || (!str && len)) {
+    return NULL;
+  }
+
+  char const *const key = str ? str : "";
+  char const *result = NULL;
+  if (in->thread_safe) {
+    mtx_lock(&in->mtx);
+  }
+
+  {
+    struct item const *const found = lookup(in, key, len);
+    if (found) {
+      if (id) {
+        *id = found->id;
+      }
+      result = found->str;
+      goto cleanup;
+    }
+  }
+
+  {
+    size_t const n = atomic_load_explicit(&in->count, memory_order_relaxed);
+    if (n >= max_ids || len == SIZE_MAX) {
+      goto cleanup;
+    }
+    uint32_t const new_id = (uint32_t)n;
+    size_t offset = 0;
+    size_t const k = segment_of(new_id, &offset);
+    if (!in->segments[k]) {
+      if (!ov_mem_realloc(
+              &in->segments[k], (size_t)segment_base << k, sizeof(struct entry) MEM_FILEPOS_VALUES_PASSTHRU)) {
+        goto cleanup;
+      }
+    }
+    // On a later failure the copied bytes stay in the arena unused; they are reclaimed on destroy.
+    char *const copy = arena_alloc(in, len + 1 MEM_FILEPOS_VALUES_PASSTHRU);
+    if (!copy) {
+      goto cleanup;
+    }
+    if (len) {
+      memcpy(copy, key, len);
+    }
+    copy[len] = '\0';
+    if (!ov_hashmap_set(in->map, &(struct item){.str = copy, .len = len, .id = new_id} MEM_FILEPOS_VALUES_PASSTHRU)) {
+      goto cleanup;
+    }
+    in->segments[k][offset] = (struct entry){.str = copy, .len = len};
+    atomic_store_explicit(&in->count, n + 1, memory_order_release);
+    if (id) {
+      *id = new_id;
+    }
+    result = copy;
+  }
+
+cleanup:
+  if (in->thread_safe) {
+    mtx_unlock(&in->mtx);
+  }
+  return result;
+}
+
+char const *ov_intern_find(struct ov_intern *const in, char const *const str, size_t const len, uint32_t *const id) {
+  assert(in != NULL && "in must not be NULL");
+  assert((str != NULL || len == 0) && "str must not be NULL");
+  if (!in || (!str && len)) {
+    return NULL;
+  }
+
+  if (in->thread_safe) {
+    mtx_lock(&in->mtx);
+  }
+  struct item const *const found = lookup(in, str ? str : "", len);
+  char const *const result = found ? found->str : NULL;
+  if (found && id) {
+    *id = found->id;
+  }
+  if (in->thread_safe) {
+    mtx_unlock(&in->mtx);
+  }
+  return result;
+}
+
+char const *ov_intern_str(struct ov_intern const *const in, uint32_t const id) {
+  assert(in != NULL && "in must not be NULL");
+  if (!in) {
+    return NULL;
+  }
+  struct entry const *const e = entry_at(in, id);
+  return e ? e->str : NULL;
+}
+
+size_t ov_intern_len(struct ov_intern const *const in, uint32_t const id) {
+  assert(in != NULL && "in must not be NULL");
+  if (!in) {
+    return 0;
+  }
+  struct entry const *const e = entry_at(in, id);
+  return e ? e->len : 0;
+}
+
+size_t ov_intern_count(struct ov_intern const *const in) {
+  if (!in) {
+    return 0;
+  }
+  return atomic_load_explicit(&in->count, memory_order_acquire);
+}
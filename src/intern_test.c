@@ -0,0 +1,213 @@
+#include <ovtest.h>
+
+#include <ovhashmap.h>
+#include <ovintern.h>
+#include <ovthreads.h>
+
+#include <stdatomic.h>
+#include <stdio.h>
+
+static void test_intern_basic(void) {
+  struct ov_intern *in = OV_INTERN_CREATE(false);
+  if (!TEST_CHECK(in != NULL)) {
+    return;
+  }
+
+  TEST_CHECK(OV_INTERN_COUNT(in) == 0);
+  TEST_CHECK(OV_INTERN_FIND(in, "hello", 5, NULL) == NULL);
+  TEST_CHECK(OV_INTERN_STR(in, 0) == NULL);
+
+  uint32_t id_a = 99, id_b = 99, id_c = 99;
+  char buf[] = "hello";
+  char const *const a = OV_INTERN(in, "hello", 5, &id_a);
+  char const *const b = OV_INTERN(in, buf, 5, &id_b);
+  char const *const c = OV_INTERN(in, "hello world", 5, &id_c);
+  if (!TEST_CHECK(a != NULL)) {
+    goto cleanup;
+  }
+  TEST_CHECK(a == b && a == c);
+  TEST_CHECK(a != buf);
+  TEST_CHECK(id_a == 0 && id_b == 0 && id_c == 0);
+  TEST_CHECK(strcmp(a, "hello") == 0);
+  TEST_CHECK(OV_INTERN_COUNT(in) == 1);
+
+  // prefix, empty and embedded NUL strings are distinct keys
+  uint32_t id = 0;
+  TEST_CHECK(OV_INTERN(in, "hell", 4, &id) != a && id == 1);
+  TEST_CHECK(OV_INTERN(in, NULL, 0, &id) != NULL && id == 2);
+  TEST_CHECK(strcmp(OV_INTERN_STR(in, 2), "") == 0);
+  TEST_CHECK(OV_INTERN(in, "", 0, &id) == OV_INTERN_STR(in, 2) && id == 2);
+  TEST_CHECK(OV_INTERN(in, "a\0b", 3, &id) != NULL && id == 3);
+  TEST_CHECK(OV_INTERN_LEN(in, 3) == 3);
+  TEST_CHECK(memcmp(OV_INTERN_STR(in, 3), "a\0b", 4) == 0);
+
+  TEST_CHECK(OV_INTERN_FIND(in, "hello", 5, &id) == a && id == 0);
+  TEST_CHECK(OV_INTERN_FIND(in, "hellO", 5, NULL) == NULL);
+  TEST_CHECK(OV_INTERN_STR(in, 0) == a);
+  TEST_CHECK(OV_INTERN_LEN(in, 0) == 5);
+  TEST_CHECK(OV_INTERN_STR(in, 4) == NULL);
+  TEST_CHECK(OV_INTERN_LEN(in, 4) == 0);
+
+cleanup:
+  OV_INTERN_DESTROY(&in);
+  TEST_CHECK(in == NULL);
+}
+
+static void test_intern_many(void) {
+  enum { n = 100000 };
+  struct ov_intern *in = OV_INTERN_CREATE(false);
+  char *large = NULL;
+  if (!TEST_CHECK(in != NULL)) {
+    return;
+  }
+
+  char const *first = NULL;
+  for (uint32_t i = 0; i < n; ++i) {
+    char buf[32];
+    int const len = snprintf(buf, sizeof(buf), "key-%u", i);
+    uint32_t id = 0;
+    char const *const s = OV_INTERN(in, buf, (size_t)len, &id);
+    if (!TEST_CHECK(s != NULL && id == i)) {
+      goto cleanup;
+    }
+    if (i == 0) {
+      first = s;
+    }
+  }
+  // strings never move while the table grows
+  TEST_CHECK(OV_INTERN_STR(in, 0) == first);
+  TEST_CHECK(OV_INTERN_COUNT(in) == n);
+  for (uint32_t i = 0; i < n; i += 997) {
+    char buf[32];
+    int const len = snprintf(buf, sizeof(buf), "key-%u", i);
+    uint32_t id = 0;
+    TEST_CHECK(OV_INTERN_FIND(in, buf, (size_t)len, &id) == OV_INTERN_STR(in, i) && id == i);
+    TEST_CHECK(strcmp(OV_INTERN_STR(in, i), buf) == 0);
+  }
+
+  // strings larger than an arena block
+  {
+    size_t const large_len = 200000;
+    if (!TEST_CHECK(OV_REALLOC(&large, large_len, sizeof(char)))) {
+      goto cleanup;
+    }
+    memset(large, 'x', large_len);
+    uint32_t id = 0;
+    char const *const s = OV_INTERN(in, large, large_len, &id);
+    TEST_CHECK(s != NULL && id == n);
+    TEST_CHECK(OV_INTERN_LEN(in, id) == large_len);
+    TEST_CHECK(OV_INTERN(in, large, large_len, NULL) == s);
+    TEST_CHECK(OV_INTERN(in, "after large", 11, &id) != NULL && id == n + 1);
+    TEST_CHECK(OV_INTERN_STR(in, 0) == first);
+  }
+
+cleanup:
+  if (large) {
+    OV_FREE(&large);
+  }
+  OV_INTERN_DESTROY(&in);
+}
+
+struct test_counter {
+  uint32_t id;
+  size_t n;
+};
+
+static void test_intern_hashmap_key(void) {
+  struct ov_intern *in = OV_INTERN_CREATE(false);
+  struct ov_hashmap *hm = OV_HASHMAP_CREATE_STATIC(sizeof(struct test_counter), 0, sizeof(uint32_t));
+  if (!TEST_CHECK(in != NULL && hm != NULL)) {
+    goto cleanup;
+  }
+
+  {
+    static char const *const words[] = {"red", "green", "red", "blue", "red", "green"};
+    for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); ++i) {
+      uint32_t id = 0;
+      if (!TEST_CHECK(OV_INTERN(in, words[i], strlen(words[i]), &id) != NULL)) {
+        goto cleanup;
+      }
+      struct test_counter const *const found = (struct test_counter const *)OV_HASHMAP_GET(hm, &id);
+      struct test_counter const c = {.id = id, .n = found ? found->n + 1 : 1};
+      if (!TEST_CHECK(OV_HASHMAP_SET(hm, &c))) {
+        goto cleanup;
+      }
+    }
+  }
+  TEST_CHECK(OV_HASHMAP_COUNT(hm) == 3);
+  {
+    uint32_t id = 0;
+    TEST_CHECK(OV_INTERN_FIND(in, "red", 3, &id) != NULL);
+    struct test_counter const *const c = (struct test_counter const *)OV_HASHMAP_GET(hm, &id);
+    TEST_CHECK(c != NULL && c->n == 3);
+  }
+
+cleanup:
+  if (hm) {
+    OV_HASHMAP_DESTROY(&hm);
+  }
+  if (in) {
+    OV_INTERN_DESTROY(&in);
+  }
+}
+
+enum {
+  test_threads = 8,
+  test_keys = 5000,
+};
+
+struct test_thread_context {
+  struct ov_intern *in;
+  uint32_t seed;
+  atomic_int *failures;
+};
+
+static int test_intern_thread(void *userdata) {
+  struct test_thread_context *const ctx = (struct test_thread_context *)userdata;
+  // every thread interns the same keys in a different order
+  for (uint32_t i = 0; i < test_keys; ++i) {
+    uint32_t const k = (i * 7919 + ctx->seed * 104729) % test_keys;
+    char buf[32];
+    int const len = snprintf(buf, sizeof(buf), "k%u", k);
+    uint32_t id = 0;
+    char const *const s = OV_INTERN(ctx->in, buf, (size_t)len, &id);
+    if (!s || strcmp(s, buf) != 0 || OV_INTERN_STR(ctx->in, id) != s) {
+      atomic_fetch_add(ctx->failures, 1);
+    }
+  }
+  return 0;
+}
+
+static void test_intern_threads(void) {
+  struct ov_intern *in = OV_INTERN_CREATE(true);
+  if (!TEST_CHECK(in != NULL)) {
+    return;
+  }
+
+  atomic_int failures = 0;
+  thrd_t threads[test_threads];
+  struct test_thread_context ctx[test_threads];
+  size_t started = 0;
+  for (size_t i = 0; i < test_threads; ++i) {
+    ctx[i] = (struct test_thread_context){.in = in, .seed = (uint32_t)i, .failures = &failures};
+    if (!TEST_CHECK(thrd_create(threads + i, test_intern_thread, ctx + i) == thrd_success)) {
+      break;
+    }
+    ++started;
+  }
+  for (size_t i = 0; i < started; ++i) {
+    thrd_join(threads[i], NULL);
+  }
+  TEST_CHECK(atomic_load(&failures) == 0);
+  TEST_CHECK(OV_INTERN_COUNT(in) == test_keys);
+
+  OV_INTERN_DESTROY(&in);
+}
+
+TEST_LIST = {
+    {"test_intern_basic", test_intern_basic},
+    {"test_intern_many", test_intern_many},
+    {"test_intern_hashmap_key", test_intern_hashmap_key},
+    {"test_intern_threads", test_intern_threads},
+    {NULL, NULL},
+};
@@ -8,6 +8,7 @@
 #endif
 
 #include <ovarray.h>
+#include <ovintern.h>
 
 struct mo_msg {
   char const *id;
@@ -190,6 +191,31 @@ static struct mo_msg *find(struct mo const *const mp, char const *const id) {
   return NULL;
 }
 
+// Same result as find() for an id of known length, using memcmp instead of strcmp's byte-at-a-time scan.
+// Plural entries store "singular\0plural" as their id, so a longer entry still matches if it ends right there.
+static struct mo_msg *find_n(struct mo const *const mp, char const *const id, size_t const id_len) {
+  size_t l = 0, r = mp->msg_len;
+  while (l < r) {
+    size_t const mid = l + (r - l) / 2;
+    struct mo_msg const *const msg = mp->msg + mid;
+    int cmp = memcmp(msg->id, id, msg->id_len < id_len ? msg->id_len : id_len);
+    if (cmp == 0 && msg->id_len < id_len) {
+      cmp = -1;
+    } else if (cmp == 0 && msg->id_len > id_len && msg->id[id_len] != '\0') {
+      cmp = 1;
+    }
+    if (cmp == 0) {
+      return mp->msg + mid;
+    }
+    if (cmp < 0) {
+      l = mid + 1;
+    } else {
+      r = mid;
+    }
+  }
+  return NULL;
+}
+
 char const *mo_gettext(struct mo const *const mp, char const *const id) {
   assert(id != NULL && "id must not be NULL");
   if (!mp) {
@@ -229,6 +255,19 @@ cleanup:
   return msg ? msg->str : id;
 }
 
+char const *mo_gettext_intern(struct mo const *const mp, struct ov_intern const *const in, uint32_t const id) {
+  assert(in != NULL && "in must not be NULL");
+  char const *const str = in ? ov_intern_str(in, id) : NULL;
+  if (!str) {
+    return "";
+  }
+  if (!mp) {
+    return str;
+  }
+  struct mo_msg *msg = find_n(mp, str, ov_intern_len(in, id));
+  return msg ? msg->str : str;
+}
+
 static char const *find_plural_form(char const *s, size_t len, unsigned long int const n) {
   unsigned long int i = 0;
   while (*s != '\0') {
@@ -2,6 +2,7 @@
 #include <ovtest.h>
 
 #include <ovarray.h>
+#include <ovintern.h>
 
 #include <stdio.h>
 #ifndef _WIN32
@@ -206,8 +207,43 @@ static void test_mo_win32(void) {
 }
 #endif
 
+static void test_mo_gettext_intern(void) {
+  uint8_t mobuf[4096];
+  struct mo *mp = open_mo(mobuf);
+  struct ov_intern *in = OV_INTERN_CREATE(false);
+  if (!mp || !TEST_CHECK(in != NULL)) {
+    goto cleanup;
+  }
+
+  {
+    static char const *const ids[] = {"Hello world", "Hello_world", "Menu|File\x04Open", "an apple", "", "Z"};
+    static char const *const expected[] = {"Hello world2", "Hello_world", "Open file", "an apple2", NULL, "Z"};
+    for (size_t i = 0; i < sizeof(ids) / sizeof(ids[0]); ++i) {
+      uint32_t id = 0;
+      if (!TEST_CHECK(OV_INTERN(in, ids[i], strlen(ids[i]), &id) != NULL)) {
+        goto cleanup;
+      }
+      char const *const got = mo_gettext_intern(mp, in, id);
+      char const *const want = expected[i] ? expected[i] : mo_gettext(mp, ids[i]);
+      TEST_CHECK(strcmp(got, want) == 0);
+      TEST_MSG("id=%s expected %s got %s", ids[i], want, got);
+    }
+  }
+  TEST_CHECK(strcmp(mo_gettext_intern(NULL, in, 0), "Hello world") == 0);
+  TEST_CHECK(strcmp(mo_gettext_intern(mp, in, 1000), "") == 0);
+
+cleanup:
+  if (in) {
+    OV_INTERN_DESTROY(&in);
+  }
+  if (mp) {
+    mo_free(&mp);
+  }
+}
+
 TEST_LIST = {
     {"test_mo", test_mo},
+    {"test_mo_gettext_intern", test_mo_gettext_intern},
     {"test_mo_get_preferred_ui_languages", test_mo_get_preferred_ui_languages},
 #ifdef _WIN32
     {"test_mo_win32_locale", test_mo_win32_locale},
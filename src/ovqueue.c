@@ -0,0 +1,435 @@
+#include <ovqueue.h>
+
+#include <ovthreads.h>
+
+#include <assert.h>
+#include <stdatomic.h>
+#include <string.h>
+
+enum {
+  cache_line_size = 64,
+  spin_limit = 64,
+  yield_limit = 8,
+};
+
+// Blocking wrappers
+//
+// Waiters count themselves before parking and re-try the operation under the mutex; the other
+// side issues a full fence after each successful operation and only takes the mutex when
+// someone is counted. Together this rules out lost wakeups while keeping the common path free
+// of locks and syscalls.
+
+struct blocking {
+  mtx_t mtx;
+  cnd_t not_empty;
+  cnd_t not_full;
+  atomic_uint empty_waiters;
+  atomic_uint full_waiters;
+  atomic_bool closed;
+};
+
+static bool blocking_init(struct blocking *const b) {
+  if (mtx_init(&b->mtx, mtx_plain) != thrd_success) {
+    return false;
+  }
+  if (cnd_init(&b->not_empty) != thrd_success) {
+    mtx_destroy(&b->mtx);
+    return false;
+  }
+  if (cnd_init(&b->not_full) != thrd_success) {
+    cnd_destroy(&b->not_empty);
+    mtx_destroy(&b->mtx);
+    return false;
+  }
+  atomic_init(&b->empty_waiters, 0);
+  atomic_init(&b->full_waiters, 0);
+  atomic_init(&b->closed, false);
+  return true;
+}
+
+static void blocking_exit(struct blocking *const b) {
+  cnd_destroy(&b->not_full);
+  cnd_destroy(&b->not_empty);
+  mtx_destroy(&b->mtx);
+}
+
+static void blocking_notify(struct blocking *const b, atomic_uint *const waiters, cnd_t *const cnd) {
+  atomic_thread_fence(memory_order_seq_cst);
+  if (atomic_load_explicit(waiters, memory_order_relaxed)) {
+    mtx_lock(&b->mtx);
+    cnd_signal(cnd);
+    mtx_unlock(&b->mtx);
+  }
+}
+
+static void blocking_close(struct blocking *const b) {
+  mtx_lock(&b->mtx);
+  atomic_store(&b->closed, true);
+  cnd_broadcast(&b->not_empty);
+  cnd_broadcast(&b->not_full);
+  mtx_unlock(&b->mtx);
+}
+
+static inline bool is_closed(struct blocking *const b) {
+  return atomic_load_explicit(&b->closed, memory_order_acquire);
+}
+
+typedef bool (*raw_push_func)(void *const q, void const *const item);
+typedef bool (*raw_pop_func)(void *const q, void *const item);
+
+static bool blocking_push(struct blocking *const b, raw_push_func const push, void *const q, void const *const item) {
+  for (size_t spins = 0; spins < spin_limit + yield_limit; ++spins) {
+    if (is_closed(b)) {
+      return false;
+    }
+    if (push(q, item)) {
+      blocking_notify(b, &b->empty_waiters, &b->not_empty);
+      return true;
+    }
+    if (spins >= spin_limit) {
+      thrd_yield();
+    }
+  }
+  bool ok = false;
+  mtx_lock(&b->mtx);
+  atomic_fetch_add_explicit(&b->full_waiters, 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+  while (!is_closed(b) && !(ok = push(q, item))) {
+    cnd_wait(&b->not_full, &b->mtx);
+  }
+  atomic_fetch_sub_explicit(&b->full_waiters, 1, memory_order_relaxed);
+  mtx_unlock(&b->mtx);
+  if (ok) {
+    blocking_notify(b, &b->empty_waiters, &b->not_empty);
+  }
+  return ok;
+}
+
+static bool blocking_pop(struct blocking *const b, raw_pop_func const pop, void *const q, void *const item) {
+  for (size_t spins = 0; spins < spin_limit + yield_limit; ++spins) {
+    if (pop(q, item)) {
+      blocking_notify(b, &b->full_waiters, &b->not_full);
+      return true;
+    }
+    if (is_closed(b)) {
+      // Re-check: the last push may have landed right before close.
+      if (pop(q, item)) {
+        blocking_notify(b, &b->full_waiters, &b->not_full);
+        return true;
+      }
+      return false;
+    }
+    if (spins >= spin_limit) {
+      thrd_yield();
+    }
+  }
+  bool ok = false;
+  mtx_lock(&b->mtx);
+  atomic_fetch_add_explicit(&b->empty_waiters, 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+  while (!(ok = pop(q, item)) && !is_closed(b)) {
+    cnd_wait(&b->not_empty, &b->mtx);
+  }
+  if (!ok) {
+    ok = pop(q, item);
+  }
+  atomic_fetch_sub_explicit(&b->empty_waiters, 1, memory_order_relaxed);
+  mtx_unlock(&b->mtx);
+  if (ok) {
+    blocking_notify(b, &b->full_waiters, &b->not_full);
+  }
+  return ok;
+}
+
+static size_t round_capacity(size_t const capacity) {
+  size_t cap = 2;
+  while (cap < capacity) {
+    cap <<= 1;
+  }
+  return cap;
+}
+
+// SPSC ring
+
+struct ov_spsc_queue {
+  // consumer side
+  _Alignas(cache_line_size) atomic_size_t head;
+  size_t cached_tail;
+  // producer side
+  _Alignas(cache_line_size) atomic_size_t tail;
+  size_t cached_head;
+  // read-only after creation
+  _Alignas(cache_line_size) unsigned char *items;
+  size_t mask;
+  size_t item_size;
+  struct blocking blocking;
+};
+
+static bool spsc_push(void *const queue, void const *const item) {
+  struct ov_spsc_queue *const q = (struct ov_spsc_queue *)queue;
+  size_t const t = atomic_load_explicit(&q->tail, memory_order_relaxed);
+  if (t - q->cached_head > q->mask) {
+    q->cached_head = atomic_load_explicit(&q->head, memory_order_acquire);
+    if (t - q->cached_head > q->mask) {
+      return false;
+    }
+  }
+  memcpy(q->items + (t & q->mask) * q->item_size, item, q->item_size);
+  atomic_store_explicit(&q->tail, t + 1, memory_order_release);
+  return true;
+}
+
+static bool spsc_pop(void *const queue, void *const item) {
+  struct ov_spsc_queue *const q = (struct ov_spsc_queue *)queue;
+  size_t const h = atomic_load_explicit(&q->head, memory_order_relaxed);
+  if (h == q->cached_tail) {
+    q->cached_tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+    if (h == q->cached_tail) {
+      return false;
+    }
+  }
+  memcpy(item, q->items + (h & q->mask) * q->item_size, q->item_size);
+  atomic_store_explicit(&q->head, h + 1, memory_order_release);
+  return true;
+}
+
+struct ov_spsc_queue *
+ov_spsc_queue_create(size_t const item_size, size_t const capacity, struct ov_error *const err MEM_FILEPOS_PARAMS) {
+  struct ov_spsc_queue *q = NULL;
+  bool result = false;
+  if (!item_size) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    goto cleanup;
+  }
+  if (!ov_mem_aligned_alloc(&q, 1, sizeof(*q), cache_line_size MEM_FILEPOS_VALUES_PASSTHRU)) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    goto cleanup;
+  }
+  memset(q, 0, sizeof(*q));
+  q->mask = round_capacity(capacity) - 1;
+  q->item_size = item_size;
+  atomic_init(&q->head, 0);
+  atomic_init(&q->tail, 0);
+  if (!ov_mem_realloc(&q->items, q->mask + 1, item_size MEM_FILEPOS_VALUES_PASSTHRU)) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    goto cleanup;
+  }
+  if (!blocking_init(&q->blocking)) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+    goto cleanup;
+  }
+  result = true;
+cleanup:
+  if (!result && q) {
+    if (q->items) {
+      ov_mem_free(&q->items MEM_FILEPOS_VALUES_PASSTHRU);
+    }
+    ov_mem_aligned_free(&q MEM_FILEPOS_VALUES_PASSTHRU);
+  }
+  return q;
+}
+
+void ov_spsc_queue_destroy(struct ov_spsc_queue **const qp MEM_FILEPOS_PARAMS) {
+  assert(qp != NULL && "qp must not be NULL");
+  struct ov_spsc_queue *const q = *qp;
+  if (!q) {
+    return;
+  }
+  blocking_exit(&q->blocking);
+  ov_mem_free(&q->items MEM_FILEPOS_VALUES_PASSTHRU);
+  ov_mem_aligned_free((void **)qp MEM_FILEPOS_VALUES_PASSTHRU);
+}
+
+bool ov_spsc_queue_try_push(struct ov_spsc_queue *const q, void const *const item) {
+  assert(q != NULL && "q must not be NULL");
+  assert(item != NULL && "item must not be NULL");
+  if (is_closed(&q->blocking) || !spsc_push(q, item)) {
+    return false;
+  }
+  blocking_notify(&q->blocking, &q->blocking.empty_waiters, &q->blocking.not_empty);
+  return true;
+}
+
+bool ov_spsc_queue_try_pop(struct ov_spsc_queue *const q, void *const item) {
+  assert(q != NULL && "q must not be NULL");
+  assert(item != NULL && "item must not be NULL");
+  if (!spsc_pop(q, item)) {
+    return false;
+  }
+  blocking_notify(&q->blocking, &q->blocking.full_waiters, &q->blocking.not_full);
+  return true;
+}
+
+bool ov_spsc_queue_push(struct ov_spsc_queue *const q, void const *const item) {
+  assert(q != NULL && "q must not be NULL");
+  assert(item != NULL && "item must not be NULL");
+  return blocking_push(&q->blocking, spsc_push, q, item);
+}
+
+bool ov_spsc_queue_pop(struct ov_spsc_queue *const q, void *const item) {
+  assert(q != NULL && "q must not be NULL");
+  assert(item != NULL && "item must not be NULL");
+  return blocking_pop(&q->blocking, spsc_pop, q, item);
+}
+
+void ov_spsc_queue_close(struct ov_spsc_queue *const q) {
+  assert(q != NULL && "q must not be NULL");
+  blocking_close(&q->blocking);
+}
+
+// Vyukov MPMC
+//
+// Slot i starts with sequence i. A producer at position pos may fill the slot when its
+// sequence equals pos and publishes it as pos + 1; a consumer at pos may take it when the
+// sequence equals pos + 1 and hands it back as pos + capacity for the next lap.
+
+struct ov_mpmc_queue {
+  _Alignas(cache_line_size) atomic_size_t enqueue_pos;
+  _Alignas(cache_line_size) atomic_size_t dequeue_pos;
+  _Alignas(cache_line_size) unsigned char *cells;
+  size_t mask;
+  size_t item_size;
+  size_t cell_size;
+  struct blocking blocking;
+};
+
+static inline atomic_size_t *cell_sequence(struct ov_mpmc_queue const *const q, size_t const pos) {
+  return (atomic_size_t *)(void *)(q->cells + (pos & q->mask) * q->cell_size);
+}
+
+static inline unsigned char *cell_data(struct ov_mpmc_queue const *const q, size_t const pos) {
+  return q->cells + (pos & q->mask) * q->cell_size + sizeof(atomic_size_t);
+}
+
+static bool mpmc_push(void *const queue, void const *const item) {
+  struct ov_mpmc_queue *const q = (struct ov_mpmc_queue *)queue;
+  size_t pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+  for (;;) {
+    size_t const seq = atomic_load_explicit(cell_sequence(q, pos), memory_order_acquire);
+    ptrdiff_t const dif = (ptrdiff_t)seq - (ptrdiff_t)pos;
+    if (dif == 0) {
+      if (atomic_compare_exchange_weak_explicit(
+              &q->enqueue_pos, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) {
+        break;
+      }
+    } else if (dif < 0) {
+      return false;
+    } else {
+      pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+    }
+  }
+  memcpy(cell_data(q, pos), item, q->item_size);
+  atomic_store_explicit(cell_sequence(q, pos), pos + 1, memory_order_release);
+  return true;
+}
+
+static bool mpmc_pop(void *const queue, void *const item) {
+  struct ov_mpmc_queue *const q = (struct ov_mpmc_queue *)queue;
+  size_t pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+  for (;;) {
+    size_t const seq = atomic_load_explicit(cell_sequence(q, pos), memory_order_acquire);
+    ptrdiff_t const dif = (ptrdiff_t)seq - (ptrdiff_t)(pos + 1);
+    if (dif == 0) {
+      if (atomic_compare_exchange_weak_explicit(
+              &q->dequeue_pos, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) {
+        break;
+      }
+    } else if (dif < 0) {
+      return false;
+    } else {
+      pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+    }
+  }
+  memcpy(item, cell_data(q, pos), q->item_size);
+  atomic_store_explicit(cell_sequence(q, pos), pos + q->mask + 1, memory_order_release);
+  return true;
+}
+
+struct ov_mpmc_queue *
+ov_mpmc_queue_create(size_t const item_size, size_t const capacity, struct ov_error *const err MEM_FILEPOS_PARAMS) {
+  struct ov_mpmc_queue *q = NULL;
+  bool result = false;
+  if (!item_size) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    goto cleanup;
+  }
+  if (!ov_mem_aligned_alloc(&q, 1, sizeof(*q), cache_line_size MEM_FILEPOS_VALUES_PASSTHRU)) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    goto cleanup;
+  }
+  memset(q, 0, sizeof(*q));
+  q->mask = round_capacity(capacity) - 1;
+  q->item_size = item_size;
+  q->cell_size = (sizeof(atomic_size_t) + item_size + sizeof(atomic_size_t) - 1) / sizeof(atomic_size_t) *
+                 sizeof(atomic_size_t);
+  atomic_init(&q->enqueue_pos, 0);
+  atomic_init(&q->dequeue_pos, 0);
+  if (!ov_mem_aligned_alloc(&q->cells, q->mask + 1, q->cell_size, cache_line_size MEM_FILEPOS_VALUES_PASSTHRU)) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    goto cleanup;
+  }
+  for (size_t i = 0; i <= q->mask; ++i) {
+    atomic_init(cell_sequence(q, i), i);
+  }
+  if (!blocking_init(&q->blocking)) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+    goto cleanup;
+  }
+  result = true;
+cleanup:
+  if (!result && q) {
+    if (q->cells) {
+      ov_mem_aligned_free(&q->cells MEM_FILEPOS_VALUES_PASSTHRU);
+    }
+    ov_mem_aligned_free(&q MEM_FILEPOS_VALUES_PASSTHRU);
+  }
+  return q;
+}
+
+void ov_mpmc_queue_destroy(struct ov_mpmc_queue **const qp MEM_FILEPOS_PARAMS) {
+  assert(qp != NULL && "qp must not be NULL");
+  struct ov_mpmc_queue *const q = *qp;
+  if (!q) {
+    return;
+  }
+  blocking_exit(&q->blocking);
+  ov_mem_aligned_free(&q->cells MEM_FILEPOS_VALUES_PASSTHRU);
+  ov_mem_aligned_free((void **)qp MEM_FILEPOS_VALUES_PASSTHRU);
+}
+
+bool ov_mpmc_queue_try_push(struct ov_mpmc_queue *const q, void const *const item) {
+  assert(q != NULL && "q must not be NULL");
+  assert(item != NULL && "item must not be NULL");
+  if (is_closed(&q->blocking) || !mpmc_push(q, item)) {
+    return false;
+  }
+  blocking_notify(&q->blocking, &q->blocking.empty_waiters, &q->blocking.not_empty);
+  return true;
+}
+
+bool ov_mpmc_queue_try_pop(struct ov_mpmc_queue *const q, void *const item) {
+  assert(q != NULL && "q must not be NULL");
+  assert(item != NULL && "item must not be NULL");
+  if (!mpmc_pop(q, item)) {
+    return false;
+  }
+  blocking_notify(&q->blocking, &q->blocking.full_waiters, &q->blocking.not_full);
+  return true;
+}
+
+bool ov_mpmc_queue_push(struct ov_mpmc_queue *const q, void const *const item) {
+  assert(q != NULL && "q must not be NULL");
+  assert(item != NULL && "item must not be NULL");
+  return blocking_push(&q->blocking, mpmc_push, q, item);
+}
+
+bool ov_mpmc_queue_pop(struct ov_mpmc_queue *const q, void *const item) {
+  assert(q != NULL && "q must not be NULL");
+  assert(item != NULL && "item must not be NULL");
+  return blocking_pop(&q->blocking, mpmc_pop, q, item);
+}
+
+void ov_mpmc_queue_close(struct ov_mpmc_queue *const q) {
+  assert(q != NULL && "q must not be NULL");
+  blocking_close(&q->blocking);
+}
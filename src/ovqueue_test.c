@@ -0,0 +1,237 @@
+#include <ovtest.h>
+
+#include <ovqueue.h>
+#include <ovthreads.h>
+
+#include <stdatomic.h>
+
+static void test_spsc_basic(void) {
+  struct ov_error err = {0};
+  struct ov_spsc_queue *q = NULL;
+  TEST_FAILED_WITH(
+      OV_SPSC_QUEUE_CREATE(0, 4, &err) != NULL, &err, ov_error_type_generic, ov_error_generic_invalid_argument);
+
+  // capacity 3 is rounded up to 4
+  q = OV_SPSC_QUEUE_CREATE(sizeof(int), 3, &err);
+  if (!TEST_SUCCEEDED(q != NULL, &err)) {
+    return;
+  }
+  int v = 0;
+  TEST_CHECK(!ov_spsc_queue_try_pop(q, &v));
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 4; ++i) {
+      TEST_CHECK(ov_spsc_queue_try_push(q, &i));
+    }
+    TEST_CHECK(!ov_spsc_queue_try_push(q, &v));
+    for (int i = 0; i < 4; ++i) {
+      TEST_CHECK(ov_spsc_queue_try_pop(q, &v));
+      TEST_CHECK(v == i);
+    }
+    TEST_CHECK(!ov_spsc_queue_try_pop(q, &v));
+  }
+
+  // after close pushes fail and pops drain what is left
+  v = 1;
+  TEST_CHECK(ov_spsc_queue_push(q, &v));
+  v = 2;
+  TEST_CHECK(ov_spsc_queue_push(q, &v));
+  ov_spsc_queue_close(q);
+  TEST_CHECK(!ov_spsc_queue_try_push(q, &v));
+  TEST_CHECK(!ov_spsc_queue_push(q, &v));
+  TEST_CHECK(ov_spsc_queue_pop(q, &v) && v == 1);
+  TEST_CHECK(ov_spsc_queue_pop(q, &v) && v == 2);
+  TEST_CHECK(!ov_spsc_queue_pop(q, &v));
+
+  OV_SPSC_QUEUE_DESTROY(&q);
+  TEST_CHECK(q == NULL);
+}
+
+enum {
+  spsc_items = 200000,
+};
+
+static int spsc_producer(void *const userdata) {
+  struct ov_spsc_queue *const q = (struct ov_spsc_queue *)userdata;
+  for (uint64_t i = 0; i < spsc_items; ++i) {
+    if (!ov_spsc_queue_push(q, &i)) {
+      return 1;
+    }
+  }
+  ov_spsc_queue_close(q);
+  return 0;
+}
+
+static void test_spsc_threads(void) {
+  struct ov_error err = {0};
+  // a small ring makes both sides block regularly
+  struct ov_spsc_queue *q = OV_SPSC_QUEUE_CREATE(sizeof(uint64_t), 16, &err);
+  if (!TEST_SUCCEEDED(q != NULL, &err)) {
+    return;
+  }
+  thrd_t producer;
+  if (!TEST_CHECK(thrd_create(&producer, spsc_producer, q) == thrd_success)) {
+    OV_SPSC_QUEUE_DESTROY(&q);
+    return;
+  }
+  uint64_t expected = 0;
+  bool in_order = true;
+  uint64_t v;
+  while (ov_spsc_queue_pop(q, &v)) {
+    in_order = in_order && v == expected;
+    ++expected;
+  }
+  int r = -1;
+  thrd_join(producer, &r);
+  TEST_CHECK(r == 0);
+  TEST_CHECK(in_order);
+  TEST_CHECK(expected == spsc_items);
+  TEST_MSG("got %llu", (unsigned long long)expected);
+  OV_SPSC_QUEUE_DESTROY(&q);
+}
+
+enum {
+  mpmc_producers = 4,
+  mpmc_consumers = 4,
+  mpmc_items = 50000,
+};
+
+struct mpmc_item {
+  uint32_t producer;
+  uint32_t seq;
+};
+
+struct mpmc_context {
+  struct ov_mpmc_queue *q;
+  atomic_uint next_producer;
+  atomic_size_t counts[mpmc_producers];
+  atomic_uint_fast64_t sums[mpmc_producers];
+  atomic_size_t out_of_order;
+};
+
+static int mpmc_producer(void *const userdata) {
+  struct mpmc_context *const ctx = (struct mpmc_context *)userdata;
+  uint32_t const id = atomic_fetch_add(&ctx->next_producer, 1);
+  for (uint32_t i = 0; i < mpmc_items; ++i) {
+    struct mpmc_item const item = {.producer = id, .seq = i};
+    // mix both entry points
+    if (i & 1) {
+      while (!ov_mpmc_queue_try_push(ctx->q, &item)) {
+        thrd_yield();
+      }
+    } else if (!ov_mpmc_queue_push(ctx->q, &item)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static int mpmc_consumer(void *const userdata) {
+  struct mpmc_context *const ctx = (struct mpmc_context *)userdata;
+  uint32_t last[mpmc_producers];
+  bool seen[mpmc_producers] = {false};
+  struct mpmc_item item;
+  while (ov_mpmc_queue_pop(ctx->q, &item)) {
+    // a single consumer sees each producer's items in the order they were pushed
+    if (seen[item.producer] && item.seq <= last[item.producer]) {
+      atomic_fetch_add(&ctx->out_of_order, 1);
+    }
+    seen[item.producer] = true;
+    last[item.producer] = item.seq;
+    atomic_fetch_add(&ctx->counts[item.producer], 1);
+    atomic_fetch_add(&ctx->sums[item.producer], item.seq);
+  }
+  return 0;
+}
+
+static void test_mpmc_threads(void) {
+  struct ov_error err = {0};
+  struct mpmc_context ctx = {0};
+  thrd_t producers[mpmc_producers];
+  thrd_t consumers[mpmc_consumers];
+  size_t nproducers = 0;
+  size_t nconsumers = 0;
+
+  ctx.q = OV_MPMC_QUEUE_CREATE(sizeof(struct mpmc_item), 64, &err);
+  if (!TEST_SUCCEEDED(ctx.q != NULL, &err)) {
+    return;
+  }
+  for (; nconsumers < mpmc_consumers; ++nconsumers) {
+    if (!TEST_CHECK(thrd_create(&consumers[nconsumers], mpmc_consumer, &ctx) == thrd_success)) {
+      break;
+    }
+  }
+  for (; nproducers < mpmc_producers; ++nproducers) {
+    if (!TEST_CHECK(thrd_create(&producers[nproducers], mpmc_producer, &ctx) == thrd_success)) {
+      break;
+    }
+  }
+  for (size_t i = 0; i < nproducers; ++i) {
+    int r = -1;
+    thrd_join(producers[i], &r);
+    TEST_CHECK(r == 0);
+  }
+  ov_mpmc_queue_close(ctx.q);
+  for (size_t i = 0; i < nconsumers; ++i) {
+    thrd_join(consumers[i], NULL);
+  }
+
+  if (nproducers == mpmc_producers && nconsumers == mpmc_consumers) {
+    uint64_t const expected_sum = (uint64_t)mpmc_items * (mpmc_items - 1) / 2;
+    for (size_t i = 0; i < mpmc_producers; ++i) {
+      TEST_CHECK(atomic_load(&ctx.counts[i]) == mpmc_items);
+      TEST_CHECK(atomic_load(&ctx.sums[i]) == expected_sum);
+      TEST_MSG("producer %zu: count %zu", i, atomic_load(&ctx.counts[i]));
+    }
+    TEST_CHECK(atomic_load(&ctx.out_of_order) == 0);
+  }
+  OV_MPMC_QUEUE_DESTROY(&ctx.q);
+  TEST_CHECK(ctx.q == NULL);
+}
+
+static int blocked_pop(void *const userdata) {
+  struct ov_mpmc_queue *const q = (struct ov_mpmc_queue *)userdata;
+  int v;
+  return ov_mpmc_queue_pop(q, &v) ? 1 : 0;
+}
+
+static void test_mpmc_close_wakes(void) {
+  struct ov_error err = {0};
+  struct ov_mpmc_queue *q = OV_MPMC_QUEUE_CREATE(sizeof(int), 2, &err);
+  if (!TEST_SUCCEEDED(q != NULL, &err)) {
+    return;
+  }
+  int v = 42;
+  TEST_CHECK(ov_mpmc_queue_try_push(q, &v));
+  TEST_CHECK(ov_mpmc_queue_try_push(q, &v));
+  TEST_CHECK(!ov_mpmc_queue_try_push(q, &v));
+  TEST_CHECK(ov_mpmc_queue_try_pop(q, &v) && v == 42);
+  TEST_CHECK(ov_mpmc_queue_try_pop(q, &v) && v == 42);
+  TEST_CHECK(!ov_mpmc_queue_try_pop(q, &v));
+
+  // consumers blocked on an empty queue return false once it is closed
+  enum { waiters = 3 };
+  thrd_t threads[waiters];
+  size_t n = 0;
+  for (; n < waiters; ++n) {
+    if (!TEST_CHECK(thrd_create(&threads[n], blocked_pop, q) == thrd_success)) {
+      break;
+    }
+  }
+  thrd_sleep(&(struct timespec){.tv_nsec = 20 * 1000 * 1000}, NULL);
+  ov_mpmc_queue_close(q);
+  for (size_t i = 0; i < n; ++i) {
+    int r = -1;
+    thrd_join(threads[i], &r);
+    TEST_CHECK(r == 0);
+  }
+  TEST_CHECK(!ov_mpmc_queue_push(q, &v));
+  OV_MPMC_QUEUE_DESTROY(&q);
+}
+
+TEST_LIST = {
+    {"test_spsc_basic", test_spsc_basic},
+    {"test_spsc_threads", test_spsc_threads},
+    {"test_mpmc_threads", test_mpmc_threads},
+    {"test_mpmc_close_wakes", test_mpmc_close_wakes},
+    {NULL, NULL},
+};
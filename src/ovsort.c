@@ -1,11 +1,20 @@
 #include <ovsort.h>
 
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
 // Algorithm adapted from Darel Rex Finley's public-domain "Quicksort" implementation:
 // https://alienryderflex.com/quicksort/
 //
 // We extend the original algorithm with a median-of-three pivot selection and an
 // insertion-sort fallback for small partitions to improve behaviour on nearly
 // sorted or reverse-sorted datasets.
+//
+// Median-of-three alone still degrades to O(n^2) on crafted inputs, so each range also
+// carries a depth budget of 2*log2(n) partitions (introsort). A range that runs out of
+// budget is finished with heapsort, which bounds the whole sort to O(n log n).
 
 static inline void
 insertion_sort_range(size_t const begin,
@@ -22,6 +31,110 @@ insertion_sort_range(size_t const begin,
   }
 }
 
+static inline void sift_down(size_t const begin,
+                             size_t root,
+                             size_t const n,
+                             int (*const compare)(size_t const idx0, size_t const idx1, void *const userdata),
+                             void (*const swap)(size_t const idx0, size_t const idx1, void *const userdata),
+                             void *const userdata) {
+  for (;;) {
+    size_t child = root * 2 + 1;
+    if (child >= n) {
+      return;
+    }
+    if (child + 1 < n && compare(begin + child, begin + child + 1, userdata) < 0) {
+      ++child;
+    }
+    if (compare(begin + root, begin + child, userdata) >= 0) {
+      return;
+    }
+    swap(begin + root, begin + child, userdata);
+    root = child;
+  }
+}
+
+static void heap_sort_range(size_t const begin,
+                            size_t const end,
+                            int (*const compare)(size_t const idx0, size_t const idx1, void *const userdata),
+                            void (*const swap)(size_t const idx0, size_t const idx1, void *const userdata),
+                            void *const userdata) {
+  size_t const n = end - begin;
+  for (size_t i = n / 2; i-- > 0;) {
+    sift_down(begin, i, n, compare, swap, userdata);
+  }
+  for (size_t i = n - 1; i > 0; --i) {
+    swap(begin, begin + i, userdata);
+    sift_down(begin, 0, i, compare, swap, userdata);
+  }
+}
+
+static inline size_t depth_budget(size_t n) {
+  size_t log2 = 0;
+  while (n >>= 1) {
+    ++log2;
+  }
+  return log2 * 2;
+}
+
+// Partitions [left, right) around a median-of-three pivot and returns the final position
+// of the pivot. Elements before it compare less or equal, elements after it greater or equal.
+static size_t partition_range(size_t left,
+                              size_t right,
+                              int (*const compare)(size_t const idx0, size_t const idx1, void *const userdata),
+                              void (*const swap)(size_t const idx0, size_t const idx1, void *const userdata),
+                              void *const userdata) {
+  right -= 1;
+
+  size_t const mid = left + ((right - left) >> 1);
+  if (compare(mid, left, userdata) < 0) {
+    swap(mid, left, userdata);
+  }
+  if (compare(right, left, userdata) < 0) {
+    swap(right, left, userdata);
+  }
+  if (compare(right, mid, userdata) < 0) {
+    swap(right, mid, userdata);
+  }
+  swap(left, mid, userdata);
+
+  size_t pivot = left;
+
+  for (;;) {
+    while (left < right && compare(right, pivot, userdata) >= 0) {
+      --right;
+    }
+    if (left < right) {
+      swap(left, right, userdata);
+      if (pivot == left) {
+        pivot = right;
+      } else if (pivot == right) {
+        pivot = left;
+      }
+      ++left;
+    }
+
+    while (left < right && compare(left, pivot, userdata) <= 0) {
+      ++left;
+    }
+    if (left < right) {
+      swap(right, left, userdata);
+      if (pivot == right) {
+        pivot = left;
+      } else if (pivot == left) {
+        pivot = right;
+      }
+      --right;
+    } else {
+      break;
+    }
+  }
+
+  if (pivot != left) {
+    swap(pivot, left, userdata);
+  }
+  return left;
+}
+
 void ov_sort(size_t const n,
              int (*const compare)(size_t const idx0, size_t const idx1, void *const userdata),
              void (*const swap)(size_t const idx0, size_t const idx1, void *const userdata),
@@ -37,10 +150,12 @@ void ov_sort(size_t const n,
 
   size_t beg[max_levels];
   size_t end[max_levels];
+  size_t budget[max_levels];
   size_t level = 0;
 
   beg[0] = 0;
   end[0] = n;
+  budget[0] = depth_budget(n);
 
   while (level < n) {
     size_t left = beg[level];
@@ -57,60 +172,18 @@ void ov_sort(size_t const n,
       continue;
     }
 
-    right -= 1;
-
-    size_t const mid = left + ((right - left) >> 1);
-    if (compare(mid, left, userdata) < 0) {
-      swap(mid, left, userdata);
-    }
-    if (compare(right, left, userdata) < 0) {
-      swap(right, left, userdata);
-    }
-    if (compare(right, mid, userdata) < 0) {
-      swap(right, mid, userdata);
-    }
-    swap(left, mid, userdata);
-
-    size_t pivot = left;
-
-    for (;;) {
-      while (left < right && compare(right, pivot, userdata) >= 0) {
-        --right;
-      }
-      if (left < right) {
-        swap(left, right, userdata);
-        if (pivot == left) {
-          pivot = right;
-        } else if (pivot == right) {
-          pivot = left;
-        }
-        ++left;
-      }
-
-      while (left < right && compare(left, pivot, userdata) <= 0) {
-        ++left;
-      }
-      if (left < right) {
-        swap(right, left, userdata);
-        if (pivot == right) {
-          pivot = left;
-        } else if (pivot == left) {
-          pivot = right;
-        }
-        --right;
-      } else {
-        break;
-      }
+    if (budget[level] == 0) {
+      heap_sort_range(left, right, compare, swap, userdata);
+      --level;
+      continue;
     }
 
-    if (pivot != left) {
-      swap(pivot, left, userdata);
-      pivot = left;
-    }
+    left = partition_range(left, right, compare, swap, userdata);
 
     beg[level + 1] = left + 1;
     end[level + 1] = end[level];
     end[level] = left;
+    budget[level + 1] = --budget[level];
     ++level;
 
     if (end[level] - beg[level] > end[level - 1] - beg[level - 1]) {
@@ -124,6 +197,78 @@ void ov_sort(size_t const n,
   }
 }
 
+// Moves the (middle - begin) smallest elements of [begin, end) into [begin, middle) as a
+// max-heap, so the largest of them ends up at begin. O((end - begin) log (middle - begin)).
+static void heap_select(size_t const begin,
+                        size_t const middle,
+                        size_t const end,
+                        int (*const compare)(size_t const idx0, size_t const idx1, void *const userdata),
+                        void (*const swap)(size_t const idx0, size_t const idx1, void *const userdata),
+                        void *const userdata) {
+  size_t const k = middle - begin;
+  for (size_t i = k / 2; i-- > 0;) {
+    sift_down(begin, i, k, compare, swap, userdata);
+  }
+  for (size_t i = middle; i < end; ++i) {
+    if (compare(i, begin, userdata) < 0) {
+      swap(i, begin, userdata);
+      sift_down(begin, 0, k, compare, swap, userdata);
+    }
+  }
+}
+
+void ov_nth_element(size_t const n,
+                    size_t const nth,
+                    int (*const compare)(size_t const idx0, size_t const idx1, void *const userdata),
+                    void (*const swap)(size_t const idx0, size_t const idx1, void *const userdata),
+                    void *const userdata) {
+  if (n < 2 || nth >= n || !compare || !swap) {
+    return;
+  }
+
+  enum {
+    insertion_threshold = 16,
+  };
+
+  size_t lo = 0;
+  size_t hi = n;
+  size_t budget = depth_budget(n);
+  while (hi - lo > insertion_threshold) {
+    if (budget == 0) {
+      heap_select(lo, nth + 1, hi, compare, swap, userdata);
+      swap(lo, nth, userdata);
+      return;
+    }
+    --budget;
+    size_t const pivot = partition_range(lo, hi, compare, swap, userdata);
+    if (pivot == nth) {
+      return;
+    }
+    if (nth < pivot) {
+      hi = pivot;
+    } else {
+      lo = pivot + 1;
+    }
+  }
+  insertion_sort_range(lo, hi, compare, swap, userdata);
+}
+
+void ov_partial_sort(size_t const n,
+                     size_t const k,
+                     int (*const compare)(size_t const idx0, size_t const idx1, void *const userdata),
+                     void (*const swap)(size_t const idx0, size_t const idx1, void *const userdata),
+                     void *const userdata) {
+  if (n < 2 || k == 0 || !compare || !swap) {
+    return;
+  }
+  size_t const m = k < n ? k : n;
+  heap_select(0, m, n, compare, swap, userdata);
+  for (size_t i = m - 1; i > 0; --i) {
+    swap(0, i, userdata);
+    sift_down(0, 0, i, compare, swap, userdata);
+  }
+}
+
 struct qsort_context {
   unsigned char *base;
   size_t item_size;
@@ -138,20 +283,93 @@ static int qsort_compare(size_t idx0, size_t idx1, void *userdata) {
   return ctx->compare(a, b, ctx->userdata);
 }
 
+// Swapping dominates for records of a few words, so common sizes get fixed-size moves.
+// memcpy through a local lets the compiler emit plain word or vector loads and stores
+// without assuming the caller's array is aligned.
+
+static void qsort_swap_4(size_t idx0, size_t idx1, void *userdata) {
+  struct qsort_context const *const ctx = (struct qsort_context const *)userdata;
+  unsigned char *const a = ctx->base + idx0 * 4;
+  unsigned char *const b = ctx->base + idx1 * 4;
+  uint32_t ta, tb;
+  memcpy(&ta, a, 4);
+  memcpy(&tb, b, 4);
+  memcpy(a, &tb, 4);
+  memcpy(b, &ta, 4);
+}
+
+static void qsort_swap_8(size_t idx0, size_t idx1, void *userdata) {
+  struct qsort_context const *const ctx = (struct qsort_context const *)userdata;
+  unsigned char *const a = ctx->base + idx0 * 8;
+  unsigned char *const b = ctx->base + idx1 * 8;
+  uint64_t ta, tb;
+  memcpy(&ta, a, 8);
+  memcpy(&tb, b, 8);
+  memcpy(a, &tb, 8);
+  memcpy(b, &ta, 8);
+}
+
+static inline void swap_16(unsigned char *const a, unsigned char *const b) {
+  unsigned char ta[16], tb[16];
+  memcpy(ta, a, 16);
+  memcpy(tb, b, 16);
+  memcpy(a, tb, 16);
+  memcpy(b, ta, 16);
+}
+
+static void qsort_swap_16(size_t idx0, size_t idx1, void *userdata) {
+  struct qsort_context const *const ctx = (struct qsort_context const *)userdata;
+  swap_16(ctx->base + idx0 * 16, ctx->base + idx1 * 16);
+}
+
+static void qsort_swap_16n(size_t idx0, size_t idx1, void *userdata) {
+  struct qsort_context const *const ctx = (struct qsort_context const *)userdata;
+  size_t const item_size = ctx->item_size;
+  unsigned char *const a = ctx->base + idx0 * item_size;
+  unsigned char *const b = ctx->base + idx1 * item_size;
+  for (size_t i = 0; i < item_size; i += 16) {
+    swap_16(a + i, b + i);
+  }
+}
+
 static void qsort_swap(size_t idx0, size_t idx1, void *userdata) {
   struct qsort_context const *const ctx = (struct qsort_context const *)userdata;
   size_t const item_size = ctx->item_size;
   unsigned char *const a = ctx->base + idx0 * item_size;
   unsigned char *const b = ctx->base + idx1 * item_size;
-  // Compiler optimizes this loop well, often faster than memcpy.
+  size_t i = 0;
+  for (; i + 8 <= item_size; i += 8) {
+    uint64_t ta, tb;
+    memcpy(&ta, a + i, 8);
+    memcpy(&tb, b + i, 8);
+    memcpy(a + i, &tb, 8);
+    memcpy(b + i, &ta, 8);
+  }
   unsigned char tmp;
-  for (size_t i = 0; i < item_size; ++i) {
+  for (; i < item_size; ++i) {
     tmp = a[i];
     a[i] = b[i];
     b[i] = tmp;
   }
 }
 
+typedef void (*swap_func)(size_t idx0, size_t idx1, void *userdata);
+
+static swap_func select_swap(size_t const item_size) {
+  switch (item_size) {
+  case 4:
+    return qsort_swap_4;
+  case 8:
+    return qsort_swap_8;
+  case 16:
+    return qsort_swap_16;
+  }
+  if (item_size % 16 == 0) {
+    return qsort_swap_16n;
+  }
+  return qsort_swap;
+}
+
 void ov_qsort(void *const base,
               size_t const n,
               size_t const item_size,
@@ -162,7 +380,7 @@ void ov_qsort(void *const base,
   }
   ov_sort(n,
           qsort_compare,
-          qsort_swap,
+          select_swap(item_size),
           &(struct qsort_context){
               .base = (unsigned char *)base,
               .item_size = item_size,
@@ -170,3 +388,547 @@ void ov_qsort(void *const base,
               .userdata = userdata,
           });
 }
+
+// Stable sorting
+//
+// Natural runs are detected (strictly descending ones are reversed in place), short runs are
+// extended to minrun with insertion sort, and runs are merged following TimSort's stack
+// invariants. Before each merge, the prefix of the left run and the suffix of the right run
+// that are already in place are trimmed with binary searches, so nearly sorted input costs
+// little more than one pass of comparisons.
+//
+// A merge whose shorter run fits in the scratch buffer is done by copying that run out and
+// merging back. Otherwise it is done in place by recursively splitting both runs around a
+// binary-searched cut and rotating the middle blocks (SymMerge), which needs only swaps.
+
+struct stable_context {
+  int (*compare)(size_t const idx0, size_t const idx1, void *const userdata);
+  void (*swap)(size_t const idx0, size_t const idx1, void *const userdata);
+  void *userdata;
+  // Set only for ov_stable_qsort with a scratch buffer; userdata is then a struct qsort_context.
+  unsigned char *scratch;
+  size_t scratch_items;
+};
+
+// First index in [lo, hi) whose element is greater than the element at key.
+static size_t upper_bound(struct stable_context const *const s, size_t lo, size_t hi, size_t const key) {
+  while (lo < hi) {
+    size_t const m = lo + (hi - lo) / 2;
+    if (s->compare(key, m, s->userdata) < 0) {
+      hi = m;
+    } else {
+      lo = m + 1;
+    }
+  }
+  return lo;
+}
+
+// First index in [lo, hi) whose element is not less than the element at key.
+static size_t lower_bound(struct stable_context const *const s, size_t lo, size_t hi, size_t const key) {
+  while (lo < hi) {
+    size_t const m = lo + (hi - lo) / 2;
+    if (s->compare(m, key, s->userdata) < 0) {
+      lo = m + 1;
+    } else {
+      hi = m;
+    }
+  }
+  return lo;
+}
+
+static void swap_range(struct stable_context const *const s, size_t const a, size_t const b, size_t const n) {
+  for (size_t i = 0; i < n; ++i) {
+    s->swap(a + i, b + i, s->userdata);
+  }
+}
+
+// Exchange the blocks [lo, mid) and [mid, hi) with n - gcd swaps.
+static void rotate(struct stable_context const *const s, size_t const lo, size_t const mid, size_t const hi) {
+  size_t i = mid - lo;
+  size_t j = hi - mid;
+  if (i == 0 || j == 0) {
+    return;
+  }
+  while (i != j) {
+    if (i > j) {
+      swap_range(s, mid - i, mid, j);
+      i -= j;
+    } else {
+      swap_range(s, mid - i, mid + j - i, i);
+      j -= i;
+    }
+  }
+  swap_range(s, mid - i, mid, i);
+}
+
+static void reverse(struct stable_context const *const s, size_t lo, size_t hi) {
+  while (lo + 1 < hi) {
+    s->swap(lo++, --hi, s->userdata);
+  }
+}
+
+static void merge_in_place(struct stable_context const *const s, size_t const lo, size_t const mid, size_t const hi) {
+  if (lo >= mid || mid >= hi) {
+    return;
+  }
+  if (hi - lo == 2) {
+    if (s->compare(mid, lo, s->userdata) < 0) {
+      s->swap(lo, mid, s->userdata);
+    }
+    return;
+  }
+  size_t cut1, cut2;
+  if (mid - lo >= hi - mid) {
+    cut1 = lo + (mid - lo) / 2;
+    cut2 = lower_bound(s, mid, hi, cut1);
+  } else {
+    cut2 = mid + (hi - mid) / 2;
+    cut1 = upper_bound(s, lo, mid, cut2);
+  }
+  rotate(s, cut1, mid, cut2);
+  size_t const new_mid = cut1 + (cut2 - mid);
+  merge_in_place(s, lo, cut1, new_mid);
+  merge_in_place(s, new_mid, cut2, hi);
+}
+
+static bool merge_buffered(struct stable_context const *const s, size_t const lo, size_t const mid, size_t const hi) {
+  size_t const len1 = mid - lo;
+  size_t const len2 = hi - mid;
+  if (!s->scratch || (len1 > s->scratch_items && len2 > s->scratch_items)) {
+    return false;
+  }
+  struct qsort_context const *const ctx = (struct qsort_context const *)s->userdata;
+  size_t const sz = ctx->item_size;
+  unsigned char *const base = ctx->base;
+  unsigned char *const buf = s->scratch;
+  if (len1 <= len2) {
+    // Copy the left run out and merge forward; the output never overtakes the right run.
+    memcpy(buf, base + lo * sz, len1 * sz);
+    size_t i = 0, j = mid, out = lo;
+    while (i < len1 && j < hi) {
+      if (ctx->compare(base + j * sz, buf + i * sz, ctx->userdata) < 0) {
+        memcpy(base + out++ * sz, base + j++ * sz, sz);
+      } else {
+        memcpy(base + out++ * sz, buf + i++ * sz, sz);
+      }
+    }
+    memcpy(base + out * sz, buf + i * sz, (len1 - i) * sz);
+  } else {
+    // Copy the right run out and merge backward.
+    memcpy(buf, base + mid * sz, len2 * sz);
+    size_t i = mid, j = len2, out = hi;
+    while (i > lo && j > 0) {
+      if (ctx->compare(buf + (j - 1) * sz, base + (i - 1) * sz, ctx->userdata) < 0) {
+        memcpy(base + --out * sz, base + --i * sz, sz);
+      } else {
+        memcpy(base + --out * sz, buf + --j * sz, sz);
+      }
+    }
+    memcpy(base + (out - j) * sz, buf, j * sz);
+  }
+  return true;
+}
+
+static void merge_runs(struct stable_context const *const s, size_t lo, size_t const mid, size_t hi) {
+  // Elements of the left run not greater than the first of the right run are already in place,
+  // and so are elements of the right run not less than the last of the left run.
+  lo = upper_bound(s, lo, mid, mid);
+  if (lo == mid) {
+    return;
+  }
+  hi = lower_bound(s, mid, hi, mid - 1);
+  if (!merge_buffered(s, lo, mid, hi)) {
+    merge_in_place(s, lo, mid, hi);
+  }
+}
+
+static size_t count_run(struct stable_context const *const s, size_t const lo, size_t const hi) {
+  size_t i = lo + 1;
+  if (i == hi) {
+    return 1;
+  }
+  if (s->compare(i, lo, s->userdata) < 0) {
+    // Only strictly descending runs can be reversed without breaking stability.
+    while (i + 1 < hi && s->compare(i + 1, i, s->userdata) < 0) {
+      ++i;
+    }
+    reverse(s, lo, i + 1);
+  } else {
+    while (i + 1 < hi && s->compare(i + 1, i, s->userdata) >= 0) {
+      ++i;
+    }
+  }
+  return i + 1 - lo;
+}
+
+static size_t min_run(size_t n) {
+  size_t r = 0;
+  while (n >= 32) {
+    r |= n & 1;
+    n >>= 1;
+  }
+  return n + r;
+}
+
+static void stable_sort(struct stable_context const *const s, size_t const n) {
+  enum {
+    // TimSort's invariants make run lengths grow at least like Fibonacci numbers.
+    max_runs = 128,
+  };
+  size_t run_base[max_runs];
+  size_t run_len[max_runs];
+  size_t runs = 0;
+  size_t const minrun = min_run(n);
+
+  for (size_t lo = 0; lo < n;) {
+    size_t len = count_run(s, lo, n);
+    if (len < minrun) {
+      size_t const forced = minrun < n - lo ? minrun : n - lo;
+      insertion_sort_range(lo, lo + forced, s->compare, s->swap, s->userdata);
+      len = forced;
+    }
+    run_base[runs] = lo;
+    run_len[runs] = len;
+    ++runs;
+    lo += len;
+
+    while (runs > 1) {
+      size_t k = runs - 2;
+      if ((k > 0 && run_len[k - 1] <= run_len[k] + run_len[k + 1]) ||
+          (k > 1 && run_len[k - 2] <= run_len[k - 1] + run_len[k])) {
+        if (run_len[k - 1] < run_len[k + 1]) {
+          --k;
+        }
+      } else if (run_len[k] > run_len[k + 1]) {
+        break;
+      }
+      merge_runs(s, run_base[k], run_base[k + 1], run_base[k + 1] + run_len[k + 1]);
+      run_len[k] += run_len[k + 1];
+      for (size_t i = k + 1; i + 1 < runs; ++i) {
+        run_base[i] = run_base[i + 1];
+        run_len[i] = run_len[i + 1];
+      }
+      --runs;
+    }
+  }
+  while (runs > 1) {
+    size_t k = runs - 2;
+    if (k > 0 && run_len[k - 1] < run_len[k + 1]) {
+      --k;
+    }
+    merge_runs(s, run_base[k], run_base[k + 1], run_base[k + 1] + run_len[k + 1]);
+    run_len[k] += run_len[k + 1];
+    for (size_t i = k + 1; i + 1 < runs; ++i) {
+      run_base[i] = run_base[i + 1];
+      run_len[i] = run_len[i + 1];
+    }
+    --runs;
+  }
+}
+
+void ov_stable_sort(size_t const n,
+                    int (*const compare)(size_t const idx0, size_t const idx1, void *const userdata),
+                    void (*const swap)(size_t const idx0, size_t const idx1, void *const userdata),
+                    void *const userdata) {
+  if (n < 2 || !compare || !swap) {
+    return;
+  }
+  stable_sort(&(struct stable_context){.compare = compare, .swap = swap, .userdata = userdata}, n);
+}
+
+void ov_stable_qsort(void *const base,
+                     size_t const n,
+                     size_t const item_size,
+                     int (*const compare)(void const *const a, void const *const b, void *const userdata),
+                     void *const userdata,
+                     void *const scratch,
+                     size_t const scratch_bytes) {
+  if (!base || !compare || !item_size || n < 2) {
+    return;
+  }
+  struct qsort_context ctx = {
+      .base = (unsigned char *)base,
+      .item_size = item_size,
+      .compare = compare,
+      .userdata = userdata,
+  };
+  stable_sort(&(struct stable_context){.compare = qsort_compare,
+                                       .swap = select_swap(item_size),
+                                       .userdata = &ctx,
+                                       .scratch = (unsigned char *)scratch,
+                                       .scratch_items = scratch ? scratch_bytes / item_size : 0},
+              n);
+}
+
+// Streaming top-k
+//
+// The kept items form a max-heap under compare, so the root is the kept item that sorts
+// last and is the one replaced when a better item arrives.
+
+static inline struct qsort_context topk_context(struct ov_topk const *const tk) {
+  return (struct qsort_context){
+      .base = (unsigned char *)tk->items,
+      .item_size = tk->item_size,
+      .compare = tk->compare,
+      .userdata = tk->userdata,
+  };
+}
+
+void ov_topk_init(struct ov_topk *const tk,
+                  void *const buffer,
+                  size_t const capacity,
+                  size_t const item_size,
+                  int (*const compare)(void const *const a, void const *const b, void *const userdata),
+                  void *const userdata) {
+  assert(tk != NULL && "tk must not be NULL");
+  assert((buffer != NULL || capacity == 0) && "buffer must not be NULL");
+  assert(item_size > 0 && "item_size must be greater than 0");
+  assert(compare != NULL && "compare must not be NULL");
+  *tk = (struct ov_topk){
+      .items = buffer,
+      .capacity = capacity,
+      .item_size = item_size,
+      .compare = compare,
+      .userdata = userdata,
+  };
+}
+
+bool ov_topk_push(struct ov_topk *const tk, void const *const item) {
+  assert(tk != NULL && "tk must not be NULL");
+  assert(item != NULL && "item must not be NULL");
+  if (!tk || !item || tk->capacity == 0) {
+    return false;
+  }
+  struct qsort_context ctx = topk_context(tk);
+  swap_func const swap = select_swap(tk->item_size);
+  if (tk->count < tk->capacity) {
+    size_t i = tk->count++;
+    memcpy(ctx.base + i * ctx.item_size, item, ctx.item_size);
+    while (i > 0) {
+      size_t const parent = (i - 1) / 2;
+      if (qsort_compare(parent, i, &ctx) >= 0) {
+        break;
+      }
+      swap(parent, i, &ctx);
+      i = parent;
+    }
+    return true;
+  }
+  if (tk->compare(item, ctx.base, tk->userdata) >= 0) {
+    return false;
+  }
+  memcpy(ctx.base, item, ctx.item_size);
+  sift_down(0, 0, tk->count, qsort_compare, swap, &ctx);
+  return true;
+}
+
+void const *ov_topk_threshold(struct ov_topk const *const tk) {
+  assert(tk != NULL && "tk must not be NULL");
+  if (!tk || tk->capacity == 0 || tk->count < tk->capacity) {
+    return NULL;
+  }
+  return tk->items;
+}
+
+size_t ov_topk_finish(struct ov_topk *const tk) {
+  assert(tk != NULL && "tk must not be NULL");
+  if (!tk) {
+    return 0;
+  }
+  size_t const n = tk->count;
+  if (n > 1) {
+    struct qsort_context ctx = topk_context(tk);
+    swap_func const swap = select_swap(tk->item_size);
+    for (size_t i = n - 1; i > 0; --i) {
+      swap(0, i, &ctx);
+      sift_down(0, 0, i, qsort_compare, swap, &ctx);
+    }
+  }
+  tk->count = 0;
+  return n;
+}
+
+// Indirect sorting
+//
+// Ties are broken by index, which makes argsort stable at no extra cost since the index
+// array has to be compared anyway.
+
+struct argsort_context {
+  unsigned char const *base;
+  size_t item_size;
+  int (*compare)(void const *const a, void const *const b, void *const userdata);
+  void *userdata;
+  void *perm;
+};
+
+static inline int argsort_compare_indices(struct argsort_context const *const ctx, size_t const a, size_t const b) {
+  int const r = ctx->compare(ctx->base + a * ctx->item_size, ctx->base + b * ctx->item_size, ctx->userdata);
+  if (r) {
+    return r;
+  }
+  return (a > b) - (a < b);
+}
+
+static int argsort_compare(size_t const idx0, size_t const idx1, void *const userdata) {
+  struct argsort_context const *const ctx = (struct argsort_context const *)userdata;
+  size_t const *const perm = (size_t const *)ctx->perm;
+  return argsort_compare_indices(ctx, perm[idx0], perm[idx1]);
+}
+
+static void argsort_swap(size_t const idx0, size_t const idx1, void *const userdata) {
+  size_t *const perm = (size_t *)((struct argsort_context const *)userdata)->perm;
+  size_t const tmp = perm[idx0];
+  perm[idx0] = perm[idx1];
+  perm[idx1] = tmp;
+}
+
+static int argsort_compare_u32(size_t const idx0, size_t const idx1, void *const userdata) {
+  struct argsort_context const *const ctx = (struct argsort_context const *)userdata;
+  uint32_t const *const perm = (uint32_t const *)ctx->perm;
+  return argsort_compare_indices(ctx, perm[idx0], perm[idx1]);
+}
+
+static void argsort_swap_u32(size_t const idx0, size_t const idx1, void *const userdata) {
+  uint32_t *const perm = (uint32_t *)((struct argsort_context const *)userdata)->perm;
+  uint32_t const tmp = perm[idx0];
+  perm[idx0] = perm[idx1];
+  perm[idx1] = tmp;
+}
+
+void ov_argsort(size_t *const perm,
+                size_t const n,
+                void const *const base,
+                size_t const item_size,
+                int (*const compare)(void const *const a, void const *const b, void *const userdata),
+                void *const userdata) {
+  if (!perm || !base || !compare || !item_size) {
+    return;
+  }
+  for (size_t i = 0; i < n; ++i) {
+    perm[i] = i;
+  }
+  ov_sort(n,
+          argsort_compare,
+          argsort_swap,
+          &(struct argsort_context){
+              .base = (unsigned char const *)base,
+              .item_size = item_size,
+              .compare = compare,
+              .userdata = userdata,
+              .perm = perm,
+          });
+}
+
+void ov_argsort_u32(uint32_t *const perm,
+                    size_t const n,
+                    void const *const base,
+                    size_t const item_size,
+                    int (*const compare)(void const *const a, void const *const b, void *const userdata),
+                    void *const userdata) {
+  assert(n <= UINT32_MAX && "n must fit in uint32_t");
+  if (!perm || !base || !compare || !item_size || n > UINT32_MAX) {
+    return;
+  }
+  for (size_t i = 0; i < n; ++i) {
+    perm[i] = (uint32_t)i;
+  }
+  ov_sort(n,
+          argsort_compare_u32,
+          argsort_swap_u32,
+          &(struct argsort_context){
+              .base = (unsigned char const *)base,
+              .item_size = item_size,
+              .compare = compare,
+              .userdata = userdata,
+              .perm = perm,
+          });
+}
+
+// Each cycle of the permutation is walked once, with visited positions marked by resetting
+// their permutation entry to themselves. The first item of a cycle is saved, the others are
+// moved one step back along the cycle, and the saved item fills the last hole, so each item
+// is copied once. When the items of all arrays do not fit in the stack buffer, the walk
+// swaps instead, which carries the displaced item along the cycle at the cost of more copies.
+
+enum {
+  permute_buffer_size = 4096,
+};
+
+static inline size_t perm_get(void const *const perm, bool const wide, size_t const i) {
+  return wide ? ((size_t const *)perm)[i] : ((uint32_t const *)perm)[i];
+}
+
+static inline void perm_set_identity(void *const perm, bool const wide, size_t const i) {
+  if (wide) {
+    ((size_t *)perm)[i] = i;
+  } else {
+    ((uint32_t *)perm)[i] = (uint32_t)i;
+  }
+}
+
+static void apply_permutation(void *const perm,
+                              bool const wide,
+                              size_t const n,
+                              struct ov_permute_array const *const arrays,
+                              size_t const narrays) {
+  size_t total = 0;
+  for (size_t a = 0; a < narrays; ++a) {
+    total += arrays[a].item_size;
+  }
+  unsigned char tmp[permute_buffer_size];
+  bool const buffered = total <= sizeof(tmp);
+  for (size_t i = 0; i < n; ++i) {
+    if (perm_get(perm, wide, i) == i) {
+      continue;
+    }
+    if (buffered) {
+      for (size_t a = 0, off = 0; a < narrays; off += arrays[a++].item_size) {
+        memcpy(tmp + off, (unsigned char *)arrays[a].base + i * arrays[a].item_size, arrays[a].item_size);
+      }
+    }
+    size_t j = i;
+    for (;;) {
+      size_t const k = perm_get(perm, wide, j);
+      assert(k < n && "perm must be a permutation of [0, n)");
+      perm_set_identity(perm, wide, j);
+      if (k == i) {
+        break;
+      }
+      for (size_t a = 0; a < narrays; ++a) {
+        unsigned char *const base = (unsigned char *)arrays[a].base;
+        size_t const sz = arrays[a].item_size;
+        if (buffered) {
+          memcpy(base + j * sz, base + k * sz, sz);
+        } else {
+          select_swap(sz)(j, k, &(struct qsort_context){.base = base, .item_size = sz});
+        }
+      }
+      j = k;
+    }
+    if (buffered) {
+      for (size_t a = 0, off = 0; a < narrays; off += arrays[a++].item_size) {
+        memcpy((unsigned char *)arrays[a].base + j * arrays[a].item_size, tmp + off, arrays[a].item_size);
+      }
+    }
+  }
+}
+
+void ov_apply_permutation(size_t *const perm,
+                          size_t const n,
+                          struct ov_permute_array const *const arrays,
+                          size_t const narrays) {
+  if (!perm || !arrays) {
+    return;
+  }
+  apply_permutation(perm, true, n, arrays, narrays);
+}
+
+void ov_apply_permutation_u32(uint32_t *const perm,
+                              size_t const n,
+                              struct ov_permute_array const *const arrays,
+                              size_t const narrays) {
+  if (!perm || !arrays) {
+    return;
+  }
+  apply_permutation(perm, false, n, arrays, narrays);
+}
@@ -0,0 +1,602 @@
+// Sort benchmark comparing ovbase sorts with libc qsort across distributions, sizes and element sizes.
+//
+// Every case is timed several times and reported as median and p95 in JSON (default) or CSV, one
+// record per implementation, distribution, size and element size, so results can be diffed between
+// releases. Small inputs are sorted in batches of copies to stay above the timer resolution.
+// old_ov_sort is skipped above 1e5 elements on few_unique and many_duplicates, where it is quadratic.
+//
+// Usage: bench_ovbase_sort [--format=json|csv] [--output=PATH] [--impl=a,b] [--dist=a,b] [--elem=4,8]
+//                          [--min-size=N] [--max-size=N] [--samples=N] [--max-bytes=N]
+
+#include <ovbase.h>
+
+#include <ovrand.h>
+#include <ovsort.h>
+#include <ovthreads.h> // struct timespec, timespec_get, TIME_UTC
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#endif
+
+void old_ov_sort(size_t const n,
+                 int (*const compare)(size_t const idx0, size_t const idx1, void *const userdata),
+                 void (*const swap)(size_t const idx0, size_t const idx1, void *const userdata),
+                 void *const userdata);
+
+enum {
+  max_elem_size = 128,
+  max_samples = 51,
+  batch_elements = 65536,
+};
+
+static double const auto_sample_seconds = 0.5;
+
+static uint64_t now_ns(void) {
+#ifdef _WIN32
+  LARGE_INTEGER f = {0}, c = {0};
+  QueryPerformanceFrequency(&f);
+  QueryPerformanceCounter(&c);
+  return (uint64_t)((double)c.QuadPart * 1e9 / (double)f.QuadPart);
+#else
+  struct timespec v = {0};
+  timespec_get(&v, TIME_UTC);
+  return (uint64_t)v.tv_sec * 1000000000u + (uint64_t)v.tv_nsec;
+#endif
+}
+
+// Elements
+
+// Keys live in the first 4 bytes of 4-byte elements and in the first 8 bytes of larger ones;
+// the rest of a larger element is payload that only has to be moved around.
+static inline uint64_t load_key(void const *const p, size_t const elem_size) {
+  if (elem_size == 4) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+  }
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline void store_key(void *const p, size_t const elem_size, uint64_t const key) {
+  if (elem_size == 4) {
+    uint32_t const v = (uint32_t)key;
+    memcpy(p, &v, sizeof(v));
+    return;
+  }
+  memcpy(p, &key, sizeof(key));
+}
+
+static inline int compare_keys(uint64_t const a, uint64_t const b) { return (a > b) - (a < b); }
+
+static int libc_compare_u32(void const *const a, void const *const b) {
+  return compare_keys(load_key(a, 4), load_key(b, 4));
+}
+
+static int libc_compare_u64(void const *const a, void const *const b) {
+  return compare_keys(load_key(a, 8), load_key(b, 8));
+}
+
+static int ov_compare_u32(void const *const a, void const *const b, void *const userdata) {
+  (void)userdata;
+  return compare_keys(load_key(a, 4), load_key(b, 4));
+}
+
+static int ov_compare_u64(void const *const a, void const *const b, void *const userdata) {
+  (void)userdata;
+  return compare_keys(load_key(a, 8), load_key(b, 8));
+}
+
+static uint64_t record_key(void const *const item, void *const userdata) {
+  (void)userdata;
+  return load_key(item, 8);
+}
+
+struct index_context {
+  unsigned char *base;
+  size_t elem_size;
+};
+
+static int index_compare(size_t const idx0, size_t const idx1, void *const userdata) {
+  struct index_context const *const ctx = (struct index_context const *)userdata;
+  return compare_keys(load_key(ctx->base + idx0 * ctx->elem_size, ctx->elem_size),
+                      load_key(ctx->base + idx1 * ctx->elem_size, ctx->elem_size));
+}
+
+static void index_swap(size_t const idx0, size_t const idx1, void *const userdata) {
+  struct index_context const *const ctx = (struct index_context const *)userdata;
+  unsigned char tmp[max_elem_size];
+  unsigned char *const a = ctx->base + idx0 * ctx->elem_size;
+  unsigned char *const b = ctx->base + idx1 * ctx->elem_size;
+  memcpy(tmp, a, ctx->elem_size);
+  memcpy(a, b, ctx->elem_size);
+  memcpy(b, tmp, ctx->elem_size);
+}
+
+// Implementations
+
+struct impl {
+  char const *name;
+  // 0 accepts every element size
+  size_t only_elem_size_up_to;
+  // largest size run on few_unique and many_duplicates, 0 for no limit
+  size_t duplicates_up_to;
+  void (*sort)(void *const base, size_t const n, size_t const elem_size, void *const scratch);
+};
+
+static void sort_libc_qsort(void *const base, size_t const n, size_t const elem_size, void *const scratch) {
+  (void)scratch;
+  qsort(base, n, elem_size, elem_size == 4 ? libc_compare_u32 : libc_compare_u64);
+}
+
+static void sort_ov_qsort(void *const base, size_t const n, size_t const elem_size, void *const scratch) {
+  (void)scratch;
+  ov_qsort(base, n, elem_size, elem_size == 4 ? ov_compare_u32 : ov_compare_u64, NULL);
+}
+
+static void sort_ov_sort(void *const base, size_t const n, size_t const elem_size, void *const scratch) {
+  (void)scratch;
+  ov_sort(n, index_compare, index_swap, &(struct index_context){.base = base, .elem_size = elem_size});
+}
+
+static void sort_old_ov_sort(void *const base, size_t const n, size_t const elem_size, void *const scratch) {
+  (void)scratch;
+  old_ov_sort(n, index_compare, index_swap, &(struct index_context){.base = base, .elem_size = elem_size});
+}
+
+static void sort_typed(void *const base, size_t const n, size_t const elem_size, void *const scratch) {
+  (void)scratch;
+  if (elem_size == 4) {
+    ov_sort_u32((uint32_t *)base, n);
+  } else {
+    ov_sort_u64((uint64_t *)base, n);
+  }
+}
+
+static void sort_radix(void *const base, size_t const n, size_t const elem_size, void *const scratch) {
+  if (elem_size == 4) {
+    ov_radix_sort_u32((uint32_t *)base, n, (uint32_t *)scratch);
+  } else if (elem_size == 8) {
+    ov_radix_sort_u64((uint64_t *)base, n, (uint64_t *)scratch);
+  } else {
+    ov_radix_sort_records(base, n, elem_size, record_key, NULL, scratch);
+  }
+}
+
+static void sort_radix_inplace(void *const base, size_t const n, size_t const elem_size, void *const scratch) {
+  (void)scratch;
+  sort_radix(base, n, elem_size, NULL);
+}
+
+static struct impl const impls[] = {
+    {"libc_qsort", 0, 0, sort_libc_qsort},
+    {"ov_qsort", 0, 0, sort_ov_qsort},
+    {"ov_sort", 0, 0, sort_ov_sort},
+    // quadratic when most keys are equal, hours per case beyond this
+    {"old_ov_sort", 0, 100000, sort_old_ov_sort},
+    {"ov_sort_typed", 8, 0, sort_typed},
+    {"ov_radix_sort", 0, 0, sort_radix},
+    {"ov_radix_sort_inplace", 0, 0, sort_radix_inplace},
+};
+
+// Distributions
+
+enum distribution {
+  distribution_random,
+  distribution_sorted,
+  distribution_reversed,
+  distribution_organ_pipe,
+  distribution_few_unique,
+  distribution_many_duplicates,
+  distribution_count,
+};
+
+static char const *const distribution_names[distribution_count] = {
+    "random",
+    "sorted",
+    "reversed",
+    "organ_pipe",
+    "few_unique",
+    "many_duplicates",
+};
+
+static void fill(unsigned char *const base, size_t const n, size_t const elem_size, enum distribution const dist) {
+  struct ov_rand_xoshiro256pp rng;
+  ov_rand_xoshiro256pp_init(&rng, (uint64_t)n * 31 + (uint64_t)dist);
+  // about sqrt(n) distinct keys, each repeated about sqrt(n) times
+  uint64_t const duplicates_range = (uint64_t)sqrt((double)n) + 1;
+  for (size_t i = 0; i < n; ++i) {
+    uint64_t key = 0;
+    switch (dist) {
+    case distribution_random:
+      key = ov_rand_xoshiro256pp_next(&rng) >> 32;
+      break;
+    case distribution_sorted:
+      key = i;
+      break;
+    case distribution_reversed:
+      key = n - i;
+      break;
+    case distribution_organ_pipe:
+      key = i < n / 2 ? i : n - i;
+      break;
+    case distribution_few_unique:
+      key = ov_rand_xoshiro256pp_next(&rng) % 8;
+      break;
+    case distribution_many_duplicates:
+    case distribution_count:
+      key = ov_rand_xoshiro256pp_next(&rng) % duplicates_range;
+      break;
+    }
+    unsigned char *const p = base + i * elem_size;
+    if (elem_size > 8) {
+      memset(p + 8, (int)(i & 0xff), elem_size - 8);
+    }
+    store_key(p, elem_size, key);
+  }
+}
+
+static bool is_sorted(unsigned char const *const base, size_t const n, size_t const elem_size) {
+  for (size_t i = 1; i < n; ++i) {
+    if (load_key(base + (i - 1) * elem_size, elem_size) > load_key(base + i * elem_size, elem_size)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Options and output
+
+enum format {
+  format_json,
+  format_csv,
+};
+
+struct options {
+  enum format format;
+  char const *output;
+  char const *impls;
+  char const *dists;
+  char const *elems;
+  size_t min_size;
+  size_t max_size;
+  size_t samples;
+  size_t max_bytes;
+};
+
+// Returns true if name appears in the comma separated list, or if there is no list.
+static bool in_list(char const *list, char const *const name) {
+  if (!list) {
+    return true;
+  }
+  size_t const len = strlen(name);
+  while (*list) {
+    char const *const end = strchr(list, ',');
+    size_t const item_len = end ? (size_t)(end - list) : strlen(list);
+    if (item_len == len && strncmp(list, name, len) == 0) {
+      return true;
+    }
+    if (!end) {
+      break;
+    }
+    list = end + 1;
+  }
+  return false;
+}
+
+static bool parse_size(char const *const s, size_t *const v) {
+  char *end = NULL;
+  double const d = strtod(s, &end);
+  if (end == s || *end != '\0' || !(d >= 0) || d > (double)SIZE_MAX) {
+    return false;
+  }
+  *v = (size_t)d;
+  return true;
+}
+
+static bool parse_args(int const argc, char **const argv, struct options *const opts) {
+  for (int i = 1; i < argc; ++i) {
+    char const *const arg = argv[i];
+    char const *const eq = strchr(arg, '=');
+    if (strncmp(arg, "--", 2) != 0 || !eq) {
+      return false;
+    }
+    size_t const key_len = (size_t)(eq - arg);
+    char const *const value = eq + 1;
+#define OPTION_IS(name) (key_len == sizeof(name) - 1 && strncmp(arg, name, key_len) == 0)
+    if (OPTION_IS("--format")) {
+      if (strcmp(value, "json") == 0) {
+        opts->format = format_json;
+      } else if (strcmp(value, "csv") == 0) {
+        opts->format = format_csv;
+      } else {
+        return false;
+      }
+    } else if (OPTION_IS("--output")) {
+      opts->output = value;
+    } else if (OPTION_IS("--impl")) {
+      opts->impls = value;
+    } else if (OPTION_IS("--dist")) {
+      opts->dists = value;
+    } else if (OPTION_IS("--elem")) {
+      opts->elems = value;
+    } else if (OPTION_IS("--min-size")) {
+      if (!parse_size(value, &opts->min_size)) {
+        return false;
+      }
+    } else if (OPTION_IS("--max-size")) {
+      if (!parse_size(value, &opts->max_size)) {
+        return false;
+      }
+    } else if (OPTION_IS("--samples")) {
+      if (!parse_size(value, &opts->samples) || opts->samples > max_samples) {
+        return false;
+      }
+    } else if (OPTION_IS("--max-bytes")) {
+      if (!parse_size(value, &opts->max_bytes)) {
+        return false;
+      }
+    } else {
+      return false;
+    }
+#undef OPTION_IS
+  }
+  return true;
+}
+
+struct result {
+  char const *impl;
+  char const *dist;
+  size_t size;
+  size_t elem_size;
+  size_t samples;
+  size_t batch;
+  double median_ns;
+  double p95_ns;
+  double min_ns;
+};
+
+static void write_header(FILE *const fp, enum format const format) {
+  if (format == format_csv) {
+    fputs("implementation,distribution,size,element_size,samples,batch,median_ns,p95_ns,min_ns,median_ns_per_element\n",
+          fp);
+  } else {
+    fputs("{\n  \"benchmark\": \"ovbase_sort\",\n  \"results\": [", fp);
+  }
+}
+
+static void write_result(FILE *const fp, enum format const format, struct result const *const r, bool const first) {
+  double const per_element = r->size ? r->median_ns / (double)r->size : 0;
+  if (format == format_csv) {
+    fprintf(fp,
+            "%s,%s,%zu,%zu,%zu,%zu,%.1f,%.1f,%.1f,%.3f\n",
+            r->impl,
+            r->dist,
+            r->size,
+            r->elem_size,
+            r->samples,
+            r->batch,
+            r->median_ns,
+            r->p95_ns,
+            r->min_ns,
+            per_element);
+  } else {
+    fprintf(fp,
+            "%s\n    {\"implementation\": \"%s\", \"distribution\": \"%s\", \"size\": %zu, \"element_size\": %zu, "
+            "\"samples\": %zu, \"batch\": %zu, \"median_ns\": %.1f, \"p95_ns\": %.1f, \"min_ns\": %.1f, "
+            "\"median_ns_per_element\": %.3f}",
+            first ? "" : ",",
+            r->impl,
+            r->dist,
+            r->size,
+            r->elem_size,
+            r->samples,
+            r->batch,
+            r->median_ns,
+            r->p95_ns,
+            r->min_ns,
+            per_element);
+  }
+  fflush(fp);
+}
+
+static void write_footer(FILE *const fp, enum format const format) {
+  if (format == format_json) {
+    fputs("\n  ]\n}\n", fp);
+  }
+}
+
+// Running
+
+struct buffers {
+  unsigned char *input;
+  unsigned char *work;
+  unsigned char *scratch;
+};
+
+static int compare_doubles(void const *const a, void const *const b) {
+  double const x = *(double const *)a;
+  double const y = *(double const *)b;
+  return (x > y) - (x < y);
+}
+
+// Times one sample of batch sorts and returns nanoseconds per sort.
+static double run_sample(struct impl const *const impl,
+                         struct buffers const *const bufs,
+                         size_t const n,
+                         size_t const elem_size,
+                         size_t const batch) {
+  size_t const bytes = n * elem_size;
+  for (size_t b = 0; b < batch; ++b) {
+    memcpy(bufs->work + b * bytes, bufs->input, bytes);
+  }
+  uint64_t const start = now_ns();
+  for (size_t b = 0; b < batch; ++b) {
+    impl->sort(bufs->work + b * bytes, n, elem_size, bufs->scratch);
+  }
+  uint64_t const end = now_ns();
+  return (double)(end - start) / (double)batch;
+}
+
+static bool run_case(struct impl const *const impl,
+                     struct buffers const *const bufs,
+                     size_t const n,
+                     size_t const elem_size,
+                     size_t const requested_samples,
+                     struct result *const r) {
+  size_t const batch = n < batch_elements ? batch_elements / n : 1;
+  double times[max_samples];
+  // The first sample warms up caches and checks the output.
+  double const warmup = run_sample(impl, bufs, n, elem_size, batch);
+  if (!is_sorted(bufs->work, n, elem_size)) {
+    return false;
+  }
+  size_t samples = requested_samples;
+  if (!samples) {
+    double const per_sample = warmup * (double)batch * 1e-9;
+    samples = per_sample > 0 ? (size_t)(auto_sample_seconds / per_sample) : max_samples;
+    samples = samples < 5 ? 5 : samples > max_samples ? max_samples : samples;
+  }
+  for (size_t s = 0; s < samples; ++s) {
+    times[s] = run_sample(impl, bufs, n, elem_size, batch);
+  }
+  qsort(times, samples, sizeof(times[0]), compare_doubles);
+  // nearest rank
+  size_t const p95 = (samples * 95 + 99) / 100 - 1;
+  *r = (struct result){
+      .impl = impl->name,
+      .size = n,
+      .elem_size = elem_size,
+      .samples = samples,
+      .batch = batch,
+      .median_ns = samples % 2 ? times[samples / 2] : (times[samples / 2 - 1] + times[samples / 2]) * 0.5,
+      .p95_ns = times[p95],
+      .min_ns = times[0],
+  };
+  return true;
+}
+
+static size_t const elem_sizes[] = {4, 8, 32, 128};
+
+static int run(struct options const *const opts, FILE *const fp) {
+  struct buffers bufs = {0};
+  int exit_code = EXIT_FAILURE;
+  bool first = true;
+  write_header(fp, opts->format);
+  for (size_t n = 10; n <= opts->max_size && n <= 100000000; n *= 10) {
+    if (n < opts->min_size) {
+      continue;
+    }
+    for (size_t e = 0; e < sizeof(elem_sizes) / sizeof(elem_sizes[0]); ++e) {
+      size_t const elem_size = elem_sizes[e];
+      char elem_name[8];
+      snprintf(elem_name, sizeof(elem_name), "%zu", elem_size);
+      if (!in_list(opts->elems, elem_name)) {
+        continue;
+      }
+      size_t const batch = n < batch_elements ? batch_elements / n : 1;
+      size_t const bytes = n * elem_size;
+      // input, batch copies and scratch
+      if (bytes * (batch + 2) > opts->max_bytes) {
+        fprintf(stderr, "skipping size=%zu element_size=%zu: exceeds --max-bytes\n", n, elem_size);
+        continue;
+      }
+      if (!OV_REALLOC(&bufs.input, n, elem_size) || !OV_REALLOC(&bufs.work, n * batch, elem_size) ||
+          !OV_REALLOC(&bufs.scratch, n, elem_size)) {
+        fprintf(stderr, "out of memory at size=%zu element_size=%zu\n", n, elem_size);
+        goto cleanup;
+      }
+      for (int d = 0; d < distribution_count; ++d) {
+        if (!in_list(opts->dists, distribution_names[d])) {
+          continue;
+        }
+        fill(bufs.input, n, elem_size, (enum distribution)d);
+        for (size_t i = 0; i < sizeof(impls) / sizeof(impls[0]); ++i) {
+          struct impl const *const impl = impls + i;
+          if (!in_list(opts->impls, impl->name) ||
+              (impl->only_elem_size_up_to && elem_size > impl->only_elem_size_up_to)) {
+            continue;
+          }
+          if (impl->duplicates_up_to && n > impl->duplicates_up_to &&
+              (d == distribution_few_unique || d == distribution_many_duplicates)) {
+            fprintf(stderr,
+                    "skipped %s %s size=%zu element_size=%zu: too slow on duplicate keys\n",
+                    impl->name,
+                    distribution_names[d],
+                    n,
+                    elem_size);
+            continue;
+          }
+          fprintf(stderr, "%s %s size=%zu element_size=%zu\n", impl->name, distribution_names[d], n, elem_size);
+          struct result r;
+          if (!run_case(impl, &bufs, n, elem_size, opts->samples, &r)) {
+            fprintf(stderr, "%s produced unsorted output\n", impl->name);
+            goto cleanup;
+          }
+          r.dist = distribution_names[d];
+          write_result(fp, opts->format, &r, first);
+          first = false;
+        }
+      }
+    }
+  }
+  write_footer(fp, opts->format);
+  exit_code = EXIT_SUCCESS;
+cleanup:
+  if (bufs.scratch) {
+    OV_FREE(&bufs.scratch);
+  }
+  if (bufs.work) {
+    OV_FREE(&bufs.work);
+  }
+  if (bufs.input) {
+    OV_FREE(&bufs.input);
+  }
+  return exit_code;
+}
+
+int main(int argc, char **argv) {
+  struct options opts = {
+      .format = format_json,
+      .min_size = 0,
+      .max_size = 1000000,
+      .max_bytes = (size_t)1 << (sizeof(size_t) > 4 ? 32 : 30),
+  };
+  if (!parse_args(argc, argv, &opts)) {
+    fprintf(stderr,
+            "usage: %s [--format=json|csv] [--output=PATH] [--impl=a,b] [--dist=a,b] [--elem=4,8,32,128]\n"
+            "          [--min-size=N] [--max-size=N] [--samples=N] [--max-bytes=N]\n"
+            "sizes are powers of ten from 10 to 1e8, --max-size defaults to 1e6\n",
+            argv[0]);
+    return EXIT_FAILURE;
+  }
+  {
+    struct ov_init_options init_opts = ov_init_get_default_options();
+    if (!ov_init(&init_opts)) {
+      return EXIT_FAILURE;
+    }
+  }
+  int exit_code = EXIT_FAILURE;
+  FILE *fp = stdout;
+  if (opts.output) {
+    fp = fopen(opts.output, "w");
+    if (!fp) {
+      fprintf(stderr, "cannot open %s\n", opts.output);
+      goto cleanup;
+    }
+  }
+  exit_code = run(&opts, fp);
+cleanup:
+  if (fp && fp != stdout) {
+    fclose(fp);
+  }
+  ov_exit();
+  return exit_code;
+}
@@ -0,0 +1,624 @@
+#include <ovsort_external.h>
+
+#include <ovsort.h>
+
+#include <assert.h>
+#include <string.h>
+
+#ifdef _WIN32
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#elif !defined(__wasi__)
+#  include <ovprintf.h>
+
+#  include <errno.h>
+#  include <fcntl.h>
+#  include <stdatomic.h>
+#  include <stdlib.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+enum {
+#ifdef __wasi__
+  // The WASI build caps linear memory at 64 MiB in total.
+  default_memory_budget = 4 * 1024 * 1024,
+#else
+  default_memory_budget = 64 * 1024 * 1024,
+#endif
+  min_items = 16,
+  min_block_bytes = 64 * 1024,
+  max_fanin = 256,
+};
+
+// Temporary files
+//
+// Runs are appended to one file and read back by offset. Files are deleted right after
+// they are created (or on close on Windows), so they never outlive the process.
+
+#ifdef _WIN32
+typedef HANDLE temp_file;
+#  define TEMP_FILE_INVALID INVALID_HANDLE_VALUE
+
+static bool temp_open(NATIVE_CHAR const *dir, temp_file *const f, struct ov_error *const err) {
+  wchar_t default_dir[MAX_PATH + 1];
+  wchar_t path[MAX_PATH + 1];
+  if (!dir) {
+    if (!GetTempPathW(MAX_PATH + 1, default_dir)) {
+      OV_ERROR_SET_HRESULT(err, HRESULT_FROM_WIN32(GetLastError()));
+      return false;
+    }
+    dir = default_dir;
+  }
+  if (!GetTempFileNameW(dir, L"ovs", 0, path)) {
+    OV_ERROR_SET_HRESULT(err, HRESULT_FROM_WIN32(GetLastError()));
+    return false;
+  }
+  *f = CreateFileW(path,
+                   GENERIC_READ | GENERIC_WRITE,
+                   0,
+                   NULL,
+                   CREATE_ALWAYS,
+                   FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE,
+                   NULL);
+  if (*f == INVALID_HANDLE_VALUE) {
+    HRESULT const hr = HRESULT_FROM_WIN32(GetLastError());
+    DeleteFileW(path);
+    OV_ERROR_SET_HRESULT(err, hr);
+    return false;
+  }
+  return true;
+}
+
+static void temp_close(temp_file *const f) {
+  if (*f != INVALID_HANDLE_VALUE) {
+    CloseHandle(*f);
+    *f = INVALID_HANDLE_VALUE;
+  }
+}
+
+static bool temp_io(temp_file const f,
+                    uint64_t offset,
+                    unsigned char *buf,
+                    size_t bytes,
+                    bool const writing,
+                    struct ov_error *const err) {
+  while (bytes > 0) {
+    DWORD const chunk = bytes > 0x40000000 ? 0x40000000 : (DWORD)bytes;
+    OVERLAPPED ov = {.Offset = (DWORD)offset, .OffsetHigh = (DWORD)(offset >> 32)};
+    DWORD done = 0;
+    BOOL const ok = writing ? WriteFile(f, buf, chunk, &done, &ov) : ReadFile(f, buf, chunk, &done, &ov);
+    if (!ok) {
+      OV_ERROR_SET_HRESULT(err, HRESULT_FROM_WIN32(GetLastError()));
+      return false;
+    }
+    if (done == 0) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_unexpected);
+      return false;
+    }
+    offset += done;
+    buf += done;
+    bytes -= done;
+  }
+  return true;
+}
+#elif !defined(__wasi__)
+typedef int temp_file;
+#  define TEMP_FILE_INVALID (-1)
+
+static bool temp_open(NATIVE_CHAR const *dir, temp_file *const f, struct ov_error *const err) {
+  static atomic_uint counter;
+  if (!dir) {
+    dir = getenv("TMPDIR");
+    if (!dir || !*dir) {
+      dir = "/tmp";
+    }
+  }
+  char path[4096];
+  for (int attempt = 0; attempt < 100; ++attempt) {
+    int const len = ov_snprintf_char(path,
+                                     sizeof(path),
+                                     NULL,
+                                     "%s/ovbase-sort-%ld-%u.tmp",
+                                     dir,
+                                     (long)getpid(),
+                                     atomic_fetch_add_explicit(&counter, 1, memory_order_relaxed));
+    if (len < 0 || (size_t)len >= sizeof(path)) {
+      OV_ERROR_SET_ERRNO(err, ENAMETOOLONG);
+      return false;
+    }
+    *f = open(path, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+    if (*f != -1) {
+      unlink(path);
+      return true;
+    }
+    if (errno != EEXIST) {
+      OV_ERROR_SET_ERRNO(err, errno);
+      return false;
+    }
+  }
+  OV_ERROR_SET_ERRNO(err, EEXIST);
+  return false;
+}
+
+static void temp_close(temp_file *const f) {
+  if (*f != -1) {
+    close(*f);
+    *f = -1;
+  }
+}
+
+static bool temp_io(temp_file const f,
+                    uint64_t const offset,
+                    unsigned char *buf,
+                    size_t bytes,
+                    bool const writing,
+                    struct ov_error *const err) {
+  if (lseek(f, (off_t)offset, SEEK_SET) == (off_t)-1) {
+    OV_ERROR_SET_ERRNO(err, errno);
+    return false;
+  }
+  while (bytes > 0) {
+    ssize_t const done = writing ? write(f, buf, bytes) : read(f, buf, bytes);
+    if (done < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      OV_ERROR_SET_ERRNO(err, errno);
+      return false;
+    }
+    if (done == 0) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_unexpected);
+      return false;
+    }
+    buf += done;
+    bytes -= (size_t)done;
+  }
+  return true;
+}
+#else
+typedef int temp_file;
+#  define TEMP_FILE_INVALID (-1)
+
+static bool temp_open(NATIVE_CHAR const *dir, temp_file *const f, struct ov_error *const err) {
+  (void)dir;
+  *f = -1;
+  OV_ERROR_SET_GENERIC(err, ov_error_generic_not_implemented_yet);
+  return false;
+}
+
+static void temp_close(temp_file *const f) { *f = -1; }
+
+static bool temp_io(temp_file const f,
+                    uint64_t const offset,
+                    unsigned char *buf,
+                    size_t bytes,
+                    bool const writing,
+                    struct ov_error *const err) {
+  (void)f;
+  (void)offset;
+  (void)buf;
+  (void)bytes;
+  (void)writing;
+  OV_ERROR_SET_GENERIC(err, ov_error_generic_not_implemented_yet);
+  return false;
+}
+#endif
+
+struct run {
+  uint64_t offset; // in items
+  uint64_t count;
+};
+
+struct ov_external_sort {
+  size_t item_size;
+  int (*compare)(void const *const a, void const *const b, void *const userdata);
+  void *userdata;
+  NATIVE_CHAR const *temp_dir;
+
+  unsigned char *buffer;
+  size_t capacity; // items in buffer
+  size_t buffered;
+
+  temp_file file;
+  uint64_t file_items;
+  struct run *runs;
+  size_t nruns;
+  size_t runs_cap;
+
+  bool finished;
+  struct ov_external_sort_stats stats;
+};
+
+static bool push_run(struct ov_external_sort *const es, struct run const r MEM_FILEPOS_PARAMS) {
+  if (es->nruns == es->runs_cap) {
+    size_t const n = es->runs_cap ? es->runs_cap * 2 : 16;
+    if (!ov_mem_realloc(&es->runs, n, sizeof(struct run) MEM_FILEPOS_VALUES_PASSTHRU)) {
+      return false;
+    }
+    es->runs_cap = n;
+  }
+  es->runs[es->nruns++] = r;
+  return true;
+}
+
+static bool spill(struct ov_external_sort *const es, struct ov_error *const err MEM_FILEPOS_PARAMS) {
+  if (es->buffered == 0) {
+    return true;
+  }
+  if (es->file == TEMP_FILE_INVALID && !temp_open(es->temp_dir, &es->file, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    return false;
+  }
+  ov_qsort(es->buffer, es->buffered, es->item_size, es->compare, es->userdata);
+  size_t const bytes = es->buffered * es->item_size;
+  if (!temp_io(es->file, es->file_items * es->item_size, es->buffer, bytes, true, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    return false;
+  }
+  struct run const r = {.offset = es->file_items, .count = es->buffered};
+  if (!push_run(es, r MEM_FILEPOS_VALUES_PASSTHRU)) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    return false;
+  }
+  es->file_items += es->buffered;
+  es->buffered = 0;
+  ++es->stats.runs;
+  es->stats.bytes_written += bytes;
+  return true;
+}
+
+// Merging
+//
+// Each run is read through a block of the buffer. The loser tree keeps the run that lost
+// each match in the internal nodes and the overall winner in node 0, so replacing the
+// winner's item costs log2(k) comparisons along a single path to the root.
+
+struct reader {
+  uint64_t next;      // next item to read from the file
+  uint64_t remaining; // items left in the file
+  unsigned char *block;
+  size_t block_items;
+  size_t loaded;
+  size_t pos;
+};
+
+struct merge {
+  struct ov_external_sort *es;
+  temp_file file;
+  struct reader *readers;
+  size_t *tree;
+  size_t k;
+};
+
+static bool reader_fill(struct merge const *const m, struct reader *const r, struct ov_error *const err) {
+  size_t const n = r->remaining < r->block_items ? (size_t)r->remaining : r->block_items;
+  size_t const sz = m->es->item_size;
+  if (n && !temp_io(m->file, r->next * sz, r->block, n * sz, false, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    return false;
+  }
+  r->next += n;
+  r->remaining -= n;
+  r->loaded = n;
+  r->pos = 0;
+  return true;
+}
+
+static inline bool reader_done(struct reader const *const r) { return r->pos == r->loaded; }
+
+static inline unsigned char const *reader_item(struct merge const *const m, struct reader const *const r) {
+  return r->block + r->pos * m->es->item_size;
+}
+
+// Index k stands for a virtual item that beats everything and is only used to build the tree.
+static inline bool beats(struct merge const *const m, size_t const a, size_t const b) {
+  if (a == m->k) {
+    return true;
+  }
+  if (b == m->k) {
+    return false;
+  }
+  struct reader const *const ra = m->readers + a;
+  struct reader const *const rb = m->readers + b;
+  if (reader_done(ra)) {
+    return false;
+  }
+  if (reader_done(rb)) {
+    return true;
+  }
+  int const r = m->es->compare(reader_item(m, ra), reader_item(m, rb), m->es->userdata);
+  return r < 0 || (r == 0 && a < b);
+}
+
+static void tree_adjust(struct merge const *const m, size_t s) {
+  for (size_t t = (s + m->k) / 2; t > 0; t /= 2) {
+    if (beats(m, m->tree[t], s)) {
+      size_t const tmp = m->tree[t];
+      m->tree[t] = s;
+      s = tmp;
+    }
+  }
+  m->tree[0] = s;
+}
+
+struct writer {
+  temp_file file;
+  uint64_t offset; // in items
+  unsigned char *block;
+  size_t block_items;
+  size_t pending;
+};
+
+static bool writer_flush(struct ov_external_sort *const es, struct writer *const w, struct ov_error *const err) {
+  if (w->pending == 0) {
+    return true;
+  }
+  size_t const bytes = w->pending * es->item_size;
+  if (!temp_io(w->file, w->offset * es->item_size, w->block, bytes, true, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    return false;
+  }
+  w->offset += w->pending;
+  w->pending = 0;
+  es->stats.bytes_written += bytes;
+  return true;
+}
+
+// Merges runs into either the writer or the output callback.
+static bool merge_runs(struct ov_external_sort *const es,
+                       temp_file const file,
+                       struct run const *const runs,
+                       size_t const k,
+                       struct reader *const readers,
+                       size_t *const tree,
+                       struct writer *const w,
+                       ov_external_sort_output_func const output,
+                       void *const userdata,
+                       struct ov_error *const err) {
+  size_t const sz = es->item_size;
+  size_t const blocks = k + (w ? 1 : 0);
+  size_t const block_items = es->capacity / blocks;
+  struct merge m = {.es = es, .file = file, .readers = readers, .tree = tree, .k = k};
+  for (size_t i = 0; i < k; ++i) {
+    readers[i] = (struct reader){
+        .next = runs[i].offset,
+        .remaining = runs[i].count,
+        .block = es->buffer + i * block_items * sz,
+        .block_items = block_items,
+    };
+    if (!reader_fill(&m, readers + i, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      return false;
+    }
+  }
+  if (w) {
+    w->block = es->buffer + k * block_items * sz;
+    w->block_items = block_items;
+    w->pending = 0;
+  }
+  for (size_t i = 0; i < k; ++i) {
+    tree[i] = k;
+  }
+  for (size_t i = k; i-- > 0;) {
+    tree_adjust(&m, i);
+  }
+  for (;;) {
+    size_t const winner = tree[0];
+    struct reader *const r = readers + winner;
+    if (reader_done(r)) {
+      break;
+    }
+    unsigned char const *const item = reader_item(&m, r);
+    if (w) {
+      memcpy(w->block + w->pending * sz, item, sz);
+      if (++w->pending == w->block_items && !writer_flush(es, w, err)) {
+        OV_ERROR_ADD_TRACE(err);
+        return false;
+      }
+    } else if (!output(item, userdata)) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_abort);
+      return false;
+    }
+    if (++r->pos == r->loaded && r->remaining && !reader_fill(&m, r, err)) {
+      OV_ERROR_ADD_TRACE(err);
+      return false;
+    }
+    tree_adjust(&m, winner);
+  }
+  if (w && !writer_flush(es, w, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    return false;
+  }
+  return true;
+}
+
+static size_t fanin_limit(struct ov_external_sort const *const es) {
+  size_t block_items = min_block_bytes / es->item_size;
+  if (block_items == 0) {
+    block_items = 1;
+  }
+  size_t const blocks = es->capacity / block_items;
+  if (blocks < 3) {
+    return 2;
+  }
+  return blocks - 1 < max_fanin ? blocks - 1 : max_fanin;
+}
+
+static void reset(struct ov_external_sort *const es) {
+  temp_close(&es->file);
+  es->file_items = 0;
+  es->nruns = 0;
+  es->buffered = 0;
+  es->finished = true;
+}
+
+struct ov_external_sort *ov_external_sort_create(struct ov_external_sort_options const *const options,
+                                                 struct ov_error *const err MEM_FILEPOS_PARAMS) {
+  assert(options != NULL && "options must not be NULL");
+  struct ov_external_sort *es = NULL;
+  bool result = false;
+  if (!options->item_size || !options->compare) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_invalid_argument);
+    goto cleanup;
+  }
+  if (!ov_mem_realloc(&es, 1, sizeof(*es) MEM_FILEPOS_VALUES_PASSTHRU)) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    goto cleanup;
+  }
+  *es = (struct ov_external_sort){
+      .item_size = options->item_size,
+      .compare = options->compare,
+      .userdata = options->userdata,
+      .temp_dir = options->temp_dir,
+      .file = TEMP_FILE_INVALID,
+  };
+  {
+    size_t const budget = options->memory_budget ? options->memory_budget : default_memory_budget;
+    size_t const capacity = budget / options->item_size;
+    es->capacity = capacity < min_items ? min_items : capacity;
+  }
+  if (!ov_mem_realloc(&es->buffer, es->capacity, es->item_size MEM_FILEPOS_VALUES_PASSTHRU)) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    goto cleanup;
+  }
+  result = true;
+cleanup:
+  if (!result && es) {
+    ov_external_sort_destroy(&es MEM_FILEPOS_VALUES_PASSTHRU);
+  }
+  return es;
+}
+
+void ov_external_sort_destroy(struct ov_external_sort **const esp MEM_FILEPOS_PARAMS) {
+  assert(esp != NULL && "esp must not be NULL");
+  struct ov_external_sort *const es = *esp;
+  if (!es) {
+    return;
+  }
+  temp_close(&es->file);
+  if (es->runs) {
+    ov_mem_free(&es->runs MEM_FILEPOS_VALUES_PASSTHRU);
+  }
+  if (es->buffer) {
+    ov_mem_free(&es->buffer MEM_FILEPOS_VALUES_PASSTHRU);
+  }
+  ov_mem_free((void **)esp MEM_FILEPOS_VALUES_PASSTHRU);
+}
+
+bool ov_external_sort_add(struct ov_external_sort *const es,
+                          void const *const items,
+                          size_t const n,
+                          struct ov_error *const err MEM_FILEPOS_PARAMS) {
+  assert(es != NULL && "es must not be NULL");
+  assert((items != NULL || n == 0) && "items must not be NULL");
+  if (es->finished) {
+    es->stats = (struct ov_external_sort_stats){0};
+    es->finished = false;
+  }
+  unsigned char const *src = (unsigned char const *)items;
+  size_t left = n;
+  while (left > 0) {
+    if (es->buffered == es->capacity && !spill(es, err MEM_FILEPOS_VALUES_PASSTHRU)) {
+      OV_ERROR_ADD_TRACE(err);
+      return false;
+    }
+    size_t const room = es->capacity - es->buffered;
+    size_t const chunk = left < room ? left : room;
+    memcpy(es->buffer + es->buffered * es->item_size, src, chunk * es->item_size);
+    es->buffered += chunk;
+    es->stats.items += chunk;
+    src += chunk * es->item_size;
+    left -= chunk;
+  }
+  return true;
+}
+
+bool ov_external_sort_finish(struct ov_external_sort *const es,
+                             ov_external_sort_output_func const output,
+                             void *const userdata,
+                             struct ov_error *const err MEM_FILEPOS_PARAMS) {
+  assert(es != NULL && "es must not be NULL");
+  assert(output != NULL && "output must not be NULL");
+  struct reader *readers = NULL;
+  size_t *tree = NULL;
+  temp_file other = TEMP_FILE_INVALID;
+  bool result = false;
+  if (es->finished) {
+    es->stats = (struct ov_external_sort_stats){0};
+  }
+  es->stats.intermediate_passes = 0;
+
+  if (es->nruns == 0) {
+    ov_qsort(es->buffer, es->buffered, es->item_size, es->compare, es->userdata);
+    for (size_t i = 0; i < es->buffered; ++i) {
+      if (!output(es->buffer + i * es->item_size, userdata)) {
+        OV_ERROR_SET_GENERIC(err, ov_error_generic_abort);
+        goto cleanup;
+      }
+    }
+    result = true;
+    goto cleanup;
+  }
+
+  if (!spill(es, err MEM_FILEPOS_VALUES_PASSTHRU)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
+  {
+    size_t const fanin = fanin_limit(es);
+    if (!ov_mem_realloc(&readers, fanin, sizeof(struct reader) MEM_FILEPOS_VALUES_PASSTHRU) ||
+        !ov_mem_realloc(&tree, fanin, sizeof(size_t) MEM_FILEPOS_VALUES_PASSTHRU)) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    while (es->nruns > fanin) {
+      // Spread runs evenly over the groups, so their sizes differ by at most one. With a
+      // fan-in of 2 and an odd number of runs one group still holds a single run, which is
+      // copied to the new file unchanged.
+      size_t const groups = (es->nruns + fanin - 1) / fanin;
+      if (!temp_open(es->temp_dir, &other, err)) {
+        OV_ERROR_ADD_TRACE(err);
+        goto cleanup;
+      }
+      struct writer w = {.file = other};
+      for (size_t g = 0; g < groups; ++g) {
+        size_t const begin = es->nruns * g / groups;
+        size_t const end = es->nruns * (g + 1) / groups;
+        uint64_t const offset = w.offset;
+        if (!merge_runs(es, es->file, es->runs + begin, end - begin, readers, tree, &w, NULL, NULL, err)) {
+          OV_ERROR_ADD_TRACE(err);
+          goto cleanup;
+        }
+        // g <= begin, so this never overwrites a run that is still to be merged.
+        es->runs[g] = (struct run){.offset = offset, .count = w.offset - offset};
+      }
+      temp_close(&es->file);
+      es->file = other;
+      other = TEMP_FILE_INVALID;
+      es->nruns = groups;
+      ++es->stats.intermediate_passes;
+    }
+  }
+  if (!merge_runs(es, es->file, es->runs, es->nruns, readers, tree, NULL, output, userdata, err)) {
+    OV_ERROR_ADD_TRACE(err);
+    goto cleanup;
+  }
+  result = true;
+cleanup:
+  temp_close(&other);
+  if (tree) {
+    ov_mem_free(&tree MEM_FILEPOS_VALUES_PASSTHRU);
+  }
+  if (readers) {
+    ov_mem_free(&readers MEM_FILEPOS_VALUES_PASSTHRU);
+  }
+  reset(es);
+  return result;
+}
+
+void ov_external_sort_get_stats(struct ov_external_sort const *const es, struct ov_external_sort_stats *const stats) {
+  assert(es != NULL && "es must not be NULL");
+  assert(stats != NULL && "stats must not be NULL");
+  *stats = es->stats;
+}
@@ -0,0 +1,270 @@
+#include <ovsort.h>
+
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define NETWORK_SSE2 1
+#  ifdef __SSE4_2__
+#    include <nmmintrin.h>
+#  endif
+#elif defined(__ARM_NEON)
+#  include <arm_neon.h>
+#  define NETWORK_NEON 1
+#endif
+
+// Bitonic sorting network in its "flip" form: each merge first compares element i of a
+// block with its mirror image, then with the element half, a quarter, ... of the block
+// further on. Every comparison goes in the same direction, and skipping the comparisons
+// whose partner is past n behaves as if the input were padded with maximum elements, so
+// any n up to 32 sorts in place without sentinels.
+//
+// The pairs of each stage form two contiguous (or mirrored) runs. Runs of at least one
+// vector go through explicit SSE2 or NEON min/max kernels; the rest, and every type the
+// target has no vector compare for (64-bit integers before SSE4.2 or on 32-bit ARM), use
+// the scalar loop. Its compare-exchanges are branchless selects, but gcc -O2 does not
+// vectorize them, so the kernels are not left to the auto-vectorizer. Both paths order
+// floats the same way, so the result does not depend on which one ran.
+enum {
+  network_max = 32,
+};
+
+#define LESS_SCALAR(a, b) (*(a) < *(b))
+// NaNs sort after every number; all NaNs are equivalent, so this stays a strict weak order.
+#define LESS_FLOAT(a, b) ((*(a) < *(b)) | (isnan(*(b)) & !isnan(*(a))))
+
+// Vector kernels. Each one handles whole vectors from the start of the run and returns how
+// many pairs it exchanged; the scalar loop finishes the rest.
+
+#define VECTOR_DEFINE(name, T, V, lanes, load, store, reverse, minmax)                                                 \
+  static inline size_t name##_exchange_vector(T *const lo, T *const hi, size_t const count) {                          \
+    size_t i = 0;                                                                                                      \
+    for (; i + lanes <= count; i += lanes) {                                                                           \
+      V x = load(lo + i);                                                                                              \
+      V y = load(hi + i);                                                                                              \
+      minmax(&x, &y);                                                                                                  \
+      store(lo + i, x);                                                                                                \
+      store(hi + i, y);                                                                                                \
+    }                                                                                                                  \
+    return i;                                                                                                          \
+  }                                                                                                                    \
+  static inline size_t name##_exchange_mirror_vector(T *const lo, T *const hi_end, size_t const count) {               \
+    size_t i = 0;                                                                                                      \
+    for (; i + lanes <= count; i += lanes) {                                                                           \
+      T *const hi = hi_end - i - (lanes - 1);                                                                          \
+      V x = load(lo + i);                                                                                              \
+      V y = reverse(load(hi));                                                                                         \
+      minmax(&x, &y);                                                                                                  \
+      store(lo + i, x);                                                                                                \
+      store(hi, reverse(y));                                                                                           \
+    }                                                                                                                  \
+    return i;                                                                                                          \
+  }
+
+#define VECTOR_NONE(name, T)                                                                                           \
+  static inline size_t name##_exchange_vector(T *const lo, T *const hi, size_t const count) {                          \
+    (void)lo;                                                                                                          \
+    (void)hi;                                                                                                          \
+    (void)count;                                                                                                       \
+    return 0;                                                                                                          \
+  }                                                                                                                    \
+  static inline size_t name##_exchange_mirror_vector(T *const lo, T *const hi_end, size_t const count) {               \
+    (void)lo;                                                                                                          \
+    (void)hi_end;                                                                                                      \
+    (void)count;                                                                                                       \
+    return 0;                                                                                                          \
+  }
+
+#if defined(NETWORK_SSE2)
+
+// SSE2 has no 32-bit min/max and no 64-bit compare, so every kernel builds a mask of the
+// lanes where y < x and swaps those lanes with an xor.
+
+static inline __m128i load_i(void const *const p) { return _mm_loadu_si128((__m128i const *)p); }
+static inline void store_i(void *const p, __m128i const v) { _mm_storeu_si128((__m128i *)p, v); }
+static inline __m128i reverse_i32(__m128i const v) { return _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3)); }
+static inline __m128i reverse_i64(__m128i const v) { return _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)); }
+
+static inline void swap_masked_i(__m128i *const x, __m128i *const y, __m128i const mask) {
+  __m128i const t = _mm_and_si128(mask, _mm_xor_si128(*x, *y));
+  *x = _mm_xor_si128(*x, t);
+  *y = _mm_xor_si128(*y, t);
+}
+
+static inline void minmax_i32(__m128i *const x, __m128i *const y) { swap_masked_i(x, y, _mm_cmpgt_epi32(*x, *y)); }
+
+static inline void minmax_u32(__m128i *const x, __m128i *const y) {
+  __m128i const bias = _mm_set1_epi32(INT32_MIN);
+  swap_masked_i(x, y, _mm_cmpgt_epi32(_mm_xor_si128(*x, bias), _mm_xor_si128(*y, bias)));
+}
+
+static inline __m128 load_f32(float const *const p) { return _mm_loadu_ps(p); }
+static inline void store_f32(float *const p, __m128 const v) { _mm_storeu_ps(p, v); }
+static inline __m128 reverse_f32(__m128 const v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 1, 2, 3)); }
+
+static inline void minmax_f32(__m128 *const x, __m128 *const y) {
+  // y < x, or x is NaN and y is not
+  __m128 const mask = _mm_or_ps(_mm_cmplt_ps(*y, *x), _mm_andnot_ps(_mm_cmpunord_ps(*y, *y), _mm_cmpunord_ps(*x, *x)));
+  __m128 const t = _mm_and_ps(mask, _mm_xor_ps(*x, *y));
+  *x = _mm_xor_ps(*x, t);
+  *y = _mm_xor_ps(*y, t);
+}
+
+static inline __m128d load_f64(double const *const p) { return _mm_loadu_pd(p); }
+static inline void store_f64(double *const p, __m128d const v) { _mm_storeu_pd(p, v); }
+static inline __m128d reverse_f64(__m128d const v) { return _mm_shuffle_pd(v, v, 1); }
+
+static inline void minmax_f64(__m128d *const x, __m128d *const y) {
+  __m128d const mask =
+      _mm_or_pd(_mm_cmplt_pd(*y, *x), _mm_andnot_pd(_mm_cmpunord_pd(*y, *y), _mm_cmpunord_pd(*x, *x)));
+  __m128d const t = _mm_and_pd(mask, _mm_xor_pd(*x, *y));
+  *x = _mm_xor_pd(*x, t);
+  *y = _mm_xor_pd(*y, t);
+}
+
+VECTOR_DEFINE(i32, int32_t, __m128i, 4, load_i, store_i, reverse_i32, minmax_i32)
+VECTOR_DEFINE(u32, uint32_t, __m128i, 4, load_i, store_i, reverse_i32, minmax_u32)
+VECTOR_DEFINE(f32, float, __m128, 4, load_f32, store_f32, reverse_f32, minmax_f32)
+VECTOR_DEFINE(f64, double, __m128d, 2, load_f64, store_f64, reverse_f64, minmax_f64)
+
+#  ifdef __SSE4_2__
+static inline void minmax_i64(__m128i *const x, __m128i *const y) { swap_masked_i(x, y, _mm_cmpgt_epi64(*x, *y)); }
+
+static inline void minmax_u64(__m128i *const x, __m128i *const y) {
+  __m128i const bias = _mm_set1_epi64x(INT64_MIN);
+  swap_masked_i(x, y, _mm_cmpgt_epi64(_mm_xor_si128(*x, bias), _mm_xor_si128(*y, bias)));
+}
+
+VECTOR_DEFINE(i64, int64_t, __m128i, 2, load_i, store_i, reverse_i64, minmax_i64)
+VECTOR_DEFINE(u64, uint64_t, __m128i, 2, load_i, store_i, reverse_i64, minmax_u64)
+#  else
+VECTOR_NONE(i64, int64_t)
+VECTOR_NONE(u64, uint64_t)
+#  endif
+
+#elif defined(NETWORK_NEON)
+
+static inline void minmax_i32(int32x4_t *const x, int32x4_t *const y) {
+  int32x4_t const lo = vminq_s32(*x, *y);
+  *y = vmaxq_s32(*x, *y);
+  *x = lo;
+}
+
+static inline void minmax_u32(uint32x4_t *const x, uint32x4_t *const y) {
+  uint32x4_t const lo = vminq_u32(*x, *y);
+  *y = vmaxq_u32(*x, *y);
+  *x = lo;
+}
+
+static inline void minmax_f32(float32x4_t *const x, float32x4_t *const y) {
+  // vminq_f32 returns NaN if either lane is NaN, so select on y < x, or x is NaN and y is not
+  uint32x4_t const mask = vorrq_u32(vcltq_f32(*y, *x), vbicq_u32(vceqq_f32(*y, *y), vceqq_f32(*x, *x)));
+  float32x4_t const lo = vbslq_f32(mask, *y, *x);
+  *y = vbslq_f32(mask, *x, *y);
+  *x = lo;
+}
+
+static inline int32x4_t reverse_i32(int32x4_t const v) { return vextq_s32(vrev64q_s32(v), vrev64q_s32(v), 2); }
+static inline uint32x4_t reverse_u32(uint32x4_t const v) { return vextq_u32(vrev64q_u32(v), vrev64q_u32(v), 2); }
+static inline float32x4_t reverse_f32(float32x4_t const v) { return vextq_f32(vrev64q_f32(v), vrev64q_f32(v), 2); }
+
+VECTOR_DEFINE(i32, int32_t, int32x4_t, 4, vld1q_s32, vst1q_s32, reverse_i32, minmax_i32)
+VECTOR_DEFINE(u32, uint32_t, uint32x4_t, 4, vld1q_u32, vst1q_u32, reverse_u32, minmax_u32)
+VECTOR_DEFINE(f32, float, float32x4_t, 4, vld1q_f32, vst1q_f32, reverse_f32, minmax_f32)
+
+#  ifdef __aarch64__
+// 64-bit lanes have compares but no min/max.
+
+static inline void minmax_i64(int64x2_t *const x, int64x2_t *const y) {
+  uint64x2_t const mask = vcltq_s64(*y, *x);
+  int64x2_t const lo = vbslq_s64(mask, *y, *x);
+  *y = vbslq_s64(mask, *x, *y);
+  *x = lo;
+}
+
+static inline void minmax_u64(uint64x2_t *const x, uint64x2_t *const y) {
+  uint64x2_t const mask = vcltq_u64(*y, *x);
+  uint64x2_t const lo = vbslq_u64(mask, *y, *x);
+  *y = vbslq_u64(mask, *x, *y);
+  *x = lo;
+}
+
+static inline void minmax_f64(float64x2_t *const x, float64x2_t *const y) {
+  uint64x2_t const mask = vorrq_u64(vcltq_f64(*y, *x), vbicq_u64(vceqq_f64(*y, *y), vceqq_f64(*x, *x)));
+  float64x2_t const lo = vbslq_f64(mask, *y, *x);
+  *y = vbslq_f64(mask, *x, *y);
+  *x = lo;
+}
+
+static inline int64x2_t reverse_i64(int64x2_t const v) { return vextq_s64(v, v, 1); }
+static inline uint64x2_t reverse_u64(uint64x2_t const v) { return vextq_u64(v, v, 1); }
+static inline float64x2_t reverse_f64(float64x2_t const v) { return vextq_f64(v, v, 1); }
+
+VECTOR_DEFINE(i64, int64_t, int64x2_t, 2, vld1q_s64, vst1q_s64, reverse_i64, minmax_i64)
+VECTOR_DEFINE(u64, uint64_t, uint64x2_t, 2, vld1q_u64, vst1q_u64, reverse_u64, minmax_u64)
+VECTOR_DEFINE(f64, double, float64x2_t, 2, vld1q_f64, vst1q_f64, reverse_f64, minmax_f64)
+#  else
+VECTOR_NONE(i64, int64_t)
+VECTOR_NONE(u64, uint64_t)
+VECTOR_NONE(f64, double)
+#  endif
+
+#else
+
+VECTOR_NONE(i32, int32_t)
+VECTOR_NONE(u32, uint32_t)
+VECTOR_NONE(i64, int64_t)
+VECTOR_NONE(u64, uint64_t)
+VECTOR_NONE(f32, float)
+VECTOR_NONE(f64, double)
+
+#endif
+
+#define NETWORK_DEFINE(name, T, less)                                                                                  \
+  static inline void name##_exchange(T *const lo, T *const hi, size_t const count) {                                   \
+    for (size_t i = name##_exchange_vector(lo, hi, count); i < count; ++i) {                                           \
+      T const x = lo[i];                                                                                               \
+      T const y = hi[i];                                                                                               \
+      bool const s = less(&y, &x);                                                                                     \
+      lo[i] = s ? y : x;                                                                                               \
+      hi[i] = s ? x : y;                                                                                               \
+    }                                                                                                                  \
+  }                                                                                                                    \
+  static inline void name##_exchange_mirror(T *const lo, T *const hi_end, size_t const count) {                        \
+    for (size_t i = name##_exchange_mirror_vector(lo, hi_end, count); i < count; ++i) {                                \
+      T const x = lo[i];                                                                                               \
+      T const y = hi_end[-(ptrdiff_t)i];                                                                               \
+      bool const s = less(&y, &x);                                                                                     \
+      lo[i] = s ? y : x;                                                                                               \
+      hi_end[-(ptrdiff_t)i] = s ? x : y;                                                                               \
+    }                                                                                                                  \
+  }                                                                                                                    \
+  void ov_sort_network_##name(T *const data, size_t const n) {                                                         \
+    assert(n <= network_max && "n must not exceed 32");                                                                \
+    if (!data || n < 2 || n > network_max) {                                                                           \
+      return;                                                                                                          \
+    }                                                                                                                  \
+    for (size_t k = 2; k / 2 < n; k *= 2) {                                                                            \
+      for (size_t b = 0; b + k / 2 < n; b += k) {                                                                      \
+        size_t const skip = b + k > n ? b + k - n : 0;                                                                 \
+        name##_exchange_mirror(data + b + skip, data + b + k - 1 - skip, k / 2 - skip);                                \
+      }                                                                                                                \
+      for (size_t j = k / 4; j > 0; j /= 2) {                                                                          \
+        for (size_t b = 0; b + j < n; b += j * 2) {                                                                    \
+          size_t const count = b + j * 2 > n ? n - b - j : j;                                                          \
+          name##_exchange(data + b, data + b + j, count);                                                              \
+        }                                                                                                              \
+      }                                                                                                                \
+    }                                                                                                                  \
+  }                                                                                                                    \
+  OV_SORT_DEFINE_BASE(sort_##name, T, less, ov_sort_network_##name, network_max)                                       \
+  void ov_sort_##name(T *const data, size_t const n) { sort_##name(data, n); }
+
+NETWORK_DEFINE(i32, int32_t, LESS_SCALAR)
+NETWORK_DEFINE(u32, uint32_t, LESS_SCALAR)
+NETWORK_DEFINE(i64, int64_t, LESS_SCALAR)
+NETWORK_DEFINE(u64, uint64_t, LESS_SCALAR)
+NETWORK_DEFINE(f32, float, LESS_FLOAT)
+NETWORK_DEFINE(f64, double, LESS_FLOAT)
@@ -0,0 +1,221 @@
+#include <ovsort.h>
+
+#include <ovthreads.h>
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <string.h>
+
+// The array is cut into one part per thread and the parts are sorted concurrently with
+// ov_qsort. Sorted runs are then merged pairwise into the scratch buffer and back, round
+// by round. Each merge is split into independent pieces by binary searching the split
+// point of both runs for evenly spaced output positions (merge path), so every round
+// keeps all threads busy even when only one or two merges are left.
+
+enum {
+  default_serial_threshold = 65536,
+  max_threads = 256,
+};
+
+struct parallel_sort {
+  unsigned char *base;
+  unsigned char *scratch;
+  size_t n;
+  size_t item_size;
+  int (*compare)(void const *const a, void const *const b, void *const userdata);
+  void *userdata;
+  size_t parts;
+
+  unsigned char const *src;
+  unsigned char *dst;
+  size_t width;  // width of the runs merged in this round, in parts
+  size_t pieces; // tasks per merge
+};
+
+static inline size_t part_bound(struct parallel_sort const *const ps, size_t const part) {
+  if (part >= ps->parts) {
+    return ps->n;
+  }
+  return (ps->n / ps->parts) * part + (ps->n % ps->parts) * part / ps->parts;
+}
+
+static inline size_t split_range(size_t const len, size_t const index, size_t const count) {
+  return (len / count) * index + (len % count) * index / count;
+}
+
+static void sort_part_task(size_t const index, void *const userdata) {
+  struct parallel_sort const *const ps = (struct parallel_sort const *)userdata;
+  size_t const lo = part_bound(ps, index);
+  size_t const hi = part_bound(ps, index + 1);
+  ov_qsort(ps->base + lo * ps->item_size, hi - lo, ps->item_size, ps->compare, ps->userdata);
+}
+
+// Returns how many items of a belong in the first d items of the merged output.
+// Ties take from a first, so the merge keeps the relative order of the two runs.
+static size_t merge_split(struct parallel_sort const *const ps,
+                          unsigned char const *const a,
+                          size_t const na,
+                          unsigned char const *const b,
+                          size_t const nb,
+                          size_t const d) {
+  size_t const sz = ps->item_size;
+  size_t lo = d > nb ? d - nb : 0;
+  size_t hi = d < na ? d : na;
+  while (lo < hi) {
+    size_t const mid = lo + (hi - lo) / 2;
+    if (ps->compare(a + mid * sz, b + (d - mid - 1) * sz, ps->userdata) > 0) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
+  }
+  return lo;
+}
+
+static void merge_piece_task(size_t const index, void *const userdata) {
+  struct parallel_sort const *const ps = (struct parallel_sort const *)userdata;
+  size_t const sz = ps->item_size;
+  size_t const pair = index / ps->pieces;
+  size_t const piece = index % ps->pieces;
+  size_t const lo = part_bound(ps, pair * 2 * ps->width);
+  size_t const mid = part_bound(ps, (pair * 2 + 1) * ps->width);
+  size_t const hi = part_bound(ps, (pair * 2 + 2) * ps->width);
+  unsigned char const *const a = ps->src + lo * sz;
+  unsigned char const *const b = ps->src + mid * sz;
+  size_t const na = mid - lo;
+  size_t const nb = hi - mid;
+
+  size_t const d0 = split_range(hi - lo, piece, ps->pieces);
+  size_t const d1 = split_range(hi - lo, piece + 1, ps->pieces);
+  if (d0 == d1) {
+    return;
+  }
+  size_t i = merge_split(ps, a, na, b, nb, d0);
+  size_t j = d0 - i;
+  size_t const i1 = merge_split(ps, a, na, b, nb, d1);
+  size_t const j1 = d1 - i1;
+  unsigned char *out = ps->dst + (lo + d0) * sz;
+  while (i < i1 && j < j1) {
+    if (ps->compare(b + j * sz, a + i * sz, ps->userdata) < 0) {
+      memcpy(out, b + j++ * sz, sz);
+    } else {
+      memcpy(out, a + i++ * sz, sz);
+    }
+    out += sz;
+  }
+  if (i < i1) {
+    memcpy(out, a + i * sz, (i1 - i) * sz);
+  } else if (j < j1) {
+    memcpy(out, b + j * sz, (j1 - j) * sz);
+  }
+}
+
+static void copy_back_task(size_t const index, void *const userdata) {
+  struct parallel_sort const *const ps = (struct parallel_sort const *)userdata;
+  size_t const lo = part_bound(ps, index);
+  size_t const hi = part_bound(ps, index + 1);
+  memcpy(ps->base + lo * ps->item_size, ps->scratch + lo * ps->item_size, (hi - lo) * ps->item_size);
+}
+
+struct thread_runner {
+  void (*task)(size_t const index, void *const userdata);
+  void *userdata;
+  size_t ntasks;
+  atomic_size_t next;
+};
+
+static int thread_runner_worker(void *const userdata) {
+  struct thread_runner *const r = (struct thread_runner *)userdata;
+  for (;;) {
+    size_t const index = atomic_fetch_add_explicit(&r->next, 1, memory_order_relaxed);
+    if (index >= r->ntasks) {
+      return 0;
+    }
+    r->task(index, r->userdata);
+  }
+}
+
+// Default runner used when no executor is given. The calling thread works too, so the
+// tasks still complete if some threads cannot be created.
+static void run_on_threads(size_t const ntasks,
+                           void (*const task)(size_t const index, void *const userdata),
+                           void *const userdata,
+                           void *const executor) {
+  size_t const threads = *(size_t const *)executor;
+  struct thread_runner r = {
+      .task = task,
+      .userdata = userdata,
+      .ntasks = ntasks,
+  };
+  atomic_init(&r.next, 0);
+  thrd_t handles[max_threads];
+  size_t const extra = (threads < ntasks ? threads : ntasks) - 1;
+  size_t started = 0;
+  for (; started < extra; ++started) {
+    if (thrd_create(handles + started, thread_runner_worker, &r) != thrd_success) {
+      break;
+    }
+  }
+  thread_runner_worker(&r);
+  for (size_t i = 0; i < started; ++i) {
+    thrd_join(handles[i], NULL);
+  }
+}
+
+void ov_parallel_qsort(void *const base,
+                       size_t const n,
+                       size_t const item_size,
+                       int (*const compare)(void const *const a, void const *const b, void *const userdata),
+                       void *const userdata,
+                       struct ov_parallel_qsort_options const *const options MEM_FILEPOS_PARAMS) {
+  if (!base || !compare || !item_size || n < 2) {
+    return;
+  }
+  size_t threads = options && options->threads ? options->threads : ov_thread_hardware_concurrency();
+  if (threads > max_threads) {
+    threads = max_threads;
+  }
+  size_t const threshold =
+      options && options->serial_threshold ? options->serial_threshold : (size_t)default_serial_threshold;
+  if (threads < 2 || n < threshold || n < threads * 2) {
+    ov_qsort(base, n, item_size, compare, userdata);
+    return;
+  }
+
+  unsigned char *scratch = NULL;
+  if (!ov_mem_realloc(&scratch, n, item_size MEM_FILEPOS_VALUES_PASSTHRU)) {
+    ov_qsort(base, n, item_size, compare, userdata);
+    return;
+  }
+
+  ov_parallel_run_func const run = options && options->run ? options->run : run_on_threads;
+  void *const executor = options && options->run ? options->executor : &threads;
+  struct parallel_sort ps = {
+      .base = (unsigned char *)base,
+      .scratch = scratch,
+      .n = n,
+      .item_size = item_size,
+      .compare = compare,
+      .userdata = userdata,
+      .parts = threads,
+  };
+  run(ps.parts, sort_part_task, &ps, executor);
+
+  unsigned char *src = ps.base;
+  unsigned char *dst = ps.scratch;
+  for (size_t width = 1; width < ps.parts; width *= 2) {
+    size_t const pairs = (ps.parts + width * 2 - 1) / (width * 2);
+    ps.src = src;
+    ps.dst = dst;
+    ps.width = width;
+    ps.pieces = (threads + pairs - 1) / pairs;
+    run(pairs * ps.pieces, merge_piece_task, &ps, executor);
+    unsigned char *const tmp = src;
+    src = dst;
+    dst = tmp;
+  }
+  if (src != ps.base) {
+    run(ps.parts, copy_back_task, &ps, executor);
+  }
+  ov_mem_free(&scratch MEM_FILEPOS_VALUES_PASSTHRU);
+}
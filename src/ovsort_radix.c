@@ -0,0 +1,305 @@
+#include <ovsort.h>
+
+#include <stdbool.h>
+#include <string.h>
+
+// Radix sorts work on unsigned keys whose order matches the order of the values: signed
+// integers get their sign bit flipped, and IEEE floats additionally get every other bit
+// inverted when negative, which puts -0.0 before +0.0 and NaNs at either end by sign.
+//
+// With a scratch buffer the sort is LSD: one read pass builds the histograms of all digits at
+// once, then each digit whose value is not the same across all keys costs one scatter pass.
+// Small keys (ids, timestamps) usually skip most of the high digits this way.
+// Without a scratch buffer the sort is MSD in place (American flag sort), recursing into each
+// bucket and finishing short buckets with insertion sort. Short inputs skip both, since the
+// histogram passes alone cost more than sorting a few dozen items.
+
+enum {
+  radix_bits = 8,
+  radix_size = 1 << radix_bits,
+  radix_mask = radix_size - 1,
+  insertion_threshold = 64,
+};
+
+static inline uint32_t key_u32(uint32_t const *const p) { return *p; }
+
+static inline uint64_t key_u64(uint64_t const *const p) { return *p; }
+
+static inline uint32_t key_i32(int32_t const *const p) { return (uint32_t)*p ^ UINT32_C(0x80000000); }
+
+static inline uint64_t key_i64(int64_t const *const p) { return ov_radix_key_i64(*p); }
+
+static inline uint32_t key_f32(float const *const p) {
+  uint32_t u;
+  memcpy(&u, p, sizeof(u));
+  return (u & UINT32_C(0x80000000)) ? ~u : u | UINT32_C(0x80000000);
+}
+
+static inline uint64_t key_f64(double const *const p) { return ov_radix_key_f64(*p); }
+
+#define RADIX_DEFINE(name, T, K, key)                                                                                  \
+  static void name##_insertion(T *const data, size_t const n) {                                                        \
+    for (size_t i = 1; i < n; ++i) {                                                                                   \
+      T const v = data[i];                                                                                             \
+      K const k = key(&v);                                                                                             \
+      size_t j = i;                                                                                                    \
+      while (j > 0 && key(&data[j - 1]) > k) {                                                                         \
+        data[j] = data[j - 1];                                                                                         \
+        --j;                                                                                                           \
+      }                                                                                                                \
+      data[j] = v;                                                                                                     \
+    }                                                                                                                  \
+  }                                                                                                                    \
+  static void name##_lsd(T *const data, size_t const n, T *const scratch) {                                            \
+    size_t counts[sizeof(K)][radix_size];                                                                              \
+    memset(counts, 0, sizeof(counts));                                                                                 \
+    for (size_t i = 0; i < n; ++i) {                                                                                   \
+      K const k = key(&data[i]);                                                                                       \
+      for (size_t d = 0; d < sizeof(K); ++d) {                                                                         \
+        ++counts[d][(k >> (d * radix_bits)) & radix_mask];                                                             \
+      }                                                                                                                \
+    }                                                                                                                  \
+    T *src = data;                                                                                                     \
+    T *dst = scratch;                                                                                                  \
+    for (size_t d = 0; d < sizeof(K); ++d) {                                                                           \
+      size_t *const c = counts[d];                                                                                     \
+      unsigned const shift = (unsigned)(d * radix_bits);                                                               \
+      if (c[(key(&src[0]) >> shift) & radix_mask] == n) {                                                              \
+        continue;                                                                                                      \
+      }                                                                                                                \
+      size_t sum = 0;                                                                                                  \
+      for (size_t b = 0; b < radix_size; ++b) {                                                                        \
+        size_t const t = c[b];                                                                                         \
+        c[b] = sum;                                                                                                    \
+        sum += t;                                                                                                      \
+      }                                                                                                                \
+      for (size_t i = 0; i < n; ++i) {                                                                                 \
+        T const v = src[i];                                                                                            \
+        dst[c[(key(&v) >> shift) & radix_mask]++] = v;                                                                 \
+      }                                                                                                                \
+      T *const tmp = src;                                                                                              \
+      src = dst;                                                                                                       \
+      dst = tmp;                                                                                                       \
+    }                                                                                                                  \
+    if (src != data) {                                                                                                 \
+      memcpy(data, src, n * sizeof(T));                                                                                \
+    }                                                                                                                  \
+  }                                                                                                                    \
+  static void name##_msd(T *const data, size_t const n, unsigned shift) {                                              \
+    size_t heads[radix_size];                                                                                          \
+    size_t ends[radix_size];                                                                                           \
+    for (;;) {                                                                                                         \
+      if (n <= insertion_threshold) {                                                                                  \
+        name##_insertion(data, n);                                                                                     \
+        return;                                                                                                        \
+      }                                                                                                                \
+      memset(ends, 0, sizeof(ends));                                                                                   \
+      for (size_t i = 0; i < n; ++i) {                                                                                 \
+        ++ends[(key(&data[i]) >> shift) & radix_mask];                                                                 \
+      }                                                                                                                \
+      if (ends[(key(&data[0]) >> shift) & radix_mask] != n) {                                                          \
+        break;                                                                                                         \
+      }                                                                                                                \
+      if (shift == 0) {                                                                                                \
+        return;                                                                                                        \
+      }                                                                                                                \
+      shift -= radix_bits;                                                                                             \
+    }                                                                                                                  \
+    size_t sum = 0;                                                                                                    \
+    for (size_t b = 0; b < radix_size; ++b) {                                                                          \
+      heads[b] = sum;                                                                                                  \
+      sum += ends[b];                                                                                                  \
+      ends[b] = sum;                                                                                                   \
+    }                                                                                                                  \
+    for (size_t b = 0; b < radix_size; ++b) {                                                                          \
+      while (heads[b] < ends[b]) {                                                                                     \
+        T v = data[heads[b]];                                                                                          \
+        size_t d = (key(&v) >> shift) & radix_mask;                                                                    \
+        while (d != b) {                                                                                               \
+          T const tmp = data[heads[d]];                                                                                \
+          data[heads[d]++] = v;                                                                                        \
+          v = tmp;                                                                                                     \
+          d = (key(&v) >> shift) & radix_mask;                                                                         \
+        }                                                                                                              \
+        data[heads[b]++] = v;                                                                                          \
+      }                                                                                                                \
+    }                                                                                                                  \
+    if (shift == 0) {                                                                                                  \
+      return;                                                                                                          \
+    }                                                                                                                  \
+    size_t start = 0;                                                                                                  \
+    for (size_t b = 0; b < radix_size; ++b) {                                                                          \
+      if (ends[b] - start > 1) {                                                                                       \
+        name##_msd(data + start, ends[b] - start, shift - radix_bits);                                                 \
+      }                                                                                                                \
+      start = ends[b];                                                                                                 \
+    }                                                                                                                  \
+  }                                                                                                                    \
+  void ov_radix_sort_##name(T *const data, size_t const n, T *const scratch) {                                         \
+    if (!data || n < 2) {                                                                                              \
+      return;                                                                                                          \
+    }                                                                                                                  \
+    if (n <= insertion_threshold) {                                                                                    \
+      name##_insertion(data, n);                                                                                       \
+    } else if (scratch) {                                                                                              \
+      name##_lsd(data, n, scratch);                                                                                    \
+    } else {                                                                                                           \
+      name##_msd(data, n, (unsigned)((sizeof(K) - 1) * radix_bits));                                                   \
+    }                                                                                                                  \
+  }
+
+RADIX_DEFINE(u32, uint32_t, uint32_t, key_u32)
+RADIX_DEFINE(u64, uint64_t, uint64_t, key_u64)
+RADIX_DEFINE(i32, int32_t, uint32_t, key_i32)
+RADIX_DEFINE(i64, int64_t, uint64_t, key_i64)
+RADIX_DEFINE(f32, float, uint32_t, key_f32)
+RADIX_DEFINE(f64, double, uint64_t, key_f64)
+
+struct record_context {
+  unsigned char *base;
+  size_t item_size;
+  uint64_t (*key)(void const *const item, void *const userdata);
+  void *userdata;
+};
+
+static inline uint64_t record_key(struct record_context const *const ctx, unsigned char const *const item) {
+  return ctx->key(item, ctx->userdata);
+}
+
+static inline void swap_records(unsigned char *const a, unsigned char *const b, size_t const item_size) {
+  size_t i = 0;
+  for (; i + 8 <= item_size; i += 8) {
+    uint64_t ta, tb;
+    memcpy(&ta, a + i, 8);
+    memcpy(&tb, b + i, 8);
+    memcpy(a + i, &tb, 8);
+    memcpy(b + i, &ta, 8);
+  }
+  for (; i < item_size; ++i) {
+    unsigned char const t = a[i];
+    a[i] = b[i];
+    b[i] = t;
+  }
+}
+
+static void records_insertion(struct record_context const *const ctx, unsigned char *const data, size_t const n) {
+  size_t const sz = ctx->item_size;
+  for (size_t i = 1; i < n; ++i) {
+    uint64_t const k = record_key(ctx, data + i * sz);
+    for (size_t j = i; j > 0 && record_key(ctx, data + (j - 1) * sz) > k; --j) {
+      swap_records(data + (j - 1) * sz, data + j * sz, sz);
+    }
+  }
+}
+
+static void records_lsd(struct record_context const *const ctx, size_t const n, unsigned char *const scratch) {
+  size_t const sz = ctx->item_size;
+  size_t counts[sizeof(uint64_t)][radix_size];
+  memset(counts, 0, sizeof(counts));
+  for (size_t i = 0; i < n; ++i) {
+    uint64_t const k = record_key(ctx, ctx->base + i * sz);
+    for (size_t d = 0; d < sizeof(uint64_t); ++d) {
+      ++counts[d][(k >> (d * radix_bits)) & radix_mask];
+    }
+  }
+  unsigned char *src = ctx->base;
+  unsigned char *dst = scratch;
+  for (size_t d = 0; d < sizeof(uint64_t); ++d) {
+    size_t *const c = counts[d];
+    unsigned const shift = (unsigned)(d * radix_bits);
+    if (c[(record_key(ctx, src) >> shift) & radix_mask] == n) {
+      continue;
+    }
+    size_t sum = 0;
+    for (size_t b = 0; b < radix_size; ++b) {
+      size_t const t = c[b];
+      c[b] = sum;
+      sum += t;
+    }
+    for (size_t i = 0; i < n; ++i) {
+      unsigned char const *const item = src + i * sz;
+      memcpy(dst + c[(record_key(ctx, item) >> shift) & radix_mask]++ * sz, item, sz);
+    }
+    unsigned char *const tmp = src;
+    src = dst;
+    dst = tmp;
+  }
+  if (src != ctx->base) {
+    memcpy(ctx->base, src, n * sz);
+  }
+}
+
+static void
+records_msd(struct record_context const *const ctx, unsigned char *const data, size_t const n, unsigned shift) {
+  size_t const sz = ctx->item_size;
+  size_t heads[radix_size];
+  size_t ends[radix_size];
+  for (;;) {
+    if (n <= insertion_threshold) {
+      records_insertion(ctx, data, n);
+      return;
+    }
+    memset(ends, 0, sizeof(ends));
+    for (size_t i = 0; i < n; ++i) {
+      ++ends[(record_key(ctx, data + i * sz) >> shift) & radix_mask];
+    }
+    if (ends[(record_key(ctx, data) >> shift) & radix_mask] != n) {
+      break;
+    }
+    if (shift == 0) {
+      return;
+    }
+    shift -= radix_bits;
+  }
+  size_t sum = 0;
+  for (size_t b = 0; b < radix_size; ++b) {
+    heads[b] = sum;
+    sum += ends[b];
+    ends[b] = sum;
+  }
+  for (size_t b = 0; b < radix_size; ++b) {
+    while (heads[b] < ends[b]) {
+      unsigned char *const item = data + heads[b] * sz;
+      size_t d = (record_key(ctx, item) >> shift) & radix_mask;
+      while (d != b) {
+        swap_records(item, data + heads[d]++ * sz, sz);
+        d = (record_key(ctx, item) >> shift) & radix_mask;
+      }
+      ++heads[b];
+    }
+  }
+  if (shift == 0) {
+    return;
+  }
+  size_t start = 0;
+  for (size_t b = 0; b < radix_size; ++b) {
+    if (ends[b] - start > 1) {
+      records_msd(ctx, data + start * sz, ends[b] - start, shift - radix_bits);
+    }
+    start = ends[b];
+  }
+}
+
+void ov_radix_sort_records(void *const base,
+                           size_t const n,
+                           size_t const item_size,
+                           uint64_t (*const key)(void const *const item, void *const userdata),
+                           void *const userdata,
+                           void *const scratch) {
+  if (!base || !key || !item_size || n < 2) {
+    return;
+  }
+  struct record_context const ctx = {
+      .base = (unsigned char *)base,
+      .item_size = item_size,
+      .key = key,
+      .userdata = userdata,
+  };
+  if (n <= insertion_threshold) {
+    records_insertion(&ctx, ctx.base, n);
+  } else if (scratch) {
+    records_lsd(&ctx, n, (unsigned char *)scratch);
+  } else {
+    records_msd(&ctx, ctx.base, n, (unsigned)((sizeof(uint64_t) - 1) * radix_bits));
+  }
+}
@@ -1,11 +1,14 @@
 #include <ovtest.h>
 
 #include <ovsort.h>
+#include <ovsort_external.h>
 
+#include <math.h>
 #include <stdio.h>
 
 #include <ovarray.h>
 #include <ovrand.h>
+#include <ovthreads.h>
 
 struct sort_item {
   size_t value;
@@ -48,6 +51,7 @@ enum dataset_kind {
   dataset_kind_mostly_sorted,
   dataset_kind_reverse_sorted,
   dataset_kind_nearly_constant,
+  dataset_kind_adversary,
 };
 
 static char const *dataset_kind_name(enum dataset_kind kind) {
@@ -60,6 +64,8 @@ static char const *dataset_kind_name(enum dataset_kind kind) {
     return "reverse_sorted";
   case dataset_kind_nearly_constant:
     return "nearly_constant";
+  case dataset_kind_adversary:
+    return "adversary";
   }
 
   return "unknown";
@@ -75,6 +81,65 @@ static void dataset_rng_init(struct ov_rand_xoshiro256pp *rng, uint32_t seed) {
   ov_rand_xoshiro256pp_init(rng, mixed);
 }
 
+// McIlroy's "A Killer Adversary for Quicksort": values are decided lazily while the sort runs.
+// Every item starts as "gas" (larger than any solid value), and an item is frozen to the next
+// solid value only when the sort compares two gas items, always choosing the one that is
+// likely the pivot. The values collected this way make that sort quadratic when replayed.
+struct adversary {
+  size_t *values; // indexed by item id
+  size_t gas;
+  size_t nsolid;
+  size_t candidate;
+  size_t comparisons;
+};
+
+static int adversary_compare_ids(struct adversary *const adv, size_t const x, size_t const y) {
+  ++adv->comparisons;
+  if (adv->values[x] == adv->gas && adv->values[y] == adv->gas) {
+    adv->values[x == adv->candidate ? x : y] = adv->nsolid++;
+  }
+  if (adv->values[x] == adv->gas) {
+    adv->candidate = x;
+  } else if (adv->values[y] == adv->gas) {
+    adv->candidate = y;
+  }
+  return adv->values[x] < adv->values[y] ? -1 : adv->values[x] > adv->values[y] ? 1 : 0;
+}
+
+struct adversary_context {
+  struct adversary *adv;
+  size_t *ids;
+};
+
+static int adversary_compare(size_t idx0, size_t idx1, void *userdata) {
+  struct adversary_context const *const ctx = (struct adversary_context const *)userdata;
+  return adversary_compare_ids(ctx->adv, ctx->ids[idx0], ctx->ids[idx1]);
+}
+
+static void adversary_swap(size_t idx0, size_t idx1, void *userdata) {
+  struct adversary_context const *const ctx = (struct adversary_context const *)userdata;
+  size_t const tmp = ctx->ids[idx0];
+  ctx->ids[idx0] = ctx->ids[idx1];
+  ctx->ids[idx1] = tmp;
+}
+
+static void adversary_init(struct adversary *const adv, size_t *const values, size_t *const ids, size_t const count) {
+  *adv = (struct adversary){.values = values, .gas = count};
+  for (size_t i = 0; i < count; ++i) {
+    values[i] = count;
+    ids[i] = i;
+  }
+}
+
+// Items that were never compared against another gas item still hold gas; give them distinct values.
+static void adversary_finish(struct adversary *const adv, size_t const count) {
+  for (size_t i = 0; i < count; ++i) {
+    if (adv->values[i] == adv->gas) {
+      adv->values[i] = adv->nsolid++;
+    }
+  }
+}
+
 static void fill_dataset(struct sort_item *items, size_t count, enum dataset_kind kind, uint32_t seed) {
   for (size_t i = 0; i < count; ++i) {
     items[i].original_index = i;
@@ -135,6 +200,32 @@ static void fill_dataset(struct sort_item *items, size_t count, enum dataset_kin
       items[i].value = count - i - 1;
     }
     return;
+  case dataset_kind_adversary: {
+    // Killer input for the plain median-of-three quicksort in ovsort_old.c.
+    size_t *values = NULL;
+    size_t *ids = NULL;
+    bool ok = OV_ARRAY_GROW(&values, count);
+    ok = ok && OV_ARRAY_GROW(&ids, count);
+    if (ok) {
+      struct adversary adv;
+      adversary_init(&adv, values, ids, count);
+      old_ov_sort(count, adversary_compare, adversary_swap, &(struct adversary_context){.adv = &adv, .ids = ids});
+      adversary_finish(&adv, count);
+      for (size_t i = 0; i < count; ++i) {
+        items[i].value = values[i];
+      }
+    }
+    if (ids) {
+      OV_ARRAY_DESTROY(&ids);
+    }
+    if (values) {
+      OV_ARRAY_DESTROY(&values);
+    }
+    if (ok) {
+      return;
+    }
+    break;
+  }
   }
 
   memset(items, 0, count * sizeof(*items));
@@ -270,6 +361,774 @@ static void test_ov_sort_matches_large_datasets(void) {
   }
 }
 
+static int byte_compare(void const *const a, void const *const b, void *const userdata) {
+  (void)userdata;
+  return (int)*(unsigned char const *)a - (int)*(unsigned char const *)b;
+}
+
+static void test_ov_qsort_item_sizes(void) {
+  static size_t const sizes[] = {1, 2, 3, 4, 5, 8, 12, 16, 24, 32, 40, 48, 64, 72};
+  enum { count = 500 };
+
+  unsigned char *items = NULL;
+  TEST_ASSERT(OV_ARRAY_GROW(&items, count * 72));
+
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+    size_t const item_size = sizes[s];
+    TEST_CASE_("item_size=%zu", item_size);
+    // Every byte of a record repeats its key, so a torn swap shows up as a mixed record.
+    struct ov_rand_xoshiro256pp rng;
+    dataset_rng_init(&rng, (uint32_t)item_size);
+    for (size_t i = 0; i < count; ++i) {
+      memset(items + i * item_size, (int)(ov_rand_xoshiro256pp_next(&rng) & 0xff), item_size);
+    }
+    ov_qsort(items, count, item_size, byte_compare, NULL);
+    for (size_t i = 0; i < count; ++i) {
+      unsigned char const *const item = items + i * item_size;
+      bool ok = i == 0 || item[-(ptrdiff_t)item_size] <= item[0];
+      for (size_t j = 1; j < item_size; ++j) {
+        ok = ok && item[j] == item[0];
+      }
+      if (!TEST_CHECK_(ok, "record %zu is out of order or corrupted", i)) {
+        break;
+      }
+    }
+  }
+  TEST_CASE_(NULL);
+
+  OV_ARRAY_DESTROY(&items);
+}
+
+#define sort_item_less(a, b)                                                                                           \
+  ((a)->value < (b)->value || ((a)->value == (b)->value && (a)->original_index < (b)->original_index))
+OV_SORT_DEFINE(typed_sort_items, struct sort_item, sort_item_less)
+
+#define u32_less(a, b) (*(a) < *(b))
+OV_SORT_DEFINE(typed_sort_u32, uint32_t, u32_less)
+
+static void test_ov_sort_define(void) {
+  static enum dataset_kind const kinds[] = {
+      dataset_kind_random,
+      dataset_kind_mostly_sorted,
+      dataset_kind_reverse_sorted,
+      dataset_kind_nearly_constant,
+  };
+  static size_t const counts[] = {0, 1, 2, 3, 16, 17, 100, 1000, 5000};
+
+  struct sort_item *baseline = NULL;
+  struct sort_item *typed = NULL;
+  bool ok = OV_ARRAY_GROW(&baseline, 5001);
+  ok = ok && OV_ARRAY_GROW(&typed, 5001);
+  TEST_ASSERT(ok);
+
+  for (size_t k = 0; k < sizeof(kinds) / sizeof(kinds[0]); ++k) {
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+      size_t const count = counts[c];
+      TEST_CASE_("kind=%s size=%zu", dataset_kind_name(kinds[k]), count);
+      fill_dataset(baseline, count, kinds[k], (uint32_t)(k * 31 + c));
+      if (count) {
+        memcpy(typed, baseline, count * sizeof(*typed));
+      }
+      old_ov_sort(count, compare_items, swap_items, baseline);
+      typed_sort_items(typed, count);
+      TEST_CHECK(count == 0 || memcmp(baseline, typed, count * sizeof(*typed)) == 0);
+    }
+  }
+  TEST_CASE_(NULL);
+
+  {
+    // many duplicates
+    uint32_t values[1000];
+    for (size_t i = 0; i < 1000; ++i) {
+      values[i] = (uint32_t)((i * 7919) % 5);
+    }
+    typed_sort_u32(values, 1000);
+    for (size_t i = 1; i < 1000; ++i) {
+      if (!TEST_CHECK(values[i - 1] <= values[i])) {
+        break;
+      }
+    }
+    TEST_CHECK(values[0] == 0 && values[999] == 4);
+  }
+
+  OV_ARRAY_DESTROY(&typed);
+  OV_ARRAY_DESTROY(&baseline);
+}
+
+static struct adversary *typed_adversary;
+#define adversary_less(a, b) (adversary_compare_ids(typed_adversary, *(a), *(b)) < 0)
+OV_SORT_DEFINE(typed_sort_adversary, size_t, adversary_less)
+
+static void test_ov_sort_adversary(void) {
+  static size_t const counts[] = {100, 1000, 20000};
+
+  size_t *values = NULL;
+  size_t *ids = NULL;
+  bool ok = OV_ARRAY_GROW(&values, 20000);
+  ok = ok && OV_ARRAY_GROW(&ids, 20000);
+  TEST_ASSERT(ok);
+
+  for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+    size_t const count = counts[c];
+    size_t log2 = 0;
+    while ((size_t)1 << (log2 + 1) <= count) {
+      ++log2;
+    }
+    // 2*log2(n) partitioning levels plus heapsort stay well below this; a quadratic sort does not.
+    size_t const bound = 6 * count * log2;
+
+    for (int typed = 0; typed < 2; ++typed) {
+      TEST_CASE_("%s size=%zu", typed ? "OV_SORT_DEFINE" : "ov_sort", count);
+      struct adversary adv;
+      adversary_init(&adv, values, ids, count);
+      if (typed) {
+        typed_adversary = &adv;
+        typed_sort_adversary(ids, count);
+      } else {
+        ov_sort(count, adversary_compare, adversary_swap, &(struct adversary_context){.adv = &adv, .ids = ids});
+      }
+      TEST_CHECK(adv.comparisons <= bound);
+      TEST_MSG("comparisons=%zu bound=%zu", adv.comparisons, bound);
+      for (size_t i = 1; i < count; ++i) {
+        if (!TEST_CHECK(values[ids[i - 1]] <= values[ids[i]])) {
+          break;
+        }
+      }
+    }
+  }
+  TEST_CASE_(NULL);
+
+  OV_ARRAY_DESTROY(&ids);
+  OV_ARRAY_DESTROY(&values);
+}
+
+struct stable_context {
+  struct sort_item *items;
+  size_t comparisons;
+};
+
+static int stable_compare(size_t idx0, size_t idx1, void *userdata) {
+  struct stable_context *const ctx = (struct stable_context *)userdata;
+  ++ctx->comparisons;
+  size_t const a = ctx->items[idx0].value;
+  size_t const b = ctx->items[idx1].value;
+  return a < b ? -1 : a > b ? 1 : 0;
+}
+
+static void stable_swap(size_t idx0, size_t idx1, void *userdata) {
+  struct stable_context const *const ctx = (struct stable_context const *)userdata;
+  swap_items(idx0, idx1, ctx->items);
+}
+
+static int stable_qsort_compare(void const *const a, void const *const b, void *const userdata) {
+  size_t *const comparisons = (size_t *)userdata;
+  ++*comparisons;
+  size_t const va = ((struct sort_item const *)a)->value;
+  size_t const vb = ((struct sort_item const *)b)->value;
+  return va < vb ? -1 : va > vb ? 1 : 0;
+}
+
+static bool is_stably_sorted(struct sort_item const *const items, size_t const count) {
+  for (size_t i = 1; i < count; ++i) {
+    if (items[i - 1].value > items[i].value ||
+        (items[i - 1].value == items[i].value && items[i - 1].original_index > items[i].original_index)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void test_ov_stable_sort(void) {
+  static enum dataset_kind const kinds[] = {
+      dataset_kind_random,
+      dataset_kind_mostly_sorted,
+      dataset_kind_reverse_sorted,
+      dataset_kind_nearly_constant,
+  };
+  static size_t const counts[] = {0, 1, 2, 31, 32, 33, 100, 1000, 10000};
+  enum { max_count = 10000 };
+
+  struct sort_item *items = NULL;
+  struct sort_item *scratch = NULL;
+  bool ok = OV_ARRAY_GROW(&items, max_count);
+  ok = ok && OV_ARRAY_GROW(&scratch, max_count / 2);
+  TEST_ASSERT(ok);
+
+  for (size_t k = 0; k < sizeof(kinds) / sizeof(kinds[0]); ++k) {
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+      size_t const count = counts[c];
+      // variant 0: callbacks, 1: no scratch, 2: small scratch, 3: full scratch
+      for (int variant = 0; variant < 4; ++variant) {
+        TEST_CASE_("kind=%s size=%zu variant=%d", dataset_kind_name(kinds[k]), count, variant);
+        fill_dataset(items, count, kinds[k], (uint32_t)(k * 131 + c));
+        // Fold values into a small range so there are plenty of ties to keep in order.
+        for (size_t i = 0; i < count; ++i) {
+          items[i].value %= 97;
+        }
+        if (variant == 0) {
+          ov_stable_sort(count, stable_compare, stable_swap, &(struct stable_context){.items = items});
+        } else {
+          size_t comparisons = 0;
+          size_t const scratch_items = variant == 1 ? 0 : variant == 2 ? 5 : count / 2;
+          size_t const scratch_bytes = scratch_items * sizeof(*scratch);
+          ov_stable_qsort(items, count, sizeof(*items), stable_qsort_compare, &comparisons, scratch, scratch_bytes);
+        }
+        TEST_CHECK(is_stably_sorted(items, count));
+      }
+    }
+  }
+  TEST_CASE_(NULL);
+
+  {
+    // Presorted and strictly descending input is recognized as a single run.
+    enum { n = 10000 };
+    struct stable_context ctx = {.items = items};
+    for (size_t i = 0; i < n; ++i) {
+      items[i] = (struct sort_item){.value = i / 3, .original_index = i};
+    }
+    ov_stable_sort(n, stable_compare, stable_swap, &ctx);
+    TEST_CHECK(is_stably_sorted(items, n));
+    TEST_CHECK(ctx.comparisons < n);
+    TEST_MSG("comparisons=%zu", ctx.comparisons);
+
+    ctx.comparisons = 0;
+    for (size_t i = 0; i < n; ++i) {
+      items[i] = (struct sort_item){.value = n - i, .original_index = i};
+    }
+    ov_stable_sort(n, stable_compare, stable_swap, &ctx);
+    TEST_CHECK(is_stably_sorted(items, n));
+    TEST_CHECK(ctx.comparisons < n);
+    TEST_MSG("comparisons=%zu", ctx.comparisons);
+
+    // A few appended items are merged in with binary searches rather than a full pass.
+    size_t comparisons = 0;
+    for (size_t i = 0; i < n; ++i) {
+      items[i] = (struct sort_item){.value = i < n - 10 ? i * 2 : (n - i) * 1000, .original_index = i};
+    }
+    ov_stable_qsort(items, n, sizeof(*items), stable_qsort_compare, &comparisons, scratch, 16 * sizeof(*scratch));
+    TEST_CHECK(is_stably_sorted(items, n));
+    TEST_CHECK(comparisons < n * 2);
+    TEST_MSG("comparisons=%zu", comparisons);
+  }
+
+  OV_ARRAY_DESTROY(&scratch);
+  OV_ARRAY_DESTROY(&items);
+}
+
+static void test_ov_nth_element(void) {
+  static enum dataset_kind const kinds[] = {
+      dataset_kind_random,
+      dataset_kind_mostly_sorted,
+      dataset_kind_reverse_sorted,
+      dataset_kind_nearly_constant,
+      dataset_kind_adversary,
+  };
+  static size_t const counts[] = {1, 2, 16, 17, 100, 1000, 10000};
+  enum { max_count = 10000, selection_count = 100000 };
+
+  struct sort_item *items = NULL;
+  struct sort_item *sorted = NULL;
+  bool ok = OV_ARRAY_GROW(&items, selection_count);
+  ok = ok && OV_ARRAY_GROW(&sorted, max_count);
+  TEST_ASSERT(ok);
+
+  for (size_t k = 0; k < sizeof(kinds) / sizeof(kinds[0]); ++k) {
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+      size_t const count = counts[c];
+      size_t const positions[] = {0, count / 4, count / 2, count - 1};
+      for (size_t p = 0; p < sizeof(positions) / sizeof(positions[0]); ++p) {
+        size_t const nth = positions[p];
+        TEST_CASE_("kind=%s size=%zu nth=%zu", dataset_kind_name(kinds[k]), count, nth);
+        fill_dataset(sorted, count, kinds[k], (uint32_t)(k * 17 + c));
+        memcpy(items, sorted, count * sizeof(*items));
+        ov_sort(count, compare_items, swap_items, sorted);
+
+        ov_nth_element(count, nth, compare_items, swap_items, items);
+        TEST_CHECK(items[nth].value == sorted[nth].value && items[nth].original_index == sorted[nth].original_index);
+        bool partitioned = true;
+        for (size_t i = 0; i < count; ++i) {
+          int const r = compare_items(i, nth, items);
+          partitioned = partitioned && (i < nth ? r <= 0 : r >= 0);
+        }
+        TEST_CHECK(partitioned);
+
+        fill_dataset(items, count, kinds[k], (uint32_t)(k * 17 + c));
+        size_t const top = count / 3 + 1;
+        ov_partial_sort(count, top, compare_items, swap_items, items);
+        TEST_CHECK(memcmp(items, sorted, top * sizeof(*items)) == 0);
+      }
+    }
+  }
+  TEST_CASE_(NULL);
+
+  {
+    // Selection must stay linear for nth_element and O(n log k) for partial sort.
+    enum { n = selection_count, k = 100 };
+    struct stable_context ctx = {.items = items};
+    fill_dataset(items, n, dataset_kind_random, 7);
+    ov_nth_element(n, n / 2, stable_compare, stable_swap, &ctx);
+    TEST_CHECK(ctx.comparisons < (size_t)n * 6);
+    TEST_MSG("nth_element comparisons=%zu", ctx.comparisons);
+
+    ctx.comparisons = 0;
+    fill_dataset(items, n, dataset_kind_random, 8);
+    ov_partial_sort(n, k, stable_compare, stable_swap, &ctx);
+    TEST_CHECK(ctx.comparisons < (size_t)n * 2);
+    TEST_MSG("partial_sort comparisons=%zu", ctx.comparisons);
+  }
+
+  OV_ARRAY_DESTROY(&sorted);
+  OV_ARRAY_DESTROY(&items);
+}
+
+static int topk_compare_desc(void const *const a, void const *const b, void *const userdata) {
+  size_t *const comparisons = (size_t *)userdata;
+  ++*comparisons;
+  struct sort_item const *const ia = (struct sort_item const *)a;
+  struct sort_item const *const ib = (struct sort_item const *)b;
+  if (ia->value != ib->value) {
+    return ia->value > ib->value ? -1 : 1;
+  }
+  return ia->original_index < ib->original_index ? -1 : ia->original_index > ib->original_index ? 1 : 0;
+}
+
+static void test_ov_topk(void) {
+  enum { n = 100000, k = 100 };
+  struct sort_item *items = NULL;
+  struct sort_item *best = NULL;
+  bool ok = OV_ARRAY_GROW(&items, n);
+  ok = ok && OV_ARRAY_GROW(&best, k);
+  TEST_ASSERT(ok);
+
+  size_t comparisons = 0;
+  struct ov_topk tk;
+  ov_topk_init(&tk, best, k, sizeof(*best), topk_compare_desc, &comparisons);
+  TEST_CHECK(ov_topk_threshold(&tk) == NULL);
+
+  // Fewer items than capacity are all kept.
+  fill_dataset(items, n, dataset_kind_random, 11);
+  for (size_t i = 0; i < 10; ++i) {
+    TEST_CHECK(ov_topk_push(&tk, &items[i]));
+  }
+  TEST_CHECK(ov_topk_finish(&tk) == 10);
+  for (size_t i = 1; i < 10; ++i) {
+    TEST_CHECK(topk_compare_desc(&best[i - 1], &best[i], &comparisons) < 0);
+  }
+
+  comparisons = 0;
+  for (size_t i = 0; i < n; ++i) {
+    ov_topk_push(&tk, &items[i]);
+  }
+  TEST_CHECK(ov_topk_threshold(&tk) != NULL);
+  TEST_CHECK(comparisons < (size_t)n * 2);
+  TEST_MSG("comparisons=%zu", comparisons);
+  TEST_CHECK(ov_topk_finish(&tk) == k);
+
+  ov_qsort(items, n, sizeof(*items), topk_compare_desc, &comparisons);
+  TEST_CHECK(memcmp(items, best, k * sizeof(*best)) == 0);
+
+  OV_ARRAY_DESTROY(&best);
+  OV_ARRAY_DESTROY(&items);
+}
+
+static int compare_values(void const *const a, void const *const b, void *const userdata) {
+  (void)userdata;
+  size_t const va = ((struct sort_item const *)a)->value;
+  size_t const vb = ((struct sort_item const *)b)->value;
+  return (va > vb) - (va < vb);
+}
+
+struct wide_record {
+  size_t value;
+  unsigned char payload[1016];
+};
+
+static int compare_wide_records(void const *const a, void const *const b, void *const userdata) {
+  (void)userdata;
+  size_t const va = ((struct wide_record const *)a)->value;
+  size_t const vb = ((struct wide_record const *)b)->value;
+  return (va > vb) - (va < vb);
+}
+
+static void test_ov_argsort(void) {
+  static enum dataset_kind const kinds[] = {
+      dataset_kind_random,
+      dataset_kind_reverse_sorted,
+      dataset_kind_nearly_constant,
+  };
+  static size_t const counts[] = {0, 1, 2, 17, 1000, 10000};
+  enum { max_count = 10000 };
+
+  struct sort_item *items = NULL;
+  struct sort_item *original = NULL;
+  uint32_t *ids = NULL;
+  size_t *perm = NULL;
+  uint32_t *perm32 = NULL;
+  bool ok = OV_ARRAY_GROW(&items, max_count);
+  ok = ok && OV_ARRAY_GROW(&original, max_count);
+  ok = ok && OV_ARRAY_GROW(&ids, max_count);
+  ok = ok && OV_ARRAY_GROW(&perm, max_count);
+  ok = ok && OV_ARRAY_GROW(&perm32, max_count);
+  TEST_ASSERT(ok);
+
+  for (size_t k = 0; k < sizeof(kinds) / sizeof(kinds[0]); ++k) {
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+      size_t const count = counts[c];
+      TEST_CASE_("kind=%s size=%zu", dataset_kind_name(kinds[k]), count);
+      fill_dataset(original, count, kinds[k], (uint32_t)(k * 13 + c));
+      for (size_t i = 0; i < count; ++i) {
+        original[i].value %= 97;
+        ids[i] = (uint32_t)(i * 7);
+      }
+
+      memcpy(items, original, count * sizeof(*items));
+      ov_argsort(perm, count, items, sizeof(*items), compare_values, NULL);
+      ov_argsort_u32(perm32, count, items, sizeof(*items), compare_values, NULL);
+      bool same = true;
+      for (size_t i = 0; i < count; ++i) {
+        same = same && perm[i] == perm32[i];
+      }
+      TEST_CHECK(same);
+      // Sorting the index array must not touch the items.
+      TEST_CHECK(memcmp(items, original, count * sizeof(*items)) == 0);
+
+      ov_apply_permutation(perm,
+                           count,
+                           (struct ov_permute_array[]){
+                               {items, sizeof(*items)},
+                               {ids, sizeof(*ids)},
+                           },
+                           2);
+      TEST_CHECK(is_stably_sorted(items, count));
+      bool follows = true;
+      bool identity = true;
+      for (size_t i = 0; i < count; ++i) {
+        follows = follows && ids[i] == items[i].original_index * 7;
+        identity = identity && perm[i] == i;
+      }
+      TEST_CHECK(follows);
+      TEST_CHECK(identity);
+
+      memcpy(items, original, count * sizeof(*items));
+      ov_apply_permutation_u32(perm32, count, &(struct ov_permute_array){items, sizeof(*items)}, 1);
+      TEST_CHECK(is_stably_sorted(items, count));
+    }
+  }
+  TEST_CASE_(NULL);
+
+  {
+    // Items too large for the stack buffer are moved with swaps.
+    enum { n = 257, big = 5000 };
+    unsigned char *blobs = NULL;
+    ok = OV_ARRAY_GROW(&blobs, n * big);
+    TEST_ASSERT(ok);
+    for (size_t i = 0; i < n; ++i) {
+      perm[i] = (i * 100) % n;
+      memset(blobs + i * big, (int)(i & 0xff), big);
+    }
+    ov_apply_permutation(perm, n, &(struct ov_permute_array){blobs, big}, 1);
+    bool moved = true;
+    for (size_t i = 0; i < n; ++i) {
+      unsigned char const expected = (unsigned char)(((i * 100) % n) & 0xff);
+      moved = moved && blobs[i * big] == expected && blobs[i * big + big - 1] == expected;
+    }
+    TEST_CHECK(moved);
+    OV_ARRAY_DESTROY(&blobs);
+  }
+
+  OV_ARRAY_DESTROY(&perm32);
+  OV_ARRAY_DESTROY(&perm);
+  OV_ARRAY_DESTROY(&ids);
+  OV_ARRAY_DESTROY(&original);
+  OV_ARRAY_DESTROY(&items);
+}
+
+static void test_ov_sort_network(void) {
+  // 0-1 principle: a comparator network that sorts every 0/1 input sorts every input.
+  for (size_t n = 0; n <= 16; ++n) {
+    bool ok = true;
+    for (uint32_t bits = 0; ok && bits < (UINT32_C(1) << n); ++bits) {
+      int32_t data[16];
+      int ones = 0;
+      for (size_t i = 0; i < n; ++i) {
+        data[i] = (int32_t)((bits >> i) & 1);
+        ones += data[i];
+      }
+      ov_sort_network_i32(data, n);
+      for (size_t i = 0; i < n; ++i) {
+        ok = ok && data[i] == (i >= n - (size_t)ones ? 1 : 0);
+      }
+    }
+    TEST_CHECK_(ok, "0-1 inputs n=%zu", n);
+  }
+
+  struct ov_rand_xoshiro256pp rng;
+  ov_rand_xoshiro256pp_init(&rng, 42);
+  for (size_t n = 0; n <= 32; ++n) {
+    for (int round = 0; round < 200; ++round) {
+      int64_t i64[32];
+      uint64_t u64[32];
+      double f64[32];
+      float f32[32];
+      uint64_t expected[32];
+      for (size_t i = 0; i < n; ++i) {
+        uint64_t const r = ov_rand_xoshiro256pp_next(&rng);
+        u64[i] = round & 1 ? r % 5 : r;
+        i64[i] = (int64_t)u64[i];
+        f64[i] = (double)i64[i];
+        f32[i] = (float)(int32_t)(r >> 40) - 1000.0f;
+        expected[i] = u64[i];
+      }
+      ov_sort_u64(expected, n);
+      ov_sort_network_u64(u64, n);
+      TEST_CHECK_(memcmp(u64, expected, n * sizeof(*u64)) == 0, "u64 n=%zu", n);
+      ov_sort_network_i64(i64, n);
+      ov_sort_network_f64(f64, n);
+      ov_sort_network_f32(f32, n);
+      bool sorted = true;
+      for (size_t i = 1; i < n; ++i) {
+        sorted = sorted && i64[i - 1] <= i64[i] && f64[i - 1] <= f64[i] && f32[i - 1] <= f32[i];
+      }
+      TEST_CHECK_(sorted, "signed and float n=%zu", n);
+    }
+  }
+
+  {
+    // NaNs go last and no element is lost.
+    float data[] = {3.0f, NAN, -1.0f, NAN, 2.0f, -INFINITY, 0.0f};
+    float const numbers[] = {-INFINITY, -1.0f, 0.0f, 2.0f, 3.0f};
+    ov_sort_network_f32(data, 7);
+    TEST_CHECK(memcmp(data, numbers, sizeof(numbers)) == 0);
+    TEST_CHECK(isnan(data[5]) && isnan(data[6]));
+  }
+
+  {
+    enum { n = 100000 };
+    int32_t *data = NULL;
+    double *fdata = NULL;
+    bool ok = OV_ARRAY_GROW(&data, n);
+    ok = ok && OV_ARRAY_GROW(&fdata, n);
+    TEST_ASSERT(ok);
+    for (int kind = 0; kind < 3; ++kind) {
+      for (size_t i = 0; i < n; ++i) {
+        uint64_t const r = ov_rand_xoshiro256pp_next(&rng);
+        data[i] = kind == 0 ? (int32_t)r : kind == 1 ? (int32_t)(r % 16) : (int32_t)(n - i);
+        fdata[i] = (i % 1000 == 0) ? NAN : (double)data[i] / 3.0;
+      }
+      ov_sort_i32(data, n);
+      ov_sort_f64(fdata, n);
+      bool sorted = true;
+      for (size_t i = 1; i < n; ++i) {
+        sorted = sorted && data[i - 1] <= data[i];
+      }
+      TEST_CHECK_(sorted, "ov_sort_i32 kind=%d", kind);
+      size_t const numbers = n - n / 1000;
+      sorted = true;
+      for (size_t i = 1; i < n; ++i) {
+        sorted = sorted && (i < numbers ? fdata[i - 1] <= fdata[i] : isnan(fdata[i]));
+      }
+      TEST_CHECK_(sorted, "ov_sort_f64 kind=%d", kind);
+    }
+    OV_ARRAY_DESTROY(&fdata);
+    OV_ARRAY_DESTROY(&data);
+  }
+}
+
+static inline uint64_t radix_key_u32(uint32_t const v) { return v; }
+static inline uint64_t radix_key_u64(uint64_t const v) { return v; }
+static inline uint64_t radix_key_i32(int32_t const v) { return ov_radix_key_i64(v); }
+static inline uint64_t radix_key_i64(int64_t const v) { return ov_radix_key_i64(v); }
+static inline uint64_t radix_key_f32(float const v) {
+  uint32_t u;
+  memcpy(&u, &v, sizeof(u));
+  return (u & UINT32_C(0x80000000)) ? ~u : u | UINT32_C(0x80000000);
+}
+static inline uint64_t radix_key_f64(double const v) { return ov_radix_key_f64(v); }
+
+// Fills data with values of the requested kind, sorts it and checks the result against
+// qsort ordered by the same key. Values come from raw random bits, so floats include
+// infinities, NaNs and both zeros.
+#define RADIX_TEST_DEFINE(name, T, bits_type)                                                                          \
+  static int radix_compare_##name(void const *const a, void const *const b) {                                          \
+    uint64_t const ka = radix_key_##name(*(T const *)a);                                                               \
+    uint64_t const kb = radix_key_##name(*(T const *)b);                                                               \
+    return ka < kb ? -1 : ka > kb ? 1 : 0;                                                                             \
+  }                                                                                                                    \
+  static bool radix_check_##name(size_t const n, int const range, bool const use_scratch, uint32_t const seed) {       \
+    T *data = NULL;                                                                                                    \
+    T *expected = NULL;                                                                                                \
+    T *scratch = NULL;                                                                                                 \
+    bool ok = OV_ARRAY_GROW(&data, n + 1) && OV_ARRAY_GROW(&expected, n + 1) && OV_ARRAY_GROW(&scratch, n + 1);        \
+    if (ok) {                                                                                                          \
+      struct ov_rand_xoshiro256pp rng;                                                                                 \
+      ov_rand_xoshiro256pp_init(&rng, seed);                                                                           \
+      for (size_t i = 0; i < n; ++i) {                                                                                 \
+        uint64_t r = ov_rand_xoshiro256pp_next(&rng);                                                                  \
+        if (range == 1) {                                                                                              \
+          r %= 1000;                                                                                                   \
+        } else if (range == 2) {                                                                                       \
+          r = 42;                                                                                                      \
+        }                                                                                                              \
+        bits_type const b = (bits_type)r;                                                                              \
+        memcpy(&data[i], &b, sizeof(T));                                                                               \
+      }                                                                                                                \
+      memcpy(expected, data, n * sizeof(T));                                                                           \
+      qsort(expected, n, sizeof(T), radix_compare_##name);                                                             \
+      ov_radix_sort_##name(data, n, use_scratch ? scratch : NULL);                                                     \
+      for (size_t i = 0; ok && i < n; ++i) {                                                                           \
+        ok = radix_key_##name(data[i]) == radix_key_##name(expected[i]);                                               \
+      }                                                                                                                \
+    }                                                                                                                  \
+    if (scratch) {                                                                                                     \
+      OV_ARRAY_DESTROY(&scratch);                                                                                      \
+    }                                                                                                                  \
+    if (expected) {                                                                                                    \
+      OV_ARRAY_DESTROY(&expected);                                                                                     \
+    }                                                                                                                  \
+    if (data) {                                                                                                        \
+      OV_ARRAY_DESTROY(&data);                                                                                         \
+    }                                                                                                                  \
+    return ok;                                                                                                         \
+  }
+
+RADIX_TEST_DEFINE(u32, uint32_t, uint32_t)
+RADIX_TEST_DEFINE(u64, uint64_t, uint64_t)
+RADIX_TEST_DEFINE(i32, int32_t, uint32_t)
+RADIX_TEST_DEFINE(i64, int64_t, uint64_t)
+RADIX_TEST_DEFINE(f32, float, uint32_t)
+RADIX_TEST_DEFINE(f64, double, uint64_t)
+
+// The network orders all NaNs last and treats both zeros as equal.
+static inline uint64_t network_key_i32(int32_t const v) { return radix_key_i32(v); }
+static inline uint64_t network_key_u32(uint32_t const v) { return radix_key_u32(v); }
+static inline uint64_t network_key_i64(int64_t const v) { return radix_key_i64(v); }
+static inline uint64_t network_key_u64(uint64_t const v) { return radix_key_u64(v); }
+static inline uint64_t network_key_f32(float const v) { return isnan(v) ? UINT64_MAX : radix_key_f32(v + 0.0f); }
+static inline uint64_t network_key_f64(double const v) { return isnan(v) ? UINT64_MAX : radix_key_f64(v + 0.0); }
+
+// Raw random bits reach the sign bits that the SSE2 kernels bias for unsigned compares,
+// and n from 0 to 32 covers whole vectors, scalar remainders and both together.
+#define NETWORK_TEST_DEFINE(name, T, bits_type)                                                                        \
+  static bool network_check_##name(size_t const n, bool const small_range, uint32_t const seed) {                      \
+    T data[32];                                                                                                        \
+    uint64_t expected[32];                                                                                             \
+    struct ov_rand_xoshiro256pp rng;                                                                                   \
+    ov_rand_xoshiro256pp_init(&rng, seed);                                                                             \
+    for (size_t i = 0; i < n; ++i) {                                                                                   \
+      uint64_t const r = ov_rand_xoshiro256pp_next(&rng);                                                              \
+      bits_type const b = (bits_type)(small_range ? r % 5 : r);                                                        \
+      memcpy(&data[i], &b, sizeof(T));                                                                                 \
+      expected[i] = network_key_##name(data[i]);                                                                       \
+    }                                                                                                                  \
+    ov_sort_u64(expected, n);                                                                                          \
+    ov_sort_network_##name(data, n);                                                                                   \
+    bool ok = true;                                                                                                    \
+    for (size_t i = 0; ok && i < n; ++i) {                                                                             \
+      ok = network_key_##name(data[i]) == expected[i];                                                                 \
+    }                                                                                                                  \
+    return ok;                                                                                                         \
+  }
+
+NETWORK_TEST_DEFINE(i32, int32_t, uint32_t)
+NETWORK_TEST_DEFINE(u32, uint32_t, uint32_t)
+NETWORK_TEST_DEFINE(i64, int64_t, uint64_t)
+NETWORK_TEST_DEFINE(u64, uint64_t, uint64_t)
+NETWORK_TEST_DEFINE(f32, float, uint32_t)
+NETWORK_TEST_DEFINE(f64, double, uint64_t)
+
+static void test_ov_sort_network_vector(void) {
+  for (size_t n = 0; n <= 32; ++n) {
+    for (int small_range = 0; small_range < 2; ++small_range) {
+      bool ok = true;
+      for (uint32_t seed = 0; seed < 50; ++seed) {
+        ok = ok && network_check_i32(n, small_range, seed);
+        ok = ok && network_check_u32(n, small_range, seed);
+        ok = ok && network_check_i64(n, small_range, seed);
+        ok = ok && network_check_u64(n, small_range, seed);
+        ok = ok && network_check_f32(n, small_range, seed);
+        ok = ok && network_check_f64(n, small_range, seed);
+      }
+      TEST_CHECK_(ok, "n=%zu small_range=%d", n, small_range);
+    }
+  }
+}
+
+struct radix_record {
+  int64_t key;
+  size_t original_index;
+};
+
+static uint64_t radix_record_key(void const *const item, void *const userdata) {
+  (void)userdata;
+  return ov_radix_key_i64(((struct radix_record const *)item)->key);
+}
+
+static void test_ov_radix_sort(void) {
+  static size_t const counts[] = {0, 1, 2, 63, 64, 65, 1000, 100000};
+  static char const *const range_names[] = {"full", "small", "constant"};
+
+  for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+    for (int range = 0; range < 3; ++range) {
+      for (int use_scratch = 0; use_scratch < 2; ++use_scratch) {
+        size_t const n = counts[c];
+        uint32_t const seed = (uint32_t)(c * 7 + (size_t)range);
+        TEST_CASE_("size=%zu range=%s scratch=%d", n, range_names[range], use_scratch);
+        TEST_CHECK(radix_check_u32(n, range, use_scratch, seed));
+        TEST_CHECK(radix_check_u64(n, range, use_scratch, seed));
+        TEST_CHECK(radix_check_i32(n, range, use_scratch, seed));
+        TEST_CHECK(radix_check_i64(n, range, use_scratch, seed));
+        TEST_CHECK(radix_check_f32(n, range, use_scratch, seed));
+        TEST_CHECK(radix_check_f64(n, range, use_scratch, seed));
+      }
+    }
+  }
+  TEST_CASE_(NULL);
+
+  {
+    double values[] = {1.0, -0.0, INFINITY, -1.5, 0.0, -INFINITY, 2.5, -0.0};
+    double const expected[] = {-INFINITY, -1.5, -0.0, -0.0, 0.0, 1.0, 2.5, INFINITY};
+    double scratch[8];
+    ov_radix_sort_f64(values, 8, scratch);
+    TEST_CHECK(memcmp(values, expected, sizeof(values)) == 0);
+    int32_t ints[] = {3, INT32_MIN, -1, 0, INT32_MAX, -7};
+    int32_t const ints_expected[] = {INT32_MIN, -7, -1, 0, 3, INT32_MAX};
+    ov_radix_sort_i32(ints, 6, NULL);
+    TEST_CHECK(memcmp(ints, ints_expected, sizeof(ints)) == 0);
+  }
+
+  {
+    enum { n = 50000 };
+    struct radix_record *items = NULL;
+    struct radix_record *scratch = NULL;
+    bool ok = OV_ARRAY_GROW(&items, n);
+    ok = ok && OV_ARRAY_GROW(&scratch, n);
+    TEST_ASSERT(ok);
+    for (int use_scratch = 0; use_scratch < 2; ++use_scratch) {
+      struct ov_rand_xoshiro256pp rng;
+      ov_rand_xoshiro256pp_init(&rng, 12345);
+      for (size_t i = 0; i < n; ++i) {
+        items[i] = (struct radix_record){
+            .key = (int64_t)(ov_rand_xoshiro256pp_next(&rng) % 2001) - 1000,
+            .original_index = i,
+        };
+      }
+      ov_radix_sort_records(items, n, sizeof(*items), radix_record_key, NULL, use_scratch ? scratch : NULL);
+      bool sorted = true;
+      bool stable = true;
+      for (size_t i = 1; i < n; ++i) {
+        sorted = sorted && items[i - 1].key <= items[i].key;
+        stable = stable && (items[i - 1].key != items[i].key || items[i - 1].original_index < items[i].original_index);
+      }
+      TEST_CHECK_(sorted, "records sorted scratch=%d", use_scratch);
+      if (use_scratch) {
+        TEST_CHECK_(stable, "records stable with scratch");
+      }
+    }
+    OV_ARRAY_DESTROY(&scratch);
+    OV_ARRAY_DESTROY(&items);
+  }
+}
+
 struct benchmark_case {
   char const *label;
   enum dataset_kind kind;
@@ -380,6 +1239,9 @@ static void test_ov_sort_benchmark(void) {
       {"size=8192 kind=reverse_sorted", dataset_kind_reverse_sorted, 8192, 50, 10, UINT32_C(0x98765432)},
       {"size=102400 kind=random", dataset_kind_random, 102400, 20, 10, UINT32_C(0x13579BDF)},
       {"size=102400 kind=mostly_sorted", dataset_kind_mostly_sorted, 102400, 20, 10, UINT32_C(0x2468ACE0)},
+      {"size=1024 kind=adversary", dataset_kind_adversary, 1024, 100, 10, 0},
+      {"size=8192 kind=adversary", dataset_kind_adversary, 8192, 5, 5, 0},
+      {"size=32768 kind=adversary", dataset_kind_adversary, 32768, 1, 3, 0},
   };
 
   for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
@@ -544,10 +1406,490 @@ static void test_ov_qsort_benchmark(void) {
   TEST_CASE_(NULL);
 }
 
+struct serial_executor {
+  size_t calls;
+  size_t tasks;
+};
+
+// Runs the tasks backwards on the calling thread, so nothing may depend on task order.
+static void run_serial_reversed(size_t const ntasks,
+                                void (*const task)(size_t const index, void *const userdata),
+                                void *const userdata,
+                                void *const executor) {
+  struct serial_executor *const ex = (struct serial_executor *)executor;
+  ++ex->calls;
+  ex->tasks += ntasks;
+  for (size_t i = ntasks; i > 0; --i) {
+    task(i - 1, userdata);
+  }
+}
+
+static void test_ov_parallel_qsort(void) {
+  static enum dataset_kind const kinds[] = {
+      dataset_kind_random,
+      dataset_kind_mostly_sorted,
+      dataset_kind_reverse_sorted,
+      dataset_kind_nearly_constant,
+  };
+  static size_t const counts[] = {0, 1, 2, 7, 100, 1000, 4097, 50000};
+  static size_t const thread_counts[] = {2, 3, 4, 7, 16};
+  enum { max_count = 50000 };
+
+  struct sort_item *items = NULL;
+  struct sort_item *expected = NULL;
+  bool ok = OV_ARRAY_GROW(&items, max_count);
+  ok = ok && OV_ARRAY_GROW(&expected, max_count);
+  TEST_ASSERT(ok);
+
+  for (size_t k = 0; k < sizeof(kinds) / sizeof(kinds[0]); ++k) {
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+      for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); ++t) {
+        size_t const count = counts[c];
+        TEST_CASE_("kind=%s size=%zu threads=%zu", dataset_kind_name(kinds[k]), count, thread_counts[t]);
+        fill_dataset(expected, count, kinds[k], (uint32_t)(k * 31 + c));
+        memcpy(items, expected, count * sizeof(*items));
+        ov_qsort(expected, count, sizeof(*expected), qsort_compare, NULL);
+
+        OV_PARALLEL_QSORT(items,
+                          count,
+                          sizeof(*items),
+                          qsort_compare,
+                          NULL,
+                          &((struct ov_parallel_qsort_options){.threads = thread_counts[t], .serial_threshold = 1}));
+        TEST_CHECK(memcmp(items, expected, count * sizeof(*items)) == 0);
+
+        fill_dataset(items, count, kinds[k], (uint32_t)(k * 31 + c));
+        struct serial_executor ex = {0};
+        OV_PARALLEL_QSORT(items,
+                          count,
+                          sizeof(*items),
+                          qsort_compare,
+                          NULL,
+                          &((struct ov_parallel_qsort_options){
+                              .threads = thread_counts[t],
+                              .serial_threshold = 1,
+                              .run = run_serial_reversed,
+                              .executor = &ex,
+                          }));
+        TEST_CHECK(memcmp(items, expected, count * sizeof(*items)) == 0);
+        if (count >= thread_counts[t] * 2) {
+          TEST_CHECK(ex.calls >= 2);
+          TEST_CHECK(ex.tasks >= thread_counts[t] * 2);
+        } else {
+          TEST_CHECK(ex.calls == 0);
+        }
+      }
+    }
+  }
+  TEST_CASE_(NULL);
+
+  {
+    // Below the threshold the executor is never used.
+    struct serial_executor ex = {0};
+    fill_dataset(items, 1000, dataset_kind_random, 99);
+    OV_PARALLEL_QSORT(items,
+                      1000,
+                      sizeof(*items),
+                      qsort_compare,
+                      NULL,
+                      &((struct ov_parallel_qsort_options){.threads = 4, .run = run_serial_reversed, .executor = &ex}));
+    TEST_CHECK(ex.calls == 0);
+    TEST_CHECK(is_stably_sorted(items, 1000));
+  }
+
+  OV_ARRAY_DESTROY(&expected);
+  OV_ARRAY_DESTROY(&items);
+}
+
+struct external_output {
+  struct sort_item *items;
+  size_t count;
+  size_t limit;
+};
+
+static bool external_collect(void const *const item, void *const userdata) {
+  struct external_output *const out = (struct external_output *)userdata;
+  if (out->count == out->limit) {
+    return false;
+  }
+  memcpy(out->items + out->count++, item, sizeof(struct sort_item));
+  return true;
+}
+
+static void test_ov_external_sort(void) {
+  static size_t const counts[] = {0, 1, 15, 16, 17, 1000, 50000};
+#ifndef __wasi__
+  // 16 items allow only two-way merges, 1000 items still need an intermediate pass at 50000
+  static size_t const budgets[] = {16 * sizeof(struct sort_item), 1000 * sizeof(struct sort_item), 0};
+#else
+  // there are no temporary files on WASI, so only the in-memory path can succeed
+  static size_t const budgets[] = {0};
+#endif
+  enum { max_count = 50000, chunk = 37 };
+
+  struct sort_item *items = NULL;
+  struct sort_item *expected = NULL;
+  struct sort_item *got = NULL;
+  struct ov_external_sort *es = NULL;
+  struct ov_error err = {0};
+  bool ok = OV_ARRAY_GROW(&items, max_count);
+  ok = ok && OV_ARRAY_GROW(&expected, max_count);
+  ok = ok && OV_ARRAY_GROW(&got, max_count);
+  TEST_ASSERT(ok);
+
+  for (size_t b = 0; b < sizeof(budgets) / sizeof(budgets[0]); ++b) {
+    es = OV_EXTERNAL_SORT_CREATE(&((struct ov_external_sort_options){
+                                     .item_size = sizeof(struct sort_item),
+                                     .compare = qsort_compare,
+                                     .memory_budget = budgets[b],
+                                 }),
+                                 &err);
+    if (!TEST_SUCCEEDED(es != NULL, &err)) {
+      goto cleanup;
+    }
+    // the same sorter is reused for every size
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+      size_t const count = counts[c];
+      TEST_CASE_("budget=%zu size=%zu", budgets[b], count);
+      fill_dataset(items, count, dataset_kind_random, (uint32_t)(b * 17 + c));
+      memcpy(expected, items, count * sizeof(*items));
+      ov_qsort(expected, count, sizeof(*expected), qsort_compare, NULL);
+      for (size_t i = 0; i < count; i += chunk) {
+        size_t const n = count - i < chunk ? count - i : chunk;
+        if (!TEST_SUCCEEDED(OV_EXTERNAL_SORT_ADD(es, items + i, n, &err), &err)) {
+          goto cleanup;
+        }
+      }
+      struct external_output out = {.items = got, .limit = max_count};
+      if (!TEST_SUCCEEDED(OV_EXTERNAL_SORT_FINISH(es, external_collect, &out, &err), &err)) {
+        goto cleanup;
+      }
+      TEST_CHECK(out.count == count);
+      TEST_CHECK(memcmp(got, expected, count * sizeof(*got)) == 0);
+
+      struct ov_external_sort_stats st;
+      ov_external_sort_get_stats(es, &st);
+      TEST_CHECK(st.items == count);
+      if (budgets[b] && count > 1000) {
+        TEST_CHECK(st.runs > 1 && st.intermediate_passes > 0);
+        TEST_MSG("runs=%zu passes=%zu", st.runs, st.intermediate_passes);
+      }
+      if (!budgets[b]) {
+        TEST_CHECK(st.runs == 0 && st.bytes_written == 0);
+      }
+    }
+    TEST_CASE_(NULL);
+
+    // stopping the merge early fails with abort and leaves the sorter empty
+    fill_dataset(items, 1000, dataset_kind_random, 99);
+    TEST_SUCCEEDED(OV_EXTERNAL_SORT_ADD(es, items, 1000, &err), &err);
+    {
+      struct external_output out = {.items = got, .limit = 10};
+      TEST_FAILED_WITH(OV_EXTERNAL_SORT_FINISH(es, external_collect, &out, &err),
+                       &err,
+                       ov_error_type_generic,
+                       ov_error_generic_abort);
+      TEST_CHECK(out.count == 10);
+    }
+    {
+      struct external_output out = {.items = got, .limit = max_count};
+      TEST_SUCCEEDED(OV_EXTERNAL_SORT_FINISH(es, external_collect, &out, &err), &err);
+      TEST_CHECK(out.count == 0);
+    }
+    OV_EXTERNAL_SORT_DESTROY(&es);
+  }
+
+#ifndef __wasi__
+  // a missing temporary directory only matters once a run has to be written
+  es = OV_EXTERNAL_SORT_CREATE(&((struct ov_external_sort_options){
+                                   .item_size = sizeof(struct sort_item),
+                                   .compare = qsort_compare,
+                                   .memory_budget = 16 * sizeof(struct sort_item),
+                                   .temp_dir = NSTR("ovbase-sort-test-missing-dir"),
+                               }),
+                               &err);
+  if (!TEST_SUCCEEDED(es != NULL, &err)) {
+    goto cleanup;
+  }
+  fill_dataset(items, 17, dataset_kind_random, 7);
+  TEST_SUCCEEDED(OV_EXTERNAL_SORT_ADD(es, items, 16, &err), &err);
+  TEST_CHECK(!OV_EXTERNAL_SORT_ADD(es, items + 16, 1, &err));
+  OV_ERROR_DESTROY(&err);
+#else
+  // spilling a run is not supported
+  es = OV_EXTERNAL_SORT_CREATE(&((struct ov_external_sort_options){
+                                   .item_size = sizeof(struct sort_item),
+                                   .compare = qsort_compare,
+                                   .memory_budget = 16 * sizeof(struct sort_item),
+                               }),
+                               &err);
+  if (!TEST_SUCCEEDED(es != NULL, &err)) {
+    goto cleanup;
+  }
+  fill_dataset(items, 17, dataset_kind_random, 7);
+  TEST_SUCCEEDED(OV_EXTERNAL_SORT_ADD(es, items, 16, &err), &err);
+  TEST_FAILED_WITH(OV_EXTERNAL_SORT_ADD(es, items + 16, 1, &err),
+                   &err,
+                   ov_error_type_generic,
+                   ov_error_generic_not_implemented_yet);
+#endif
+
+cleanup:
+  OV_EXTERNAL_SORT_DESTROY(&es);
+  OV_ARRAY_DESTROY(&got);
+  OV_ARRAY_DESTROY(&expected);
+  OV_ARRAY_DESTROY(&items);
+}
+
+static void test_ov_parallel_qsort_benchmark(void) {
+  if (!ovtest_should_run_benchmarks()) {
+    return;
+  }
+
+  static size_t const counts[] = {100000, 1000000, 10000000};
+  size_t const threads = ov_thread_hardware_concurrency();
+
+  for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+    size_t const count = counts[c];
+    struct sort_item *base = NULL;
+    struct sort_item *serial = NULL;
+    struct sort_item *parallel = NULL;
+    bool ok = OV_ARRAY_GROW(&base, count);
+    ok = ok && OV_ARRAY_GROW(&serial, count);
+    ok = ok && OV_ARRAY_GROW(&parallel, count);
+    TEST_ASSERT(ok);
+    fill_dataset(base, count, dataset_kind_random, UINT32_C(0x2468ACE0));
+
+    memcpy(serial, base, count * sizeof(*serial));
+    acutest_timer_get_time_(&acutest_timer_start_);
+    ov_qsort(serial, count, sizeof(*serial), qsort_compare, NULL);
+    acutest_timer_get_time_(&acutest_timer_end_);
+    double const serial_elapsed = acutest_timer_diff_(acutest_timer_start_, acutest_timer_end_);
+
+    memcpy(parallel, base, count * sizeof(*parallel));
+    acutest_timer_get_time_(&acutest_timer_start_);
+    OV_PARALLEL_QSORT(parallel, count, sizeof(*parallel), qsort_compare, NULL, NULL);
+    acutest_timer_get_time_(&acutest_timer_end_);
+    double const parallel_elapsed = acutest_timer_diff_(acutest_timer_start_, acutest_timer_end_);
+
+    TEST_CHECK(memcmp(serial, parallel, count * sizeof(*serial)) == 0);
+    printf("[benchmark parallel qsort] size=%zu threads=%zu ov_qsort=%.6f secs parallel=%.6f secs speedup=%.2fx\n",
+           count,
+           threads,
+           serial_elapsed,
+           parallel_elapsed,
+           parallel_elapsed > 0.0 ? serial_elapsed / parallel_elapsed : 0.0);
+
+    OV_ARRAY_DESTROY(&parallel);
+    OV_ARRAY_DESTROY(&serial);
+    OV_ARRAY_DESTROY(&base);
+  }
+}
+
+static void test_ov_argsort_benchmark(void) {
+  if (!ovtest_should_run_benchmarks()) {
+    return;
+  }
+
+  enum { count = 100000 };
+  struct wide_record *base = NULL;
+  struct wide_record *direct = NULL;
+  struct wide_record *indirect = NULL;
+  uint32_t *perm = NULL;
+  bool ok = OV_ARRAY_GROW(&base, count);
+  ok = ok && OV_ARRAY_GROW(&direct, count);
+  ok = ok && OV_ARRAY_GROW(&indirect, count);
+  ok = ok && OV_ARRAY_GROW(&perm, count);
+  TEST_ASSERT(ok);
+
+  struct ov_rand_xoshiro256pp rng;
+  ov_rand_xoshiro256pp_init(&rng, 0xA5A5);
+  for (size_t i = 0; i < count; ++i) {
+    base[i].value = (size_t)ov_rand_xoshiro256pp_next(&rng);
+    memset(base[i].payload, (int)(i & 0xff), sizeof(base[i].payload));
+  }
+
+  memcpy(direct, base, count * sizeof(*direct));
+  acutest_timer_get_time_(&acutest_timer_start_);
+  ov_qsort(direct, count, sizeof(*direct), compare_wide_records, NULL);
+  acutest_timer_get_time_(&acutest_timer_end_);
+  double const direct_elapsed = acutest_timer_diff_(acutest_timer_start_, acutest_timer_end_);
+
+  memcpy(indirect, base, count * sizeof(*indirect));
+  acutest_timer_get_time_(&acutest_timer_start_);
+  ov_argsort_u32(perm, count, indirect, sizeof(*indirect), compare_wide_records, NULL);
+  ov_apply_permutation_u32(perm, count, &(struct ov_permute_array){indirect, sizeof(*indirect)}, 1);
+  acutest_timer_get_time_(&acutest_timer_end_);
+  double const indirect_elapsed = acutest_timer_diff_(acutest_timer_start_, acutest_timer_end_);
+
+  TEST_CHECK(memcmp(direct, indirect, count * sizeof(*direct)) == 0);
+  printf("[benchmark argsort] record=%zu bytes size=%d ov_qsort=%.6f secs argsort+apply=%.6f secs speedup=%.2fx\n",
+         sizeof(struct wide_record),
+         count,
+         direct_elapsed,
+         indirect_elapsed,
+         indirect_elapsed > 0.0 ? direct_elapsed / indirect_elapsed : 0.0);
+
+  OV_ARRAY_DESTROY(&perm);
+  OV_ARRAY_DESTROY(&indirect);
+  OV_ARRAY_DESTROY(&direct);
+  OV_ARRAY_DESTROY(&base);
+}
+
+#define int32_less(a, b) (*(a) < *(b))
+OV_SORT_DEFINE(typed_sort_i32, int32_t, int32_less)
+
+static int compare_i32(void const *const a, void const *const b, void *const userdata) {
+  (void)userdata;
+  int32_t const va = *(int32_t const *)a;
+  int32_t const vb = *(int32_t const *)b;
+  return (va > vb) - (va < vb);
+}
+
+static void test_ov_sort_network_benchmark(void) {
+  if (!ovtest_should_run_benchmarks()) {
+    return;
+  }
+
+  static size_t const group_sizes[] = {4, 8, 16, 32, 64};
+  enum { total = 4000000 };
+  int32_t *base = NULL;
+  int32_t *work = NULL;
+  bool ok = OV_ARRAY_GROW(&base, total);
+  ok = ok && OV_ARRAY_GROW(&work, total);
+  TEST_ASSERT(ok);
+  struct ov_rand_xoshiro256pp rng;
+  ov_rand_xoshiro256pp_init(&rng, 0xBEEF);
+  for (size_t i = 0; i < total; ++i) {
+    base[i] = (int32_t)ov_rand_xoshiro256pp_next(&rng);
+  }
+
+  for (size_t g = 0; g < sizeof(group_sizes) / sizeof(group_sizes[0]); ++g) {
+    size_t const group = group_sizes[g];
+    size_t const groups = total / group;
+    double elapsed[3];
+    for (int variant = 0; variant < 3; ++variant) {
+      memcpy(work, base, total * sizeof(*work));
+      acutest_timer_get_time_(&acutest_timer_start_);
+      for (size_t i = 0; i < groups; ++i) {
+        int32_t *const p = work + i * group;
+        if (variant == 0) {
+          ov_qsort(p, group, sizeof(*p), compare_i32, NULL);
+        } else if (variant == 1) {
+          typed_sort_i32(p, group);
+        } else {
+          ov_sort_i32(p, group);
+        }
+      }
+      acutest_timer_get_time_(&acutest_timer_end_);
+      elapsed[variant] = acutest_timer_diff_(acutest_timer_start_, acutest_timer_end_);
+    }
+    printf("[benchmark network] groups=%zu group=%zu ov_qsort=%.6f secs insertion=%.6f secs network=%.6f secs "
+           "speedup=%.2fx\n",
+           groups,
+           group,
+           elapsed[0],
+           elapsed[1],
+           elapsed[2],
+           elapsed[2] > 0.0 ? elapsed[1] / elapsed[2] : 0.0);
+  }
+
+  OV_ARRAY_DESTROY(&work);
+  OV_ARRAY_DESTROY(&base);
+}
+
+static int radix_benchmark_compare(void const *const a, void const *const b, void *const userdata) {
+  (void)userdata;
+  uint64_t const va = *(uint64_t const *)a;
+  uint64_t const vb = *(uint64_t const *)b;
+  return va < vb ? -1 : va > vb ? 1 : 0;
+}
+
+static void test_ov_radix_sort_benchmark(void) {
+  if (!ovtest_should_run_benchmarks()) {
+    return;
+  }
+
+  static struct {
+    char const *label;
+    size_t count;
+    uint64_t mask;
+  } const cases[] = {
+      {"u64 full", 1000000, UINT64_MAX},
+      {"u64 32-bit ids", 1000000, UINT32_MAX},
+      {"u64 20-bit ids", 1000000, (UINT64_C(1) << 20) - 1},
+      {"u64 full", 10000000, UINT64_MAX},
+  };
+
+  for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); ++c) {
+    size_t const count = cases[c].count;
+    uint64_t *base = NULL;
+    uint64_t *work = NULL;
+    uint64_t *scratch = NULL;
+    bool ok = OV_ARRAY_GROW(&base, count);
+    ok = ok && OV_ARRAY_GROW(&work, count);
+    ok = ok && OV_ARRAY_GROW(&scratch, count);
+    TEST_ASSERT(ok);
+
+    struct ov_rand_xoshiro256pp rng;
+    ov_rand_xoshiro256pp_init(&rng, 0x5eed);
+    for (size_t i = 0; i < count; ++i) {
+      base[i] = ov_rand_xoshiro256pp_next(&rng) & cases[c].mask;
+    }
+
+    memcpy(work, base, count * sizeof(*work));
+    acutest_timer_get_time_(&acutest_timer_start_);
+    ov_qsort(work, count, sizeof(*work), radix_benchmark_compare, NULL);
+    acutest_timer_get_time_(&acutest_timer_end_);
+    double const qsort_elapsed = acutest_timer_diff_(acutest_timer_start_, acutest_timer_end_);
+
+    memcpy(work, base, count * sizeof(*work));
+    acutest_timer_get_time_(&acutest_timer_start_);
+    ov_radix_sort_u64(work, count, scratch);
+    acutest_timer_get_time_(&acutest_timer_end_);
+    double const lsd_elapsed = acutest_timer_diff_(acutest_timer_start_, acutest_timer_end_);
+
+    memcpy(work, base, count * sizeof(*work));
+    acutest_timer_get_time_(&acutest_timer_start_);
+    ov_radix_sort_u64(work, count, NULL);
+    acutest_timer_get_time_(&acutest_timer_end_);
+    double const msd_elapsed = acutest_timer_diff_(acutest_timer_start_, acutest_timer_end_);
+
+    printf("[benchmark radix] %s size=%zu ov_qsort=%.6f secs lsd=%.6f secs (%.2fx) msd=%.6f secs (%.2fx)\n",
+           cases[c].label,
+           count,
+           qsort_elapsed,
+           lsd_elapsed,
+           lsd_elapsed > 0.0 ? qsort_elapsed / lsd_elapsed : 0.0,
+           msd_elapsed,
+           msd_elapsed > 0.0 ? qsort_elapsed / msd_elapsed : 0.0);
+
+    OV_ARRAY_DESTROY(&scratch);
+    OV_ARRAY_DESTROY(&work);
+    OV_ARRAY_DESTROY(&base);
+  }
+}
+
 TEST_LIST = {
     {"test_ov_sort_matches_standard", test_ov_sort_matches_standard},
     {"test_ov_sort_matches_large_datasets", test_ov_sort_matches_large_datasets},
+    {"test_ov_qsort_item_sizes", test_ov_qsort_item_sizes},
+    {"test_ov_sort_define", test_ov_sort_define},
+    {"test_ov_sort_adversary", test_ov_sort_adversary},
+    {"test_ov_stable_sort", test_ov_stable_sort},
+    {"test_ov_nth_element", test_ov_nth_element},
+    {"test_ov_topk", test_ov_topk},
+    {"test_ov_argsort", test_ov_argsort},
+    {"test_ov_sort_network", test_ov_sort_network},
+    {"test_ov_sort_network_vector", test_ov_sort_network_vector},
+    {"test_ov_radix_sort", test_ov_radix_sort},
+    {"test_ov_parallel_qsort", test_ov_parallel_qsort},
+    {"test_ov_external_sort", test_ov_external_sort},
     {"test_ov_sort_benchmark", test_ov_sort_benchmark},
     {"test_ov_qsort_benchmark", test_ov_qsort_benchmark},
+    {"test_ov_parallel_qsort_benchmark", test_ov_parallel_qsort_benchmark},
+    {"test_ov_argsort_benchmark", test_ov_argsort_benchmark},
+    {"test_ov_sort_network_benchmark", test_ov_sort_network_benchmark},
+    {"test_ov_radix_sort_benchmark", test_ov_radix_sort_benchmark},
     {NULL, NULL},
 };
@@ -0,0 +1,681 @@
+#if defined(__linux__) && !defined(_DEFAULT_SOURCE)
+// syscall() is only declared outside the strict POSIX namespace.
+#  ifdef __clang__
+#    pragma clang diagnostic push
+#    if __has_warning("-Wreserved-id-macro")
+#      pragma clang diagnostic ignored "-Wreserved-id-macro"
+#    endif
+#    if __has_warning("-Wreserved-macro-identifier")
+#      pragma clang diagnostic ignored "-Wreserved-macro-identifier"
+#    endif
+#  endif
+#  define _DEFAULT_SOURCE
+#  ifdef __clang__
+#    pragma clang diagnostic pop
+#  endif
+#endif
+
+#include <ovsync.h>
+
+#include <assert.h>
+#include <limits.h>
+
+#ifdef _WIN32
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#endif
+
+#ifdef OV_SYNC_FUTEX
+#  include <linux/futex.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#  if !defined(SYS_futex) && defined(SYS_futex_time64)
+#    define SYS_futex SYS_futex_time64
+#  endif
+#endif
+
+enum {
+  max_pause = 64,
+  adaptive_max_spins = 200,
+  rwlock_spins = 64,
+  wait_spins = 16,
+};
+
+static inline void cpu_relax(void) {
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+  __builtin_ia32_pause();
+#elif defined(__GNUC__) && defined(__aarch64__)
+  __asm__ __volatile__("yield");
+#elif defined(_WIN32)
+  YieldProcessor();
+#endif
+}
+
+// Exponential backoff: pause for 1, 2, 4, ... max_pause rounds, then keep yielding the time slice.
+static inline void backoff(unsigned int *const pauses) {
+  if (*pauses < max_pause) {
+    for (unsigned int i = 0; i < *pauses; ++i) {
+      cpu_relax();
+    }
+    *pauses *= 2;
+    return;
+  }
+  thrd_yield();
+}
+
+static void counters_init(struct ov_lock_counters *const c) {
+  atomic_init(&c->contended, 0);
+  atomic_init(&c->spins, 0);
+  atomic_init(&c->parks, 0);
+}
+
+static void counters_add(struct ov_lock_counters *const c, uint64_t const spins, uint64_t const parks) {
+  atomic_fetch_add_explicit(&c->contended, 1, memory_order_relaxed);
+  if (spins) {
+    atomic_fetch_add_explicit(&c->spins, spins, memory_order_relaxed);
+  }
+  if (parks) {
+    atomic_fetch_add_explicit(&c->parks, parks, memory_order_relaxed);
+  }
+}
+
+static void counters_get(struct ov_lock_counters *const c, struct ov_lock_stats *const stats) {
+  *stats = (struct ov_lock_stats){
+      .contended = atomic_load_explicit(&c->contended, memory_order_relaxed),
+      .spins = atomic_load_explicit(&c->spins, memory_order_relaxed),
+      .parks = atomic_load_explicit(&c->parks, memory_order_relaxed),
+  };
+}
+
+static bool init_wait_queues(mtx_t *const mtx, cnd_t *const cnd1, cnd_t *const cnd2, struct ov_error *const err) {
+  if (mtx_init(mtx, mtx_plain) != thrd_success) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+    return false;
+  }
+  if (cnd_init(cnd1) != thrd_success) {
+    mtx_destroy(mtx);
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+    return false;
+  }
+  if (cnd_init(cnd2) != thrd_success) {
+    cnd_destroy(cnd1);
+    mtx_destroy(mtx);
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+    return false;
+  }
+  return true;
+}
+
+// Parking
+//
+// park sleeps only while *addr still holds expected, and unpark wakes sleepers of addr.
+// Callers change the word before calling unpark, so a waiter either sees the new value
+// before it sleeps or is woken afterwards.
+//
+// Without futexes the same contract is emulated with a mutex and a condition variable:
+// the value is re-checked under the mutex, and unpark takes the mutex before signalling,
+// so the change cannot slip in between the check and the wait.
+
+#ifdef OV_SYNC_FUTEX
+static_assert(sizeof(atomic_uint) == sizeof(int), "futex word must be 32 bits");
+
+static bool fallback_init(struct ov_sync_fallback *const fb, struct ov_error *const err) {
+  (void)fb;
+  (void)err;
+  return true;
+}
+
+static void fallback_exit(struct ov_sync_fallback *const fb) { (void)fb; }
+
+static void park(atomic_uint *const addr, unsigned int const expected, struct ov_sync_fallback *const fb) {
+  (void)fb;
+  syscall(SYS_futex, (void *)addr, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+}
+
+static void unpark(atomic_uint *const addr, unsigned int const n, struct ov_sync_fallback *const fb) {
+  (void)fb;
+  syscall(SYS_futex, (void *)addr, FUTEX_WAKE_PRIVATE, n < INT_MAX ? (int)n : INT_MAX, NULL, NULL, 0);
+}
+
+#  define FALLBACK(p) NULL
+#else
+static bool fallback_init(struct ov_sync_fallback *const fb, struct ov_error *const err) {
+  if (mtx_init(&fb->mtx, mtx_plain) != thrd_success) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+    return false;
+  }
+  if (cnd_init(&fb->cnd) != thrd_success) {
+    mtx_destroy(&fb->mtx);
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+    return false;
+  }
+  return true;
+}
+
+static void fallback_exit(struct ov_sync_fallback *const fb) {
+  cnd_destroy(&fb->cnd);
+  mtx_destroy(&fb->mtx);
+}
+
+static void park(atomic_uint *const addr, unsigned int const expected, struct ov_sync_fallback *const fb) {
+  mtx_lock(&fb->mtx);
+  if (atomic_load(addr) == expected) {
+    cnd_wait(&fb->cnd, &fb->mtx);
+  }
+  mtx_unlock(&fb->mtx);
+}
+
+static void unpark(atomic_uint *const addr, unsigned int const n, struct ov_sync_fallback *const fb) {
+  (void)addr;
+  mtx_lock(&fb->mtx);
+  if (n == 1) {
+    cnd_signal(&fb->cnd);
+  } else {
+    cnd_broadcast(&fb->cnd);
+  }
+  mtx_unlock(&fb->mtx);
+}
+
+#  define FALLBACK(p) (&(p)->fallback)
+#endif
+
+// Spinlock
+
+void ov_spinlock_init(struct ov_spinlock *const sl) {
+  assert(sl != NULL && "sl must not be NULL");
+  atomic_init(&sl->locked, false);
+  counters_init(&sl->counters);
+}
+
+bool ov_spinlock_try_lock(struct ov_spinlock *const sl) {
+  assert(sl != NULL && "sl must not be NULL");
+  return !atomic_load_explicit(&sl->locked, memory_order_relaxed) &&
+         !atomic_exchange_explicit(&sl->locked, true, memory_order_acquire);
+}
+
+void ov_spinlock_lock(struct ov_spinlock *const sl) {
+  assert(sl != NULL && "sl must not be NULL");
+  if (!atomic_exchange_explicit(&sl->locked, true, memory_order_acquire)) {
+    return;
+  }
+  uint64_t spins = 0;
+  unsigned int pauses = 1;
+  do {
+    while (atomic_load_explicit(&sl->locked, memory_order_relaxed)) {
+      backoff(&pauses);
+      ++spins;
+    }
+  } while (atomic_exchange_explicit(&sl->locked, true, memory_order_acquire));
+  counters_add(&sl->counters, spins, 0);
+}
+
+void ov_spinlock_unlock(struct ov_spinlock *const sl) {
+  assert(sl != NULL && "sl must not be NULL");
+  atomic_store_explicit(&sl->locked, false, memory_order_release);
+}
+
+void ov_spinlock_get_stats(struct ov_spinlock *const sl, struct ov_lock_stats *const stats) {
+  assert(sl != NULL && "sl must not be NULL");
+  assert(stats != NULL && "stats must not be NULL");
+  counters_get(&sl->counters, stats);
+}
+
+// Adaptive mutex
+//
+// state is 0 when unlocked, 1 when locked and 2 when locked with possibly parked waiters.
+// A parking thread swaps in 2 before it sleeps, so an unlock that swaps out a 2 knows it has
+// to wake someone, and an unlock that swaps out a 1 can skip it.
+
+enum {
+  mutex_unlocked = 0,
+  mutex_locked = 1,
+  mutex_parked = 2,
+};
+
+bool ov_adaptive_mutex_init(struct ov_adaptive_mutex *const m, struct ov_error *const err) {
+  assert(m != NULL && "m must not be NULL");
+  if (!fallback_init(FALLBACK(m), err)) {
+    return false;
+  }
+  atomic_init(&m->state, mutex_unlocked);
+  m->max_spins = ov_thread_hardware_concurrency() > 1 ? adaptive_max_spins : 0;
+  atomic_init(&m->spin_budget, m->max_spins / 2);
+  counters_init(&m->counters);
+  return true;
+}
+
+void ov_adaptive_mutex_exit(struct ov_adaptive_mutex *const m) {
+  assert(m != NULL && "m must not be NULL");
+  assert(atomic_load(&m->state) == mutex_unlocked && "mutex must not be locked");
+  fallback_exit(FALLBACK(m));
+}
+
+bool ov_adaptive_mutex_try_lock(struct ov_adaptive_mutex *const m) {
+  assert(m != NULL && "m must not be NULL");
+  unsigned int expected = mutex_unlocked;
+  return atomic_compare_exchange_strong_explicit(
+      &m->state, &expected, mutex_locked, memory_order_acquire, memory_order_relaxed);
+}
+
+void ov_adaptive_mutex_lock(struct ov_adaptive_mutex *const m) {
+  assert(m != NULL && "m must not be NULL");
+  unsigned int expected = mutex_unlocked;
+  if (atomic_compare_exchange_strong_explicit(
+          &m->state, &expected, mutex_locked, memory_order_acquire, memory_order_relaxed)) {
+    return;
+  }
+
+  // Spin for up to twice the recent average, and move the average towards what this
+  // acquisition needed: short critical sections grow the budget, parking shrinks it.
+  unsigned int const budget = atomic_load_explicit(&m->spin_budget, memory_order_relaxed);
+  unsigned int const limit = budget * 2 + 10 < m->max_spins ? budget * 2 + 10 : m->max_spins;
+  unsigned int spins = 0;
+  while (spins < limit) {
+    ++spins;
+    cpu_relax();
+    expected = atomic_load_explicit(&m->state, memory_order_relaxed);
+    if (expected == mutex_unlocked &&
+        atomic_compare_exchange_weak_explicit(
+            &m->state, &expected, mutex_locked, memory_order_acquire, memory_order_relaxed)) {
+      int const delta = ((int)spins - (int)budget) / 8;
+      atomic_store_explicit(&m->spin_budget, (unsigned int)((int)budget + delta), memory_order_relaxed);
+      counters_add(&m->counters, spins, 0);
+      return;
+    }
+  }
+
+  uint64_t parks = 0;
+  while (atomic_exchange_explicit(&m->state, mutex_parked, memory_order_acquire) != mutex_unlocked) {
+    ++parks;
+    park(&m->state, mutex_parked, FALLBACK(m));
+  }
+  if (limit) {
+    atomic_store_explicit(&m->spin_budget, budget - budget / 4, memory_order_relaxed);
+  }
+  counters_add(&m->counters, spins, parks);
+}
+
+void ov_adaptive_mutex_unlock(struct ov_adaptive_mutex *const m) {
+  assert(m != NULL && "m must not be NULL");
+  unsigned int const prev = atomic_exchange_explicit(&m->state, mutex_unlocked, memory_order_release);
+  assert(prev != mutex_unlocked && "mutex must be locked");
+  if (prev == mutex_parked) {
+    unpark(&m->state, 1, FALLBACK(m));
+  }
+}
+
+void ov_adaptive_mutex_get_stats(struct ov_adaptive_mutex *const m, struct ov_lock_stats *const stats) {
+  assert(m != NULL && "m must not be NULL");
+  assert(stats != NULL && "stats must not be NULL");
+  counters_get(&m->counters, stats);
+}
+
+// Reader-writer lock
+//
+// state holds the reader count in the low bits plus three flags. writer_bit is set while a
+// writer owns the lock. writer_waiting_bit is set while a writer is parked or about to park;
+// it keeps new readers out and tells the last reader to wake a writer. readers_waiting_bit
+// is set while readers are parked and tells the releasing writer to wake them.
+// Flags are only raised under mtx, and a waiter re-checks the value its own fetch_or returned
+// before sleeping, so a release that races with parking always observes the flag.
+
+static unsigned int const writer_bit = 0x80000000u;
+static unsigned int const writer_waiting_bit = 0x40000000u;
+static unsigned int const readers_waiting_bit = 0x20000000u;
+static unsigned int const reader_mask = 0x1fffffffu;
+
+bool ov_rwlock_init(struct ov_rwlock *const rw, struct ov_error *const err) {
+  assert(rw != NULL && "rw must not be NULL");
+  if (!init_wait_queues(&rw->mtx, &rw->readers, &rw->writers, err)) {
+    return false;
+  }
+  atomic_init(&rw->state, 0);
+  rw->writers_waiting = 0;
+  counters_init(&rw->read_counters);
+  counters_init(&rw->write_counters);
+  return true;
+}
+
+void ov_rwlock_exit(struct ov_rwlock *const rw) {
+  assert(rw != NULL && "rw must not be NULL");
+  assert(atomic_load(&rw->state) == 0 && "rwlock must not be held");
+  cnd_destroy(&rw->writers);
+  cnd_destroy(&rw->readers);
+  mtx_destroy(&rw->mtx);
+}
+
+static inline bool read_acquire(struct ov_rwlock *const rw, unsigned int st) {
+  assert((st & reader_mask) != reader_mask && "too many readers");
+  return !(st & (writer_bit | writer_waiting_bit)) &&
+         atomic_compare_exchange_weak_explicit(&rw->state, &st, st + 1, memory_order_acquire, memory_order_relaxed);
+}
+
+bool ov_rwlock_try_read_lock(struct ov_rwlock *const rw) {
+  assert(rw != NULL && "rw must not be NULL");
+  unsigned int st = atomic_load_explicit(&rw->state, memory_order_relaxed);
+  while (!(st & (writer_bit | writer_waiting_bit))) {
+    if (atomic_compare_exchange_weak_explicit(&rw->state, &st, st + 1, memory_order_acquire, memory_order_relaxed)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void ov_rwlock_read_lock(struct ov_rwlock *const rw) {
+  assert(rw != NULL && "rw must not be NULL");
+  if (read_acquire(rw, atomic_load_explicit(&rw->state, memory_order_relaxed))) {
+    return;
+  }
+  uint64_t spins = 0;
+  unsigned int pauses = 1;
+  while (spins < rwlock_spins) {
+    ++spins;
+    backoff(&pauses);
+    if (read_acquire(rw, atomic_load_explicit(&rw->state, memory_order_relaxed))) {
+      counters_add(&rw->read_counters, spins, 0);
+      return;
+    }
+  }
+
+  uint64_t parks = 0;
+  mtx_lock(&rw->mtx);
+  for (;;) {
+    if (read_acquire(rw, atomic_load_explicit(&rw->state, memory_order_relaxed))) {
+      break;
+    }
+    unsigned int const prev = atomic_fetch_or_explicit(&rw->state, readers_waiting_bit, memory_order_relaxed);
+    if (!(prev & (writer_bit | writer_waiting_bit))) {
+      continue;
+    }
+    ++parks;
+    cnd_wait(&rw->readers, &rw->mtx);
+  }
+  mtx_unlock(&rw->mtx);
+  counters_add(&rw->read_counters, spins, parks);
+}
+
+void ov_rwlock_read_unlock(struct ov_rwlock *const rw) {
+  assert(rw != NULL && "rw must not be NULL");
+  unsigned int const prev = atomic_fetch_sub_explicit(&rw->state, 1, memory_order_release);
+  assert((prev & reader_mask) != 0 && "rwlock must be read-locked");
+  if ((prev & reader_mask) == 1 && (prev & writer_waiting_bit)) {
+    mtx_lock(&rw->mtx);
+    cnd_signal(&rw->writers);
+    mtx_unlock(&rw->mtx);
+  }
+}
+
+// readers_waiting_bit can be left behind by a reader that found the writer gone while parking;
+// it is harmless for a writer, whose unlock clears it.
+bool ov_rwlock_try_write_lock(struct ov_rwlock *const rw) {
+  assert(rw != NULL && "rw must not be NULL");
+  unsigned int st = atomic_load_explicit(&rw->state, memory_order_relaxed);
+  while (!(st & ~readers_waiting_bit)) {
+    if (atomic_compare_exchange_weak_explicit(
+            &rw->state, &st, st | writer_bit, memory_order_acquire, memory_order_relaxed)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void ov_rwlock_write_lock(struct ov_rwlock *const rw) {
+  assert(rw != NULL && "rw must not be NULL");
+  if (ov_rwlock_try_write_lock(rw)) {
+    return;
+  }
+  uint64_t spins = 0;
+  unsigned int pauses = 1;
+  while (spins < rwlock_spins) {
+    ++spins;
+    backoff(&pauses);
+    if (ov_rwlock_try_write_lock(rw)) {
+      counters_add(&rw->write_counters, spins, 0);
+      return;
+    }
+  }
+
+  uint64_t parks = 0;
+  mtx_lock(&rw->mtx);
+  ++rw->writers_waiting;
+  for (;;) {
+    unsigned int st = atomic_fetch_or_explicit(&rw->state, writer_waiting_bit, memory_order_relaxed);
+    if (!(st & (writer_bit | reader_mask))) {
+      // Keep writer_waiting_bit raised for the writers still queued behind this one.
+      st |= writer_waiting_bit;
+      unsigned int const next =
+          writer_bit | (st & readers_waiting_bit) | (rw->writers_waiting > 1 ? writer_waiting_bit : 0);
+      if (atomic_compare_exchange_strong_explicit(
+              &rw->state, &st, next, memory_order_acquire, memory_order_relaxed)) {
+        break;
+      }
+      continue;
+    }
+    ++parks;
+    cnd_wait(&rw->writers, &rw->mtx);
+  }
+  --rw->writers_waiting;
+  mtx_unlock(&rw->mtx);
+  counters_add(&rw->write_counters, spins, parks);
+}
+
+void ov_rwlock_write_unlock(struct ov_rwlock *const rw) {
+  assert(rw != NULL && "rw must not be NULL");
+  unsigned int const prev = atomic_fetch_and_explicit(&rw->state, ~writer_bit, memory_order_release);
+  assert((prev & writer_bit) && "rwlock must be write-locked");
+  if (!(prev & (writer_waiting_bit | readers_waiting_bit))) {
+    return;
+  }
+  mtx_lock(&rw->mtx);
+  if (rw->writers_waiting) {
+    cnd_signal(&rw->writers);
+  } else {
+    atomic_fetch_and_explicit(&rw->state, ~readers_waiting_bit, memory_order_relaxed);
+    cnd_broadcast(&rw->readers);
+  }
+  mtx_unlock(&rw->mtx);
+}
+
+void ov_rwlock_get_stats(struct ov_rwlock *const rw,
+                         struct ov_lock_stats *const read_stats,
+                         struct ov_lock_stats *const write_stats) {
+  assert(rw != NULL && "rw must not be NULL");
+  if (read_stats) {
+    counters_get(&rw->read_counters, read_stats);
+  }
+  if (write_stats) {
+    counters_get(&rw->write_counters, write_stats);
+  }
+}
+
+// Event
+//
+// state is 0 while unset, 1 while set and 2 while unset with possibly parked waiters, so
+// ov_event_set only has to wake anyone when it replaces a 2.
+
+enum {
+  event_unset = 0,
+  event_set = 1,
+  event_parked = 2,
+};
+
+bool ov_event_init(struct ov_event *const ev, bool const set, struct ov_error *const err) {
+  assert(ev != NULL && "ev must not be NULL");
+  if (!fallback_init(FALLBACK(ev), err)) {
+    return false;
+  }
+  atomic_init(&ev->state, set ? event_set : event_unset);
+  return true;
+}
+
+void ov_event_exit(struct ov_event *const ev) {
+  assert(ev != NULL && "ev must not be NULL");
+  fallback_exit(FALLBACK(ev));
+}
+
+void ov_event_set(struct ov_event *const ev) {
+  assert(ev != NULL && "ev must not be NULL");
+  if (atomic_exchange_explicit(&ev->state, event_set, memory_order_release) == event_parked) {
+    unpark(&ev->state, UINT_MAX, FALLBACK(ev));
+  }
+}
+
+void ov_event_reset(struct ov_event *const ev) {
+  assert(ev != NULL && "ev must not be NULL");
+  unsigned int expected = event_set;
+  atomic_compare_exchange_strong_explicit(
+      &ev->state, &expected, event_unset, memory_order_relaxed, memory_order_relaxed);
+}
+
+bool ov_event_is_set(struct ov_event *const ev) {
+  assert(ev != NULL && "ev must not be NULL");
+  return atomic_load_explicit(&ev->state, memory_order_acquire) == event_set;
+}
+
+void ov_event_wait(struct ov_event *const ev) {
+  assert(ev != NULL && "ev must not be NULL");
+  if (ov_event_is_set(ev)) {
+    return;
+  }
+  unsigned int pauses = 1;
+  for (unsigned int i = 0; i < wait_spins; ++i) {
+    backoff(&pauses);
+    if (ov_event_is_set(ev)) {
+      return;
+    }
+  }
+  for (;;) {
+    unsigned int st = atomic_load_explicit(&ev->state, memory_order_acquire);
+    if (st == event_set) {
+      return;
+    }
+    if (st == event_unset && !atomic_compare_exchange_weak_explicit(
+                                 &ev->state, &st, event_parked, memory_order_relaxed, memory_order_relaxed)) {
+      continue;
+    }
+    park(&ev->state, event_parked, FALLBACK(ev));
+  }
+}
+
+// Semaphore and wait group
+//
+// Both keep the number of parked (or about to park) threads next to the value they wait on.
+// The waiter raises it before its final check of the value and the waker changes the value
+// before looking at it, both sequentially consistent, so at least one of them sees the other:
+// either the waiter does not sleep, or the waker knows it has to wake it.
+
+static bool semaphore_take(struct ov_semaphore *const sem) {
+  unsigned int c = atomic_load(&sem->count);
+  while (c) {
+    if (atomic_compare_exchange_weak_explicit(&sem->count, &c, c - 1, memory_order_acquire, memory_order_relaxed)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ov_semaphore_init(struct ov_semaphore *const sem, unsigned int const count, struct ov_error *const err) {
+  assert(sem != NULL && "sem must not be NULL");
+  if (!fallback_init(FALLBACK(sem), err)) {
+    return false;
+  }
+  atomic_init(&sem->count, count);
+  atomic_init(&sem->waiters, 0);
+  return true;
+}
+
+void ov_semaphore_exit(struct ov_semaphore *const sem) {
+  assert(sem != NULL && "sem must not be NULL");
+  assert(atomic_load(&sem->waiters) == 0 && "semaphore must not have waiters");
+  fallback_exit(FALLBACK(sem));
+}
+
+void ov_semaphore_post(struct ov_semaphore *const sem, unsigned int const n) {
+  assert(sem != NULL && "sem must not be NULL");
+  if (!n) {
+    return;
+  }
+  atomic_fetch_add(&sem->count, n);
+  if (atomic_load(&sem->waiters)) {
+    unpark(&sem->count, n, FALLBACK(sem));
+  }
+}
+
+bool ov_semaphore_try_wait(struct ov_semaphore *const sem) {
+  assert(sem != NULL && "sem must not be NULL");
+  return semaphore_take(sem);
+}
+
+void ov_semaphore_wait(struct ov_semaphore *const sem) {
+  assert(sem != NULL && "sem must not be NULL");
+  if (semaphore_take(sem)) {
+    return;
+  }
+  unsigned int pauses = 1;
+  for (unsigned int i = 0; i < wait_spins; ++i) {
+    backoff(&pauses);
+    if (semaphore_take(sem)) {
+      return;
+    }
+  }
+  atomic_fetch_add(&sem->waiters, 1);
+  while (!semaphore_take(sem)) {
+    park(&sem->count, 0, FALLBACK(sem));
+  }
+  atomic_fetch_sub_explicit(&sem->waiters, 1, memory_order_relaxed);
+}
+
+bool ov_waitgroup_init(struct ov_waitgroup *const wg, struct ov_error *const err) {
+  assert(wg != NULL && "wg must not be NULL");
+  if (!fallback_init(FALLBACK(wg), err)) {
+    return false;
+  }
+  atomic_init(&wg->count, 0);
+  atomic_init(&wg->waiters, 0);
+  return true;
+}
+
+void ov_waitgroup_exit(struct ov_waitgroup *const wg) {
+  assert(wg != NULL && "wg must not be NULL");
+  assert(atomic_load(&wg->waiters) == 0 && "wait group must not have waiters");
+  fallback_exit(FALLBACK(wg));
+}
+
+void ov_waitgroup_add(struct ov_waitgroup *const wg, unsigned int const n) {
+  assert(wg != NULL && "wg must not be NULL");
+  unsigned int const prev = atomic_fetch_add_explicit(&wg->count, n, memory_order_relaxed);
+  (void)prev;
+  assert(prev + n >= prev && "wait group counter overflow");
+}
+
+void ov_waitgroup_done(struct ov_waitgroup *const wg) {
+  assert(wg != NULL && "wg must not be NULL");
+  unsigned int const prev = atomic_fetch_sub(&wg->count, 1);
+  assert(prev != 0 && "ov_waitgroup_done called more often than jobs were added");
+  if (prev == 1 && atomic_load(&wg->waiters)) {
+    unpark(&wg->count, UINT_MAX, FALLBACK(wg));
+  }
+}
+
+void ov_waitgroup_wait(struct ov_waitgroup *const wg) {
+  assert(wg != NULL && "wg must not be NULL");
+  if (!atomic_load_explicit(&wg->count, memory_order_acquire)) {
+    return;
+  }
+  unsigned int pauses = 1;
+  for (unsigned int i = 0; i < wait_spins; ++i) {
+    backoff(&pauses);
+    if (!atomic_load_explicit(&wg->count, memory_order_acquire)) {
+      return;
+    }
+  }
+  atomic_fetch_add(&wg->waiters, 1);
+  for (;;) {
+    unsigned int const c = atomic_load(&wg->count);
+    if (!c) {
+      break;
+    }
+    park(&wg->count, c, FALLBACK(wg));
+  }
+  atomic_fetch_sub_explicit(&wg->waiters, 1, memory_order_relaxed);
+}
@@ -0,0 +1,386 @@
+#include <ovtest.h>
+
+#include <ovsync.h>
+
+enum {
+  nthreads = 4,
+  iterations = 20000,
+};
+
+struct counter_context {
+  struct ov_spinlock spinlock;
+  struct ov_adaptive_mutex mutex;
+  bool use_mutex;
+  // two values that are only consistent while the lock is held
+  size_t a;
+  size_t b;
+  size_t mismatches;
+};
+
+static int counter_worker(void *const userdata) {
+  struct counter_context *const ctx = (struct counter_context *)userdata;
+  for (size_t i = 0; i < iterations; ++i) {
+    if (ctx->use_mutex) {
+      ov_adaptive_mutex_lock(&ctx->mutex);
+    } else {
+      ov_spinlock_lock(&ctx->spinlock);
+    }
+    if (ctx->a != ctx->b) {
+      ++ctx->mismatches;
+    }
+    ++ctx->a;
+    if ((i & 255) == 0) {
+      // occasionally give up the processor inside the critical section to force contention
+      thrd_yield();
+    }
+    ++ctx->b;
+    if (ctx->use_mutex) {
+      ov_adaptive_mutex_unlock(&ctx->mutex);
+    } else {
+      ov_spinlock_unlock(&ctx->spinlock);
+    }
+  }
+  return 0;
+}
+
+static void run_counter(struct counter_context *const ctx) {
+  thrd_t threads[nthreads];
+  size_t n = 0;
+  for (; n < nthreads; ++n) {
+    if (!TEST_CHECK(thrd_create(&threads[n], counter_worker, ctx) == thrd_success)) {
+      break;
+    }
+  }
+  for (size_t i = 0; i < n; ++i) {
+    thrd_join(threads[i], NULL);
+  }
+  TEST_CHECK(ctx->a == n * iterations);
+  TEST_CHECK(ctx->b == n * iterations);
+  TEST_CHECK(ctx->mismatches == 0);
+}
+
+static void test_spinlock(void) {
+  struct counter_context ctx = {0};
+  ov_spinlock_init(&ctx.spinlock);
+
+  TEST_CHECK(ov_spinlock_try_lock(&ctx.spinlock));
+  TEST_CHECK(!ov_spinlock_try_lock(&ctx.spinlock));
+  ov_spinlock_unlock(&ctx.spinlock);
+
+  run_counter(&ctx);
+  struct ov_lock_stats stats;
+  ov_spinlock_get_stats(&ctx.spinlock, &stats);
+  TEST_CHECK(stats.contended <= nthreads * iterations);
+  TEST_CHECK(stats.parks == 0);
+  TEST_MSG("contended %llu spins %llu", (unsigned long long)stats.contended, (unsigned long long)stats.spins);
+}
+
+static void test_adaptive_mutex(void) {
+  struct ov_error err = {0};
+  struct counter_context ctx = {.use_mutex = true};
+  if (!TEST_SUCCEEDED(ov_adaptive_mutex_init(&ctx.mutex, &err), &err)) {
+    return;
+  }
+
+  TEST_CHECK(ov_adaptive_mutex_try_lock(&ctx.mutex));
+  TEST_CHECK(!ov_adaptive_mutex_try_lock(&ctx.mutex));
+  ov_adaptive_mutex_unlock(&ctx.mutex);
+
+  struct ov_lock_stats stats;
+  ov_adaptive_mutex_get_stats(&ctx.mutex, &stats);
+  TEST_CHECK(stats.contended == 0 && stats.spins == 0 && stats.parks == 0);
+
+  run_counter(&ctx);
+  ov_adaptive_mutex_get_stats(&ctx.mutex, &stats);
+  TEST_CHECK(stats.contended <= nthreads * iterations);
+  TEST_MSG("contended %llu spins %llu parks %llu",
+           (unsigned long long)stats.contended,
+           (unsigned long long)stats.spins,
+           (unsigned long long)stats.parks);
+  ov_adaptive_mutex_exit(&ctx.mutex);
+}
+
+struct rw_context {
+  struct ov_rwlock lock;
+  size_t a;
+  size_t b;
+  atomic_size_t mismatches;
+  atomic_size_t reads;
+};
+
+static int rw_reader(void *const userdata) {
+  struct rw_context *const ctx = (struct rw_context *)userdata;
+  for (size_t i = 0; i < iterations; ++i) {
+    ov_rwlock_read_lock(&ctx->lock);
+    if (ctx->a != ctx->b) {
+      atomic_fetch_add(&ctx->mismatches, 1);
+    }
+    ov_rwlock_read_unlock(&ctx->lock);
+    atomic_fetch_add_explicit(&ctx->reads, 1, memory_order_relaxed);
+  }
+  return 0;
+}
+
+static int rw_writer(void *const userdata) {
+  struct rw_context *const ctx = (struct rw_context *)userdata;
+  for (size_t i = 0; i < iterations / 10; ++i) {
+    ov_rwlock_write_lock(&ctx->lock);
+    ++ctx->a;
+    if ((i & 31) == 0) {
+      thrd_yield();
+    }
+    ++ctx->b;
+    ov_rwlock_write_unlock(&ctx->lock);
+  }
+  return 0;
+}
+
+static void test_rwlock(void) {
+  struct ov_error err = {0};
+  struct rw_context ctx = {0};
+  if (!TEST_SUCCEEDED(ov_rwlock_init(&ctx.lock, &err), &err)) {
+    return;
+  }
+
+  // readers share, writers exclude
+  TEST_CHECK(ov_rwlock_try_read_lock(&ctx.lock));
+  TEST_CHECK(ov_rwlock_try_read_lock(&ctx.lock));
+  TEST_CHECK(!ov_rwlock_try_write_lock(&ctx.lock));
+  ov_rwlock_read_unlock(&ctx.lock);
+  ov_rwlock_read_unlock(&ctx.lock);
+  TEST_CHECK(ov_rwlock_try_write_lock(&ctx.lock));
+  TEST_CHECK(!ov_rwlock_try_read_lock(&ctx.lock));
+  TEST_CHECK(!ov_rwlock_try_write_lock(&ctx.lock));
+  ov_rwlock_write_unlock(&ctx.lock);
+
+  thrd_t threads[nthreads];
+  size_t n = 0;
+  for (; n < nthreads; ++n) {
+    if (!TEST_CHECK(thrd_create(&threads[n], n < 2 ? rw_writer : rw_reader, &ctx) == thrd_success)) {
+      break;
+    }
+  }
+  for (size_t i = 0; i < n; ++i) {
+    thrd_join(threads[i], NULL);
+  }
+  if (n == nthreads) {
+    TEST_CHECK(ctx.a == 2 * (iterations / 10));
+    TEST_CHECK(ctx.b == ctx.a);
+    TEST_CHECK(atomic_load(&ctx.reads) == (nthreads - 2) * iterations);
+  }
+  TEST_CHECK(atomic_load(&ctx.mismatches) == 0);
+
+  struct ov_lock_stats read_stats;
+  struct ov_lock_stats write_stats;
+  ov_rwlock_get_stats(&ctx.lock, &read_stats, &write_stats);
+  TEST_MSG("read contended %llu parks %llu, write contended %llu parks %llu",
+           (unsigned long long)read_stats.contended,
+           (unsigned long long)read_stats.parks,
+           (unsigned long long)write_stats.contended,
+           (unsigned long long)write_stats.parks);
+  ov_rwlock_exit(&ctx.lock);
+}
+
+static int blocked_writer(void *const userdata) {
+  struct rw_context *const ctx = (struct rw_context *)userdata;
+  ov_rwlock_write_lock(&ctx->lock);
+  ++ctx->a;
+  ov_rwlock_write_unlock(&ctx->lock);
+  return 0;
+}
+
+static void test_rwlock_writer_preference(void) {
+  struct ov_error err = {0};
+  struct rw_context ctx = {0};
+  if (!TEST_SUCCEEDED(ov_rwlock_init(&ctx.lock, &err), &err)) {
+    return;
+  }
+  ov_rwlock_read_lock(&ctx.lock);
+  thrd_t writer;
+  if (!TEST_CHECK(thrd_create(&writer, blocked_writer, &ctx) == thrd_success)) {
+    ov_rwlock_read_unlock(&ctx.lock);
+    ov_rwlock_exit(&ctx.lock);
+    return;
+  }
+
+  // once the writer has queued up, new readers are turned away even though only readers hold the lock
+  bool turned_away = false;
+  for (int i = 0; i < 2000 && !turned_away; ++i) {
+    if (ov_rwlock_try_read_lock(&ctx.lock)) {
+      ov_rwlock_read_unlock(&ctx.lock);
+      thrd_sleep(&(struct timespec){.tv_nsec = 1000 * 1000}, NULL);
+    } else {
+      turned_away = true;
+    }
+  }
+  TEST_CHECK(turned_away);
+
+  ov_rwlock_read_unlock(&ctx.lock);
+  thrd_join(writer, NULL);
+  TEST_CHECK(ctx.a == 1);
+
+  struct ov_lock_stats write_stats;
+  ov_rwlock_get_stats(&ctx.lock, NULL, &write_stats);
+  TEST_CHECK(write_stats.contended == 1);
+  TEST_CHECK(write_stats.parks >= 1);
+  ov_rwlock_exit(&ctx.lock);
+}
+
+struct event_context {
+  struct ov_event ev;
+  atomic_int passed;
+};
+
+static int event_waiter(void *const userdata) {
+  struct event_context *const ctx = (struct event_context *)userdata;
+  ov_event_wait(&ctx->ev);
+  atomic_fetch_add(&ctx->passed, 1);
+  return 0;
+}
+
+static void test_event(void) {
+  struct ov_error err = {0};
+  struct event_context ctx = {0};
+  if (!TEST_SUCCEEDED(ov_event_init(&ctx.ev, false, &err), &err)) {
+    return;
+  }
+  TEST_CHECK(!ov_event_is_set(&ctx.ev));
+
+  thrd_t threads[nthreads];
+  size_t n = 0;
+  for (; n < nthreads; ++n) {
+    if (!TEST_CHECK(thrd_create(&threads[n], event_waiter, &ctx) == thrd_success)) {
+      break;
+    }
+  }
+  // give the waiters time to get past spinning and park
+  thrd_sleep(&(struct timespec){.tv_nsec = 20 * 1000 * 1000}, NULL);
+  TEST_CHECK(atomic_load(&ctx.passed) == 0);
+  ov_event_set(&ctx.ev);
+  for (size_t i = 0; i < n; ++i) {
+    thrd_join(threads[i], NULL);
+  }
+  TEST_CHECK(atomic_load(&ctx.passed) == (int)n);
+
+  // a set event lets waits through until it is reset
+  TEST_CHECK(ov_event_is_set(&ctx.ev));
+  ov_event_set(&ctx.ev);
+  ov_event_wait(&ctx.ev);
+  ov_event_reset(&ctx.ev);
+  TEST_CHECK(!ov_event_is_set(&ctx.ev));
+  ov_event_reset(&ctx.ev);
+  TEST_CHECK(!ov_event_is_set(&ctx.ev));
+  ov_event_exit(&ctx.ev);
+
+  if (TEST_SUCCEEDED(ov_event_init(&ctx.ev, true, &err), &err)) {
+    TEST_CHECK(ov_event_is_set(&ctx.ev));
+    ov_event_wait(&ctx.ev);
+    ov_event_exit(&ctx.ev);
+  }
+}
+
+struct ping_pong {
+  struct ov_semaphore ping;
+  struct ov_semaphore pong;
+  size_t rounds;
+};
+
+static int pong_worker(void *const userdata) {
+  struct ping_pong *const pp = (struct ping_pong *)userdata;
+  for (size_t i = 0; i < pp->rounds; ++i) {
+    ov_semaphore_wait(&pp->ping);
+    ov_semaphore_post(&pp->pong, 1);
+  }
+  return 0;
+}
+
+static void test_semaphore(void) {
+  struct ov_error err = {0};
+  struct ping_pong pp = {.rounds = iterations};
+  if (!TEST_SUCCEEDED(ov_semaphore_init(&pp.ping, 2, &err), &err)) {
+    return;
+  }
+  if (!TEST_SUCCEEDED(ov_semaphore_init(&pp.pong, 0, &err), &err)) {
+    ov_semaphore_exit(&pp.ping);
+    return;
+  }
+
+  TEST_CHECK(ov_semaphore_try_wait(&pp.ping));
+  TEST_CHECK(ov_semaphore_try_wait(&pp.ping));
+  TEST_CHECK(!ov_semaphore_try_wait(&pp.ping));
+  ov_semaphore_post(&pp.ping, 3);
+  ov_semaphore_wait(&pp.ping);
+  ov_semaphore_wait(&pp.ping);
+  ov_semaphore_wait(&pp.ping);
+  TEST_CHECK(!ov_semaphore_try_wait(&pp.ping));
+
+  // every round hands the turn over twice, so a lost wakeup shows up as a hang
+  thrd_t t;
+  if (TEST_CHECK(thrd_create(&t, pong_worker, &pp) == thrd_success)) {
+    for (size_t i = 0; i < pp.rounds; ++i) {
+      ov_semaphore_post(&pp.ping, 1);
+      ov_semaphore_wait(&pp.pong);
+    }
+    thrd_join(t, NULL);
+  }
+  TEST_CHECK(!ov_semaphore_try_wait(&pp.ping));
+  TEST_CHECK(!ov_semaphore_try_wait(&pp.pong));
+  ov_semaphore_exit(&pp.pong);
+  ov_semaphore_exit(&pp.ping);
+}
+
+struct waitgroup_context {
+  struct ov_waitgroup wg;
+  atomic_size_t finished;
+};
+
+static int waitgroup_job(void *const userdata) {
+  struct waitgroup_context *const ctx = (struct waitgroup_context *)userdata;
+  thrd_sleep(&(struct timespec){.tv_nsec = 5 * 1000 * 1000}, NULL);
+  atomic_fetch_add(&ctx->finished, 1);
+  ov_waitgroup_done(&ctx->wg);
+  return 0;
+}
+
+static void test_waitgroup(void) {
+  struct ov_error err = {0};
+  struct waitgroup_context ctx = {0};
+  if (!TEST_SUCCEEDED(ov_waitgroup_init(&ctx.wg, &err), &err)) {
+    return;
+  }
+  // nothing registered: returns at once
+  ov_waitgroup_wait(&ctx.wg);
+
+  for (size_t round = 1; round <= 3; ++round) {
+    thrd_t threads[nthreads];
+    size_t n = 0;
+    ov_waitgroup_add(&ctx.wg, nthreads);
+    for (; n < nthreads; ++n) {
+      if (!TEST_CHECK(thrd_create(&threads[n], waitgroup_job, &ctx) == thrd_success)) {
+        break;
+      }
+    }
+    for (size_t i = n; i < nthreads; ++i) {
+      ov_waitgroup_done(&ctx.wg);
+    }
+    ov_waitgroup_wait(&ctx.wg);
+    // every job that was started had finished by the time wait returned
+    TEST_CHECK(atomic_load(&ctx.finished) == (round - 1) * nthreads + n);
+    for (size_t i = 0; i < n; ++i) {
+      thrd_join(threads[i], NULL);
+    }
+    atomic_store(&ctx.finished, round * nthreads);
+  }
+  ov_waitgroup_exit(&ctx.wg);
+}
+
+TEST_LIST = {
+    {"test_spinlock", test_spinlock},
+    {"test_adaptive_mutex", test_adaptive_mutex},
+    {"test_rwlock", test_rwlock},
+    {"test_rwlock_writer_preference", test_rwlock_writer_preference},
+    {"test_event", test_event},
+    {"test_semaphore", test_semaphore},
+    {"test_waitgroup", test_waitgroup},
+    {NULL, NULL},
+};
@@ -0,0 +1,700 @@
+#include <ovthreadpool.h>
+
+#include <ovthreads.h>
+
+#include <assert.h>
+#include <stdatomic.h>
+#include <string.h>
+
+enum {
+  cache_line_size = 64,
+  initial_deque_capacity = 256,
+  initial_inject_capacity = 64,
+  steal_rounds = 64,
+};
+
+struct task {
+  ov_threadpool_task_func func;
+  void *userdata;
+};
+
+// Chase-Lev work-stealing deque (Le, Pop, Cohen, Zappa Nardelli, "Correct and Efficient
+// Work-Stealing for Weak Memory Models", 2013). The owner pushes and pops at the bottom,
+// thieves take from the top. Arrays that were outgrown are kept until the pool is destroyed
+// because a thief may still be reading from them.
+//
+// A stalled thief can read a slot while the owner wraps around and overwrites it. The CAS on
+// top then fails and the value is thrown away, but the accesses must still be atomic, so the
+// slots are read and written with relaxed atomics as in the paper.
+
+struct deque_slot {
+  _Atomic(ov_threadpool_task_func) func;
+  _Atomic(void *) userdata;
+};
+
+struct deque_array {
+  struct deque_array *retired;
+  int64_t mask;
+  struct deque_slot items[];
+};
+
+static inline struct task slot_load(struct deque_slot *const slot) {
+  return (struct task){
+      .func = atomic_load_explicit(&slot->func, memory_order_relaxed),
+      .userdata = atomic_load_explicit(&slot->userdata, memory_order_relaxed),
+  };
+}
+
+static inline void slot_store(struct deque_slot *const slot, struct task const t) {
+  atomic_store_explicit(&slot->func, t.func, memory_order_relaxed);
+  atomic_store_explicit(&slot->userdata, t.userdata, memory_order_relaxed);
+}
+
+struct worker {
+  _Alignas(cache_line_size) _Atomic(int64_t) top;
+  _Alignas(cache_line_size) _Atomic(int64_t) bottom;
+  _Atomic(struct deque_array *) array;
+  struct ov_threadpool *tp;
+  thrd_t thread;
+  size_t index;
+  uint64_t rng;
+};
+
+struct ov_threadpool {
+  struct worker *workers;
+  size_t nworkers;
+
+  // Tasks from threads outside the pool, protected by inject_mtx.
+  mtx_t inject_mtx;
+  struct task *inject;
+  size_t inject_head;
+  size_t inject_cap;
+  atomic_size_t inject_count;
+
+  // Submitted but not yet finished tasks.
+  _Alignas(cache_line_size) atomic_size_t pending;
+  atomic_size_t sleepers;
+  mtx_t mtx;
+  cnd_t wake;
+  cnd_t idle;
+  bool ready;
+  atomic_bool stopping;
+};
+
+static bool deque_array_alloc(struct deque_array **const ap, int64_t const cap MEM_FILEPOS_PARAMS) {
+  *ap = NULL;
+  size_t const bytes = sizeof(struct deque_array) + (size_t)cap * sizeof(struct deque_slot);
+  if (!ov_mem_realloc(ap, 1, bytes MEM_FILEPOS_VALUES_PASSTHRU)) {
+    return false;
+  }
+  (*ap)->retired = NULL;
+  (*ap)->mask = cap - 1;
+  return true;
+}
+
+static bool deque_push(struct worker *const w, struct task const t) {
+  int64_t const b = atomic_load_explicit(&w->bottom, memory_order_relaxed);
+  int64_t const top = atomic_load_explicit(&w->top, memory_order_acquire);
+  struct deque_array *a = atomic_load_explicit(&w->array, memory_order_relaxed);
+  if (b - top > a->mask) {
+    struct deque_array *grown = NULL;
+    if (!deque_array_alloc(&grown, (a->mask + 1) * 2 MEM_FILEPOS_VALUES)) {
+      return false;
+    }
+    for (int64_t i = top; i < b; ++i) {
+      slot_store(grown->items + (i & grown->mask), slot_load(a->items + (i & a->mask)));
+    }
+    grown->retired = a;
+    atomic_store_explicit(&w->array, grown, memory_order_release);
+    a = grown;
+  }
+  slot_store(a->items + (b & a->mask), t);
+  atomic_thread_fence(memory_order_release);
+  atomic_store_explicit(&w->bottom, b + 1, memory_order_relaxed);
+  return true;
+}
+
+static bool deque_pop(struct worker *const w, struct task *const t) {
+  int64_t const b = atomic_load_explicit(&w->bottom, memory_order_relaxed) - 1;
+  struct deque_array *const a = atomic_load_explicit(&w->array, memory_order_relaxed);
+  atomic_store_explicit(&w->bottom, b, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+  int64_t top = atomic_load_explicit(&w->top, memory_order_relaxed);
+  if (top > b) {
+    atomic_store_explicit(&w->bottom, b + 1, memory_order_relaxed);
+    return false;
+  }
+  *t = slot_load(a->items + (b & a->mask));
+  if (top == b) {
+    // Last item: race against thieves for it.
+    bool const won = atomic_compare_exchange_strong_explicit(
+        &w->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed);
+    atomic_store_explicit(&w->bottom, b + 1, memory_order_relaxed);
+    return won;
+  }
+  return true;
+}
+
+static bool deque_steal(struct worker *const w, struct task *const t) {
+  int64_t top = atomic_load_explicit(&w->top, memory_order_acquire);
+  atomic_thread_fence(memory_order_seq_cst);
+  int64_t const b = atomic_load_explicit(&w->bottom, memory_order_acquire);
+  if (top >= b) {
+    return false;
+  }
+  struct deque_array *const a = atomic_load_explicit(&w->array, memory_order_acquire);
+  struct task const item = slot_load(a->items + (top & a->mask));
+  if (!atomic_compare_exchange_strong_explicit(&w->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed)) {
+    return false;
+  }
+  *t = item;
+  return true;
+}
+
+static bool deque_nonempty(struct worker *const w) {
+  return atomic_load_explicit(&w->top, memory_order_seq_cst) < atomic_load_explicit(&w->bottom, memory_order_seq_cst);
+}
+
+// Shared queue
+
+static bool inject_push(struct ov_threadpool *const tp, struct task const t, struct ov_error *const err) {
+  bool result = false;
+  mtx_lock(&tp->inject_mtx);
+  size_t const count = atomic_load_explicit(&tp->inject_count, memory_order_relaxed);
+  if (count == tp->inject_cap) {
+    size_t const cap = tp->inject_cap ? tp->inject_cap * 2 : initial_inject_capacity;
+    if (!OV_REALLOC(&tp->inject, cap, sizeof(struct task))) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    // Unwrap the ring into the new space.
+    for (size_t i = 0; i < tp->inject_head; ++i) {
+      tp->inject[tp->inject_cap + i] = tp->inject[i];
+    }
+    tp->inject_cap = cap;
+  }
+  tp->inject[(tp->inject_head + count) & (tp->inject_cap - 1)] = t;
+  atomic_store_explicit(&tp->inject_count, count + 1, memory_order_seq_cst);
+  result = true;
+cleanup:
+  mtx_unlock(&tp->inject_mtx);
+  return result;
+}
+
+static bool inject_pop(struct ov_threadpool *const tp, struct task *const t) {
+  if (atomic_load_explicit(&tp->inject_count, memory_order_relaxed) == 0) {
+    return false;
+  }
+  bool found = false;
+  mtx_lock(&tp->inject_mtx);
+  size_t const count = atomic_load_explicit(&tp->inject_count, memory_order_relaxed);
+  if (count) {
+    *t = tp->inject[tp->inject_head];
+    tp->inject_head = (tp->inject_head + 1) & (tp->inject_cap - 1);
+    atomic_store_explicit(&tp->inject_count, count - 1, memory_order_relaxed);
+    found = true;
+  }
+  mtx_unlock(&tp->inject_mtx);
+  return found;
+}
+
+// Scheduling
+
+// Every worker records itself in thread-local storage, so finding out whether the caller
+// is a worker of a given pool is a single load instead of a scan over thread ids.
+#ifdef OV_HAS_THREAD_LOCAL
+static OV_THREAD_LOCAL struct worker *tls_worker;
+
+static inline void set_current_worker(struct worker *const w) { tls_worker = w; }
+
+static inline struct worker *get_current_worker(void) { return tls_worker; }
+#else
+static tss_t worker_key;
+static once_flag worker_key_once = ONCE_FLAG_INIT;
+
+static void worker_key_create(void) {
+  int const r = tss_create(&worker_key, NULL);
+  (void)r;
+  assert(r == thrd_success && "tss_create failed");
+}
+
+static inline void set_current_worker(struct worker *const w) {
+  call_once(&worker_key_once, worker_key_create);
+  tss_set(worker_key, w);
+}
+
+static inline struct worker *get_current_worker(void) {
+  call_once(&worker_key_once, worker_key_create);
+  return (struct worker *)tss_get(worker_key);
+}
+#endif
+
+static struct worker *current_worker(struct ov_threadpool *const tp) {
+  struct worker *const w = get_current_worker();
+  return w && w->tp == tp ? w : NULL;
+}
+
+static bool has_work(struct ov_threadpool *const tp) {
+  if (atomic_load_explicit(&tp->inject_count, memory_order_seq_cst)) {
+    return true;
+  }
+  for (size_t i = 0; i < tp->nworkers; ++i) {
+    if (deque_nonempty(tp->workers + i)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static inline uint64_t next_random(uint64_t *const state) {
+  uint64_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  *state = x;
+  return x;
+}
+
+// Finds a task for self (NULL when called from outside the pool): own deque first, then the
+// shared queue, then the other deques starting at a random victim.
+static bool find_task(struct ov_threadpool *const tp, struct worker *const self, struct task *const t) {
+  if (self && deque_pop(self, t)) {
+    return true;
+  }
+  if (inject_pop(tp, t)) {
+    return true;
+  }
+  size_t const n = tp->nworkers;
+  uint64_t seed = (uint64_t)(uintptr_t)t | 1;
+  size_t const start = (size_t)next_random(self ? &self->rng : &seed) % n;
+  for (size_t i = 0; i < n; ++i) {
+    struct worker *const victim = tp->workers + (start + i) % n;
+    if (victim != self && deque_steal(victim, t)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void task_done(struct ov_threadpool *const tp) {
+  if (atomic_fetch_sub_explicit(&tp->pending, 1, memory_order_acq_rel) == 1) {
+    mtx_lock(&tp->mtx);
+    cnd_broadcast(&tp->idle);
+    mtx_unlock(&tp->mtx);
+  }
+}
+
+static void run_task(struct ov_threadpool *const tp, struct task const t) {
+  t.func(t.userdata);
+  task_done(tp);
+}
+
+static void wake_one(struct ov_threadpool *const tp) {
+  atomic_thread_fence(memory_order_seq_cst);
+  if (atomic_load_explicit(&tp->sleepers, memory_order_seq_cst)) {
+    mtx_lock(&tp->mtx);
+    cnd_signal(&tp->wake);
+    mtx_unlock(&tp->mtx);
+  }
+}
+
+static int worker_main(void *const userdata) {
+  struct worker *const w = (struct worker *)userdata;
+  struct ov_threadpool *const tp = w->tp;
+  set_current_worker(w);
+  mtx_lock(&tp->mtx);
+  while (!tp->ready) {
+    cnd_wait(&tp->wake, &tp->mtx);
+  }
+  mtx_unlock(&tp->mtx);
+
+  struct task t;
+  for (;;) {
+    bool found = false;
+    for (size_t round = 0; round < steal_rounds && !found; ++round) {
+      found = find_task(tp, w, &t);
+      if (!found) {
+        thrd_yield();
+      }
+    }
+    if (found) {
+      run_task(tp, t);
+      continue;
+    }
+    // Sleepers are counted before work is checked again under the lock, and submitters
+    // publish the task before looking at the count, so a wakeup cannot be missed.
+    mtx_lock(&tp->mtx);
+    atomic_fetch_add_explicit(&tp->sleepers, 1, memory_order_seq_cst);
+    while (!has_work(tp) && !atomic_load_explicit(&tp->stopping, memory_order_relaxed)) {
+      cnd_wait(&tp->wake, &tp->mtx);
+    }
+    atomic_fetch_sub_explicit(&tp->sleepers, 1, memory_order_relaxed);
+    bool const stop = atomic_load_explicit(&tp->stopping, memory_order_relaxed) && !has_work(tp);
+    mtx_unlock(&tp->mtx);
+    if (stop) {
+      break;
+    }
+  }
+  return 0;
+}
+
+struct ov_threadpool *ov_threadpool_create(struct ov_threadpool_options const *const options,
+                                           struct ov_error *const err MEM_FILEPOS_PARAMS) {
+  struct ov_threadpool *tp = NULL;
+  size_t started = 0;
+  bool mutexes = false;
+  bool result = false;
+  size_t const n = options && options->threads ? options->threads : ov_thread_hardware_concurrency();
+
+  if (!ov_mem_realloc(&tp, 1, sizeof(*tp) MEM_FILEPOS_VALUES_PASSTHRU)) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    goto cleanup;
+  }
+  *tp = (struct ov_threadpool){0};
+  if (!ov_mem_aligned_alloc(&tp->workers, n, sizeof(struct worker), cache_line_size MEM_FILEPOS_VALUES_PASSTHRU)) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    goto cleanup;
+  }
+  for (size_t i = 0; i < n; ++i) {
+    struct worker *const w = tp->workers + i;
+    memset(w, 0, sizeof(*w));
+    w->tp = tp;
+    w->index = i;
+    w->rng = (uint64_t)i * UINT64_C(0x9e3779b97f4a7c15) + 1;
+    struct deque_array *a = NULL;
+    if (!deque_array_alloc(&a, initial_deque_capacity MEM_FILEPOS_VALUES_PASSTHRU)) {
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      goto cleanup;
+    }
+    atomic_init(&w->array, a);
+    tp->nworkers = i + 1;
+  }
+  if (mtx_init(&tp->inject_mtx, mtx_plain) != thrd_success) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+    goto cleanup;
+  }
+  if (mtx_init(&tp->mtx, mtx_plain) != thrd_success) {
+    mtx_destroy(&tp->inject_mtx);
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+    goto cleanup;
+  }
+  cnd_init(&tp->wake);
+  cnd_init(&tp->idle);
+  mutexes = true;
+
+  // Workers wait until every thread has started, so a partial start can stop them before they run anything.
+  mtx_lock(&tp->mtx);
+  for (; started < n; ++started) {
+    if (thrd_create(&tp->workers[started].thread, worker_main, tp->workers + started) != thrd_success) {
+      break;
+    }
+  }
+  tp->ready = true;
+  if (started < n) {
+    atomic_store(&tp->stopping, true);
+  }
+  cnd_broadcast(&tp->wake);
+  mtx_unlock(&tp->mtx);
+  if (started < n) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_fail);
+    goto cleanup;
+  }
+  result = true;
+
+cleanup:
+  if (!result && tp) {
+    for (size_t i = 0; i < started; ++i) {
+      thrd_join(tp->workers[i].thread, NULL);
+    }
+    if (mutexes) {
+      cnd_destroy(&tp->idle);
+      cnd_destroy(&tp->wake);
+      mtx_destroy(&tp->mtx);
+      mtx_destroy(&tp->inject_mtx);
+    }
+    for (size_t i = 0; i < tp->nworkers; ++i) {
+      struct deque_array *a = atomic_load(&tp->workers[i].array);
+      ov_mem_free(&a MEM_FILEPOS_VALUES_PASSTHRU);
+    }
+    if (tp->workers) {
+      ov_mem_aligned_free(&tp->workers MEM_FILEPOS_VALUES_PASSTHRU);
+    }
+    ov_mem_free(&tp MEM_FILEPOS_VALUES_PASSTHRU);
+  }
+  return tp;
+}
+
+void ov_threadpool_destroy(struct ov_threadpool **const tpp MEM_FILEPOS_PARAMS) {
+  assert(tpp != NULL && "tpp must not be NULL");
+  struct ov_threadpool *const tp = *tpp;
+  if (!tp) {
+    return;
+  }
+  ov_threadpool_wait(tp);
+  mtx_lock(&tp->mtx);
+  atomic_store(&tp->stopping, true);
+  cnd_broadcast(&tp->wake);
+  mtx_unlock(&tp->mtx);
+  for (size_t i = 0; i < tp->nworkers; ++i) {
+    thrd_join(tp->workers[i].thread, NULL);
+  }
+  for (size_t i = 0; i < tp->nworkers; ++i) {
+    struct deque_array *a = atomic_load(&tp->workers[i].array);
+    while (a) {
+      struct deque_array *retired = a->retired;
+      ov_mem_free(&a MEM_FILEPOS_VALUES_PASSTHRU);
+      a = retired;
+    }
+  }
+  cnd_destroy(&tp->idle);
+  cnd_destroy(&tp->wake);
+  mtx_destroy(&tp->mtx);
+  mtx_destroy(&tp->inject_mtx);
+  if (tp->inject) {
+    ov_mem_free(&tp->inject MEM_FILEPOS_VALUES_PASSTHRU);
+  }
+  ov_mem_aligned_free(&tp->workers MEM_FILEPOS_VALUES_PASSTHRU);
+  ov_mem_free((void **)tpp MEM_FILEPOS_VALUES_PASSTHRU);
+}
+
+bool ov_threadpool_submit(struct ov_threadpool *const tp,
+                          ov_threadpool_task_func const func,
+                          void *const userdata,
+                          struct ov_error *const err) {
+  assert(tp != NULL && "tp must not be NULL");
+  assert(func != NULL && "func must not be NULL");
+  assert(!atomic_load_explicit(&tp->stopping, memory_order_relaxed) && "pool is being destroyed");
+  struct task const t = {.func = func, .userdata = userdata};
+  atomic_fetch_add_explicit(&tp->pending, 1, memory_order_relaxed);
+  struct worker *const self = current_worker(tp);
+  if (self) {
+    if (!deque_push(self, t)) {
+      task_done(tp);
+      OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+      return false;
+    }
+  } else if (!inject_push(tp, t, err)) {
+    task_done(tp);
+    OV_ERROR_ADD_TRACE(err);
+    return false;
+  }
+  wake_one(tp);
+  return true;
+}
+
+void ov_threadpool_wait(struct ov_threadpool *const tp) {
+  assert(tp != NULL && "tp must not be NULL");
+  mtx_lock(&tp->mtx);
+  while (atomic_load_explicit(&tp->pending, memory_order_acquire)) {
+    cnd_wait(&tp->idle, &tp->mtx);
+  }
+  mtx_unlock(&tp->mtx);
+}
+
+size_t ov_threadpool_get_threads(struct ov_threadpool const *const tp) {
+  assert(tp != NULL && "tp must not be NULL");
+  return tp->nworkers;
+}
+
+// ov_parallel_run_func adapter
+//
+// Instead of one pool task per index, up to one runner per worker is queued and every runner,
+// as well as the caller, claims indices from a shared counter until none are left. The group
+// lives on the caller's stack, so the caller also waits for runners that start after all
+// indices are taken.
+
+struct run_group {
+  void (*task)(size_t const index, void *const userdata);
+  void *userdata;
+  size_t ntasks;
+  atomic_size_t next;
+  atomic_size_t runners;
+};
+
+static void run_group_claim(struct run_group *const g) {
+  for (;;) {
+    size_t const i = atomic_fetch_add_explicit(&g->next, 1, memory_order_relaxed);
+    if (i >= g->ntasks) {
+      return;
+    }
+    g->task(i, g->userdata);
+  }
+}
+
+static void run_group_runner(void *const userdata) {
+  struct run_group *const g = (struct run_group *)userdata;
+  run_group_claim(g);
+  atomic_fetch_sub_explicit(&g->runners, 1, memory_order_release);
+}
+
+void ov_threadpool_parallel_run(size_t const ntasks,
+                                void (*const task)(size_t const index, void *const userdata),
+                                void *const userdata,
+                                void *const executor) {
+  assert(executor != NULL && "executor must not be NULL");
+  assert(task != NULL && "task must not be NULL");
+  struct ov_threadpool *const tp = (struct ov_threadpool *)executor;
+  struct run_group g = {
+      .task = task,
+      .userdata = userdata,
+      .ntasks = ntasks,
+  };
+  atomic_init(&g.next, 0);
+  atomic_init(&g.runners, 0);
+  size_t const want = ntasks > 1 ? (ntasks - 1 < tp->nworkers ? ntasks - 1 : tp->nworkers) : 0;
+  for (size_t i = 0; i < want; ++i) {
+    atomic_fetch_add_explicit(&g.runners, 1, memory_order_relaxed);
+    if (!ov_threadpool_submit(tp, run_group_runner, &g, NULL)) {
+      atomic_fetch_sub_explicit(&g.runners, 1, memory_order_relaxed);
+      break;
+    }
+  }
+  run_group_claim(&g);
+  struct worker *const self = current_worker(tp);
+  struct task t;
+  while (atomic_load_explicit(&g.runners, memory_order_acquire)) {
+    if (find_task(tp, self, &t)) {
+      run_task(tp, t);
+    } else {
+      thrd_yield();
+    }
+  }
+}
+
+// Data-parallel loops
+//
+// Every participant claims chunks of the range from a shared cursor. Chunks start at
+// 1/(2 * participants) of what is left and shrink as the range drains (guided scheduling),
+// so the first claims amortize the atomic and the last ones even out uneven work. The cursor
+// sits on its own cache line, and reduce partials are cache-line padded.
+
+struct loop {
+  _Alignas(cache_line_size) atomic_size_t next;
+  _Alignas(cache_line_size) size_t end;
+  size_t grain;
+  size_t participants;
+  ov_parallel_for_func fn;
+  ov_parallel_map_func map;
+  void *userdata;
+  unsigned char *partials;
+  size_t partial_stride;
+};
+
+static bool loop_claim(struct loop *const l, size_t *const begin, size_t *const end) {
+  size_t cur = atomic_load_explicit(&l->next, memory_order_relaxed);
+  for (;;) {
+    if (cur >= l->end) {
+      return false;
+    }
+    // Whole multiples of grain keep every chunk boundary at begin + k * grain.
+    size_t chunk = (l->end - cur) / (l->participants * 2) / l->grain * l->grain;
+    if (chunk < l->grain) {
+      chunk = l->grain;
+    }
+    size_t const stop = l->end - cur < chunk ? l->end : cur + chunk;
+    if (atomic_compare_exchange_weak_explicit(&l->next, &cur, stop, memory_order_relaxed, memory_order_relaxed)) {
+      *begin = cur;
+      *end = stop;
+      return true;
+    }
+  }
+}
+
+static void loop_for_task(size_t const index, void *const userdata) {
+  (void)index;
+  struct loop *const l = (struct loop *)userdata;
+  size_t b, e;
+  while (loop_claim(l, &b, &e)) {
+    l->fn(b, e, l->userdata);
+  }
+}
+
+static void loop_reduce_task(size_t const index, void *const userdata) {
+  struct loop *const l = (struct loop *)userdata;
+  void *const partial = l->partials + index * l->partial_stride;
+  size_t b, e;
+  while (loop_claim(l, &b, &e)) {
+    l->map(b, e, partial, l->userdata);
+  }
+}
+
+static size_t loop_participants(struct ov_threadpool const *const tp, size_t const n, size_t const grain) {
+  size_t const chunks = n / grain + (n % grain != 0);
+  size_t const threads = tp ? tp->nworkers + 1 : 1;
+  return chunks < threads ? chunks : threads;
+}
+
+void ov_parallel_for(struct ov_threadpool *const tp,
+                     size_t const begin,
+                     size_t const end,
+                     size_t const grain,
+                     ov_parallel_for_func const fn,
+                     void *const userdata) {
+  assert(fn != NULL && "fn must not be NULL");
+  if (begin >= end) {
+    return;
+  }
+  size_t const g = grain ? grain : 1;
+  size_t const participants = loop_participants(tp, end - begin, g);
+  if (participants < 2) {
+    fn(begin, end, userdata);
+    return;
+  }
+  struct loop l = {
+      .end = end,
+      .grain = g,
+      .participants = participants,
+      .fn = fn,
+      .userdata = userdata,
+  };
+  atomic_init(&l.next, begin);
+  ov_threadpool_parallel_run(participants, loop_for_task, &l, tp);
+}
+
+bool ov_parallel_reduce(struct ov_threadpool *const tp,
+                        size_t const begin,
+                        size_t const end,
+                        size_t const grain,
+                        void *const result,
+                        size_t const result_size,
+                        ov_parallel_map_func const map,
+                        ov_parallel_combine_func const combine,
+                        void *const userdata,
+                        struct ov_error *const err) {
+  assert(result != NULL && "result must not be NULL");
+  assert(result_size > 0 && "result_size must be greater than 0");
+  assert(map != NULL && "map must not be NULL");
+  assert(combine != NULL && "combine must not be NULL");
+  if (begin >= end) {
+    return true;
+  }
+  size_t const g = grain ? grain : 1;
+  size_t const participants = loop_participants(tp, end - begin, g);
+  if (participants < 2) {
+    map(begin, end, result, userdata);
+    return true;
+  }
+  struct loop l = {
+      .end = end,
+      .grain = g,
+      .participants = participants,
+      .map = map,
+      .userdata = userdata,
+      .partial_stride = (result_size + cache_line_size - 1) / cache_line_size * cache_line_size,
+  };
+  atomic_init(&l.next, begin);
+  if (!OV_ALIGNED_ALLOC(&l.partials, participants, l.partial_stride, cache_line_size)) {
+    OV_ERROR_SET_GENERIC(err, ov_error_generic_out_of_memory);
+    return false;
+  }
+  // result holds the identity; every partial starts from a copy of it.
+  for (size_t i = 0; i < participants; ++i) {
+    memcpy(l.partials + i * l.partial_stride, result, result_size);
+  }
+  ov_threadpool_parallel_run(participants, loop_reduce_task, &l, tp);
+  for (size_t i = 0; i < participants; ++i) {
+    combine(result, l.partials + i * l.partial_stride, userdata);
+  }
+  OV_ALIGNED_FREE(&l.partials);
+  return true;
+}
@@ -0,0 +1,407 @@
+#include <ovtest.h>
+
+#include <ovsort.h>
+#include <ovthreadpool.h>
+#include <ovthreads.h>
+
+#include <stdatomic.h>
+
+static void increment(void *const userdata) { atomic_fetch_add((atomic_size_t *)userdata, 1); }
+
+static void test_submit_wait(void) {
+  enum { ntasks = 10000 };
+  struct ov_error err = {0};
+  struct ov_threadpool *tp = OV_THREADPOOL_CREATE(&((struct ov_threadpool_options){.threads = 4}), &err);
+  if (!TEST_SUCCEEDED(tp != NULL, &err)) {
+    return;
+  }
+  TEST_CHECK(ov_threadpool_get_threads(tp) == 4);
+
+  atomic_size_t counter = 0;
+  for (int round = 0; round < 3; ++round) {
+    for (size_t i = 0; i < ntasks; ++i) {
+      if (!TEST_SUCCEEDED(ov_threadpool_submit(tp, increment, &counter, &err), &err)) {
+        break;
+      }
+    }
+    ov_threadpool_wait(tp);
+    TEST_CHECK(atomic_load(&counter) == (size_t)(round + 1) * ntasks);
+  }
+  // waiting on an idle pool returns immediately
+  ov_threadpool_wait(tp);
+
+  OV_THREADPOOL_DESTROY(&tp);
+  TEST_CHECK(tp == NULL);
+}
+
+struct tree_context {
+  struct ov_threadpool *tp;
+  atomic_size_t leaves;
+  atomic_size_t failures;
+};
+
+struct tree_node {
+  struct tree_context *ctx;
+  unsigned depth;
+};
+
+static struct tree_node tree_nodes[1 << 13];
+
+// Every node spawns its two children from inside a worker, so they go through the worker deques.
+static void tree_task(void *const userdata) {
+  struct tree_node const *const node = (struct tree_node const *)userdata;
+  size_t const index = (size_t)(node - tree_nodes);
+  if (node->depth == 0) {
+    atomic_fetch_add(&node->ctx->leaves, 1);
+    return;
+  }
+  for (size_t c = 1; c <= 2; ++c) {
+    struct tree_node *const child = tree_nodes + index * 2 + c;
+    *child = (struct tree_node){.ctx = node->ctx, .depth = node->depth - 1};
+    if (!ov_threadpool_submit(node->ctx->tp, tree_task, child, NULL)) {
+      atomic_fetch_add(&node->ctx->failures, 1);
+    }
+  }
+}
+
+static void test_nested_submit(void) {
+  enum { depth = 12 };
+  struct ov_error err = {0};
+  struct tree_context ctx = {0};
+  ctx.tp = OV_THREADPOOL_CREATE(&((struct ov_threadpool_options){.threads = 3}), &err);
+  if (!TEST_SUCCEEDED(ctx.tp != NULL, &err)) {
+    return;
+  }
+  tree_nodes[0] = (struct tree_node){.ctx = &ctx, .depth = depth};
+  TEST_SUCCEEDED(ov_threadpool_submit(ctx.tp, tree_task, tree_nodes, &err), &err);
+  ov_threadpool_wait(ctx.tp);
+  TEST_CHECK(atomic_load(&ctx.failures) == 0);
+  TEST_CHECK(atomic_load(&ctx.leaves) == (size_t)1 << depth);
+  TEST_MSG("leaves=%zu", atomic_load(&ctx.leaves));
+  OV_THREADPOOL_DESTROY(&ctx.tp);
+}
+
+struct run_context {
+  struct ov_threadpool *tp;
+  atomic_uint hits[1000];
+  atomic_size_t nested;
+};
+
+static void mark_index(size_t const index, void *const userdata) {
+  struct run_context *const ctx = (struct run_context *)userdata;
+  atomic_fetch_add(ctx->hits + index, 1);
+}
+
+static void count_nested(size_t const index, void *const userdata) {
+  (void)index;
+  atomic_fetch_add((atomic_size_t *)userdata, 1);
+}
+
+static void nested_run(size_t const index, void *const userdata) {
+  (void)index;
+  struct run_context *const ctx = (struct run_context *)userdata;
+  ov_threadpool_parallel_run(10, count_nested, &ctx->nested, ctx->tp);
+}
+
+static void test_parallel_run(void) {
+  struct ov_error err = {0};
+  static struct run_context ctx;
+  ctx.tp = OV_THREADPOOL_CREATE(&((struct ov_threadpool_options){.threads = 4}), &err);
+  if (!TEST_SUCCEEDED(ctx.tp != NULL, &err)) {
+    return;
+  }
+  static size_t const counts[] = {0, 1, 2, 5, 1000};
+  for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+    for (size_t i = 0; i < 1000; ++i) {
+      atomic_store(ctx.hits + i, 0);
+    }
+    ov_threadpool_parallel_run(counts[c], mark_index, &ctx, ctx.tp);
+    bool once = true;
+    for (size_t i = 0; i < 1000; ++i) {
+      once = once && atomic_load(ctx.hits + i) == (i < counts[c] ? 1u : 0u);
+    }
+    TEST_CHECK_(once, "every index runs exactly once, ntasks=%zu", counts[c]);
+  }
+
+  // tasks that fan out again wait for their own group while helping the pool
+  atomic_store(&ctx.nested, 0);
+  ov_threadpool_parallel_run(20, nested_run, &ctx, ctx.tp);
+  TEST_CHECK(atomic_load(&ctx.nested) == 200);
+
+  OV_THREADPOOL_DESTROY(&ctx.tp);
+}
+
+static int compare_u32(void const *const a, void const *const b, void *const userdata) {
+  (void)userdata;
+  uint32_t const x = *(uint32_t const *)a;
+  uint32_t const y = *(uint32_t const *)b;
+  return (x > y) - (x < y);
+}
+
+static void test_parallel_qsort(void) {
+  enum { n = 200000 };
+  struct ov_error err = {0};
+  uint32_t *values = NULL;
+  struct ov_threadpool *tp = OV_THREADPOOL_CREATE(&((struct ov_threadpool_options){.threads = 4}), &err);
+  if (!TEST_SUCCEEDED(tp != NULL, &err)) {
+    return;
+  }
+  if (!TEST_CHECK(OV_ARRAY_GROW(&values, n))) {
+    goto cleanup;
+  }
+  uint32_t state = 1;
+  for (size_t i = 0; i < n; ++i) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    values[i] = state;
+  }
+  OV_PARALLEL_QSORT(values,
+                    n,
+                    sizeof(*values),
+                    compare_u32,
+                    NULL,
+                    &((struct ov_parallel_qsort_options){
+                        .threads = 4,
+                        .serial_threshold = 1,
+                        .run = ov_threadpool_parallel_run,
+                        .executor = tp,
+                    }));
+  {
+    bool sorted = true;
+    for (size_t i = 1; i < n; ++i) {
+      sorted = sorted && values[i - 1] <= values[i];
+    }
+    TEST_CHECK(sorted);
+  }
+
+cleanup:
+  if (values) {
+    OV_ARRAY_DESTROY(&values);
+  }
+  OV_THREADPOOL_DESTROY(&tp);
+}
+
+static void sleep_then_increment(void *const userdata) {
+  thrd_sleep(&(struct timespec){.tv_nsec = 1000000}, NULL);
+  increment(userdata);
+}
+
+struct submit_args {
+  struct ov_threadpool *tp;
+  atomic_size_t *counter;
+};
+
+static int submit_from_thread(void *const userdata) {
+  struct submit_args const *const args = (struct submit_args const *)userdata;
+  for (size_t i = 0; i < 1000; ++i) {
+    if (!ov_threadpool_submit(args->tp, increment, args->counter, NULL)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static void test_destroy_drains(void) {
+  struct ov_error err = {0};
+  struct ov_threadpool *tp = OV_THREADPOOL_CREATE(&((struct ov_threadpool_options){.threads = 2}), &err);
+  if (!TEST_SUCCEEDED(tp != NULL, &err)) {
+    return;
+  }
+  atomic_size_t counter = 0;
+  // submissions from several threads at once all land in the shared queue
+  {
+    struct submit_args args = {.tp = tp, .counter = &counter};
+    thrd_t threads[4];
+    size_t started = 0;
+    for (; started < 4; ++started) {
+      if (!TEST_CHECK(thrd_create(threads + started, submit_from_thread, &args) == thrd_success)) {
+        break;
+      }
+    }
+    for (size_t i = 0; i < started; ++i) {
+      int r = 1;
+      thrd_join(threads[i], &r);
+      TEST_CHECK(r == 0);
+    }
+    ov_threadpool_wait(tp);
+    TEST_CHECK(atomic_load(&counter) == started * 1000);
+    atomic_store(&counter, 0);
+  }
+  for (size_t i = 0; i < 50; ++i) {
+    TEST_CHECK(ov_threadpool_submit(tp, sleep_then_increment, &counter, NULL));
+  }
+  // destroy runs everything that is still queued
+  OV_THREADPOOL_DESTROY(&tp);
+  TEST_CHECK(atomic_load(&counter) == 50);
+}
+
+struct for_context {
+  atomic_uchar *hits;
+  size_t begin;
+  size_t grain;
+  atomic_size_t calls;
+  atomic_size_t misaligned;
+};
+
+static void mark_range(size_t const begin, size_t const end, void *const userdata) {
+  struct for_context *const ctx = (struct for_context *)userdata;
+  atomic_fetch_add(&ctx->calls, 1);
+  if ((begin - ctx->begin) % ctx->grain != 0) {
+    atomic_fetch_add(&ctx->misaligned, 1);
+  }
+  for (size_t i = begin; i < end; ++i) {
+    atomic_fetch_add(ctx->hits + i, 1);
+  }
+}
+
+static void test_parallel_for(void) {
+  enum { max_end = 100000 };
+  struct ov_error err = {0};
+  atomic_uchar *hits = NULL;
+  struct ov_threadpool *tp = OV_THREADPOOL_CREATE(&((struct ov_threadpool_options){.threads = 3}), &err);
+  if (!TEST_SUCCEEDED(tp != NULL, &err)) {
+    return;
+  }
+  if (!TEST_CHECK(OV_ARRAY_GROW(&hits, max_end))) {
+    goto cleanup;
+  }
+  static struct {
+    size_t begin;
+    size_t end;
+    size_t grain;
+  } const cases[] = {
+      {0, 0, 1},
+      {5, 5, 1},
+      {0, 1, 0},
+      {3, 17, 1},
+      {0, 1000, 64},
+      {10, 100000, 1},
+      {7, 100000, 1000},
+      {0, 100000, 200000},
+  };
+  for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); ++c) {
+    for (int use_pool = 0; use_pool < 2; ++use_pool) {
+      TEST_CASE_("begin=%zu end=%zu grain=%zu pool=%d", cases[c].begin, cases[c].end, cases[c].grain, use_pool);
+      for (size_t i = 0; i < max_end; ++i) {
+        atomic_store(hits + i, 0);
+      }
+      struct for_context ctx = {
+          .hits = hits,
+          .begin = cases[c].begin,
+          .grain = cases[c].grain ? cases[c].grain : 1,
+      };
+      ov_parallel_for(use_pool ? tp : NULL, cases[c].begin, cases[c].end, cases[c].grain, mark_range, &ctx);
+      bool once = true;
+      for (size_t i = 0; i < max_end; ++i) {
+        once = once && atomic_load(hits + i) == (i >= cases[c].begin && i < cases[c].end ? 1 : 0);
+      }
+      TEST_CHECK(once);
+      TEST_CHECK(atomic_load(&ctx.misaligned) == 0);
+      if (!use_pool) {
+        TEST_CHECK(atomic_load(&ctx.calls) == (cases[c].begin < cases[c].end ? 1u : 0u));
+      }
+    }
+  }
+  TEST_CASE_(NULL);
+
+cleanup:
+  if (hits) {
+    OV_ARRAY_DESTROY(&hits);
+  }
+  OV_THREADPOOL_DESTROY(&tp);
+}
+
+struct stats {
+  uint64_t sum;
+  uint64_t min;
+  uint64_t max;
+};
+
+static void stats_map(size_t const begin, size_t const end, void *const partial, void *const userdata) {
+  struct stats *const st = (struct stats *)partial;
+  uint32_t const *const values = (uint32_t const *)userdata;
+  for (size_t i = begin; i < end; ++i) {
+    st->sum += values[i];
+    st->min = values[i] < st->min ? values[i] : st->min;
+    st->max = values[i] > st->max ? values[i] : st->max;
+  }
+}
+
+static void stats_combine(void *const dest, void const *const src, void *const userdata) {
+  (void)userdata;
+  struct stats *const d = (struct stats *)dest;
+  struct stats const *const s = (struct stats const *)src;
+  d->sum += s->sum;
+  d->min = s->min < d->min ? s->min : d->min;
+  d->max = s->max > d->max ? s->max : d->max;
+}
+
+static void test_parallel_reduce(void) {
+  enum { n = 300000 };
+  struct ov_error err = {0};
+  uint32_t *values = NULL;
+  struct ov_threadpool *tp = OV_THREADPOOL_CREATE(&((struct ov_threadpool_options){.threads = 4}), &err);
+  if (!TEST_SUCCEEDED(tp != NULL, &err)) {
+    return;
+  }
+  if (!TEST_CHECK(OV_ARRAY_GROW(&values, n))) {
+    goto cleanup;
+  }
+  struct stats expected = {.min = UINT64_MAX};
+  uint32_t state = 7;
+  for (size_t i = 0; i < n; ++i) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    values[i] = state;
+  }
+  stats_map(0, n, &expected, values);
+
+  static size_t const grains[] = {0, 1, 100, 4096, n};
+  for (size_t g = 0; g < sizeof(grains) / sizeof(grains[0]); ++g) {
+    for (int use_pool = 0; use_pool < 2; ++use_pool) {
+      TEST_CASE_("grain=%zu pool=%d", grains[g], use_pool);
+      struct stats st = {.min = UINT64_MAX};
+      if (!TEST_SUCCEEDED(ov_parallel_reduce(use_pool ? tp : NULL,
+                                             0,
+                                             n,
+                                             grains[g],
+                                             &st,
+                                             sizeof(st),
+                                             stats_map,
+                                             stats_combine,
+                                             values,
+                                             &err),
+                          &err)) {
+        continue;
+      }
+      TEST_CHECK(st.sum == expected.sum && st.min == expected.min && st.max == expected.max);
+    }
+  }
+  TEST_CASE_(NULL);
+
+  {
+    // an empty range leaves the identity untouched
+    struct stats st = {.min = UINT64_MAX};
+    TEST_SUCCEEDED(ov_parallel_reduce(tp, 5, 5, 1, &st, sizeof(st), stats_map, stats_combine, values, &err), &err);
+    TEST_CHECK(st.sum == 0 && st.min == UINT64_MAX && st.max == 0);
+  }
+
+cleanup:
+  if (values) {
+    OV_ARRAY_DESTROY(&values);
+  }
+  OV_THREADPOOL_DESTROY(&tp);
+}
+
+TEST_LIST = {
+    {"test_submit_wait", test_submit_wait},
+    {"test_nested_submit", test_nested_submit},
+    {"test_parallel_run", test_parallel_run},
+    {"test_parallel_qsort", test_parallel_qsort},
+    {"test_destroy_drains", test_destroy_drains},
+    {"test_parallel_for", test_parallel_for},
+    {"test_parallel_reduce", test_parallel_reduce},
+    {NULL, NULL},
+};
@@ -2,12 +2,29 @@
 
 #include <ovthreads.h>
 
+#ifdef _WIN32
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#else
+#  include <unistd.h>
+#endif
+
+size_t ov_thread_hardware_concurrency(void) {
+#ifdef _WIN32
+  SYSTEM_INFO si;
+  GetSystemInfo(&si);
+  return si.dwNumberOfProcessors > 0 ? (size_t)si.dwNumberOfProcessors : 1;
+#elif defined(_SC_NPROCESSORS_ONLN)
+  long const n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? (size_t)n : 1;
+#else
+  return 1;
+#endif
+}
+
 #if __STDC_VERSION__ < 201112L || !defined(__STDC_NO_THREADS) || __STDC_NO_THREADS__
 #  if defined(IMPLEMENT_BASE_TIMESPEC_WIN32)
 
-#    define WIN32_LEAN_AND_MEAN
-#    include <windows.h>
-
 int timespec_get(struct timespec *ts, int base) {
   if (!ts) {
     return 0;
@@ -32,9 +49,6 @@ int timespec_get(struct timespec *ts, int base) {
 }
 #  endif
 
-#  define DISABLE_TLS
-#  define DISABLE_CALL_ONCE
-
 // Replace malloc/free in tinycthread with ovbase memory management
 #  include "mem.h"
 static void *tinycthread_malloc_(size_t const sz) {
@@ -64,7 +78,5 @@ static void tinycthread_free_(void *p) { mem_core_(&p, 0 MEM_FILEPOS_VALUES); }
 
 #  undef free
 #  undef malloc
-#  undef DISABLE_TLS
-#  undef DISABLE_CALL_ONCE
 
 #endif // __STDC_VERSION__ < 201112L || !defined(__STDC_NO_THREADS) || __STDC_NO_THREADS__
@@ -475,11 +475,124 @@ static void test_cnd_broadcast_idle_cpu(void) {
 static void test_cnd_signal_stress(void) { TEST_SKIP("Windows-only test (tinycthread condvar signal-loss race)"); }
 #endif
 
+struct tls_context {
+  tss_t key;
+  mtx_t mtx;
+  int destroyed;
+  int mismatches;
+};
+
+static struct tls_context tls_ctx;
+static OV_THREAD_LOCAL int tls_value;
+
+static void tls_destructor(void *value) {
+  mtx_lock(&tls_ctx.mtx);
+  tls_ctx.destroyed += *(int *)value;
+  mtx_unlock(&tls_ctx.mtx);
+}
+
+static int tls_worker(void *userdata) {
+  int *const slot = (int *)userdata;
+  if (tss_get(tls_ctx.key) != NULL || tls_value != 0) {
+    ++tls_ctx.mismatches;
+  }
+  tls_value = *slot;
+  if (tss_set(tls_ctx.key, slot) != thrd_success) {
+    ++tls_ctx.mismatches;
+  }
+  for (int i = 0; i < 100; ++i) {
+    thrd_yield();
+    if (tss_get(tls_ctx.key) != slot || tls_value != *slot) {
+      ++tls_ctx.mismatches;
+    }
+  }
+  return 0;
+}
+
+static void test_tss(void) {
+  enum { nthreads = 4 };
+  tls_ctx = (struct tls_context){0};
+  if (!TEST_CHECK(mtx_init(&tls_ctx.mtx, mtx_plain) == thrd_success)) {
+    return;
+  }
+  if (!TEST_CHECK(tss_create(&tls_ctx.key, tls_destructor) == thrd_success)) {
+    mtx_destroy(&tls_ctx.mtx);
+    return;
+  }
+
+  int main_slot = 1000;
+  tls_value = -1;
+  TEST_CHECK(tss_get(tls_ctx.key) == NULL);
+  TEST_CHECK(tss_set(tls_ctx.key, &main_slot) == thrd_success);
+
+  int slots[nthreads];
+  thrd_t threads[nthreads];
+  int started = 0;
+  int expected = 0;
+  for (; started < nthreads; ++started) {
+    slots[started] = 1 << started;
+    if (!TEST_CHECK(thrd_create(&threads[started], tls_worker, slots + started) == thrd_success)) {
+      break;
+    }
+    expected += slots[started];
+  }
+  for (int i = 0; i < started; ++i) {
+    thrd_join(threads[i], NULL);
+  }
+
+  // each thread saw only its own values, and the destructor ran once per exited thread
+  TEST_CHECK(tls_ctx.mismatches == 0);
+  TEST_CHECK(tls_ctx.destroyed == expected);
+  TEST_MSG("want %d, got %d", expected, tls_ctx.destroyed);
+  TEST_CHECK(tss_get(tls_ctx.key) == &main_slot);
+  TEST_CHECK(tls_value == -1);
+
+  tss_set(tls_ctx.key, NULL);
+  tss_delete(tls_ctx.key);
+  mtx_destroy(&tls_ctx.mtx);
+}
+
+static once_flag once = ONCE_FLAG_INIT;
+static int once_calls;
+
+static void once_func(void) {
+  // widen the window in which other threads can arrive
+  thrd_sleep(&(struct timespec){.tv_nsec = 10 * 1000 * 1000}, NULL);
+  ++once_calls;
+}
+
+static int once_worker(void *userdata) {
+  (void)userdata;
+  call_once(&once, once_func);
+  // call_once returns only after the function has completed
+  return once_calls;
+}
+
+static void test_call_once(void) {
+  enum { nthreads = 4 };
+  thrd_t threads[nthreads];
+  int started = 0;
+  for (; started < nthreads; ++started) {
+    if (!TEST_CHECK(thrd_create(&threads[started], once_worker, NULL) == thrd_success)) {
+      break;
+    }
+  }
+  for (int i = 0; i < started; ++i) {
+    int r = 0;
+    thrd_join(threads[i], &r);
+    TEST_CHECK(r == 1);
+  }
+  call_once(&once, once_func);
+  TEST_CHECK(once_calls == 1);
+}
+
 TEST_LIST = {
     {"test_mtx_timedwait", test_mtx_timedwait},
     {"test_cnd_timedwait", test_cnd_timedwait},
     {"test_cnd_wait_with_timed_mutex", test_cnd_wait_with_timed_mutex},
     {"test_cnd_broadcast_idle_cpu", test_cnd_broadcast_idle_cpu},
     {"test_cnd_signal_stress", test_cnd_signal_stress},
+    {"test_tss", test_tss},
+    {"test_call_once", test_call_once},
     {NULL, NULL},
 };